@@ -0,0 +1,326 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "stdafx.h"
+#include "FEBioBulkReader.h"
+#include <fstream>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <assert.h>
+
+// size of the blocks that are read from the file
+static const size_t BULK_BUF_SIZE = 1048576;
+
+//-----------------------------------------------------------------------------
+// same definition as used by the XMLReader
+static inline bool isvalid(char c)
+{
+	return (isalnum((unsigned char)c) || (c == '_') || (c == '.') || (c == '-') || (c == ':'));
+}
+
+static inline bool isws(char c)
+{
+	return ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'));
+}
+
+//-----------------------------------------------------------------------------
+FEBioBulkReader::FEBioBulkReader(XMLTag& tag) : m_tag(tag)
+{
+	m_fs = nullptr;
+	m_beg = m_end = 0;
+	m_bufPos = 0;
+	m_eof = false;
+	m_failed = false;
+	m_atEnd = false;
+	m_line = 0;
+	m_name = m_att = m_attVal = m_val = nullptr;
+	m_nameLen = m_attLen = m_attValLen = m_valLen = 0;
+	m_endLine = 0;
+
+	// we can only do this for sections that have children and are read from a file
+	if (tag.isleaf() || tag.isempty() || tag.isend() || (tag.m_preader == nullptr)) return;
+	std::ifstream* fs = tag.m_preader->GetFileStream();
+	if ((fs == nullptr) || !fs->is_open()) return;
+
+	// the reader handles the eof itself, so we can clear the stream flags
+	fs->clear();
+	m_streamPos = fs->tellg();
+	if (m_streamPos == std::streampos(-1)) return;
+
+	// The tag's file position points to the start of the first child
+	fs->seekg(tag.m_fpos, std::ios_base::beg);
+	if (fs->fail()) { fs->clear(); fs->seekg(m_streamPos); return; }
+
+	m_fs = fs;
+	m_bufPos = tag.m_fpos;
+	m_line = tag.m_ncurrent_line;
+	m_buf.resize(BULK_BUF_SIZE + 1);
+}
+
+//-----------------------------------------------------------------------------
+FEBioBulkReader::~FEBioBulkReader()
+{
+	// The XMLReader may still read from its current stream position, so we 
+	// need to put that back. (If Finish was called, the reader will seek anyway.)
+	if (m_fs)
+	{
+		m_fs->clear();
+		m_fs->seekg(m_streamPos);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Move the unprocessed data to the front of the buffer and read the next block.
+bool FEBioBulkReader::FillBuffer()
+{
+	if (m_eof) return false;
+
+	size_t n = m_end - m_beg;
+	if (m_beg > 0)
+	{
+		if (n > 0) memmove(&m_buf[0], &m_buf[m_beg], n);
+		m_bufPos += m_beg;
+		m_beg = 0;
+		m_end = n;
+	}
+
+	// grow the buffer if a single leaf does not fit
+	if (m_buf.size() - 1 - m_end < BULK_BUF_SIZE / 2) m_buf.resize(m_buf.size() + BULK_BUF_SIZE);
+
+	size_t nread = m_buf.size() - 1 - m_end;
+	m_fs->read(&m_buf[m_end], nread);
+	size_t nget = (size_t)m_fs->gcount();
+	if (nget != nread) { m_eof = true; m_fs->clear(); }
+	m_end += nget;
+	m_buf[m_end] = 0;
+
+	return (nget > 0);
+}
+
+//-----------------------------------------------------------------------------
+FEBioBulkReader::ParseResult FEBioBulkReader::ParseLeaf()
+{
+	const char* p = &m_buf[m_beg];
+	const char* end = &m_buf[m_end];
+
+	// find the start of the next tag
+	while ((p < end) && isws(*p)) p++;
+	if (p + 2 > end) return NEED_MORE;
+	if (p[0] != '<') return INVALID;
+	const char* ptag = p;
+
+	// end tag?
+	if (p[1] == '/')
+	{
+		p += 2;
+		while ((p < end) && isws(*p)) p++;
+		const char* sz = p;
+		while ((p < end) && isvalid(*p)) p++;
+		int l = (int)(p - sz);
+		while ((p < end) && isws(*p)) p++;
+		if (p == end) return NEED_MORE;
+		if ((*p != '>') || (l != (int)m_tag.m_sztag.size()) || (strncmp(sz, m_tag.m_sztag.c_str(), l) != 0)) return INVALID;
+		p++;
+
+		for (const char* c = &m_buf[m_beg]; c < ptag; ++c) if (*c == '\n') m_line++;
+		m_endLine = m_line;
+		for (const char* c = ptag; c < p; ++c) if (*c == '\n') m_line++;
+		m_beg = p - &m_buf[0];
+		return END_TAG;
+	}
+
+	// comments, processing instructions, etc. are handled by the XMLReader
+	if (!isvalid(p[1])) return INVALID;
+
+	// read the tag name
+	p++;
+	const char* name = p;
+	while ((p < end) && isvalid(*p)) p++;
+	int nameLen = (int)(p - name);
+
+	// read the attribute (if any)
+	const char* att = nullptr; int attLen = 0;
+	const char* attVal = nullptr; int attValLen = 0;
+	while ((p < end) && isws(*p)) p++;
+	if (p == end) return NEED_MORE;
+	if (isvalid(*p))
+	{
+		att = p;
+		while ((p < end) && isvalid(*p)) p++;
+		attLen = (int)(p - att);
+		while ((p < end) && isws(*p)) p++;
+		if (p == end) return NEED_MORE;
+		if (*p != '=') return INVALID;
+		p++;
+		while ((p < end) && isws(*p)) p++;
+		if (p == end) return NEED_MORE;
+		char quot = *p;
+		if ((quot != '"') && (quot != '\'')) return INVALID;
+		p++;
+		attVal = p;
+		while ((p < end) && (*p != quot)) p++;
+		if (p == end) return NEED_MORE;
+		attValLen = (int)(p - attVal);
+		p++;
+		while ((p < end) && isws(*p)) p++;
+		if (p == end) return NEED_MORE;
+	}
+
+	// this also rejects empty tags and tags with more than one attribute
+	if (*p != '>') return INVALID;
+	p++;
+
+	// read the value
+	const char* val = p;
+	while ((p < end) && (*p != '<')) p++;
+	if (p + 2 > end) return NEED_MORE;
+	int valLen = (int)(p - val);
+
+	// read the end tag
+	if (p[1] != '/') return INVALID;
+	p += 2;
+	while ((p < end) && isws(*p)) p++;
+	const char* sz = p;
+	while ((p < end) && isvalid(*p)) p++;
+	int l = (int)(p - sz);
+	while ((p < end) && isws(*p)) p++;
+	if (p == end) return NEED_MORE;
+	if ((*p != '>') || (l != nameLen) || (strncmp(sz, name, l) != 0)) return INVALID;
+	p++;
+
+	m_name = name; m_nameLen = nameLen;
+	m_att = att; m_attLen = attLen;
+	m_attVal = attVal; m_attValLen = attValLen;
+	m_val = val; m_valLen = valLen;
+
+	for (const char* c = &m_buf[m_beg]; c < p; ++c) if (*c == '\n') m_line++;
+	m_beg = p - &m_buf[0];
+
+	return LEAF;
+}
+
+//-----------------------------------------------------------------------------
+bool FEBioBulkReader::NextLeaf()
+{
+	if ((m_fs == nullptr) || m_failed || m_atEnd) return false;
+
+	while (true)
+	{
+		ParseResult res = ParseLeaf();
+		switch (res)
+		{
+		case LEAF: return true;
+		case END_TAG: m_atEnd = true; return false;
+		case NEED_MORE:
+			if (FillBuffer() == false) { m_failed = true; return false; }
+			break;
+		default:
+			m_failed = true;
+			return false;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+bool FEBioBulkReader::IsLeaf(const char* szname) const
+{
+	int l = (int)strlen(szname);
+	return ((l == m_nameLen) && (strncmp(m_name, szname, l) == 0));
+}
+
+//-----------------------------------------------------------------------------
+bool FEBioBulkReader::Attribute(const char* szatt, int& n) const
+{
+	int l = (int)strlen(szatt);
+	if ((m_att == nullptr) || (l != m_attLen) || (strncmp(m_att, szatt, l) != 0)) return false;
+
+	// the value is followed by the closing quote, so atoi stops there
+	n = atoi(m_attVal);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// The value is always followed by the '<' of the end tag, which stops the 
+// conversion functions, so we don't need a null-terminated copy.
+int FEBioBulkReader::Values(double* v, int nmax) const
+{
+	const char* sz = m_val;
+	const char* end = m_val + m_valLen;
+	int n = 0;
+	while ((n < nmax) && (sz < end))
+	{
+		char* ch = nullptr;
+		double d = strtod(sz, &ch);
+		if ((ch == sz) || (ch > end)) break;
+		v[n++] = d;
+		sz = ch;
+		while ((sz < end) && isws(*sz)) sz++;
+		if ((sz < end) && (*sz == ',')) sz++;
+	}
+	return n;
+}
+
+int FEBioBulkReader::Values(int* v, int nmax) const
+{
+	const char* sz = m_val;
+	const char* end = m_val + m_valLen;
+	int n = 0;
+	while ((n < nmax) && (sz < end))
+	{
+		while ((sz < end) && isws(*sz)) sz++;
+		if (sz == end) break;
+
+		bool neg = false;
+		if ((*sz == '-') || (*sz == '+')) { neg = (*sz == '-'); sz++; }
+		if ((sz == end) || !isdigit((unsigned char)*sz)) break;
+
+		int m = 0;
+		while ((sz < end) && isdigit((unsigned char)*sz)) m = 10 * m + (*sz++ - '0');
+		v[n++] = (neg ? -m : m);
+
+		while ((sz < end) && isws(*sz)) sz++;
+		if ((sz < end) && (*sz == ',')) sz++;
+	}
+	return n;
+}
+
+//-----------------------------------------------------------------------------
+void FEBioBulkReader::Finish(XMLTag& tag)
+{
+	assert(&tag == &m_tag);
+	assert(m_atEnd);
+
+	// this is what the XMLReader would do after reading the end tag
+	std::string name = tag.m_sztag;
+	tag.m_path.push_back(name);
+	tag.clear();
+	tag.m_sztag = name;
+	tag.m_bend = true;
+	tag.m_nstart_line = m_endLine;
+	tag.m_ncurrent_line = m_line;
+	tag.m_fpos = m_bufPos + (int64_t)m_beg;
+}
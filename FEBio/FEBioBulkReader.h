@@ -0,0 +1,103 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <FECore/XMLReader.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// This class reads the leaves of a large section (e.g. Nodes, Elements) 
+// directly from the file stream, instead of going through the XMLReader one 
+// tag at a time. Each child of the section must be a leaf of the form
+//
+//   <name att="value">v1,v2,...,vn</name>
+//
+// with at most one attribute. Anything else (comments, nested tags, empty 
+// tags, ...) makes the reader fail, in which case the caller must parse the 
+// section with the XMLReader instead. The XMLTag is not modified until Finish 
+// is called, so falling back is always safe.
+class FEBioBulkReader
+{
+public:
+	// the tag must be the start tag of a section that has children
+	FEBioBulkReader(XMLTag& tag);
+	~FEBioBulkReader();
+
+	// returns false if the section cannot be read directly from the file
+	bool IsValid() const { return (m_fs != nullptr); }
+
+	// Read the next leaf. Returns false when the end of the section is reached, 
+	// or when an unexpected construct was found. Use AtEnd() to distinguish.
+	bool NextLeaf();
+
+	// returns true if the end tag of the section was reached
+	bool AtEnd() const { return m_atEnd; }
+
+	// check the name of the current leaf
+	bool IsLeaf(const char* szname) const;
+
+	// get the integer value of the current leaf's attribute. 
+	// Returns false if the leaf does not have an attribute with this name.
+	bool Attribute(const char* szatt, int& n) const;
+
+	// read the comma-separated values of the current leaf. 
+	// Returns the number of values read.
+	int Values(double* v, int nmax) const;
+	int Values(int* v, int nmax) const;
+
+	// Move the tag to the end tag of the section, as if the section was parsed 
+	// with the XMLReader. Should only be called when AtEnd() returns true.
+	void Finish(XMLTag& tag);
+
+private:
+	enum ParseResult { LEAF, END_TAG, NEED_MORE, INVALID };
+
+	ParseResult ParseLeaf();
+	bool FillBuffer();
+
+private:
+	XMLTag&			m_tag;
+	std::ifstream*	m_fs;
+	std::streampos	m_streamPos;	// stream position to restore when done
+
+	std::vector<char>	m_buf;
+	size_t	m_beg;		// start of unprocessed data in buffer
+	size_t	m_end;		// end of valid data in buffer
+	int64_t	m_bufPos;	// file position of the first character in buffer
+	bool	m_eof;
+	bool	m_failed;
+	bool	m_atEnd;
+
+	int		m_line;		// current line number
+
+	// current leaf
+	const char*	m_name; int m_nameLen;
+	const char*	m_att; int m_attLen;
+	const char*	m_attVal; int m_attValLen;
+	const char*	m_val; int m_valLen;
+
+	int		m_endLine;		// line number of the section's end tag
+};
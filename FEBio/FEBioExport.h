@@ -54,6 +54,18 @@ enum FEBioExportSections
 	FEBIO_MAX_SECTIONS		// = max nr of sections
 };
 
+// XMLWriter that can also write blocks of text that were formatted elsewhere
+// (e.g. the bulk mesh sections, which are formatted in parallel). 
+class FEBioXMLWriter : public XMLWriter
+{
+public:
+	// the indentation of the current level
+	const char* tabs() const { return m_sztab; }
+
+	// write pre-formatted text
+	void write(const std::string& s) { m_stream->write(s.data(), s.size()); }
+};
+
 class FEBioExport : public FSFileExport
 {
 public:
@@ -86,8 +98,8 @@ public: // helper functions for writing to the xml file directly
 	XMLWriter& GetXMLWriter();
 
 protected:
-	FSModel&	m_fem;
-	XMLWriter	m_xml;
+	FSModel&		m_fem;
+	FEBioXMLWriter	m_xml;
 
 	unsigned int m_section;	//!< write section flags
 
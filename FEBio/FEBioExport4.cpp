@@ -42,6 +42,9 @@ SOFTWARE.*/
 #include <FECore/FETransform.h>
 #include <GeomLib/GPartSection.h>
 #include <FEMLib/FEElementFormulation.h>
+#include <charconv>
+#include <algorithm>
+#include <omp.h>
 
 using namespace std;
 
@@ -64,6 +67,80 @@ std::vector<FEBioExport4::Domain*> FEBioExport4::Part::GetDomainsFromGPart(GPart
 	return domainList;
 }
 
+//-----------------------------------------------------------------------------
+// Helpers for writing the bulk mesh sections (nodes, elements, element data).
+// These sections are formatted in parallel into chunk buffers, which are then
+// written in order. The output is identical to writing each leaf with XMLWriter.
+
+// gives access to the formatted value of an XMLElement
+class XMLValueFormatter : public XMLElement
+{
+public:
+	const std::string& text() const { return m_val; }
+};
+
+// same format as stringstream << int
+static void append_int(std::string& s, int n)
+{
+	char sz[16];
+	std::to_chars_result r = std::to_chars(sz, sz + sizeof(sz), n);
+	s.append(sz, r.ptr - sz);
+}
+
+// same format as type_to_string<vec3d>
+static void append_vec3d(std::string& s, const vec3d& r)
+{
+	char sz[128];
+	int l = snprintf(sz, sizeof(sz), "%.9g,%.9g,%.9g", r.x, r.y, r.z);
+	s.append(sz, l);
+}
+
+// start a leaf with one integer attribute, e.g. <elem id="1">
+static void append_leaf_start(std::string& s, const char* sztag, const char* szatt, int n)
+{
+	s += '<'; s += sztag; s += ' '; s += szatt; s += "=\"";
+	append_int(s, n);
+	s += "\">";
+}
+
+// close a leaf, e.g. </elem>
+static void append_leaf_end(std::string& s, const char* sztag)
+{
+	s += "</"; s += sztag; s += ">\n";
+}
+
+// Format n leaves in parallel and write them to the xml file in order.
+// fmt(i, s) must append the i-th leaf (without the indentation) to s.
+template <class F> static void write_leaves(FEBioXMLWriter& xml, int n, F fmt)
+{
+	const char* sztab = xml.tabs();
+	const int chunkSize = 4096;
+	int nchunks = (n + chunkSize - 1) / chunkSize;
+
+	// process the chunks in batches so that the buffers remain small
+	int batch = 4 * omp_get_max_threads();
+	std::vector<std::string> buf(batch);
+	for (int c0 = 0; c0 < nchunks; c0 += batch)
+	{
+		int c1 = std::min(c0 + batch, nchunks);
+#pragma omp parallel for schedule(dynamic)
+		for (int c = c0; c < c1; ++c)
+		{
+			std::string& s = buf[c - c0];
+			s.clear();
+			int i0 = c * chunkSize;
+			int i1 = std::min(i0 + chunkSize, n);
+			for (int i = i0; i < i1; ++i)
+			{
+				s += sztab;
+				fmt(i, s);
+			}
+		}
+
+		for (int c = c0; c < c1; ++c) xml.write(buf[c - c0]);
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
@@ -74,12 +151,15 @@ FEBioExport4::FEBioExport4(FSModel& fem) : FEBioExport(fem)
 	m_exportEnumStrings = true;
 	m_writeControlSection = true;
 	m_allowMixedParts = false;
+	m_binaryMesh = false;
+	m_meshFile = nullptr;
 	m_prg = nullptr;
 }
 
 FEBioExport4::~FEBioExport4()
 {
 	Clear();
+	delete m_meshFile;
 }
 
 void FEBioExport4::SetProgressTracker(ProgressTracker* prg)
@@ -623,6 +703,17 @@ bool FEBioExport4::Write(const char* szfile)
 		// open the file
 		if (!m_xml.open(szfile)) return errf("Failed opening file %s", szfile);
 
+		// create the binary mesh file
+		std::string meshFileName;
+		delete m_meshFile; m_meshFile = nullptr;
+		if (m_binaryMesh && (mdl.Objects() > 0) && WriteSection(FEBIO_GEOMETRY))
+		{
+			meshFileName = FEBioMeshFile::FileName(szfile);
+			std::string meshFile = FEBioMeshFile::FullPath(szfile, meshFileName);
+			m_meshFile = new FEBioMeshFile;
+			if (m_meshFile->Create(meshFile.c_str()) == false) return errf("Failed creating file %s", meshFile.c_str());
+		}
+
 		if (m_writeNotes)
 		{
 			WriteNote(&mdl);
@@ -684,7 +775,9 @@ bool FEBioExport4::Write(const char* szfile)
 			// output Mesh section
 			if ((m_fem.GetModel().Objects() > 0) && (WriteSection(FEBIO_GEOMETRY)))
 			{
-				m_xml.add_branch("Mesh");
+				XMLElement mesh("Mesh");
+				if (m_meshFile) mesh.add_attribute("bin_file", meshFileName);
+				m_xml.add_branch(mesh);
 				{
 					WriteMeshSection();
 				}
@@ -871,6 +964,7 @@ bool FEBioExport4::Write(const char* szfile)
 
 	// close the file
 	m_xml.close();
+	delete m_meshFile; m_meshFile = nullptr;
 
 	return true;
 }
@@ -1458,11 +1552,37 @@ void FEBioExport4::WriteGeometrySurfaces()
 	{
 		XMLElement el("Surface");
 		el.add_attribute("name", m_pSurf[i].m_name.c_str());
-		m_xml.add_branch(el);
+		if (m_meshFile)
 		{
-			WriteSurfaceSection(m_pSurf[i]);
+			FSItemListBuilder* pl = m_pSurf[i].m_list;
+			std::unique_ptr<FSFaceList> pfl(pl->BuildFaceList());
+			if (pfl == nullptr) throw InvalidItemListBuilder(m_pSurf[i].m_name);
+
+			FEBioMeshFile::Section sec;
+			FSFaceList::Iterator pf = pfl->First();
+			for (int j = 0; j < pfl->Size(); ++j, ++pf)
+			{
+				if (pf->m_pi == 0) throw InvalidItemListBuilder(m_pSurf[i].m_name);
+				FSFace& face = *(pf->m_pi);
+				if (face.CanExport())
+				{
+					int nfn = face.Nodes();
+					FSCoreMesh* pm = pf->m_pm;
+					sec.att.push_back(j + 1);
+					sec.size.push_back(nfn);
+					for (int k = 0; k < nfn; ++k) sec.ival.push_back(pm->Node(face.n[k]).m_nid);
+				}
+			}
+			WriteMeshFileSection(el, sec);
+		}
+		else
+		{
+			m_xml.add_branch(el);
+			{
+				WriteSurfaceSection(m_pSurf[i]);
+			}
+			m_xml.close_branch();
 		}
-		m_xml.close_branch();
 	}
 }
 
@@ -1723,24 +1843,51 @@ void FEBioExport4::WriteGeometryNodes()
 			const string& name = po->GetName();
 			if (name.empty() == false) tagNodes.add_attribute("name", name.c_str());
 
-			m_xml.add_branch(tagNodes);
+			std::vector<int> nodeList;
+			nodeList.reserve(pm->Nodes());
+			for (int j = 0; j < pm->Nodes(); ++j)
 			{
-				XMLElement el("node");
-				int nid = el.add_attribute("id", 0);
-				for (int j = 0; j < pm->Nodes(); ++j)
+				FSNode& node = pm->Node(j);
+				if (node.CanExport())
 				{
-					FSNode& node = pm->Node(j);
-					if (node.CanExport())
-					{
-						el.set_attribute(nid, node.m_nid);
-						if (node.m_nid > n) n = node.m_nid + 1;
-						vec3d r = po->GetTransform().LocalToGlobal(node.r);
-						el.value(r);
-						m_xml.add_leaf(el, false);
-					}
+					nodeList.push_back(j);
+					if (node.m_nid > n) n = node.m_nid + 1;
 				}
 			}
-			m_xml.close_branch();
+
+			const Transform& T = po->GetTransform();
+			if (m_meshFile)
+			{
+				int NN = (int)nodeList.size();
+				FEBioMeshFile::Section sec;
+				sec.stride = 3;
+				sec.att.resize(NN);
+				sec.dval.resize(3 * (size_t)NN);
+#pragma omp parallel for
+				for (int j = 0; j < NN; ++j)
+				{
+					FSNode& node = pm->Node(nodeList[j]);
+					vec3d r = T.LocalToGlobal(node.r);
+					sec.att[j] = node.m_nid;
+					sec.dval[3 * (size_t)j    ] = r.x;
+					sec.dval[3 * (size_t)j + 1] = r.y;
+					sec.dval[3 * (size_t)j + 2] = r.z;
+				}
+				WriteMeshFileSection(tagNodes, sec);
+			}
+			else
+			{
+				m_xml.add_branch(tagNodes);
+				{
+					write_leaves(m_xml, (int)nodeList.size(), [&](int j, std::string& s) {
+						FSNode& node = pm->Node(nodeList[j]);
+						append_leaf_start(s, "node", "id", node.m_nid);
+						append_vec3d(s, T.LocalToGlobal(node.r));
+						append_leaf_end(s, "node");
+					});
+				}
+				m_xml.close_branch();
+			}
 		}
 	}
 
@@ -1973,37 +2120,71 @@ void FEBioExport4::WriteMixedElementsPart(Part* part, GPart* pg, std::vector<int
 
 	int lastElemID = 0;
 	int ncount = 0;
-	m_xml.add_branch(xe);
+
+	// check the elements first, since we can't throw from the parallel loops
+	for (int i = 0; i < NE; ++i)
+	{
+		FSElement_& el = pm->ElementRef(elemList[i]);
+		if (el.m_nid <= lastElemID) throw FEBioExportError();
+		lastElemID = el.m_nid;
+
+		if (el.Type() != elemType)
+		{
+			int nn[FSElement::MAX_NODES] = { 0 };
+			if (get_degenerate_nodes(elemType, el.Type(), nn) == -1) throw FEBioExportError();
+		}
+
+		ncount++;
+		es.m_elem.push_back(elemList[i]);
+	}
+
+	if (m_meshFile)
 	{
-		// loop over unprocessed elements
-		int nn[FSElement::MAX_NODES];
+		FSElement tmp;
+		tmp.SetType(elemType);
+		const int ne = tmp.Nodes();
+
+		FEBioMeshFile::Section sec;
+		sec.stride = ne;
+		sec.att.resize(NE);
+		sec.ival.resize((size_t)NE * ne);
+#pragma omp parallel for
 		for (int i = 0; i < NE; ++i)
 		{
 			FSElement_& el = pm->ElementRef(elemList[i]);
-			if (el.m_nid <= lastElemID) throw FEBioExportError();
-			lastElemID = el.m_nid;
+			int nn[FSElement::MAX_NODES];
+			int m = el.Nodes();
+			for (int k = 0; k < m; ++k) nn[k] = pm->Node(el.m_node[k]).m_nid;
+			if (el.Type() != elemType) get_degenerate_nodes(elemType, el.Type(), nn);
 
-			int ntype = el.Type();
-
-			XMLElement xel("elem");
-			xel.add_attribute("id", el.m_nid);
+			sec.att[i] = el.m_nid;
+			for (int k = 0; k < ne; ++k) sec.ival[(size_t)i * ne + k] = nn[k];
+		}
+		WriteMeshFileSection(xe, sec);
+	}
+	else
+	{
+		m_xml.add_branch(xe);
+		{
+			write_leaves(m_xml, NE, [&](int i, std::string& s) {
+				FSElement_& el = pm->ElementRef(elemList[i]);
+				append_leaf_start(s, "elem", "id", el.m_nid);
 
-			int ne = el.Nodes();
-			for (int k = 0; k < ne; ++k) nn[k] = pm->Node(el.m_node[k]).m_nid;
+				int nn[FSElement::MAX_NODES];
+				int ne = el.Nodes();
+				for (int k = 0; k < ne; ++k) nn[k] = pm->Node(el.m_node[k]).m_nid;
+				if (el.Type() != elemType) ne = get_degenerate_nodes(elemType, el.Type(), nn);
 
-			if (el.Type() != elemType)
-			{
-				ne = get_degenerate_nodes(elemType, el.Type(), nn);
-				if (ne == -1) throw FEBioExportError();
-			}
-					
-			xel.value(nn, ne);
-			m_xml.add_leaf(xel, false);
-			ncount++;
-			es.m_elem.push_back(elemList[i]);
+				for (int k = 0; k < ne; ++k)
+				{
+					if (k > 0) s += ',';
+					append_int(s, nn[k]);
+				}
+				append_leaf_end(s, "elem");
+			});
 		}
+		m_xml.close_branch();
 	}
-	m_xml.close_branch();
 
 	m_ElSet.push_back(es);
 
@@ -2049,7 +2230,6 @@ void FEBioExport4::WriteGeometryPart(Part* part, GPart* pg, std::vector<int>& el
 	// loop over unprocessed elements
 	int nset = 0;
 	int ncount = 0;
-	int nn[FSElement::MAX_NODES];
 	char szname[128] = { 0 };
 	for (int i = 0; ncount < NEP; ++i)
 	{
@@ -2092,34 +2272,60 @@ void FEBioExport4::WriteGeometryPart(Part* part, GPart* pg, std::vector<int>& el
 			}
 
 			xe.add_attribute("name", szname);
-			m_xml.add_branch(xe);
-			{
-				XMLElement xej("elem");
-				int n1 = xej.add_attribute("id", (int)0);
-				int lastElemID = 0;
 
-				for (int j = i; j < NEP; ++j)
+			int lastElemID = 0;
+			for (int j = i; j < NEP; ++j)
+			{
+				FSElement_& ej = pm->ElementRef(elemList[j]);
+				if ((ej.m_ntag == 1) && (ej.Type() == ntype))
 				{
-					FSElement_& ej = pm->ElementRef(elemList[j]);
-					if ((ej.m_ntag == 1) && (ej.Type() == ntype))
-					{
-						if (ej.m_nid <= lastElemID) throw FEBioExportError();
-						lastElemID = ej.m_nid;
+					if (ej.m_nid <= lastElemID) throw FEBioExportError();
+					lastElemID = ej.m_nid;
+
+					assert(ej.Nodes() == el.Nodes());
+					ej.m_ntag = -1;	// mark as processed
+					ncount++;
+
+					es.m_elem.push_back(elemList[j]);
+				}
+			}
 
-						xej.set_attribute(n1, ej.m_nid);
+			if (m_meshFile)
+			{
+				const int ne = el.Nodes();
+				const int NE = (int)es.m_elem.size();
+
+				FEBioMeshFile::Section sec;
+				sec.stride = ne;
+				sec.att.resize(NE);
+				sec.ival.resize((size_t)NE * ne);
+#pragma omp parallel for
+				for (int j = 0; j < NE; ++j)
+				{
+					FSElement_& ej = pm->ElementRef(es.m_elem[j]);
+					sec.att[j] = ej.m_nid;
+					for (int k = 0; k < ne; ++k) sec.ival[(size_t)j * ne + k] = pm->Node(ej.m_node[k]).m_nid;
+				}
+				WriteMeshFileSection(xe, sec);
+			}
+			else
+			{
+				m_xml.add_branch(xe);
+				{
+					write_leaves(m_xml, (int)es.m_elem.size(), [&](int j, std::string& s) {
+						FSElement_& ej = pm->ElementRef(es.m_elem[j]);
+						append_leaf_start(s, "elem", "id", ej.m_nid);
 						int ne = ej.Nodes();
-						assert(ne == el.Nodes());
-						for (int k = 0; k < ne; ++k) nn[k] = pm->Node(ej.m_node[k]).m_nid;
-						xej.value(nn, ne);
-						m_xml.add_leaf(xej, false);
-						ej.m_ntag = -1;	// mark as processed
-						ncount++;
-
-						es.m_elem.push_back(elemList[j]);
-					}
+						for (int k = 0; k < ne; ++k)
+						{
+							if (k > 0) s += ',';
+							append_int(s, pm->Node(ej.m_node[k]).m_nid);
+						}
+						append_leaf_end(s, "elem");
+					});
 				}
+				m_xml.close_branch();
 			}
-			m_xml.close_branch();
 
 			nset++;
 			m_ElSet.push_back(es);
@@ -2607,32 +2813,54 @@ void FEBioExport4::WriteElementDataFields()
 					assert(false);
 				}
 
-				m_xml.add_branch(tag);
+				std::vector<int> itemList;
+				itemList.reserve(pg->size());
+				FSItemListBuilder::ConstIterator it = pg->begin();
+				for (int j = 0; j < pg->size(); ++j, ++it)
 				{
-					double d[FSElementData::MAX_ITEM_SIZE];
-					XMLElement el("e");
-					int nid = el.add_attribute("lid", 0);
-					FSItemListBuilder::ConstIterator it = pg->begin();
-					int M = data.ItemSize();
-					for (int j = 0; j < pg->size(); ++j, ++it)
+					int eid = *it;
+					FSElement_& e = pm->ElementRef(eid);
+					if (e.CanExport()) itemList.push_back(j);
+				}
+
+				int M = data.ItemSize();
+				if (m_meshFile)
+				{
+					int NI = (int)itemList.size();
+					FEBioMeshFile::Section sec;
+					sec.stride = M;
+					sec.att.resize(NI);
+					sec.dval.resize((size_t)NI * M);
+#pragma omp parallel for
+					for (int l = 0; l < NI; ++l)
 					{
-						int eid = *it;
-						FSElement_& e = pm->ElementRef(eid);
-						if (e.CanExport())
-						{
-							el.set_attribute(nid, j + 1);
+						int j = itemList[l];
+						sec.att[l] = j + 1;
+						data.get(j, &sec.dval[(size_t)l * M]);
+					}
+					WriteMeshFileSection(tag, sec);
+				}
+				else
+				{
+					m_xml.add_branch(tag);
+					{
+						write_leaves(m_xml, (int)itemList.size(), [&](int l, std::string& s) {
+							int j = itemList[l];
+							double d[FSElementData::MAX_ITEM_SIZE];
 							data.get(j, d);
-							el.value(d, M);
-							m_xml.add_leaf(el, false);
-						}
+							XMLValueFormatter val;
+							val.value(d, M);
+							append_leaf_start(s, "e", "lid", j + 1);
+							s += val.text();
+							append_leaf_end(s, "e");
+						});
 					}
+					m_xml.close_branch();
 				}
-				m_xml.close_branch();
 			}
 			FSPartData* partData = dynamic_cast<FSPartData*>(pm->GetMeshDataField(n));
 			if (partData)
 			{
-				double v[FSElement::MAX_NODES] = { 0 };
 				FSPartData& data = *partData;
 				FSPartSet* partList = data.GetPartSet();
 				FSElemList* elemList = data.BuildElemList();
@@ -2665,52 +2893,99 @@ void FEBioExport4::WriteElementDataFields()
 								assert(false);
 							}
 
-							m_xml.add_branch(tag);
+							std::vector<std::pair<int, FSElement_*> > items;
+							int N = elemList->Size();
+							FSElemList::Iterator it = elemList->First();
+							for (int j = 0; j < N; ++j, ++it)
+							{
+								FSElement_* pe = it->m_pi;
+								if ((pe->m_gid == pid) && (pe->Type() == dom->m_elemType)) items.push_back({ j, pe });
+							}
+
+							if (m_meshFile)
 							{
-								XMLElement el("e");
-								int nid = el.add_attribute("lid", 0);
-								int N = elemList->Size();
-								FSElemList::Iterator it = elemList->First();
-								int lid = 1;
-								for (int j = 0; j < N; ++j, ++it)
+								FEBioMeshFile::Section sec;
+								for (int l = 0; l < (int)items.size(); ++l)
 								{
-									FSElement_* pe = it->m_pi;
-									if ((pe->m_gid == pid) && (pe->Type() == dom->m_elemType))
-									{
-										el.set_attribute(nid, lid++);
+									int j = items[l].first;
+									FSElement_* pe = items[l].second;
 
-										if (partData->GetDataType() == DATA_SCALAR)
+									double v[FSElement::MAX_NODES] = { 0 };
+									int nv = 0;
+									if (partData->GetDataType() == DATA_SCALAR)
+									{
+										if (data.GetDataFormat() == DATA_ITEM)
+										{
+											v[0] = data[j]; nv = 1;
+										}
+										else if (data.GetDataFormat() == DATA_MULT)
 										{
-											if (data.GetDataFormat() == DATA_ITEM)
-											{
-												el.value(data[j]);
-											}
-											else if (data.GetDataFormat() == DATA_MULT)
-											{
-												int nn = pe->Nodes();
-												for (int k = 0; k < nn; ++k) v[k] = data.GetValue(j, k);
-												el.value(v, nn);
-											}
+											nv = pe->Nodes();
+											for (int k = 0; k < nv; ++k) v[k] = data.GetValue(j, k);
 										}
-										else if (partData->GetDataType() == DATA_VEC3)
+									}
+									else if (partData->GetDataType() == DATA_VEC3)
+									{
+										vec3d r = data.getVec3d(j);
+										v[0] = r.x; v[1] = r.y; v[2] = r.z; nv = 3;
+									}
+									else if (partData->GetDataType() == DATA_MAT3)
+									{
+										mat3d m = data.getMat3d(j);
+										for (int k = 0; k < 9; ++k) v[k] = m(k / 3, k % 3);
+										nv = 9;
+									}
+									else assert(false);
+
+									sec.att.push_back(l + 1);
+									sec.size.push_back(nv);
+									sec.dval.insert(sec.dval.end(), v, v + nv);
+								}
+								WriteMeshFileSection(tag, sec);
+								continue;
+							}
+
+							m_xml.add_branch(tag);
+							{
+								write_leaves(m_xml, (int)items.size(), [&](int l, std::string& s) {
+									int j = items[l].first;
+									FSElement_* pe = items[l].second;
+
+									XMLValueFormatter el;
+									if (partData->GetDataType() == DATA_SCALAR)
+									{
+										if (data.GetDataFormat() == DATA_ITEM)
 										{
-											// we only support DATA_ITEM format
-											assert(data.GetDataFormat() == DATA_ITEM);
-											vec3d v = data.getVec3d(j);
-											el.value(v);
+											el.value(data[j]);
 										}
-										else if (partData->GetDataType() == DATA_MAT3)
+										else if (data.GetDataFormat() == DATA_MULT)
 										{
-											// we only support DATA_ITEM format
-											assert(data.GetDataFormat() == DATA_ITEM);
-											mat3d v = data.getMat3d(j);
-											el.value(v);
+											double v[FSElement::MAX_NODES] = { 0 };
+											int nn = pe->Nodes();
+											for (int k = 0; k < nn; ++k) v[k] = data.GetValue(j, k);
+											el.value(v, nn);
 										}
-										else assert(false);
-
-										m_xml.add_leaf(el, false);
 									}
-								}
+									else if (partData->GetDataType() == DATA_VEC3)
+									{
+										// we only support DATA_ITEM format
+										assert(data.GetDataFormat() == DATA_ITEM);
+										vec3d v = data.getVec3d(j);
+										el.value(v);
+									}
+									else if (partData->GetDataType() == DATA_MAT3)
+									{
+										// we only support DATA_ITEM format
+										assert(data.GetDataFormat() == DATA_ITEM);
+										mat3d v = data.getMat3d(j);
+										el.value(v);
+									}
+									else assert(false);
+
+									append_leaf_start(s, "e", "lid", l + 1);
+									s += el.text();
+									append_leaf_end(s, "e");
+								});
 							}
 							m_xml.close_branch();
 						}
@@ -2796,6 +3071,29 @@ void FEBioExport4::WriteNodeDataSection()
 				FSItemListBuilder* pitem = nd.GetItemList();
 				tag.add_attribute("node_set", GetNodeSetName(pitem));
 
+				if (m_meshFile)
+				{
+					int M = (nd.GetDataType() == DATA_VEC3 ? 3 : 1);
+					FEBioMeshFile::Section sec;
+					sec.stride = M;
+					sec.att.resize(nd.Size());
+					sec.dval.resize((size_t)nd.Size() * M);
+					for (int i = 0; i < nd.Size(); ++i)
+					{
+						sec.att[i] = i + 1;
+						if (M == 1) sec.dval[i] = nd.getScalar(i);
+						else
+						{
+							vec3d v = nd.getVec3d(i);
+							sec.dval[3 * (size_t)i    ] = v.x;
+							sec.dval[3 * (size_t)i + 1] = v.y;
+							sec.dval[3 * (size_t)i + 2] = v.z;
+						}
+					}
+					WriteMeshFileSection(tag, sec);
+					continue;
+				}
+
 				m_xml.add_branch(tag);
 				{
 					XMLElement el("node");
@@ -3332,6 +3630,17 @@ void FEBioExport4::WriteLoadDataSection()
 
 //-----------------------------------------------------------------------------
 
+// Write a section to the binary mesh file. In the xml file, the section is
+// replaced by an empty tag that refers to the section in the mesh file.
+void FEBioExport4::WriteMeshFileSection(XMLElement& el, const FEBioMeshFile::Section& s)
+{
+	assert(m_meshFile);
+	int id = m_meshFile->WriteSection(s);
+	el.add_attribute("bin_id", id);
+	m_xml.add_empty(el);
+}
+
+//-----------------------------------------------------------------------------
 void FEBioExport4::WriteSurfaceSection(FSFaceList& s)
 {
 	XMLElement ef;
@@ -27,6 +27,7 @@ SOFTWARE.*/
 #include <FEMLib/FEMultiMaterial.h>
 #include <FEMLib/FEBodyLoad.h>
 #include "FEBioExport.h"
+#include "FEBioMeshFile.h"
 
 class FSSurfaceLoad;
 class GPartList;
@@ -221,6 +222,9 @@ public: // set export attributes
 
 	void SetMixedMeshFlag(bool b) { m_allowMixedParts = b; }
 
+	// write the bulk mesh sections to a binary mesh file (see FEBioMeshFile)
+	void SetBinaryMeshFlag(bool b) { m_binaryMesh = b; }
+
 protected:
 	bool PrepareExport();
 	void BuildItemLists();
@@ -296,6 +300,8 @@ protected:
 	void WriteEdgeSection(NamedItemList& l);
 	void WriteElementList(FSElemList& el);
 
+	void WriteMeshFileSection(XMLElement& el, const FEBioMeshFile::Section& s);
+
 protected:
 	bool	m_writeControlSection;	// write Control section for single step analysis
 	ProgressTracker* m_prg;
@@ -345,5 +351,8 @@ protected:
 	bool	m_bdata;	// write MeshData section flag
 	bool	m_writeNotes;	// write notes as comments
 	bool	m_allowMixedParts; // if true, parts will not be split by elements. Instead, degenerate elements are written.
+	bool	m_binaryMesh;	// write bulk mesh sections to a binary mesh file
+
+	FEBioMeshFile*	m_meshFile;	// the binary mesh file (only while writing)
 };
 
@@ -26,6 +26,7 @@ SOFTWARE.*/
 
 #include "stdafx.h"
 #include "FEBioFormat4.h"
+#include "FEBioBulkReader.h"
 #include <GeomLib/GMeshObject.h>
 #include <FEMLib/FEInitialCondition.h>
 #include <FEMLib/FEBodyLoad.h>
@@ -44,6 +45,7 @@ SOFTWARE.*/
 #include <FSCore/Palette.h>
 #include <assert.h>
 #include <sstream>
+#include <unordered_map>
 using namespace std;
 
 //-----------------------------------------------------------------------------
@@ -124,12 +126,27 @@ static bool validate_dof(string bc)
 FEBioFormat4::FEBioFormat4(FEBioFileImport* fileReader, FEBioInputModel& febio) : FEBioFormat(fileReader, febio)
 {
 	m_geomFormat = 0;
+	m_meshFile = nullptr;
 }
 
 FEBioFormat4::~FEBioFormat4()
 {
+	delete m_meshFile;
 }
 
+//-----------------------------------------------------------------------------
+bool FEBioFormat4::ReadMeshFileSection(XMLTag& tag, FEBioMeshFile::Section& s)
+{
+	const char* szid = tag.AttributeValue("bin_id", true);
+	if (szid == nullptr) return false;
+
+	if ((m_meshFile == nullptr) || (m_meshFile->ReadSection(atoi(szid), s) == false))
+		throw XMLReader::InvalidAttributeValue(tag, "bin_id", szid);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
 FEBioInputModel::Part* FEBioFormat4::DefaultPart()
 {
 	FEBioInputModel& febio = GetFEBioModel();
@@ -392,6 +409,16 @@ bool FEBioFormat4::ParseMeshSection(XMLTag& tag)
 	// make sure the section is not empty
 	if (tag.isleaf()) return true;
 
+	// see if the bulk mesh sections are stored in a binary mesh file
+	const char* szbin = tag.AttributeValue("bin_file", true);
+	if (szbin)
+	{
+		std::string fileName = FEBioMeshFile::FullPath(FileReader()->GetFileName(), szbin);
+		delete m_meshFile;
+		m_meshFile = new FEBioMeshFile;
+		if (m_meshFile->Open(fileName.c_str()) == false) throw XMLReader::InvalidAttributeValue(tag, "bin_file", szbin);
+	}
+
 	// loop over all sections
 	++tag;
 	do
@@ -575,17 +602,60 @@ void FEBioFormat4::ParseGeometryNodes(FEBioInputModel::Part* part, XMLTag& tag)
 	if (szname) part->SetName(szname);
 
 	// read nodal coordinates
-	++tag;
-	do
+	// The nodes are read from the binary mesh file, or directly from the xml file
+	// if possible, since that is much faster.
+	bool bulkRead = false;
+	FEBioMeshFile::Section sec;
+	if (ReadMeshFileSection(tag, sec))
+	{
+		if ((sec.stride != 3) || (sec.dval.size() != 3 * (size_t)sec.Leaves())) throw XMLReader::InvalidTag(tag);
+
+		int nn = sec.Leaves();
+		nodes.resize(nn);
+		for (int i = 0; i < nn; ++i)
+		{
+			const double* r = &sec.dval[3 * (size_t)i];
+			nodes[i].id = sec.att[i];
+			nodes[i].r = vec3d(r[0], r[1], r[2]);
+		}
+		bulkRead = true;
+	}
+	else
 	{
-		FEBioInputModel::NODE node;
-		tag.value(node.r);
-		int nid = tag.AttributeValue<int>("id", -1); assert(nid != -1);
-		node.id = nid;
+		FEBioBulkReader bulk(tag);
+		while (bulk.NextLeaf())
+		{
+			FEBioInputModel::NODE node;
+			double r[3] = { 0.0 };
+			int nid = -1;
+			if (!bulk.IsLeaf("node") || !bulk.Attribute("id", nid) || (bulk.Values(r, 3) != 3)) break;
+			node.r = vec3d(r[0], r[1], r[2]);
+			node.id = nid;
+			nodes.push_back(node);
+		}
 
-		nodes.push_back(node);
+		if (bulk.AtEnd())
+		{
+			bulk.Finish(tag);
+			bulkRead = true;
+		}
+	}
+
+	if (bulkRead == false)
+	{
+		nodes.clear();
 		++tag;
-	} while (!tag.isend());
+		do
+		{
+			FEBioInputModel::NODE node;
+			tag.value(node.r);
+			int nid = tag.AttributeValue<int>("id", -1); assert(nid != -1);
+			node.id = nid;
+
+			nodes.push_back(node);
+			++tag;
+		} while (!tag.isend());
+	}
 
 	// create nodes
 	int nn = (int)nodes.size();
@@ -605,70 +675,70 @@ void FEBioFormat4::ParseGeometryNodes(FEBioInputModel::Part* part, XMLTag& tag)
 // helper function for converting the element's type attribute to FSElementType
 FSElementType ConvertStringToElementType(const char* sztype)
 {
-	FSElementType ntype = FE_INVALID_ELEMENT_TYPE;
-	if      (strcmp(sztype, "hex8"   ) == 0) ntype = FE_HEX8;
-	else if (strcmp(sztype, "hex20"  ) == 0) ntype = FE_HEX20;
-	else if (strcmp(sztype, "hex27"  ) == 0) ntype = FE_HEX27;
-	else if (strcmp(sztype, "penta6" ) == 0) ntype = FE_PENTA6;
-	else if (strcmp(sztype, "tet4"   ) == 0) ntype = FE_TET4;
-	else if (strcmp(sztype, "tet5"   ) == 0) ntype = FE_TET5;
-	else if (strcmp(sztype, "tet10"  ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "tet15"  ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "tet20"  ) == 0) ntype = FE_TET20;
-	else if (strcmp(sztype, "quad4"  ) == 0) ntype = FE_QUAD4;
-	else if (strcmp(sztype, "quad8"  ) == 0) ntype = FE_QUAD8;
-	else if (strcmp(sztype, "quad9"  ) == 0) ntype = FE_QUAD9;
-	else if (strcmp(sztype, "tri3"   ) == 0) ntype = FE_TRI3;
-	else if (strcmp(sztype, "tri6"   ) == 0) ntype = FE_TRI6;
-	else if (strcmp(sztype, "pyra5"  ) == 0) ntype = FE_PYRA5;
-	else if (strcmp(sztype, "penta15") == 0) ntype = FE_PENTA15;
-	else if (strcmp(sztype, "pyra13" ) == 0) ntype = FE_PYRA13;
-	else if (strcmp(sztype, "TET10G4"     ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10G8"     ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10GL11"   ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10G4_S3"  ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10G8_S3"  ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10GL11_S3") == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10G4_S4"  ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10G8_S4"  ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10GL11_S4") == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10G4_S7"  ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10G8_S7"  ) == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET10GL11_S7") == 0) ntype = FE_TET10;
-	else if (strcmp(sztype, "TET15G8"     ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G11"    ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G15"    ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G8_S3"  ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G11_S3" ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G15_S3" ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G8_S4"  ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G11_S4" ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G15_S4" ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G8_S7"  ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G11_S7" ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "TET15G15_S7" ) == 0) ntype = FE_TET15;
-	else if (strcmp(sztype, "PENTA15G8"   ) == 0) ntype = FE_PENTA15;
-	else if (strcmp(sztype, "HEX20G8"     ) == 0) ntype = FE_HEX20;
-	else if (strcmp(sztype, "QUAD4G8"     ) == 0) ntype = FE_QUAD4;
-	else if (strcmp(sztype, "QUAD4G12"    ) == 0) ntype = FE_QUAD4;
-	else if (strcmp(sztype, "QUAD8G18"    ) == 0) ntype = FE_QUAD8;
-	else if (strcmp(sztype, "QUAD8G27"    ) == 0) ntype = FE_QUAD8;
-	else if (strcmp(sztype, "TRI3G6"      ) == 0) ntype = FE_TRI3;
-	else if (strcmp(sztype, "TRI3G9"      ) == 0) ntype = FE_TRI3;
-	else if (strcmp(sztype, "TRI6G14"     ) == 0) ntype = FE_TRI6;
-	else if (strcmp(sztype, "TRI6G21"     ) == 0) ntype = FE_TRI6;
-	else if (strcmp(sztype, "line2"       ) == 0) ntype = FE_BEAM2;
-	else if (strcmp(sztype, "line3"       ) == 0) ntype = FE_BEAM3;
-	return ntype;
+	static const std::unordered_map<std::string, FSElementType> typeMap = {
+		{ "hex8"         , FE_HEX8 },
+		{ "hex20"        , FE_HEX20 },
+		{ "hex27"        , FE_HEX27 },
+		{ "penta6"       , FE_PENTA6 },
+		{ "tet4"         , FE_TET4 },
+		{ "tet5"         , FE_TET5 },
+		{ "tet10"        , FE_TET10 },
+		{ "tet15"        , FE_TET15 },
+		{ "tet20"        , FE_TET20 },
+		{ "quad4"        , FE_QUAD4 },
+		{ "quad8"        , FE_QUAD8 },
+		{ "quad9"        , FE_QUAD9 },
+		{ "tri3"         , FE_TRI3 },
+		{ "tri6"         , FE_TRI6 },
+		{ "pyra5"        , FE_PYRA5 },
+		{ "penta15"      , FE_PENTA15 },
+		{ "pyra13"       , FE_PYRA13 },
+		{ "TET10G4"      , FE_TET10 },
+		{ "TET10G8"      , FE_TET10 },
+		{ "TET10GL11"    , FE_TET10 },
+		{ "TET10G4_S3"   , FE_TET10 },
+		{ "TET10G8_S3"   , FE_TET10 },
+		{ "TET10GL11_S3" , FE_TET10 },
+		{ "TET10G4_S4"   , FE_TET10 },
+		{ "TET10G8_S4"   , FE_TET10 },
+		{ "TET10GL11_S4" , FE_TET10 },
+		{ "TET10G4_S7"   , FE_TET10 },
+		{ "TET10G8_S7"   , FE_TET10 },
+		{ "TET10GL11_S7" , FE_TET10 },
+		{ "TET15G8"      , FE_TET15 },
+		{ "TET15G11"     , FE_TET15 },
+		{ "TET15G15"     , FE_TET15 },
+		{ "TET15G8_S3"   , FE_TET15 },
+		{ "TET15G11_S3"  , FE_TET15 },
+		{ "TET15G15_S3"  , FE_TET15 },
+		{ "TET15G8_S4"   , FE_TET15 },
+		{ "TET15G11_S4"  , FE_TET15 },
+		{ "TET15G15_S4"  , FE_TET15 },
+		{ "TET15G8_S7"   , FE_TET15 },
+		{ "TET15G11_S7"  , FE_TET15 },
+		{ "TET15G15_S7"  , FE_TET15 },
+		{ "PENTA15G8"    , FE_PENTA15 },
+		{ "HEX20G8"      , FE_HEX20 },
+		{ "QUAD4G8"      , FE_QUAD4 },
+		{ "QUAD4G12"     , FE_QUAD4 },
+		{ "QUAD8G18"     , FE_QUAD8 },
+		{ "QUAD8G27"     , FE_QUAD8 },
+		{ "TRI3G6"       , FE_TRI3 },
+		{ "TRI3G9"       , FE_TRI3 },
+		{ "TRI6G14"      , FE_TRI6 },
+		{ "TRI6G21"      , FE_TRI6 },
+		{ "line2"        , FE_BEAM2 },
+		{ "line3"        , FE_BEAM3 }
+	};
+
+	auto it = typeMap.find(sztype);
+	return (it != typeMap.end() ? it->second : FE_INVALID_ELEMENT_TYPE);
 }
 
 void FEBioFormat4::ParseGeometryElements(FEBioInputModel::Part* part, XMLTag& tag)
 {
 	if (part == 0) throw XMLReader::InvalidTag(tag);
 
-	// first we need to figure out how many elements there are
-	int elems = tag.children();
-
 	// get the required type attribute
 	const char* sztype = tag.AttributeValue("type");
 	FSElementType elemType = ConvertStringToElementType(sztype);
@@ -706,14 +776,97 @@ void FEBioFormat4::ParseGeometryElements(FEBioInputModel::Part* part, XMLTag& ta
 	FEBioInputModel::Domain* dom = part->AddDomain(name, matID);
 //	dom->m_bshellNodalNormals = GetFEBioModel().m_shellNodalNormals;
 
-	// create elements
+	// generate the part id
+	int pid = part->Domains() - 1;
+
+	// The elements are read from the binary mesh file, or directly from the xml file
+	// if possible, since that is much faster.
 	FSMesh& mesh = *part->GetFEMesh();
+	{
+		FSElement tmp;
+		tmp.SetType(elemType);
+		const int ne = tmp.Nodes();
+
+		vector<int> ids;
+		vector<int> conn;
+		bool bulkRead = false;
+		FEBioMeshFile::Section sec;
+		if (ReadMeshFileSection(tag, sec))
+		{
+			if ((sec.stride != ne) || (sec.ival.size() != (size_t)ne * sec.Leaves())) throw XMLReader::InvalidTag(tag);
+			ids.swap(sec.att);
+			conn.swap(sec.ival);
+			bulkRead = true;
+		}
+		else
+		{
+			ids.reserve(10000);
+			conn.reserve(10000 * ne);
+			FEBioBulkReader bulk(tag);
+			while (bulk.NextLeaf())
+			{
+				int id = -1;
+				if ((!bulk.IsLeaf("e") && !bulk.IsLeaf("elem")) || !bulk.Attribute("id", id)) break;
+
+				int n[FSElement::MAX_NODES] = { 0 };
+				if (bulk.Values(n, ne) != ne) break;
+				ids.push_back(id);
+				conn.insert(conn.end(), n, n + ne);
+			}
+
+			if (bulk.AtEnd())
+			{
+				bulk.Finish(tag);
+				bulkRead = true;
+			}
+		}
+
+		if (bulkRead)
+		{
+			int elems = (int)ids.size();
+			int NTE = mesh.Elements();
+			mesh.Create(0, elems + NTE);
+			for (int i = 0; i < elems; ++i)
+			{
+				FSElement& el = mesh.Element(NTE + i);
+				el.SetType(elemType);
+				el.m_gid = pid;
+				el.m_nid = ids[i];
+				dom->AddElement(NTE + i);
+
+				int* n = &conn[(size_t)i * ne];
+				int m = ne;
+				if (elemType == FE_HEX8)
+				{
+					if ((n[2] == n[3]) && (n[6] == n[7]))
+					{
+						el.SetType(FE_PENTA6);
+						m = 6;
+						n[3] = n[4];
+						n[4] = n[5];
+						n[5] = n[6];
+					}
+					else if ((n[2] == n[3]) && (n[4] == n[5]) && (n[4] == n[6]) && (n[4] == n[7]))
+					{
+						el.SetType(FE_TET4);
+						m = 4;
+						n[3] = n[4];
+					}
+				}
+
+				for (int j = 0; j < m; ++j) el.m_node[j] = n[j];
+			}
+			return;
+		}
+	}
+
+	// we need to figure out how many elements there are
+	int elems = tag.children();
+
+	// create elements
 	int NTE = mesh.Elements();
 	mesh.Create(0, elems + NTE);
 
-	// generate the part id
-	int pid = part->Domains() - 1;
-
 	// read element data
 	++tag;
 	vector<int> elemSet; elemSet.reserve(elems);
@@ -899,7 +1052,21 @@ void FEBioFormat4::ParseGeometrySurface(FEBioInputModel::Part* part, XMLTag& tag
 	FEBioInputModel::Surface s;
 	s.m_name = szname;
 
-	if (tag.isleaf() == false)
+	FEBioMeshFile::Section sec;
+	if (ReadMeshFileSection(tag, sec))
+	{
+		if ((sec.stride != 0) || (sec.ival.empty() && (sec.Leaves() > 0))) throw XMLReader::InvalidTag(tag);
+
+		const int* n = sec.ival.data();
+		for (int i = 0; i < sec.Leaves(); ++i)
+		{
+			int N = sec.size[i];
+			if ((N != 3) && (N != 4) && (N != 6) && (N != 7) && (N != 8) && (N != 9)) throw XMLReader::InvalidTag(tag);
+			s.m_face.push_back(vector<int>(n, n + N));
+			n += N;
+		}
+	}
+	else if (tag.isleaf() == false)
 	{
 		// read the surface data
 		int nf[FSElement::MAX_NODES], N;
@@ -1214,6 +1381,24 @@ bool FEBioFormat4::ParseNodeDataSection(XMLTag& tag)
 			FSNodeData* nodeData = feMesh->AddNodeDataField(name->cvalue(), nodeSet, dataType);
 			const int items = nodeData->Size();
 
+			// see if the values are stored in the binary mesh file
+			FEBioMeshFile::Section sec;
+			if (ReadMeshFileSection(tag, sec))
+			{
+				const int nv = (dataType == DATA_VEC3 ? 3 : 1);
+				if ((sec.stride != nv) || (sec.dval.size() != (size_t)nv * sec.Leaves())) throw XMLReader::InvalidTag(tag);
+				for (int i = 0; i < sec.Leaves(); ++i)
+				{
+					int index = sec.att[i] - 1;
+					if ((index < 0) || (index >= items)) throw XMLReader::InvalidAttributeValue(tag, "lid");
+
+					const double* v = &sec.dval[(size_t)i * nv];
+					if (dataType == DATA_VEC3) nodeData->setVec3d(index, vec3d(v[0], v[1], v[2]));
+					else nodeData->setScalar(index, v[0]);
+				}
+				return true;
+			}
+
 			++tag;
 			do
 			{
@@ -1622,6 +1807,65 @@ bool FEBioFormat4::ParseElementDataSection(XMLTag& tag)
 			}
 		}
 
+		// the local IDs must lie in [1, items - offset]
+		const int items = meshData->DataItems();
+
+		// see if the values are stored in the binary mesh file
+		FEBioMeshFile::Section sec;
+		if (ReadMeshFileSection(tag, sec))
+		{
+			const int nv = (dataType == DATA_SCALAR ? 1 : (dataType == DATA_VEC3 ? 3 : 9));
+			size_t m = 0;
+			for (int i = 0; i < sec.Leaves(); ++i)
+			{
+				int ni = (sec.stride > 0 ? sec.stride : sec.size[i]);
+				if ((ni < nv) || (m + ni > sec.dval.size())) throw XMLReader::InvalidTag(tag);
+				const double* v = &sec.dval[m];
+				m += ni;
+
+				int lid = sec.att[i];
+				if ((lid < 1) || (offset + lid > items)) throw XMLReader::InvalidAttributeValue(tag, "lid");
+				switch (dataType)
+				{
+				case DATA_SCALAR: meshData->set(offset + lid - 1, v[0]); break;
+				case DATA_VEC3  : meshData->set(offset + lid - 1, vec3d(v[0], v[1], v[2])); break;
+				case DATA_MAT3  : meshData->set(offset + lid - 1, mat3d(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8])); break;
+				default:
+					break;
+				}
+			}
+			return true;
+		}
+
+		// We first try to read the values directly from the file, since that is much faster.
+		// (Values that were already assigned are simply overwritten if this fails.)
+		{
+			const int nv = (dataType == DATA_SCALAR ? 1 : (dataType == DATA_VEC3 ? 3 : 9));
+			FEBioBulkReader bulk(tag);
+			while (bulk.NextLeaf())
+			{
+				double v[9] = { 0.0 };
+				int lid = 0;
+				if (!bulk.Attribute("lid", lid) || (bulk.Values(v, nv) != nv)) break;
+				if ((lid < 1) || (offset + lid > items)) break;
+
+				switch (dataType)
+				{
+				case DATA_SCALAR: meshData->set(offset + lid - 1, v[0]); break;
+				case DATA_VEC3  : meshData->set(offset + lid - 1, vec3d(v[0], v[1], v[2])); break;
+				case DATA_MAT3  : meshData->set(offset + lid - 1, mat3d(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8])); break;
+				default:
+					break;
+				}
+			}
+
+			if (bulk.AtEnd())
+			{
+				bulk.Finish(tag);
+				return true;
+			}
+		}
+
 		if (dataType == DATA_SCALAR)
 		{
 			double val;
@@ -1630,6 +1874,7 @@ bool FEBioFormat4::ParseElementDataSection(XMLTag& tag)
 			do
 			{
 				tag.AttributePtr("lid")->value(lid);
+				if ((lid < 1) || (offset + lid > items)) throw XMLReader::InvalidAttributeValue(tag, "lid");
 				tag.value(val);
 
 				meshData->set(offset + lid - 1, val);
@@ -1645,6 +1890,7 @@ bool FEBioFormat4::ParseElementDataSection(XMLTag& tag)
 			do
 			{
 				tag.AttributePtr("lid")->value(lid);
+				if ((lid < 1) || (offset + lid > items)) throw XMLReader::InvalidAttributeValue(tag, "lid");
 				tag.value(val);
 				meshData->set(offset + lid - 1, val);
 				++tag;
@@ -1658,6 +1904,7 @@ bool FEBioFormat4::ParseElementDataSection(XMLTag& tag)
 			do
 			{
 				tag.AttributePtr("lid")->value(lid);
+				if ((lid < 1) || (offset + lid > items)) throw XMLReader::InvalidAttributeValue(tag, "lid");
 				tag.value(val);
 				meshData->set(offset + lid - 1, val);
 				++tag;
@@ -27,6 +27,7 @@ SOFTWARE.*/
 #pragma once
 #include "FEBioImport.h"
 #include "FEBioFormat.h"
+#include "FEBioMeshFile.h"
 
 //-----------------------------------------------------------------------------
 class GMeshObject;
@@ -118,10 +119,16 @@ private:
 private:
 	FEBioInputModel::Part* DefaultPart();
 
+	// read the section that the tag refers to from the binary mesh file.
+	// Returns false if the tag does not refer to the mesh file.
+	bool ReadMeshFileSection(XMLTag& tag, FEBioMeshFile::Section& s);
+
 private:
 	// Geometry format flag
 	// 0 = don't know yet
 	// 1 = old fomrat
 	// 2 = new format (i.e. parts and instances)
 	int m_geomFormat;	
+
+	FEBioMeshFile*	m_meshFile;	// binary mesh file (if referenced by the Mesh section)
 };
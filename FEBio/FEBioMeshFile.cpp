@@ -0,0 +1,254 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "stdafx.h"
+#include "FEBioMeshFile.h"
+#include <algorithm>
+#include <assert.h>
+
+//-----------------------------------------------------------------------------
+FEBioMeshFile::FEBioMeshFile()
+{
+	m_fp = nullptr;
+	m_fs = nullptr;
+	m_sections = 0;
+}
+
+FEBioMeshFile::~FEBioMeshFile()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------
+void FEBioMeshFile::Close()
+{
+	m_ar.Close();
+	if (m_fs) delete m_fs;
+	m_fs = nullptr;
+	if (m_fp) fclose(m_fp);
+	m_fp = nullptr;
+	m_sections = 0;
+	m_index.clear();
+}
+
+//-----------------------------------------------------------------------------
+bool FEBioMeshFile::Create(const char* szfile)
+{
+	Close();
+	if (m_ar.Create(szfile) == false) return false;
+	m_ar.SetCompression(0);
+
+	m_ar.BeginChunk(FEBM_HEADER);
+	{
+		unsigned int version = VERSION;
+		m_ar.WriteChunk(FEBM_HDR_VERSION, version);
+	}
+	m_ar.EndChunk();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+int FEBioMeshFile::WriteSection(const Section& s)
+{
+	int id = m_sections++;
+
+	int N = s.Leaves();
+	int stride = s.stride;
+	assert((stride > 0) || ((int)s.size.size() == N));
+
+	// write the section in blocks
+	int first = 0;
+	size_t voff = 0;
+	do
+	{
+		int n = std::min((int)BLOCK_SIZE, N - first);
+
+		// number of values in this block
+		size_t nv = 0;
+		if (stride > 0) nv = (size_t)n * stride;
+		else for (int i = first; i < first + n; ++i) nv += s.size[i];
+
+		m_ar.BeginChunk(FEBM_SECTION);
+		{
+			m_ar.WriteChunk(FEBM_SEC_ID, id);
+			m_ar.WriteChunk(FEBM_SEC_FIRST, first);
+			m_ar.WriteChunk(FEBM_SEC_LEAVES, n);
+			m_ar.WriteChunk(FEBM_SEC_TOTAL, N);
+			m_ar.WriteChunk(FEBM_SEC_STRIDE, stride);
+			if (n > 0)
+			{
+				m_ar.WriteChunk(FEBM_SEC_ATT, (int*)&s.att[first], n);
+				if (stride == 0) m_ar.WriteChunk(FEBM_SEC_SIZE, (int*)&s.size[first], n);
+				if (nv > 0)
+				{
+					if (s.ival.empty() == false) m_ar.WriteChunk(FEBM_SEC_INT_VALS, (int*)&s.ival[voff], (int)nv);
+					else m_ar.WriteChunk(FEBM_SEC_DBL_VALS, (double*)&s.dval[voff], (int)nv);
+				}
+			}
+		}
+		m_ar.EndChunk();
+
+		first += n;
+		voff += nv;
+	}
+	while (first < N);
+
+	return id;
+}
+
+//-----------------------------------------------------------------------------
+bool FEBioMeshFile::Open(const char* szfile)
+{
+	Close();
+
+	m_fp = fopen(szfile, "rb");
+	if (m_fp == nullptr) return false;
+
+	m_fs = new FileStream(m_fp, false);
+	if (m_ar.Open(m_fs) == false) { Close(); return false; }
+	m_ar.SetCompression(0);
+
+	// read the header
+	if ((m_ar.OpenChunk() != xpltArchive::IO_OK) || (m_ar.GetChunkID() != FEBM_HEADER)) { Close(); return false; }
+	unsigned int version = 0;
+	while (m_ar.OpenChunk() == xpltArchive::IO_OK)
+	{
+		if (m_ar.GetChunkID() == FEBM_HDR_VERSION) m_ar.read(version);
+		m_ar.CloseChunk();
+	}
+	m_ar.CloseChunk();
+	if ((version == 0) || (version > VERSION)) { Close(); return false; }
+	if (m_ar.OpenChunk() != xpltArchive::IO_END) { Close(); return false; }
+
+	// Index the sections. We only need the section ID of each block.
+	while (true)
+	{
+		off_type pos = m_ar.Tell();
+		if (m_ar.OpenChunkHead(64) != xpltArchive::IO_OK) break;
+
+		if (m_ar.GetChunkID() == FEBM_SECTION)
+		{
+			int id = -1;
+			if ((m_ar.OpenChunk() == xpltArchive::IO_OK) && (m_ar.GetChunkID() == FEBM_SEC_ID))
+			{
+				m_ar.read(id);
+				m_ar.CloseChunk();
+			}
+			else { Close(); return false; }
+
+			BLOCK b = { id, pos };
+			m_index.push_back(b);
+		}
+
+		m_ar.CloseChunk();
+
+		// clear end-flag
+		if (m_ar.OpenChunk() != xpltArchive::IO_END) break;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// append n values of the current chunk to the array
+template <typename T> void append_values(xpltArchive& ar, std::vector<T>& a, int n)
+{
+	if (n <= 0) return;
+	size_t n0 = a.size();
+	a.resize(n0 + n);
+	ar.read(&a[n0], n);
+}
+
+bool FEBioMeshFile::ReadSection(int id, Section& s)
+{
+	s.clear();
+
+	bool found = false;
+	for (const BLOCK& b : m_index)
+	{
+		if (b.id != id) continue;
+
+		if ((m_ar.Seek(b.pos) == false) || (m_ar.OpenChunk() != xpltArchive::IO_OK)) return false;
+
+		int first = -1, n = 0, total = 0;
+		while (m_ar.OpenChunk() == xpltArchive::IO_OK)
+		{
+			int nsize = (int)m_ar.GetChunkSize();
+			switch (m_ar.GetChunkID())
+			{
+			case FEBM_SEC_FIRST : m_ar.read(first); break;
+			case FEBM_SEC_LEAVES: m_ar.read(n); break;
+			case FEBM_SEC_TOTAL :
+				m_ar.read(total);
+				if (found == false) s.att.reserve(total);
+				break;
+			case FEBM_SEC_STRIDE: m_ar.read(s.stride); break;
+			case FEBM_SEC_ATT      : append_values(m_ar, s.att , nsize / (int)sizeof(int)); break;
+			case FEBM_SEC_SIZE     : append_values(m_ar, s.size, nsize / (int)sizeof(int)); break;
+			case FEBM_SEC_INT_VALS : append_values(m_ar, s.ival, nsize / (int)sizeof(int)); break;
+			case FEBM_SEC_DBL_VALS : append_values(m_ar, s.dval, nsize / (int)sizeof(double)); break;
+			}
+			m_ar.CloseChunk();
+		}
+		m_ar.CloseChunk();
+		if (m_ar.OpenChunk() != xpltArchive::IO_END) return false;
+
+		// make sure the blocks are consistent
+		if ((first != s.Leaves() - n) || (s.Leaves() > total)) return false;
+		if ((s.stride == 0) && (s.size.size() != s.att.size())) return false;
+
+		found = true;
+	}
+
+	if (found == false) return false;
+
+	// make sure we have all the values
+	size_t nv = 0;
+	if (s.stride > 0) nv = (size_t)s.Leaves() * s.stride;
+	else for (int n : s.size) nv += n;
+	if (nv != s.ival.size() + s.dval.size()) return false;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+std::string FEBioMeshFile::FileName(const std::string& febFile)
+{
+	std::string name = febFile;
+	size_t n = name.find_last_of("/\\");
+	if (n != std::string::npos) name = name.substr(n + 1);
+	size_t m = name.rfind('.');
+	if (m != std::string::npos) name.erase(m);
+	return name + ".febm";
+}
+
+std::string FEBioMeshFile::FullPath(const std::string& febFile, const std::string& fileName)
+{
+	size_t n = febFile.find_last_of("/\\");
+	if (n == std::string::npos) return fileName;
+	return febFile.substr(0, n + 1) + fileName;
+}
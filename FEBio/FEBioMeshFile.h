@@ -0,0 +1,120 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <XPLTLib/xpltArchive.h>
+#include <vector>
+#include <string>
+
+//-----------------------------------------------------------------------------
+// The FEBio mesh file is a binary file that stores the bulk sections of a .feb 
+// file (nodes, elements, surfaces, mesh data). In the .feb file, such a section 
+// is written as an empty tag with a "bin_id" attribute that refers to the section
+// in the mesh file. The mesh file itself is referenced by the "bin_file" attribute
+// of the Mesh section.
+//
+// The file uses the same chunk layout as the plot file. Each section is split into 
+// blocks of at most BLOCK_SIZE leaves and each block is stored as a top-level chunk,
+// so that the sections can be located without reading the entire file.
+class FEBioMeshFile
+{
+public:
+	enum { VERSION = 1 };
+	enum { BLOCK_SIZE = 1048576 };
+
+	// chunk IDs
+	enum {
+		FEBM_HEADER        = 0x01000000,
+		FEBM_HDR_VERSION   = 0x01010000,
+		FEBM_SECTION       = 0x02000000,
+		FEBM_SEC_ID        = 0x02010000,
+		FEBM_SEC_FIRST     = 0x02020000,
+		FEBM_SEC_LEAVES    = 0x02030000,
+		FEBM_SEC_TOTAL     = 0x02040000,
+		FEBM_SEC_STRIDE    = 0x02050000,
+		FEBM_SEC_ATT       = 0x02060000,
+		FEBM_SEC_SIZE      = 0x02070000,
+		FEBM_SEC_INT_VALS  = 0x02080000,
+		FEBM_SEC_DBL_VALS  = 0x02090000
+	};
+
+	// A section is a table of leaves. Each leaf has an integer attribute (e.g. the 
+	// node ID) and a list of either integer or floating point values. 
+	struct Section
+	{
+		std::vector<int>	att;	// attribute value of each leaf
+		int					stride;	// number of values per leaf (or 0 if this varies)
+		std::vector<int>	size;	// number of values of each leaf (only when stride = 0)
+		std::vector<int>	ival;	// the values, for integer sections
+		std::vector<double>	dval;	// the values, for floating point sections
+
+		Section() : stride(0) {}
+
+		int Leaves() const { return (int)att.size(); }
+
+		void clear() { att.clear(); size.clear(); ival.clear(); dval.clear(); stride = 0; }
+	};
+
+public:
+	FEBioMeshFile();
+	~FEBioMeshFile();
+
+	// --- writing ---
+	bool Create(const char* szfile);
+
+	// write a section and return its ID
+	int WriteSection(const Section& s);
+
+	// --- reading ---
+	// open the file and find all sections
+	bool Open(const char* szfile);
+
+	// read a section
+	bool ReadSection(int id, Section& s);
+
+	// close the file
+	void Close();
+
+public:
+	// name of the mesh file that goes with a .feb file
+	static std::string FileName(const std::string& febFile);
+
+	// full path of a file that is referenced from a .feb file
+	static std::string FullPath(const std::string& febFile, const std::string& fileName);
+
+private:
+	struct BLOCK
+	{
+		int			id;		// section ID
+		off_type	pos;	// file position of chunk
+	};
+
+	xpltArchive		m_ar;
+	FILE*			m_fp;
+	FileStream*		m_fs;
+	int				m_sections;		// number of sections written
+	std::vector<BLOCK>	m_index;	// blocks of all sections (when reading)
+};
@@ -525,7 +525,7 @@ void CGLMonitorScene::UpdateMeshState(FEModel* fem)
 			if (!el.isActive())
 			{
 				unsigned int mask = ~(Post::StatusFlags::VISIBLE);
-				state->m_ELEM[ne].m_state &= mask;
+				state->m_ELEM.m_state[ne] &= mask;
 			}
 		}
 	}
@@ -87,6 +87,28 @@ void CCmdGroup::UnExecute()
 
 int CCmdGroup::GetCount() const { return (int)m_Cmd.size(); }
 
+size_t CCmdGroup::MemoryUsage() const
+{
+	size_t mem = 0;
+	for (int i = 0; i < (int)m_Cmd.size(); ++i) mem += m_Cmd[i]->MemoryUsage();
+	return mem;
+}
+
+void CCmdGroup::Compact()
+{
+	// Commands that delete objects on compacting are only compacted when they are the 
+	// first command of the group, since the commands before it could refer to those objects.
+	for (int i = 0; i < (int)m_Cmd.size(); ++i)
+	{
+		if ((i == 0) || !m_Cmd[i]->CompactDeletesObjects()) m_Cmd[i]->Compact();
+	}
+}
+
+bool CCmdGroup::CompactDeletesObjects() const
+{
+	return (!m_Cmd.empty() && m_Cmd[0]->CompactDeletesObjects());
+}
+
 void CCmdGroup::SetViewState(VIEW_STATE state)
 {
 	CCommand::SetViewState(state);
@@ -84,6 +84,19 @@ public:
 
 	bool HasFlag(Flag flag) const { return (m_flags & flag) != 0; }
 
+	// the amount of memory (in bytes) this command holds for undoing/redoing
+	virtual size_t MemoryUsage() const { return 0; }
+
+	// Reduce the memory this command holds (e.g. by compressing stored data).
+	// The command manager calls this on older commands when the undo history
+	// exceeds its memory budget.
+	virtual void Compact() {}
+
+	// Returns true if Compact deletes objects (e.g. a mesh) that older commands may
+	// still point to. The command manager only compacts such a command when there
+	// are no older commands left in the undo history.
+	virtual bool CompactDeletesObjects() const { return false; }
+
 protected:
 	// doc/view state variables
 	VIEW_STATE	m_state;
@@ -118,6 +131,12 @@ public:
 
 	void SetViewState(VIEW_STATE state) override;
 
+	size_t MemoryUsage() const override;
+
+	void Compact() override;
+
+	bool CompactDeletesObjects() const override;
+
 protected:
 	CCmdPtrArray	m_Cmd;	// array of pointer to commands
 };
@@ -29,8 +29,10 @@ SOFTWARE.*/
 #include "Command.h"
 #include "GLDocument.h"
 #include <GeomLib/GObject.h>
+#include <FSCore/FSLogger.h>
 
 std::string CBasicCmdManager::m_err;
+size_t CBasicCmdManager::m_memBudget = 0;
 
 CBasicCmdManager::CBasicCmdManager()
 {
@@ -42,13 +44,70 @@ CBasicCmdManager::~CBasicCmdManager()
 }
 
 void CBasicCmdManager::AddCommand(CCommand* pcmd)
+{
+	PushCommand(pcmd);
+}
+
+void CBasicCmdManager::PushCommand(CCommand* pcmd)
 {
 	// push the command
-	m_Undo.push(pcmd);
+	m_Undo.push_back(pcmd);
 
 	// clear the redo stack
 	int N = (int)m_Redo.size();
-	for (int i = 0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	for (int i = 0; i<N; i++) { delete m_Redo.back(); m_Redo.pop_back(); }
+
+	EnforceMemoryBudget();
+}
+
+size_t CBasicCmdManager::MemoryUsage() const
+{
+	size_t mem = 0;
+	for (CCommand* pcmd : m_Undo) mem += pcmd->MemoryUsage();
+	for (CCommand* pcmd : m_Redo) mem += pcmd->MemoryUsage();
+	return mem;
+}
+
+void CBasicCmdManager::EnforceMemoryBudget()
+{
+	if (m_memBudget == 0) return;
+
+	size_t mem = MemoryUsage();
+	if (mem <= m_memBudget) return;
+
+	// First, compact the older commands, starting with the oldest.
+	// The last command is left alone, so that it can be undone quickly.
+	// Commands that delete objects when compacted (e.g. a held mesh) can only be compacted
+	// when they are the oldest command, since older commands may still point to those objects.
+	for (int i = 0; (i < (int)m_Undo.size() - 1) && (mem > m_memBudget); ++i)
+	{
+		CCommand* pcmd = m_Undo[i];
+		if ((i > 0) && pcmd->CompactDeletesObjects()) continue;
+		size_t m0 = pcmd->MemoryUsage();
+		pcmd->Compact();
+		mem = mem - m0 + pcmd->MemoryUsage();
+	}
+
+	// if that is not enough, remove the oldest commands
+	int n = 0;
+	while ((mem > m_memBudget) && (m_Undo.size() > 1))
+	{
+		CCommand* pcmd = m_Undo.front();
+		mem -= pcmd->MemoryUsage();
+		delete pcmd;
+		m_Undo.pop_front();
+		n++;
+
+		// the next command is now the oldest, so it can be compacted
+		if ((mem > m_memBudget) && (m_Undo.size() > 1))
+		{
+			pcmd = m_Undo.front();
+			size_t m0 = pcmd->MemoryUsage();
+			pcmd->Compact();
+			mem = mem - m0 + pcmd->MemoryUsage();
+		}
+	}
+	if (n > 0) FSLogger::Write("Undo history: removed %d oldest command(s) to stay within the memory budget.\n", n);
 }
 
 bool CBasicCmdManager::DoCommand(CCommand* pcmd)
@@ -78,11 +137,7 @@ bool CBasicCmdManager::DoCommand(CCommand* pcmd)
 	}
 
 	// add it to the undo stack
-	m_Undo.push(pcmd);
-
-	// clear the redo stack
-	int N = (int)m_Redo.size();
-	for (int i = 0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	PushCommand(pcmd);
 
 	return true;
 }
@@ -92,13 +147,13 @@ void CBasicCmdManager::UndoCommand()
 	if (m_Undo.empty() == false)
 	{
 		// pop the command from the undo stack
-		CCommand* pcmd = m_Undo.top(); m_Undo.pop();
+		CCommand* pcmd = m_Undo.back(); m_Undo.pop_back();
 
 		// unexecute it
 		pcmd->UnExecute();
 
 		// push it on the redo stack
-		m_Redo.push(pcmd);
+		m_Redo.push_back(pcmd);
 	}
 }
 
@@ -107,13 +162,13 @@ void CBasicCmdManager::RedoCommand()
 	if (m_Redo.empty() == false)
 	{
 		// pop the command from the redo stack
-		CCommand* pcmd = m_Redo.top(); m_Redo.pop();
+		CCommand* pcmd = m_Redo.back(); m_Redo.pop_back();
 
 		// execute it
 		pcmd->Execute();
 
 		// push it on the undo stack
-		m_Undo.push(pcmd);
+		m_Undo.push_back(pcmd);
 	}
 }
 
@@ -121,15 +176,15 @@ void CBasicCmdManager::Clear()
 {
 	// clear undo stack
 	int N = (int)m_Undo.size();
-	for (int i = 0; i<N; i++) { delete m_Undo.top(); m_Undo.pop(); }
+	for (int i = 0; i<N; i++) { delete m_Undo.back(); m_Undo.pop_back(); }
 
 	// clear redo stack
 	N = (int)m_Redo.size();
-	for (int i = 0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	for (int i = 0; i<N; i++) { delete m_Redo.back(); m_Redo.pop_back(); }
 }
 
-const char* CBasicCmdManager::GetUndoCmdName() { return (m_Undo.size() ? m_Undo.top()->GetName() : 0); }
-const char* CBasicCmdManager::GetRedoCmdName() { return (m_Redo.size() ? m_Redo.top()->GetName() : 0); }
+const char* CBasicCmdManager::GetUndoCmdName() { return (m_Undo.size() ? m_Undo.back()->GetName() : 0); }
+const char* CBasicCmdManager::GetRedoCmdName() { return (m_Redo.size() ? m_Redo.back()->GetName() : 0); }
 
 //////////////////////////////////////////////////////////////////////
 // CCommandManager
@@ -189,11 +244,7 @@ bool CCommandManager::DoCommand(CCommand* pcmd)
 	}
 		
 	// add it to the undo stack
-	m_Undo.push(pcmd);
-
-	// clear the redo stack
-	int N = (int)m_Redo.size();
-	for (int i=0; i<N; i++) { delete m_Redo.top(); m_Redo.pop(); }
+	PushCommand(pcmd);
 
 	return true;
 }
@@ -201,7 +252,7 @@ bool CCommandManager::DoCommand(CCommand* pcmd)
 void CCommandManager::UndoCommand()
 {
 	// pop the command from the undo stack
-	CCommand* pcmd = m_Undo.top(); m_Undo.pop();
+	CCommand* pcmd = m_Undo.back(); m_Undo.pop_back();
 
 	// reset the view state
     CGLDocument* glDoc = dynamic_cast<CGLDocument*>(m_pDoc);
@@ -214,13 +265,13 @@ void CCommandManager::UndoCommand()
 	pcmd->UnExecute();
 
 	// push it on the redo stack
-	m_Redo.push(pcmd);
+	m_Redo.push_back(pcmd);
 }
 
 void CCommandManager::RedoCommand()
 {
 	// pop the command from the redo stack
-	CCommand* pcmd = m_Redo.top(); m_Redo.pop();
+	CCommand* pcmd = m_Redo.back(); m_Redo.pop_back();
 
 	// reset the view state
 	CGLDocument* glDoc = dynamic_cast<CGLDocument*>(m_pDoc);
@@ -233,5 +284,5 @@ void CCommandManager::RedoCommand()
 	pcmd->Execute();
 
 	// push it on the undo stack
-	m_Undo.push(pcmd);
+	m_Undo.push_back(pcmd);
 }
@@ -25,13 +25,15 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 
 #pragma once
-#include <stack>
+#include <deque>
 #include <string>
 
 class CCommand;
 class CUndoDocument;
 
-typedef std::stack<CCommand*> CCmdStack;
+// The command stacks. The top of the stack is at the back. (A deque is used
+// so that the oldest commands can be removed from the undo stack.)
+typedef std::deque<CCommand*> CCmdStack;
 
 class CBasicCmdManager
 {
@@ -55,10 +57,28 @@ public:
 	const char* GetUndoCmdName();
 	const char* GetRedoCmdName();
 
+	// the memory (in bytes) held by the commands on the undo and redo stacks
+	size_t MemoryUsage() const;
+
+	// Set the memory budget (in bytes) of the undo history (0 = no limit).
+	// When the budget is exceeded, older commands are compacted first, and
+	// when that is not enough, the oldest commands are removed.
+	static void SetMemoryBudget(size_t bytes) { m_memBudget = bytes; }
+	static size_t GetMemoryBudget() { return m_memBudget; }
+
+protected:
+	// push a command on the undo stack and clear the redo stack
+	void PushCommand(CCommand* pcmd);
+
+	// make sure the undo history stays within the memory budget
+	void EnforceMemoryBudget();
+
 protected:
 	CCmdStack	m_Undo;	// the undo stack
 	CCmdStack	m_Redo;	// the redo stack
 
+	static size_t	m_memBudget;	// memory budget of undo history
+
 public:
 	static const std::string& GetErrorString() { return m_err; }
 	void SetErrorString(const std::string& err) { m_err = err; }
@@ -2446,6 +2446,9 @@ CCmdDeleteFESelection::CCmdDeleteFESelection(GMeshObject* po, int nitem) : CComm
 
 void CCmdDeleteFESelection::Execute()
 {
+	// restore the held mesh if it was compacted
+	RestoreMesh();
+
 	// create a copy of the old mesh
 	if (m_pnew == 0)
 	{
@@ -2472,6 +2475,8 @@ void CCmdDeleteFESelection::Execute()
 //! \todo this function does not restore the original GMeshObject
 void CCmdDeleteFESelection::UnExecute()
 {
+	RestoreMesh();
+
 	// set the object's mesh
 	m_pobj->ReplaceFEMesh(m_pnew);
 
@@ -2479,6 +2484,29 @@ void CCmdDeleteFESelection::UnExecute()
 	FSMesh* pm = m_pnew; m_pnew = m_pold; m_pold = pm;
 }
 
+void CCmdDeleteFESelection::RestoreMesh()
+{
+	if ((m_pnew == 0) && !m_snapshot.IsEmpty())
+	{
+		m_pnew = m_snapshot.Restore(m_pobj);
+		assert(m_pnew);
+	}
+}
+
+size_t CCmdDeleteFESelection::MemoryUsage() const
+{
+	return CMeshSnapshot::MeshMemoryUsage(m_pnew) + m_snapshot.Size();
+}
+
+void CCmdDeleteFESelection::Compact()
+{
+	if (m_pnew && m_snapshot.Create(m_pnew))
+	{
+		delete m_pnew;
+		m_pnew = 0;
+	}
+}
+
 //=============================================================================
 // CCmdDeleteFESurfaceSelection
 //-----------------------------------------------------------------------------
@@ -3245,6 +3273,11 @@ CCmdChangeFEMesh::CCmdChangeFEMesh(GObject* po, FSMesh* pm) : CCommand("Change m
 
 void CCmdChangeFEMesh::Execute()
 {
+	if ((m_pnew == nullptr) && !m_snapshot.IsEmpty())
+	{
+		m_pnew = m_snapshot.Restore(m_po);
+		assert(m_pnew);
+	}
 	m_pnew = m_po->ReplaceFEMesh(m_pnew);
 }
 
@@ -3253,17 +3286,42 @@ void CCmdChangeFEMesh::UnExecute()
 	Execute();
 }
 
+size_t CCmdChangeFEMesh::MemoryUsage() const
+{
+	return CMeshSnapshot::MeshMemoryUsage(m_pnew) + m_snapshot.Size();
+}
+
+void CCmdChangeFEMesh::Compact()
+{
+	if (m_pnew && m_snapshot.Create(m_pnew))
+	{
+		delete m_pnew;
+		m_pnew = nullptr;
+	}
+}
+
 
 CCmdChangeFENodes::CCmdChangeFENodes(GObject* po, const std::vector<vec3d>& newPos) : CCommand("Change mesh")
 {
 	m_po = po;
 	m_newPos = newPos;
+	m_nodes = 0;
 }
 
 void CCmdChangeFENodes::Execute()
 {
 	if (m_po == nullptr) return;
 
+	// unpack the positions if they were compacted
+	if (!m_packed.empty())
+	{
+		m_newPos.resize(m_nodes);
+		bool b = CMeshSnapshot::Decompress(m_packed, m_newPos.data(), m_nodes * sizeof(vec3d));
+		assert(b);
+		std::vector<unsigned char>().swap(m_packed);
+		m_nodes = 0;
+	}
+
 	FSMesh* pm = m_po->GetFEMesh();
 	if (pm == nullptr) return;
 
@@ -3290,6 +3348,70 @@ void CCmdChangeFENodes::UnExecute()
 	Execute();
 }
 
+size_t CCmdChangeFENodes::MemoryUsage() const
+{
+	return m_newPos.capacity() * sizeof(vec3d) + m_packed.capacity();
+}
+
+void CCmdChangeFENodes::Compact()
+{
+	if (m_newPos.empty() || !m_packed.empty()) return;
+	if (CMeshSnapshot::Compress(m_newPos.data(), m_newPos.size() * sizeof(vec3d), m_packed))
+	{
+		m_packed.shrink_to_fit();
+		m_nodes = m_newPos.size();
+		std::vector<vec3d>().swap(m_newPos);
+	}
+	else m_packed.clear();
+}
+
+//=============================================================================
+// CCmdRenumberMesh
+//-----------------------------------------------------------------------------
+
+CCmdRenumberMesh::CCmdRenumberMesh(GObject* po, const std::vector<int>& nodeOrder, const std::vector<int>& elemOrder) : CCommand("Renumber mesh")
+{
+	m_po = po;
+	m_nodeOrder = nodeOrder;
+	m_elemOrder = elemOrder;
+}
+
+void CCmdRenumberMesh::Execute()
+{
+	FSMesh* pm = (m_po ? m_po->GetFEMesh() : nullptr);
+	if (pm == nullptr) return;
+
+	if ((m_nodeOrder.size() != pm->Nodes()) || (m_elemOrder.size() != pm->Elements()))
+	{
+		assert(false);
+		return;
+	}
+
+	FSMeshBuilder builder(*pm);
+	builder.RenumberMesh(m_nodeOrder, m_elemOrder);
+
+	// store the inverse permutations, so the next call undoes this one
+	std::vector<int> tmp(m_nodeOrder.size());
+	for (int i = 0; i < (int)m_nodeOrder.size(); ++i) tmp[m_nodeOrder[i]] = i;
+	m_nodeOrder.swap(tmp);
+
+	tmp.resize(m_elemOrder.size());
+	for (int i = 0; i < (int)m_elemOrder.size(); ++i) tmp[m_elemOrder[i]] = i;
+	m_elemOrder.swap(tmp);
+
+	m_po->Update();
+}
+
+void CCmdRenumberMesh::UnExecute()
+{
+	Execute();
+}
+
+size_t CCmdRenumberMesh::MemoryUsage() const
+{
+	return (m_nodeOrder.capacity() + m_elemOrder.capacity()) * sizeof(int);
+}
+
 //=============================================================================
 // CCmdChangeFESurfaceMesh
 //-----------------------------------------------------------------------------
@@ -42,6 +42,7 @@ SOFTWARE.*/
 #include <MeshTools/FESurfaceModifier.h>
 #include <GeomLib/GSurfaceMeshObject.h>
 #include <GLLib/GLCamera.h>
+#include "MeshSnapshot.h"
 
 class CModelDocument;
 class CGLDocument;
@@ -1022,10 +1023,18 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t MemoryUsage() const override;
+	void Compact() override;
+	bool CompactDeletesObjects() const override { return true; }
+
+protected:
+	void RestoreMesh();
+
 protected:
 	GMeshObject*	m_pobj;
 	FSMesh*			m_pold;
 	FSMesh*			m_pnew;
+	CMeshSnapshot	m_snapshot;	// compacted copy of m_pnew
 	int		m_nitem;
 };
 
@@ -1235,9 +1244,14 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t MemoryUsage() const override;
+	void Compact() override;
+	bool CompactDeletesObjects() const override { return true; }
+
 protected:
 	GObject*	m_po;
 	FSMesh*		m_pnew;
+	CMeshSnapshot	m_snapshot;	// compacted copy of m_pnew
 };
 
 class CCmdChangeFENodes : public CCommand
@@ -1248,9 +1262,33 @@ public:
 	void Execute();
 	void UnExecute();
 
+	size_t MemoryUsage() const override;
+	void Compact() override;
+
 protected:
 	GObject* m_po;
 	std::vector<vec3d> m_newPos;
+	std::vector<unsigned char>	m_packed;	// compressed copy of m_newPos
+	size_t	m_nodes;	// nr of positions in m_packed
+};
+
+//-----------------------------------------------------------------------------
+// Renumber the nodes and elements of a mesh (see FSMeshBuilder::RenumberMesh).
+// Undoing applies the inverse permutation.
+class CCmdRenumberMesh : public CCommand
+{
+public:
+	CCmdRenumberMesh(GObject* po, const std::vector<int>& nodeOrder, const std::vector<int>& elemOrder);
+
+	void Execute();
+	void UnExecute();
+
+	size_t MemoryUsage() const override;
+
+protected:
+	GObject* m_po;
+	std::vector<int>	m_nodeOrder;
+	std::vector<int>	m_elemOrder;
 };
 
 //-----------------------------------------------------------------------------
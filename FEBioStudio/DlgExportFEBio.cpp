@@ -75,6 +75,7 @@ public:
 	QCheckBox*	comp;
 	QCheckBox*	hybrid;
 	QCheckBox*	notes;
+	QCheckBox*	binMesh;
 	QCheckBox* pc[16];
 
 public:
@@ -100,12 +101,15 @@ public:
 
 		hybrid = new QCheckBox("Allow degenerate elements");
 
+		binMesh = new QCheckBox("Write mesh to binary file (FEBio Studio only)");
+
 		QVBoxLayout* topLayout = new QVBoxLayout;
 		topLayout->addLayout(formatLayout);
 		topLayout->addWidget(sel);
 		topLayout->addWidget(notes);
 		topLayout->addWidget(comp);
 		topLayout->addWidget(hybrid);
+		topLayout->addWidget(binMesh);
 
 		// extension widget
 		QPushButton* allButton = new QPushButton("All");
@@ -177,6 +181,7 @@ CDlgExportFEBio::CDlgExportFEBio(QWidget* parent) : QDialog(parent), ui(new Ui::
 	m_compress = false;
 	m_bexportSelections = false;
 	m_allowHybrids = false;
+	m_binaryMesh = false;
 	m_writeNotes = true;
 
 	if (m_nindex == -1) m_nindex = 0;
@@ -196,6 +201,7 @@ void CDlgExportFEBio::accept()
 	m_bexportSelections = ui->sel->isChecked();
 	m_writeNotes = ui->notes->isChecked();
 	m_allowHybrids = ui->hybrid->isChecked();
+	m_binaryMesh = ui->binMesh->isChecked();
 
 	m_nsection = 0;
 	for (int i = 0; i < FEBIO_MAX_SECTIONS; ++i)
@@ -61,6 +61,7 @@ public:
 	bool	m_compress;
 	bool	m_writeNotes;
 	bool	m_allowHybrids;
+	bool	m_binaryMesh;
 
 private slots:
 	void OnAllClicked();
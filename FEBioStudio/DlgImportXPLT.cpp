@@ -102,6 +102,7 @@ public:
 	QRadioButton* pb2;
 	QRadioButton* pb3;
 	QRadioButton* pb4;
+	QRadioButton* pb5;
 	QLineEdit* pitems;
 
 public:
@@ -120,6 +121,7 @@ public:
 
 		pv->addWidget(pitems = new QLineEdit);
 		pv->addWidget(new QLabel("(e.g.:1,2,3:6,10:100:5)"));
+		pv->addWidget(pb5 = new QRadioButton("Read states on demand (large files)"));
 
 		QDialogButtonBox* bb = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
 
@@ -144,6 +146,7 @@ void CDlgImportXPLT::accept()
 	if (ui->pb2->isChecked()) m_nop = 1;
 	if (ui->pb3->isChecked()) m_nop = 2;
 	if (ui->pb4->isChecked()) m_nop = 3;
+	if (ui->pb5->isChecked()) m_nop = 5;
 
 	std::string s = ui->pitems->text().toStdString();
 	char buf[256] = {0}; 
@@ -157,6 +157,7 @@ public:
 		addBoolProperty(&m_bcmd , "Clear undo stack on save");
 		addProperty("Recent files list", CProperty::Action)->info = QString("Clear");
 		addIntProperty(&m_autoSaveInterval, "AutoSave Interval (s)");
+		addIntProperty(&m_undoBudget, "Undo memory budget (MB)");
 	}
 
 	void SetPropertyValue(int i, const QVariant& v) override
@@ -178,6 +179,7 @@ public:
 	bool	m_bcmd;
 	int		m_theme;
 	int		m_autoSaveInterval;
+	int		m_undoBudget;
 };
 
 //-----------------------------------------------------------------------------
@@ -1269,6 +1271,7 @@ void CDlgSettings::UpdateSettings()
 	ui->m_ui->m_apply = (view.m_apply == 1);
 	ui->m_ui->m_bcmd = m_pwnd->clearCommandStackOnSave();
 	ui->m_ui->m_autoSaveInterval = m_pwnd->autoSaveInterval();
+	ui->m_ui->m_undoBudget = m_pwnd->undoMemoryBudget();
 
 	ui->m_select->m_bconnect = view.m_bconn;
 	ui->m_select->m_ntagInfo = view.m_ntagInfo;
@@ -1404,6 +1407,7 @@ void CDlgSettings::apply()
 
 	m_pwnd->setClearCommandStackOnSave(ui->m_ui->m_bcmd);
 	m_pwnd->setAutoSaveInterval(ui->m_ui->m_autoSaveInterval);
+	m_pwnd->setUndoMemoryBudget(ui->m_ui->m_undoBudget);
 
 	// update units
 	int newUnit = ui->m_unit->m_unit;
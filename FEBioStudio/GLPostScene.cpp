@@ -218,6 +218,12 @@ void GLPostModelItem::RenderMesh(GLRenderEngine& re, GLMesh& mesh, int surfId)
 	{
 		re.deleteCachedMesh(&mesh);
 		mesh.setModified(false);
+		mesh.setScalarModified(false);
+	}
+	else if (mesh.IsScalarModified())
+	{
+		re.updateCachedMeshScalars(&mesh);
+		mesh.setScalarModified(false);
 	}
 	re.renderGMesh(mesh, surfId, true);
 }
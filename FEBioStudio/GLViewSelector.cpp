@@ -1145,7 +1145,7 @@ void GLViewSelector::SelectFEElements(int x, int y)
 						{
 							Post::FEPostModel* fem = postDoc->GetFSModel();
 							Post::FEState* state = fem->CurrentState();
-							double val = state->m_ELEM[num].m_val;
+							double val = state->m_ELEM.m_val[num];
 							FSElement& el = pm->Element(num);
 							QString txt = QString("Element %1 : %2\n").arg(el.m_nid).arg(val);
 
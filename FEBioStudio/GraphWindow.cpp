@@ -1994,6 +1994,10 @@ void CModelGraphWindow::Update(bool breset, bool bfit)
 		for (int i = 0; i<nsteps; ++i) po->GetDisplacementMap()->UpdateState(i);
 	}
 
+	// the cached time histories are only valid for the current model and its data
+	m_history.SetModel(&fem);
+	if (breset) m_history.Clear();
+
 	// clear data on plots (we don't delete the plots so that we can retain user changes)
 	ClearPlotsData();
 	m_pltCounter = 0;
@@ -2432,6 +2436,14 @@ void CModelGraphWindow::addSelectedNodes()
 
 	// get the selected nodes
 	int NN = mesh.Nodes();
+	vector<int> sel;
+	for (int i = 0; i < NN; i++)
+	{
+		FSNode& node = mesh.Node(i);
+		if (node.IsSelected()) sel.push_back(i);
+	}
+	cacheHistories(Post::FETimeHistoryCache::NODE_ITEM, sel);
+
 	switch (m_xtype)
 	{
 	case 0: // time values
@@ -2441,7 +2453,7 @@ void CModelGraphWindow::addSelectedNodes()
 			FSNode& node = mesh.Node(i);
 			if (node.IsSelected())
 			{
-				for (int j = 0; j<nsteps; j++) xdata[j] = fem.GetState(j + m_firstState)->m_time;
+				for (int j = 0; j<nsteps; j++) xdata[j] = fem.GetTimeValue(j + m_firstState);
 
 				// evaluate y-field
 				TrackNodeHistory(i, &ydata[0], m_dataY, m_firstState, m_lastState);
@@ -2493,13 +2505,6 @@ void CModelGraphWindow::addSelectedNodes()
 	break;
 	case 3: // time-scatter
 	{
-		vector<int> sel;
-		for (int i = 0; i < NN; i++)
-		{
-			FSNode& node = mesh.Node(i);
-			if (node.IsSelected()) sel.push_back(i);
-		}
-
 		if (sel.empty() == false)
 		{
 			int states = fem.GetStates();
@@ -2576,8 +2581,15 @@ void CModelGraphWindow::addSelectedEdges()
 	vector<float> xdata(nsteps);
 	vector<float> ydata(nsteps);
 
-	// get the selected nodes
+	// get the selected edges
 	int NL = mesh.Edges();
+	vector<int> sel;
+	for (int i = 0; i < NL; i++)
+	{
+		if (mesh.Edge(i).IsSelected()) sel.push_back(i);
+	}
+	cacheHistories(Post::FETimeHistoryCache::EDGE_ITEM, sel);
+
 	for (int i = 0; i<NL; i++)
 	{
 		FSEdge& edge = mesh.Edge(i);
@@ -2587,7 +2599,7 @@ void CModelGraphWindow::addSelectedEdges()
 			switch (m_xtype)
 			{
 			case 0:
-				for (int j = 0; j<nsteps; j++) xdata[j] = fem.GetState(j + m_firstState)->m_time;
+				for (int j = 0; j<nsteps; j++) xdata[j] = fem.GetTimeValue(j + m_firstState);
 				break;
 			case 1:
 				for (int j = 0; j<nsteps; j++) xdata[j] = (float)j + 1.f + m_firstState;
@@ -2619,6 +2631,14 @@ void CModelGraphWindow::addSelectedFaces()
 
 	// get the selected faces
 	int NF = mesh.Faces();
+	vector<int> sel;
+	for (int i = 0; i < NF; i++)
+	{
+		FSFace& face = mesh.Face(i);
+		if (face.IsSelected()) sel.push_back(i);
+	}
+	cacheHistories(Post::FETimeHistoryCache::FACE_ITEM, sel);
+
 	switch (m_xtype)
 	{
 	case 0:
@@ -2628,7 +2648,7 @@ void CModelGraphWindow::addSelectedFaces()
 			if (f.IsSelected())
 			{
 				// evaluate x-field
-				for (int j = 0; j < nsteps; j++) xdata[j] = fem.GetState(j + m_firstState)->m_time;
+				for (int j = 0; j < nsteps; j++) xdata[j] = fem.GetTimeValue(j + m_firstState);
 
 				// evaluate y-field
 				TrackFaceHistory(i, &ydata[0], m_dataY, m_firstState, m_lastState);
@@ -2676,13 +2696,6 @@ void CModelGraphWindow::addSelectedFaces()
 		break;
 	case 3:	// time-scatter
 	{
-		vector<int> sel;
-		for (int i = 0; i < NF; i++)
-		{
-			FSFace& face = mesh.Face(i);
-			if (face.IsSelected()) sel.push_back(i);
-		}
-
 		if (sel.empty() == false)
 		{
 			int nsteps = m_lastState - m_firstState + 1;
@@ -2746,6 +2759,14 @@ void CModelGraphWindow::addSelectedElems()
 
 	// get the selected elements
 	int NE = mesh.Elements();
+	vector<int> sel;
+	for (int i = 0; i < NE; i++)
+	{
+		FSElement_& e = mesh.ElementRef(i);
+		if (e.IsSelected()) sel.push_back(i);
+	}
+	cacheHistories(Post::FETimeHistoryCache::ELEM_ITEM, sel);
+
 	switch (m_xtype)
 	{
 	case 0:
@@ -2755,7 +2776,7 @@ void CModelGraphWindow::addSelectedElems()
 			if (e.IsSelected())
 			{
 				// evaluate x-field
-				for (int j = 0; j < nsteps; j++) xdata[j] = fem.GetState(j + m_firstState)->m_time;
+				for (int j = 0; j < nsteps; j++) xdata[j] = fem.GetTimeValue(j + m_firstState);
 
 				// evaluate y-field
 				TrackElementHistory(i, &ydata[0], m_dataY, m_firstState, m_lastState);
@@ -2804,13 +2825,6 @@ void CModelGraphWindow::addSelectedElems()
 		break;
 	case 3:	// time-scatter
 	{
-		vector<int> sel;
-		for (int i = 0; i < NE; i++)
-		{
-			FSElement_& e = mesh.ElementRef(i);
-			if (e.IsSelected()) sel.push_back(i);
-		}
-
 		if (sel.empty() == false)
 		{
 			int ninc = m_incState;
@@ -2863,13 +2877,20 @@ void CModelGraphWindow::addSelectedElems()
 }
 
 //-----------------------------------------------------------------------------
-// Calculate time history of a node
-
-void CModelGraphWindow::TrackNodeHistory(int node, float* pval, int nfield, int nmin, int nmax)
+// Evaluate the time histories of the selected items in one pass, so that the 
+// Track*History functions below only need to look up the values.
+void CModelGraphWindow::cacheHistories(int itemType, const std::vector<int>& items)
 {
-	CPostDocument* doc = GetPostDoc();
-	Post::FEPostModel& fem = *doc->GetFSModel();
+	if (items.empty()) return;
+
+	m_history.Evaluate(itemType, m_dataY, items);
+	if (m_xtype >= 2) m_history.Evaluate(itemType, m_dataX, items);
+}
 
+//-----------------------------------------------------------------------------
+// copy the (cached) time history of an item
+static void copyHistory(Post::FETimeHistoryCache& history, Post::FEPostModel& fem, int itemType, int item, float* pval, int nfield, int nmin, int nmax)
+{
 	int nsteps = fem.GetStates();
 	if (nmin <       0) nmin = 0;
 	if (nmax == -1) nmax = nsteps - 1;
@@ -2877,34 +2898,29 @@ void CModelGraphWindow::TrackNodeHistory(int node, float* pval, int nfield, int
 	if (nmax <    nmin) nmax = nmin;
 	int nn = nmax - nmin + 1;
 
-	Post::NODEDATA nd;
-	for (int n = 0; n<nn; n++)
+	const float* pv = history.GetHistory(itemType, nfield, item);
+	for (int n = 0; n < nn; n++)
 	{
-		fem.EvaluateNode(node, n + nmin, nfield, nd);
-		pval[n] = nd.m_val;
+		pval[n] = (pv ? pv[n + nmin] : 0.f);
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Calculate time history of a node
+void CModelGraphWindow::TrackNodeHistory(int node, float* pval, int nfield, int nmin, int nmax)
+{
+	CPostDocument* doc = GetPostDoc();
+	Post::FEPostModel& fem = *doc->GetFSModel();
+	copyHistory(m_history, fem, Post::FETimeHistoryCache::NODE_ITEM, node, pval, nfield, nmin, nmax);
+}
+
 //-----------------------------------------------------------------------------
 // Calculate time history of a edge
 void CModelGraphWindow::TrackEdgeHistory(int edge, float* pval, int nfield, int nmin, int nmax)
 {
 	CPostDocument* doc = GetPostDoc();
 	Post::FEPostModel& fem = *doc->GetFSModel();
-
-	int nsteps = fem.GetStates();
-	if (nmin <       0) nmin = 0;
-	if (nmax == -1) nmax = nsteps - 1;
-	if (nmax >= nsteps) nmax = nsteps - 1;
-	if (nmax <    nmin) nmax = nmin;
-	int nn = nmax - nmin + 1;
-
-	Post::EDGEDATA nd;
-	for (int n = 0; n<nn; n++)
-	{
-		fem.EvaluateEdge(edge, n + nmin, nfield, nd);
-		pval[n] = nd.m_val;
-	}
+	copyHistory(m_history, fem, Post::FETimeHistoryCache::EDGE_ITEM, edge, pval, nfield, nmin, nmax);
 }
 
 //-----------------------------------------------------------------------------
@@ -2913,20 +2929,7 @@ void CModelGraphWindow::TrackFaceHistory(int nface, float* pval, int nfield, int
 {
 	CPostDocument* doc = GetPostDoc();
 	Post::FEPostModel& fem = *doc->GetFSModel();
-
-	int nsteps = fem.GetStates();
-	if (nmin <       0) nmin = 0;
-	if (nmax == -1) nmax = nsteps - 1;
-	if (nmax >= nsteps) nmax = nsteps - 1;
-	if (nmax <    nmin) nmax = nmin;
-	int nn = nmax - nmin + 1;
-
-	float data[FSFace::MAX_NODES], val;
-	for (int n = 0; n<nn; n++)
-	{
-		fem.EvaluateFace(nface, n + nmin, nfield, data, val);
-		pval[n] = val;
-	}
+	copyHistory(m_history, fem, Post::FETimeHistoryCache::FACE_ITEM, nface, pval, nfield, nmin, nmax);
 }
 
 //-----------------------------------------------------------------------------
@@ -2935,20 +2938,7 @@ void CModelGraphWindow::TrackElementHistory(int nelem, float* pval, int nfield,
 {
 	CPostDocument* doc = GetPostDoc();
 	Post::FEPostModel& fem = *doc->GetFSModel();
-
-	int nsteps = fem.GetStates();
-	if (nmin <       0) nmin = 0;
-	if (nmax == -1) nmax = nsteps - 1;
-	if (nmax >= nsteps) nmax = nsteps - 1;
-	if (nmax <    nmin) nmax = nmin;
-	int nn = nmax - nmin + 1;
-
-	float data[FSElement::MAX_NODES] = { 0.f }, val;
-	for (int n = 0; n<nn; n++)
-	{
-		fem.EvaluateElement(nelem, n + nmin, nfield, data, val);
-		pval[n] = val;
-	}
+	copyHistory(m_history, fem, Post::FETimeHistoryCache::ELEM_ITEM, nelem, pval, nfield, nmin, nmax);
 }
 
 //=====================================================================================
@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include <CUILib/PlotWidget.h>
 #include "Document.h"
 #include <FSCore/LoadCurve.h>
+#include <PostLib/FETimeHistory.h>
 
 class CMainWindow;
 class CGraphWidget;
@@ -434,6 +435,9 @@ private:
 	void TrackNodeHistory(int node, float* pval, int nfield, int nmin = 0, int nmax = -1);
 	void TrackObjectHistory(int nobj, float* pval, int nfield, int nmin = 0, int nmax = -1);
 
+	// evaluate the time histories of a batch of selected items
+	void cacheHistories(int itemType, const std::vector<int>& items);
+
 private:
 	void addSelectedNodes();
 	void addSelectedEdges();
@@ -455,6 +459,9 @@ private: // temporary variables used during update
 	int	m_dataX, m_dataY;				// X and Y data field IDs
 	int	m_dataXPrev, m_dataYPrev;		// Previous X, Y data fields
 	int	m_pltCounter;
+
+private:
+	Post::FETimeHistoryCache	m_history;	// cached time histories of mesh items
 };
 
 //=================================================================================================
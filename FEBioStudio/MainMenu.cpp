@@ -95,6 +95,7 @@ CMainMenu::CMainMenu(CMainWindow* wnd) : m_wnd(wnd)
 	actionCloneGrid = createAction("Clone Grid ...", "actionCloneGrid", "clonegrid");
 	actionCloneRevolve = createAction("Clone Revolve ...", "actionCloneRevolve", "clonerevolve");
 	actionPurge = createAction("Purge ...", "actionPurge");
+	QAction* actionRenumberMesh = createAction("Renumber Mesh ...", "actionRenumberMesh");
 
 	QAction* actionFace2Elems = createAction("Face to Element Selection", "actionFaceToElem");
 	QAction* actionSurfaceToFaces = createAction("Surface to Face Selection", "actionSurfaceToFaces");
@@ -465,6 +466,7 @@ CMainMenu::CMainMenu(CMainWindow* wnd) : m_wnd(wnd)
 	menuEdit->addAction(actionMerge);
 	menuEdit->addAction(actionCopyObject);
 	menuEdit->addAction(actionPasteObject);
+	menuEdit->addAction(actionRenumberMesh);
 	menuEdit->addSeparator();
 	menuEdit->addAction(actionPurge);
 
@@ -67,6 +67,7 @@ SOFTWARE.*/
 #include "Encrypter.h"
 #include "DlgImportXPLT.h"
 #include "Commands.h"
+#include "CommandManager.h"
 #include <XPLTLib/xpltFileReader.h>
 #include <GeomLib/GModel.h>
 #include "DocManager.h"
@@ -261,6 +262,9 @@ CMainWindow::CMainWindow(bool reset, GraphicsAPI api, QWidget* parent) : QMainWi
 		ui->m_autoSaveTimer->start(ui->m_settings.autoSaveInterval * 1000);
 	}
 
+	// set the memory budget of the undo history
+	setUndoMemoryBudget(ui->m_settings.undoMemoryBudget);
+
 	// Auto Update Check
 	if(ui->m_updaterPresent)
 	{
@@ -1881,6 +1885,18 @@ int CMainWindow::autoSaveInterval()
 	return ui->m_settings.autoSaveInterval;
 }
 
+void CMainWindow::setUndoMemoryBudget(int mb)
+{
+	if (mb < 0) mb = 0;
+	ui->m_settings.undoMemoryBudget = mb;
+	CBasicCmdManager::SetMemoryBudget((size_t)mb * 1024 * 1024);
+}
+
+int CMainWindow::undoMemoryBudget()
+{
+	return ui->m_settings.undoMemoryBudget;
+}
+
 QString CMainWindow::GetServerMessage()
 {
     return ui->m_serverMessage;
@@ -1981,6 +1997,7 @@ void CMainWindow::writeSettings()
 		// UI
 		settings.setValue("emulateApply", vs.m_apply);
 		settings.setValue("autoSaveInterval", ui->m_settings.autoSaveInterval);
+		settings.setValue("undoMemoryBudget", ui->m_settings.undoMemoryBudget);
 
 		// Units
 		settings.setValue("defaultUnits", ui->m_settings.defaultUnits);
@@ -2151,6 +2168,8 @@ void CMainWindow::readSettings()
 		vs.m_apply = settings.value("emulateApply", vs.m_apply).toBool();
 		int autoSaveInterval = settings.value("autoSaveInterval", 600).toInt();
 		setAutoSaveInterval(autoSaveInterval);
+		int undoBudget = settings.value("undoMemoryBudget", ui->m_settings.undoMemoryBudget).toInt();
+		setUndoMemoryBudget(undoBudget);
 
 		// Units
 		ui->m_settings.defaultUnits = settings.value("defaultUnits", 0).toInt();
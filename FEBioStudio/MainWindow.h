@@ -211,6 +211,10 @@ public:
 	void setAutoSaveInterval(int interval);
 	int autoSaveInterval();
 
+	// memory budget (in MB) of the undo history
+	void setUndoMemoryBudget(int mb);
+	int undoMemoryBudget();
+
 	// autoUpdate Check
     QString GetServerMessage();
 	bool updaterPresent();
@@ -500,6 +504,7 @@ public slots:
 	void on_actionCloneRevolve_triggered();
 	void on_actionMerge_triggered();
 	void on_actionPurge_triggered();
+	void on_actionRenumberMesh_triggered();
 	void on_actionDetach_triggered();
 	void on_actionExtract_triggered();
 	void on_actionEditProject_triggered();
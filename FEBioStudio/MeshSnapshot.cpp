@@ -0,0 +1,346 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "stdafx.h"
+#include "MeshSnapshot.h"
+#include "version.h"
+#include <MeshLib/FSMesh.h>
+#include <GeomLib/GObject.h>
+#include <FSCore/Archive.h>
+#include <QTemporaryFile>
+#include <QFile>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// signature of the snapshot archives
+const unsigned int SNAPSHOT_SIGNATURE = 0x534E4150; // 'SNAP'
+
+// zlib's stream sizes are 32-bit, so we process large buffers in blocks
+const size_t ZBLOCK = (size_t)1 << 30;
+
+// block size used when streaming an archive from or to a file
+const size_t FBLOCK = (size_t)1 << 16;
+
+// Read a file in blocks and compress it into out. The size of the
+// uncompressed file is returned in nsize.
+static bool CompressFile(QIODevice& file, std::vector<unsigned char>& out, size_t& nsize)
+{
+#ifdef HAVE_ZLIB
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	if (deflateInit(&strm, Z_BEST_SPEED) != Z_OK) return false;
+
+	out.clear();
+	nsize = 0;
+	unsigned char in[FBLOCK];
+	unsigned char buf[FBLOCK];
+	int flush = Z_NO_FLUSH;
+	int ret = Z_OK;
+	do
+	{
+		qint64 nread = file.read((char*)in, (qint64)FBLOCK);
+		if (nread < 0) { deflateEnd(&strm); return false; }
+		nsize += (size_t)nread;
+		flush = (file.atEnd() ? Z_FINISH : Z_NO_FLUSH);
+		strm.next_in = in;
+		strm.avail_in = (uInt)nread;
+		do
+		{
+			strm.next_out = buf;
+			strm.avail_out = sizeof(buf);
+			ret = deflate(&strm, flush);
+			if (ret == Z_STREAM_ERROR) { deflateEnd(&strm); return false; }
+			out.insert(out.end(), buf, buf + (sizeof(buf) - strm.avail_out));
+		} while (strm.avail_out == 0);
+	}
+	while (flush != Z_FINISH);
+	deflateEnd(&strm);
+	return (ret == Z_STREAM_END);
+#else
+	return false;
+#endif
+}
+
+// Decompress in and write it to a file in blocks. nsize is the expected
+// size of the uncompressed data.
+static bool DecompressToFile(const std::vector<unsigned char>& in, size_t nsize, QIODevice& file)
+{
+#ifdef HAVE_ZLIB
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	strm.avail_in = 0;
+	strm.next_in = Z_NULL;
+	if (inflateInit(&strm) != Z_OK) return false;
+
+	const unsigned char* src = in.data();
+	size_t nin = in.size();
+	size_t nout = 0;
+	unsigned char buf[FBLOCK];
+	int ret = Z_OK;
+	while (ret != Z_STREAM_END)
+	{
+		if (strm.avail_in == 0)
+		{
+			if (nin == 0) break;
+			size_t n = (nin < ZBLOCK ? nin : ZBLOCK);
+			strm.next_in = (Bytef*)src;
+			strm.avail_in = (uInt)n;
+			src += n;
+			nin -= n;
+		}
+		strm.next_out = buf;
+		strm.avail_out = sizeof(buf);
+		ret = inflate(&strm, Z_NO_FLUSH);
+		if ((ret != Z_OK) && (ret != Z_STREAM_END)) break;
+		qint64 n = (qint64)(sizeof(buf) - strm.avail_out);
+		if (file.write((const char*)buf, n) != n) { ret = Z_ERRNO; break; }
+		nout += (size_t)n;
+	}
+	inflateEnd(&strm);
+	return (ret == Z_STREAM_END) && (nout == nsize);
+#else
+	return false;
+#endif
+}
+
+CMeshSnapshot::CMeshSnapshot()
+{
+	m_rawSize = 0;
+	m_compressed = false;
+}
+
+void CMeshSnapshot::Clear()
+{
+	std::vector<unsigned char>().swap(m_data);
+	m_rawSize = 0;
+	m_compressed = false;
+}
+
+bool CMeshSnapshot::Create(FSMesh* pm)
+{
+	Clear();
+	if (pm == nullptr) return false;
+
+	// The archive classes work on files, so we write the mesh to a temporary file
+	QTemporaryFile tmp;
+	if (tmp.open() == false) return false;
+	std::string fileName = tmp.fileName().toStdString();
+	tmp.close();
+
+	OArchive ar;
+	if (ar.Create(fileName.c_str(), SNAPSHOT_SIGNATURE) == false) return false;
+	ar.BeginChunk(CID_MESH);
+	{
+		pm->Save(ar);
+	}
+	ar.EndChunk();
+	ar.Close();
+
+	// Compress the file into memory. The file is streamed in blocks, so we
+	// never hold a second uncompressed copy of the archive.
+	QFile file(tmp.fileName());
+	if (file.open(QIODevice::ReadOnly) == false) return false;
+	m_compressed = CompressFile(file, m_data, m_rawSize);
+	if (m_compressed == false)
+	{
+		// store the archive as is
+		file.seek(0);
+		m_data.clear();
+		m_rawSize = (size_t)file.size();
+		m_data.resize(m_rawSize);
+		size_t nread = 0;
+		while (nread < m_rawSize)
+		{
+			qint64 n = file.read((char*)m_data.data() + nread, (qint64)(m_rawSize - nread));
+			if (n <= 0) break;
+			nread += (size_t)n;
+		}
+		if (nread != m_rawSize) { Clear(); return false; }
+	}
+	file.close();
+	if (m_rawSize == 0) { Clear(); return false; }
+	m_data.shrink_to_fit();
+
+	return true;
+}
+
+FSMesh* CMeshSnapshot::Restore(GObject* po)
+{
+	if (m_data.empty()) return nullptr;
+
+	// write the archive to a temporary file so we can read it with an archive
+	QTemporaryFile tmp;
+	if (tmp.open() == false) return nullptr;
+	bool ok = true;
+	if (m_compressed) ok = DecompressToFile(m_data, m_rawSize, tmp);
+	else
+	{
+		size_t nwritten = 0;
+		while (ok && (nwritten < m_data.size()))
+		{
+			size_t n = m_data.size() - nwritten;
+			if (n > ZBLOCK) n = ZBLOCK;
+			ok = (tmp.write((const char*)m_data.data() + nwritten, (qint64)n) == (qint64)n);
+			nwritten += n;
+		}
+	}
+	tmp.close();
+	if (ok == false) return nullptr;
+	std::string fileName = tmp.fileName().toStdString();
+
+	IArchive ar;
+	if (ar.Open(fileName.c_str(), SNAPSHOT_SIGNATURE) == false) return nullptr;
+	ar.SetVersion(SAVE_VERSION);
+
+	FSMesh* pm = nullptr;
+	try {
+		while (ar.OpenChunk() == IArchive::IO_OK)
+		{
+			if (ar.GetChunkID() == CID_MESH)
+			{
+				pm = new FSMesh;
+				pm->SetGObject(po);
+				pm->Load(ar);
+			}
+			ar.CloseChunk();
+		}
+	}
+	catch (...)
+	{
+		delete pm;
+		pm = nullptr;
+	}
+	ar.Close();
+
+	if (pm) Clear();
+
+	return pm;
+}
+
+size_t CMeshSnapshot::MeshMemoryUsage(const FSMesh* pm)
+{
+	if (pm == nullptr) return 0;
+	FSMesh& m = const_cast<FSMesh&>(*pm);
+	size_t mem = sizeof(FSMesh);
+	mem += (size_t)m.Nodes() * sizeof(FSNode);
+	mem += (size_t)m.Elements() * sizeof(FSElement);
+	mem += (size_t)m.Faces() * sizeof(FSFace);
+	mem += (size_t)m.Edges() * sizeof(FSEdge);
+	return mem;
+}
+
+bool CMeshSnapshot::Compress(const void* pd, size_t nsize, std::vector<unsigned char>& out)
+{
+#ifdef HAVE_ZLIB
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	if (deflateInit(&strm, Z_BEST_SPEED) != Z_OK) return false;
+
+	out.clear();
+	out.reserve(nsize / 2);
+	const unsigned char* src = (const unsigned char*)pd;
+	size_t nleft = nsize;
+	unsigned char buf[1 << 16];
+	int ret = Z_OK;
+	do
+	{
+		size_t nin = (nleft < ZBLOCK ? nleft : ZBLOCK);
+		strm.next_in = (Bytef*)src;
+		strm.avail_in = (uInt)nin;
+		src += nin;
+		nleft -= nin;
+		int flush = (nleft == 0 ? Z_FINISH : Z_NO_FLUSH);
+		do
+		{
+			strm.next_out = buf;
+			strm.avail_out = sizeof(buf);
+			ret = deflate(&strm, flush);
+			if (ret == Z_STREAM_ERROR) { deflateEnd(&strm); return false; }
+			out.insert(out.end(), buf, buf + (sizeof(buf) - strm.avail_out));
+		} while (strm.avail_out == 0);
+	}
+	while (nleft > 0);
+	deflateEnd(&strm);
+	return (ret == Z_STREAM_END);
+#else
+	return false;
+#endif
+}
+
+bool CMeshSnapshot::Decompress(const std::vector<unsigned char>& in, void* pd, size_t nsize)
+{
+#ifdef HAVE_ZLIB
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	strm.avail_in = 0;
+	strm.next_in = Z_NULL;
+	strm.avail_out = 0;
+	strm.next_out = Z_NULL;
+	if (inflateInit(&strm) != Z_OK) return false;
+
+	const unsigned char* src = in.data();
+	size_t nin = in.size();
+	unsigned char* dst = (unsigned char*)pd;
+	size_t nout = nsize;
+	int ret = Z_OK;
+	while (ret != Z_STREAM_END)
+	{
+		if (strm.avail_in == 0)
+		{
+			if (nin == 0) break;
+			size_t n = (nin < ZBLOCK ? nin : ZBLOCK);
+			strm.next_in = (Bytef*)src;
+			strm.avail_in = (uInt)n;
+			src += n;
+			nin -= n;
+		}
+		if (strm.avail_out == 0)
+		{
+			if (nout == 0) break;
+			size_t n = (nout < ZBLOCK ? nout : ZBLOCK);
+			strm.next_out = dst;
+			strm.avail_out = (uInt)n;
+			dst += n;
+			nout -= n;
+		}
+		ret = inflate(&strm, Z_NO_FLUSH);
+		if ((ret != Z_OK) && (ret != Z_STREAM_END)) break;
+	}
+	inflateEnd(&strm);
+	return (ret == Z_STREAM_END) && (nout == 0) && (strm.avail_out == 0);
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,70 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include <vector>
+#include <stddef.h>
+
+class FSMesh;
+class GObject;
+
+//-----------------------------------------------------------------------------
+// A compact copy of a mesh that is used by the undo history. The mesh is
+// stored in the same archive format that is used for saving models, and the
+// archive is compressed when zlib is available.
+class CMeshSnapshot
+{
+public:
+	CMeshSnapshot();
+
+	// store the mesh. Returns false if the mesh could not be stored.
+	bool Create(FSMesh* pm);
+
+	// Create a new mesh from the stored data. The mesh will be assigned to the object po.
+	// The stored data is released. Returns nullptr on failure.
+	FSMesh* Restore(GObject* po);
+
+	// is there any data stored
+	bool IsEmpty() const { return m_data.empty(); }
+
+	// size of the stored data (in bytes)
+	size_t Size() const { return m_data.capacity(); }
+
+	// release the stored data
+	void Clear();
+
+public:
+	// estimate of the memory used by a mesh (in bytes)
+	static size_t MeshMemoryUsage(const FSMesh* pm);
+
+	// compress/decompress a buffer. These return false if zlib is not available.
+	static bool Compress(const void* pd, size_t nsize, std::vector<unsigned char>& out);
+	static bool Decompress(const std::vector<unsigned char>& in, void* pd, size_t nsize);
+
+private:
+	std::vector<unsigned char>	m_data;		// stored (compressed) archive
+	size_t						m_rawSize;	// size of uncompressed archive
+	bool						m_compressed;
+};
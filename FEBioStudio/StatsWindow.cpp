@@ -119,7 +119,7 @@ void CStatsWindow::Update(bool breset, bool bfit)
 		{
 			if (pm->ElementRef(i).IsEnabled())
 			{
-				double v = ps->m_ELEM[i].m_val;
+				double v = ps->m_ELEM.m_val[i];
 				data.push_back(v);
 			}
 		}
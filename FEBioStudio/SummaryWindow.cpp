@@ -283,7 +283,7 @@ CSummaryWindow::RANGE CSummaryWindow::EvalElemRange(Post::FEPostModel& fem, int
 
 			for (int j=0; j<ne; ++j)
 			{
-//				float val = state.m_ELEM[i].m_val;
+//				float val = state.m_ELEM.m_val[i];
 				float val = elemData.value(i, j);
 
 				rng.favg += val*w;
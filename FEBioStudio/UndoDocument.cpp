@@ -36,6 +36,11 @@ void ChangeLog::append(const QString& s)
 	m_entry.push_back({ s, current });
 }
 
+void ChangeLog::setLastEntryMemory(size_t bytes)
+{
+	if (m_entry.empty() == false) m_entry.back().mem = bytes;
+}
+
 QString ChangeLog::toJson() const
 {
 	QJsonArray json;
@@ -89,6 +94,17 @@ bool CUndoDocument::CanUndo() { return m_pCmd->CanUndo(); }
 
 bool CUndoDocument::CanRedo() { return m_pCmd->CanRedo(); }
 
+// record the memory that a command keeps in the undo history with its
+// change log entry, so it can be shown in the change log
+static void ReportUndoMemory(CCommand* pcmd, CCommandManager* pcm, ChangeLog& log)
+{
+	size_t mem = pcmd->MemoryUsage();
+	if (mem == 0) return;
+	log.setLastEntryMemory(mem);
+	const double MB = 1024.0 * 1024.0;
+	FSLogger::Write("undo data: %.1lf MB (undo history: %.1lf MB)\n", mem / MB, pcm->MemoryUsage() / MB);
+}
+
 void CUndoDocument::AddCommand(CCommand* pcmd, const std::string& s)
 {
 	assert(pcmd);
@@ -101,6 +117,7 @@ void CUndoDocument::AddCommand(CCommand* pcmd, const std::string& s)
 	FSLogger::Write("Executing command: " + msg + "\n");
 
 	m_pCmd->AddCommand(pcmd);
+	ReportUndoMemory(pcmd, m_pCmd, m_changeLog);
 	if (pcmd->HasFlag(CCommand::MODIFIES_DOC)) SetModifiedFlag();
 	Update();
 }
@@ -121,6 +138,7 @@ bool CUndoDocument::DoCommand(CCommand* pcmd, const std::string& s)
 	FSLogger::Write("Executing command: " + msg + "\n");
 
 	bool ret = m_pCmd->DoCommand(pcmd);
+	if (ret) ReportUndoMemory(pcmd, m_pCmd, m_changeLog);
 	if (ret && pcmd->HasFlag(CCommand::MODIFIES_DOC))
 	{
 		SetModifiedFlag();
@@ -134,6 +152,11 @@ const std::string& CUndoDocument::GetCommandErrorString() const
 	return m_pCmd->GetErrorString();
 }
 
+size_t CUndoDocument::GetUndoMemoryUsage() const
+{
+	return m_pCmd->MemoryUsage();
+}
+
 void CUndoDocument::UndoCommand()
 {
 	string cmdName = m_pCmd->GetUndoCmdName();
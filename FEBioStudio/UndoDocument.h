@@ -36,6 +36,7 @@ public:
 	public:
 		QString txt;
 		QDateTime time;
+		size_t mem = 0;	// memory (in bytes) the command added to the undo history
 	};
 
 public:
@@ -44,6 +45,9 @@ public:
 
 	void append(const QString& s);
 
+	// set the undo memory of the last entry
+	void setLastEntryMemory(size_t bytes);
+
 public:
 	QString toJson() const;
 
@@ -76,6 +80,9 @@ public:
 	void ClearCommandStack();
 	const std::string& GetCommandErrorString() const;
 
+	// the memory (in bytes) held by the undo history
+	size_t GetUndoMemoryUsage() const;
+
 public:
 	//! Get the change log
 	const ChangeLog& GetChangeLog();
@@ -54,6 +54,7 @@ SOFTWARE.*/
 #include <PostGL/GLModel.h>
 #include <MeshTools/FEMeshOverlap.h>
 #include <MeshLib/FSFindElement.h>
+#include <MeshLib/FSMeshRenumber.h>
 #include "TextDocument.h"
 #include <GLLib/GLScene.h>
 #include <sstream>
@@ -164,6 +165,7 @@ void CMainWindow::on_actionChangeLog_triggered()
 	const ChangeLog& log = doc->GetChangeLog();
 	int n = log.size();
 	int m = (int) log10(n) + 1;
+	const double MB = 1024.0 * 1024.0;
 	for (int i = 0; i < n; ++i)
 	{
 		const ChangeLog::Entry& v = log.entry(i);
@@ -171,11 +173,13 @@ void CMainWindow::on_actionChangeLog_triggered()
 		line += QString("%1: (").arg(i + 1, m);
 		line += v.time.toString() + ") ";
 		line += v.txt;
+		if (v.mem > 0) line += QString(" [undo data: %1 MB]").arg(v.mem / MB, 0, 'f', 1);
 		txt.push_back(line);
 	}
 
 	CDlgChangeLog dlg(this);
 	dlg.SetText(QString::fromStdString(doc->GetDocFileName()), txt);
+	dlg.setWindowTitle(dlg.windowTitle() + QString(" - undo history: %1 MB").arg(doc->GetUndoMemoryUsage() / MB, 0, 'f', 1));
 	if (dlg.exec())
 	{
 		// this assumes the "Save" button was pressed
@@ -1625,6 +1629,41 @@ void CMainWindow::on_actionPurge_triggered()
 	}
 }
 
+void CMainWindow::on_actionRenumberMesh_triggered()
+{
+	CModelDocument* doc = dynamic_cast<CModelDocument*>(GetDocument());
+	if (doc == nullptr) return;
+
+	GMeshObject* po = dynamic_cast<GMeshObject*>(doc->GetActiveObject());
+	FSMesh* pm = (po ? po->GetFEMesh() : nullptr);
+	if (pm == nullptr)
+	{
+		QMessageBox::critical(this, "Renumber Mesh", "Please select an editable mesh object.");
+		return;
+	}
+
+	QStringList methods;
+	methods << "Reverse Cuthill-McKee" << "Morton curve";
+	bool ok = false;
+	QString method = QInputDialog::getItem(this, "Renumber Mesh", "Method:", methods, 0, false, &ok);
+	if ((ok == false) || method.isEmpty()) return;
+
+	MeshTools::MeshLocality before = MeshTools::EvaluateLocality(*pm);
+
+	std::vector<int> nodeOrder, elemOrder;
+	MeshTools::CalculateRenumbering(*pm, methods.indexOf(method), nodeOrder, elemOrder);
+	if (!doc->DoCommand(new CCmdRenumberMesh(po, nodeOrder, elemOrder), po->GetName())) return;
+
+	MeshTools::MeshLocality after = MeshTools::EvaluateLocality(*pm);
+	AddLogEntry(QString("%1: renumbered mesh (%2)\n").arg(QString::fromStdString(po->GetName())).arg(method));
+	AddLogEntry(QString("  average element node span : %1 -> %2\n").arg(before.nodeSpan).arg(after.nodeSpan));
+	AddLogEntry(QString("  bandwidth                 : %1 -> %2\n").arg(before.bandwidth).arg(after.bandwidth));
+	AddLogEntry(QString("  average neighbor distance : %1 -> %2\n").arg(before.neighborGap).arg(after.neighborGap));
+
+	UpdateModel();
+	RedrawGL();
+}
+
 void CMainWindow::on_actionFaceToElem_triggered()
 {
 	CGLDocument* doc = dynamic_cast<CGLDocument*>(GetDocument());
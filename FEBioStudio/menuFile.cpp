@@ -1006,7 +1006,7 @@ void CMainWindow::SavePostDoc()
 		<< "LSDYNA Keyword (*.k)"
 		<< "BYU files(*.byu)"
 		<< "NIKE3D files (*.n)"
-		<< "VTK files (*.vtk)"
+		<< "VTK files (*.vtk *.vtu)"
 		<< "LSDYNA database (*.d3plot)"
 		<< "Abaqus files (*.inp)";
 
@@ -1596,6 +1596,7 @@ void CMainWindow::on_actionExportFEModel_triggered()
 						writer.SetExportSelectionsFlag(dlg.m_bexportSelections);
 						writer.SetWriteNotesFlag(dlg.m_writeNotes);
 						writer.SetMixedMeshFlag(dlg.m_allowHybrids);
+						writer.SetBinaryMeshFlag(dlg.m_binaryMesh);
 						writer.SetSectionFlags(dlg.m_nsection);
 						bsuccess = writer.Write(szfile);
 						if (bsuccess == false) errMsg = QString::fromStdString(writer.GetErrorMessage());
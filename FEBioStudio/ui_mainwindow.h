@@ -229,6 +229,7 @@ struct FBS_SETTINGS
 {
 	int		defaultUnits;	// default units used for new model and post documents
 	int		autoSaveInterval; // interval (in seconds) between autosaves
+	int		undoMemoryBudget; // max memory (in MB) used by the undo history (0 = no limit)
 
 	bool	loadFEBioConfigFile;	// load the FEBio config file on startup
 	QString	febioConfigFileName;	// the path to the default FEBio config file
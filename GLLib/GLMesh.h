@@ -114,6 +114,9 @@ public:
 
 	bool IsModified() const { return m_isModified; }
 
+	// returns true if only the first texture coordinate of the face nodes was modified
+	bool IsScalarModified() const { return m_isScalarModified; }
+
 	int Nodes() const { return (int) m_Node.size(); }
 	int Edges() const { return (int)m_Edge.size(); }
 	int Faces() const { return (int)m_Face.size(); }
@@ -188,6 +191,10 @@ public:
 
 	void setModified(bool b) { m_isModified = b; }
 
+	// Use this instead of setModified when only the first texture coordinate of the 
+	// face nodes changed. Render engines can then update just those values. 
+	void setScalarModified(bool b) { m_isScalarModified = b; }
+
 	unsigned int GetUID() const { return m_uid; }
 
 private:
@@ -205,6 +212,7 @@ private:
 	vector<EDGE_PARTITION>		m_EIL;
 
 	bool m_isModified = false;
+	bool m_isScalarModified = false;
 	bool m_hasNeighborList = false;
 
 	unsigned int m_uid; // unique ID
@@ -82,6 +82,9 @@ public:
 
 public:
 	virtual void deleteCachedMesh(GLMesh* gm) {}
+
+	// update the scalars (i.e. first texture coordinate) of a cached mesh
+	virtual void updateCachedMeshScalars(GLMesh* gm) {}
 	 
 public:
 	virtual void viewport(int vp[4]) {}
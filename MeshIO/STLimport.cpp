@@ -23,47 +23,280 @@ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
 LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
-
 #include "STLimport.h"
 #include <GeomLib/GSurfaceMeshObject.h>
 #include <GeomLib/GModel.h>
+#include <algorithm>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <omp.h>
+
+#ifdef WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 //-----------------------------------------------------------------------------
-STLimport::STLimport(FSProject& prj) : FSFileImport(prj)
+// Provides read access to the entire contents of an open file. The file is
+// memory-mapped when possible, otherwise it is read into a buffer.
+class STLFileData
+{
+public:
+	STLFileData() : m_data(nullptr), m_size(0)
+	{
+#ifdef WIN32
+		m_hmap = NULL;
+#else
+		m_map = nullptr;
+#endif
+	}
+	~STLFileData() { Release(); }
+
+	bool Load(FILE* fp);
+	void Release();
+
+	const char* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+private:
+	const char*			m_data;
+	size_t				m_size;
+	std::vector<char>	m_buf;	// only used when the file could not be mapped
+#ifdef WIN32
+	HANDLE				m_hmap;
+#else
+	void*				m_map;
+#endif
+};
+
+bool STLFileData::Load(FILE* fp)
 {
+	Release();
+	if (fp == nullptr) return false;
+
+#ifdef WIN32
+	HANDLE hfile = (HANDLE)_get_osfhandle(_fileno(fp));
+	LARGE_INTEGER size;
+	if ((hfile != INVALID_HANDLE_VALUE) && GetFileSizeEx(hfile, &size) && (size.QuadPart > 0))
+	{
+		m_hmap = CreateFileMapping(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_hmap != NULL)
+		{
+			void* p = MapViewOfFile(m_hmap, FILE_MAP_READ, 0, 0, 0);
+			if (p)
+			{
+				m_data = (const char*)p;
+				m_size = (size_t)size.QuadPart;
+				return true;
+			}
+			CloseHandle(m_hmap);
+			m_hmap = NULL;
+		}
+	}
+#else
+	int fd = fileno(fp);
+	struct stat st;
+	if ((fstat(fd, &st) == 0) && (st.st_size > 0))
+	{
+		void* p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED)
+		{
+			madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+			m_map = p;
+			m_data = (const char*)p;
+			m_size = (size_t)st.st_size;
+			return true;
+		}
+	}
+#endif
+
+	// mapping failed, so just read the file
+	rewind(fp);
+	char tmp[65536];
+	size_t nread = 0;
+	while ((nread = fread(tmp, 1, sizeof(tmp), fp)) > 0) m_buf.insert(m_buf.end(), tmp, tmp + nread);
+	m_data = m_buf.data();
+	m_size = m_buf.size();
+	return (m_size > 0);
 }
 
-//-----------------------------------------------------------------------------
-STLimport::~STLimport(void)
+void STLFileData::Release()
 {
+#ifdef WIN32
+	if (m_hmap)
+	{
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_hmap);
+		m_hmap = NULL;
+	}
+#else
+	if (m_map)
+	{
+		munmap(m_map, m_size);
+		m_map = nullptr;
+	}
+#endif
+	std::vector<char>().swap(m_buf);
+	m_data = nullptr;
+	m_size = 0;
 }
 
 //-----------------------------------------------------------------------------
-// read a line from the input file
-bool STLimport::read_line(char* szline, const char* sz)
+// helper functions for parsing ASCII STL data
+
+// skip white space (this also skips stray non-ASCII characters)
+static const char* skip_space(const char* p, const char* end)
 {
-	m_nline++;
+	while ((p < end) && ((*p < 0) || isspace((unsigned char)*p))) ++p;
+	return p;
+}
 
-	int l = (int)strlen(sz);
-	if (fgets(szline, 255, m_fp) == 0) return false;
+// find the start of the next line
+static const char* next_line(const char* p, const char* end)
+{
+	while ((p < end) && (*p != '\n')) ++p;
+	return (p < end ? p + 1 : end);
+}
 
-	// remove leading white space
-	// We also check for negative ASCII values. This can happen
-	// if this turns out to be a binary STL file after all.
-	int n = 0;
-	while ((szline[n] < 0) || (isspace(szline[n]))) ++n;
-	if (n != 0)
+// see if the text at p starts with sz
+static bool starts_with(const char* p, const char* end, const char* sz)
+{
+	size_t l = strlen(sz);
+	return (((size_t)(end - p) >= l) && (strncmp(p, sz, l) == 0));
+}
+
+// Find the first line at or after p that starts a new facet
+static const char* find_facet(const char* p, const char* end)
+{
+	p = next_line(p, end);
+	while (p < end)
 	{
-		char* ch = szline + n;
-		n = 0;
-		while (*ch) szline[n++] = *ch++;
+		const char* s = skip_space(p, end);
+		if (starts_with(s, end, "facet")) return s;
+		p = next_line(s, end);
 	}
-	
-	if (strncmp(szline, sz, l) != 0) return false;
+	return end;
+}
 
+// read the coordinates of a vertex line
+static bool read_vertex(const char* p, const char* end, float* v)
+{
+	if (starts_with(p, end, "vertex ") == false) return false;
+
+	// copy the line, so the number parser cannot run past the end of the data
+	char szline[256];
+	int n = 0;
+	while ((p + n < end) && (p[n] != '\n') && (n < 255)) { szline[n] = p[n]; n++; }
+	szline[n] = 0;
+
+	char* ch = szline + 7;
+	for (int i = 0; i < 3; ++i) v[i] = strtof(ch, &ch);
 	return true;
 }
 
+// facets parsed by one thread
+struct STL_CHUNK
+{
+	std::vector<float>	vert;		// vertex coordinates
+	const char*			err;		// location of error (or null)
+	bool				bend;		// endsolid was found
+};
+
+// Parse the facets that start in [p, p1). The last facet may extend beyond p1.
+static void parse_chunk(const char* p, const char* p1, const char* end, STL_CHUNK& c)
+{
+	c.err = nullptr;
+	c.bend = false;
+
+	float v[9];
+	while (true)
+	{
+		p = skip_space(p, end);
+		if (p >= p1) break;
+
+		// check for the endsolid tag
+		if (starts_with(p, end, "endsolid")) { c.bend = true; break; }
+
+		// read the facet line
+		if (starts_with(p, end, "facet normal") == false) { c.err = p; break; }
+
+		// read the outer loop line
+		p = skip_space(next_line(p, end), end);
+		if (starts_with(p, end, "outer loop") == false) { c.err = p; break; }
+
+		// read the vertex data
+		bool bok = true;
+		for (int i = 0; i < 3; ++i)
+		{
+			p = skip_space(next_line(p, end), end);
+			if (read_vertex(p, end, v + 3 * i) == false) { bok = false; break; }
+		}
+		if (bok == false) { c.err = p; break; }
+
+		// read the endloop tag
+		p = skip_space(next_line(p, end), end);
+		if (starts_with(p, end, "endloop") == false) { c.err = p; break; }
+
+		// read the endfacet tag
+		p = skip_space(next_line(p, end), end);
+		if (starts_with(p, end, "endfacet") == false) { c.err = p; break; }
+		p = next_line(p, end);
+
+		// add the facet
+		c.vert.insert(c.vert.end(), v, v + 9);
+	}
+}
+
+// Sort the array in parallel. The comparison must define a strict total order,
+// so that the result does not depend on the number of threads.
+template <class Less> static void parallel_sort(std::vector<int>& v, Less less)
+{
+	int n = (int)v.size();
+	int nt = omp_get_max_threads();
+	if ((nt <= 1) || (n < 100000))
+	{
+		std::sort(v.begin(), v.end(), less);
+		return;
+	}
+
+	// sort equal chunks
+	std::vector<int> off(nt + 1);
+	for (int k = 0; k <= nt; ++k) off[k] = (int)(((long long)n * k) / nt);
+#pragma omp parallel for schedule(static, 1)
+	for (int k = 0; k < nt; ++k) std::sort(v.begin() + off[k], v.begin() + off[k + 1], less);
+
+	// merge pairs of sorted chunks until only one is left
+	std::vector<int> tmp(n);
+	for (int w = 1; w < nt; w *= 2)
+	{
+#pragma omp parallel for schedule(dynamic)
+		for (int k = 0; k < nt; k += 2 * w)
+		{
+			int a = off[k];
+			int m = off[std::min(k + w, nt)];
+			int b = off[std::min(k + 2 * w, nt)];
+			std::merge(v.begin() + a, v.begin() + m, v.begin() + m, v.begin() + b, tmp.begin() + a, less);
+		}
+		v.swap(tmp);
+	}
+}
+
+//-----------------------------------------------------------------------------
+STLimport::STLimport(FSProject& prj) : FSFileImport(prj)
+{
+	m_pfem = nullptr;
+	m_tol = 1e-7;
+}
+
+//-----------------------------------------------------------------------------
+STLimport::~STLimport(void)
+{
+}
+
 //-----------------------------------------------------------------------------
 // Load an STL model
 bool STLimport::Load(const char* szfile)
@@ -71,23 +304,46 @@ bool STLimport::Load(const char* szfile)
 	FSModel& fem = m_prj.GetFSModel();
 	m_pfem = &fem;
 
-	// try to read ascii STL
-	if (read_ascii(szfile) == false)
+	// try to open the file
+	if (Open(szfile, "rb") == false) return errf("Failed opening file %s.", szfile);
+
+	STLFileData file;
+	if (file.Load(FilePtr()) == false) { Close(); return errf("Failed reading file %s.", szfile); }
+	const char* buf = file.Data();
+	size_t size = file.Size();
+
+	// A binary file has an 80 byte header, followed by the number of triangles
+	// and 50 bytes per triangle. ASCII files start with "solid", but so do some
+	// binary files, so we check the file size first.
+	bool bbinary = false;
+	if (size >= 84)
 	{
-		// try to read binary STL
-		if (read_binary(szfile) == false)
-		{
-			return false;
-		}
+		uint32_t numtri = 0;
+		memcpy(&numtri, buf + 80, sizeof(numtri));
+		bbinary = (84 + 50 * (uint64_t)numtri == size);
 	}
+	const char* p = skip_space(buf, buf + size);
+	bool bascii = starts_with(p, buf + size, "solid");
+
+	bool bok = false;
+	if (bbinary || !bascii) bok = read_binary(buf, size);
+	else
+	{
+		// try to read ascii STL, and binary STL if that fails
+		bok = read_ascii(buf, size);
+		if (bok == false) bok = read_binary(buf, size);
+	}
+
+	file.Release();
+	Close();
+	if (bok == false) return false;
+
+	if (m_vert.empty()) return errf("No triangles found.");
 
 	// build the nodes
 	GObject* po = build_mesh();
+	m_vert.clear();
 
-//	static int nc = 1;
-//	char sz[256];
-//	sprintf(sz, "STL-Object%02d", nc++);
-//	po->SetName(sz);
 	const char* szname = strrchr(szfile, '/');
 	if (szname == nullptr)
 	{
@@ -104,116 +360,225 @@ bool STLimport::Load(const char* szfile)
 }
 
 //-----------------------------------------------------------------------------
-bool STLimport::read_ascii(const char* szfile)
+// Read ASCII STL data. The facets are parsed in parallel chunks, which start
+// at facet boundaries.
+bool STLimport::read_ascii(const char* buf, size_t size)
 {
-	m_nline = 0;
+	m_vert.clear();
 
-	// try to open the file
-	if (Open(szfile, "rt") == false) return errf("Failed opening file %s.", szfile);
+	const char* end = buf + size;
 
-	// read the first line
-	char szline[256] = { 0 };
-	if (read_line(szline, "solid") == false) return errf("First line must be solid definition.");
+	// the first line must be the solid definition
+	const char* p = skip_space(buf, end);
+	if (starts_with(p, end, "solid") == false) return errf("First line must be solid definition.");
 
-	// clear the list
-	m_Face.clear();
+	// divide the data into chunks of approximately equal size
+	int nc = omp_get_max_threads();
+	if (size < (1 << 20)) nc = 1;
+	std::vector<const char*> start(nc + 1);
+	start[0] = find_facet(p, end);
+	for (int i = 1; i < nc; ++i)
+	{
+		const char* pi = buf + (size * i) / nc;
+		if (pi < start[i - 1]) pi = start[i - 1];
+		start[i] = (pi < end ? find_facet(pi, end) : end);
+	}
+	start[nc] = end;
 
-	// read all the triangles
-	int nc = 0;
-	FACET face;
-	do
+	std::vector<STL_CHUNK> chunk(nc);
+#pragma omp parallel for schedule(static, 1)
+	for (int i = 0; i < nc; ++i)
 	{
-		// read the facet line
-		if (read_line(szline, "facet normal") == false)
+		parse_chunk(start[i], start[i + 1], end, chunk[i]);
+	}
+
+	// collect the facets up to the endsolid tag
+	size_t nsize = 0;
+	for (int i = 0; i < nc; ++i)
+	{
+		STL_CHUNK& c = chunk[i];
+		if (c.err)
 		{
-			// check for the endsolid tag
-			if (strncmp(szline, "endsolid", 8) == 0) break;
-			else return errf("Error encountered at line %d", m_nline);
+			int nline = 1 + (int)std::count(buf, c.err, '\n');
+			return errf("Error encountered at line %d", nline);
 		}
+		nsize += c.vert.size();
+		if (c.bend) { nc = i + 1; break; }
+	}
 
-		// read the outer loop line
-		if (read_line(szline, "outer loop") == false) return errf("Error encountered at line %d", m_nline);
-
-		// read the vertex data
-		float x, y, z;
-		if (read_line(szline, "vertex ") == false) return errf("Error encountered at line %d", m_nline);
-		sscanf(szline, "vertex %g%g%g", &x, &y, &z);
-		face.v1[0] = x;	face.v1[1] = y; face.v1[2] = z;
-
-		if (read_line(szline, "vertex ") == false) return errf("Error encountered at line %d", m_nline);
-		sscanf(szline, "vertex %g%g%g", &x, &y, &z);
-		face.v2[0] = x;	face.v2[1] = y; face.v2[2] = z;
-
-		if (read_line(szline, "vertex ") == false) return errf("Error encountered at line %d", m_nline);
-		sscanf(szline, "vertex %g%g%g", &x, &y, &z);
-		face.v3[0] = x;	face.v3[1] = y; face.v3[2] = z;
-
-		// read the endloop tag
-		if (read_line(szline, "endloop") == false) return errf("Error encountered at line %d", m_nline);
-
-		// read the endfacet tag
-		if (read_line(szline, "endfacet") == false) return errf("Error encountered at line %d", m_nline);
-
-		// add the facet to the list
-		m_Face.push_back(face);
-	} while (1);
-
-	// close the file
-	Close();
+	m_vert.reserve(nsize);
+	for (int i = 0; i < nc; ++i)
+	{
+		m_vert.insert(m_vert.end(), chunk[i].vert.begin(), chunk[i].vert.end());
+		std::vector<float>().swap(chunk[i].vert);
+	}
 
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-// read a line from the input file
-bool STLimport::read_facet(STLimport::FACET& f)
+// Read binary STL data
+bool STLimport::read_binary(const char* buf, size_t size)
 {
-	unsigned short att;
-	if (fread(f.norm, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(f.v1, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(f.v2, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(f.v3, sizeof(float), 3, m_fp) != 3) return false;
-	if (fread(&att, sizeof(att), 1, m_fp) != 1) return false;
-	return true;
-}
-
-//-----------------------------------------------------------------------------
-// Load an STL model
-bool STLimport::read_binary(const char* szfile)
-{
-	FSModel& fem = m_prj.GetFSModel();
-	m_pfem = &fem;
-
-	// try to open the file
-	if (Open(szfile, "rb") == false) return errf("Failed opening file %s.", szfile);
+	m_vert.clear();
 
 	// read the header
-	char szbuf[80] = { 0 };
-	if (fread(szbuf, 80, 1, m_fp) != 1) return errf("Failed reading header.");
-
-	// clear the list
-	m_Face.clear();
+	if (size < 80) return errf("Failed reading header.");
 
 	// read the number of triangles
 	int numtri = 0;
-	fread(&numtri, sizeof(int), 1, m_fp);
+	if (size >= 84) memcpy(&numtri, buf + 80, sizeof(int));
 	if (numtri <= 0) return errf("Invalid number of triangles.");
+	if (84 + 50 * (uint64_t)numtri > size) return errf("Error encountered reading triangle data.");
 
-	// read all the triangles
-	FACET face;
+	// Each triangle stores the normal, three vertices, and a 2-byte attribute.
+	// We only need the vertices.
+	m_vert.resize(9 * (size_t)numtri);
+	const char* pd = buf + 84;
+#pragma omp parallel for
 	for (int i = 0; i < numtri; ++i)
 	{
-		// read the facet line
-		if (read_facet(face) == false) return errf("Error encountered reading triangle data.");
+		memcpy(&m_vert[9 * (size_t)i], pd + 50 * (size_t)i + 12, 9 * sizeof(float));
+	}
 
-		// add the facet to the list
-		m_Face.push_back(face);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Merge vertices that are closer than the weld tolerance. A vertex is merged with
+// the first vertex before it (in facet order) that is not merged itself and is
+// within the tolerance. Vertices are sorted into a grid with the tolerance as its
+// spacing, so only the vertex's own cell and the 26 cells around it need to be
+// searched. Nodes are numbered in the order in which they first appear in the
+// facet list.
+void STLimport::weld_vertices(std::vector<vec3d>& nodes, std::vector<int>& tri)
+{
+	int NV = (int)m_vert.size() / 3;
+	const float* v = m_vert.data();
+
+	BoundingBox& b = m_box;
+	vec3d r0 = b.r0();
+	double h = m_tol;
+	double W = b.GetMaxExtent();
+	if (h < 1e-15 * W) h = 1e-15 * W;
+	if (h <= 0.0) h = 1.0;
+
+	// find the cell of each vertex
+	std::vector<int64_t> cell(3 * (size_t)NV);
+#pragma omp parallel for
+	for (int i = 0; i < NV; ++i)
+	{
+		cell[3 * (size_t)i    ] = (int64_t)floor((v[3 * (size_t)i    ] - r0.x) / h);
+		cell[3 * (size_t)i + 1] = (int64_t)floor((v[3 * (size_t)i + 1] - r0.y) / h);
+		cell[3 * (size_t)i + 2] = (int64_t)floor((v[3 * (size_t)i + 2] - r0.z) / h);
 	}
 
-	// close the file
-	Close();
+	// sort the vertices by cell (and by index within a cell)
+	std::vector<int> idx(NV);
+	for (int i = 0; i < NV; ++i) idx[i] = i;
+	const int64_t* c = cell.data();
+	auto cellLess = [](const int64_t* a, const int64_t* b) {
+		if (a[0] != b[0]) return a[0] < b[0];
+		if (a[1] != b[1]) return a[1] < b[1];
+		return a[2] < b[2];
+	};
+	parallel_sort(idx, [c, cellLess](int i, int j) {
+		const int64_t* a = c + 3 * (size_t)i;
+		const int64_t* b = c + 3 * (size_t)j;
+		if (cellLess(a, b)) return true;
+		if (cellLess(b, a)) return false;
+		return i < j;
+	});
+
+	// find the runs of vertices in the same cell
+	std::vector<int> run;
+	run.push_back(0);
+	for (int i = 1; i < NV; ++i)
+	{
+		const int64_t* a = c + 3 * (size_t)idx[i - 1];
+		const int64_t* b = c + 3 * (size_t)idx[i];
+		if ((a[0] != b[0]) || (a[1] != b[1]) || (a[2] != b[2])) run.push_back(i);
+	}
+	run.push_back(NV);
+	int NR = (int)run.size() - 1;
+
+	// Find the first vertex j in [j0, i) that is within the tolerance of vertex i
+	// and is accepted by the filter. The runs are sorted by cell, so the neighboring
+	// cells are found by bisection, and each run is sorted by vertex index.
+	const double tol2 = m_tol * m_tol;
+	auto findFirst = [&](int i, int j0, auto accept) {
+		const float* ri = v + 3 * (size_t)i;
+		const int64_t* ci = c + 3 * (size_t)i;
+		int jmin = i;
+		for (int dx = -1; dx <= 1; ++dx)
+			for (int dy = -1; dy <= 1; ++dy)
+				for (int dz = -1; dz <= 1; ++dz)
+				{
+					int64_t cn[3] = { ci[0] + dx, ci[1] + dy, ci[2] + dz };
+					int lo = 0, hi = NR;
+					while (lo < hi)
+					{
+						int m = (lo + hi) / 2;
+						if (cellLess(c + 3 * (size_t)idx[run[m]], cn)) lo = m + 1; else hi = m;
+					}
+					if ((lo == NR) || cellLess(cn, c + 3 * (size_t)idx[run[lo]])) continue;
+
+					for (int k = run[lo]; k < run[lo + 1]; ++k)
+					{
+						int j = idx[k];
+						if (j < j0) continue;
+						if (j >= jmin) break;
+						if (!accept(j)) continue;
+						const float* rj = v + 3 * (size_t)j;
+						double ex = (double)ri[0] - (double)rj[0];
+						double ey = (double)ri[1] - (double)rj[1];
+						double ez = (double)ri[2] - (double)rj[2];
+						if (ex*ex + ey*ey + ez*ez < tol2) { jmin = j; break; }
+					}
+				}
+		return (jmin < i ? jmin : -1);
+	};
+
+	// for each vertex, find the first vertex before it that is within the tolerance
+	std::vector<int> first(NV);
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < NV; ++i)
+	{
+		first[i] = findFirst(i, 0, [](int) { return true; });
+	}
 
-	return true;
+	// Assign the representatives in facet order. The first vertex within the 
+	// tolerance is usually a representative itself. Only when it was merged with 
+	// another vertex do we need to search for the next candidate.
+	std::vector<int> rep(NV);
+	for (int i = 0; i < NV; ++i)
+	{
+		int j = first[i];
+		if ((j >= 0) && (rep[j] != j)) j = findFirst(i, j + 1, [&](int k) { return rep[k] == k; });
+		rep[i] = (j < 0 ? i : j);
+	}
+	std::vector<int64_t>().swap(cell);
+	std::vector<int>().swap(first);
+	std::vector<int>().swap(idx);
+
+	// number the nodes (representatives always come before the vertices they represent)
+	tri.resize(NV);
+	int NN = 0;
+	for (int i = 0; i < NV; ++i)
+	{
+		tri[i] = (rep[i] == i ? NN++ : tri[rep[i]]);
+	}
+
+	nodes.resize(NN);
+#pragma omp parallel for
+	for (int i = 0; i < NV; ++i)
+	{
+		if (rep[i] == i)
+		{
+			const float* ri = v + 3 * (size_t)i;
+			nodes[tri[i]] = vec3d(ri[0], ri[1], ri[2]);
+		}
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -221,78 +586,39 @@ bool STLimport::read_binary(const char* szfile)
 GObject* STLimport::build_mesh()
 {
 	// number of facets
-	int NF = (int)m_Face.size();
+	int NF = (int)(m_vert.size() / 9);
 
 	// find the bounding box of the model
-	BoundingBox& b = m_box = GetBoundingBox();
-	double h = 0.01*b.GetMaxExtent();
-	b.Inflate(h,h,h);
-	vec3d r0(b.x0, b.y0, b.z0);
-	vec3d r1(b.x1, b.y1, b.z1);
-
-	// create the box partition
-	int NB = m_NB = (int) pow((double) (NF*3), 0.25) + 1;
-	if (NB < 1) NB = 1;
-	if (NB > 50) NB = 50;
-	m_BL.resize(NB*NB*NB);
-	int n = 0;
-	for (int i=0; i<NB; ++i)
-		for (int j=0; j<NB; ++j)
-			for (int k=0; k<NB; ++k)
-			{
-				OBOX& bn = m_BL[n++];
-				bn.r0.x = r0.x + i*(r1.x - r0.x)/NB;
-				bn.r0.y = r0.x + j*(r1.x - r0.x)/NB;
-				bn.r0.z = r0.x + k*(r1.x - r0.x)/NB;
-
-				bn.r1.x = r0.x + (i+1)*(r1.x - r0.x)/NB;
-				bn.r1.y = r0.x + (j+1)*(r1.x - r0.x)/NB;
-				bn.r1.z = r0.x + (k+1)*(r1.x - r0.x)/NB;
-			}
+	m_box = GetBoundingBox();
 
-	// reserve space for nodes
-	m_Node.reserve(NF*3);
-	
-	// create the nodes
-	std::list<FACET>::iterator pf = m_Face.begin();
-	int nid = 0;
-	for (int i=0; i<NF; ++i, ++pf)
-	{
-		FACET& f = *pf;
-        vec3d v1 = vec3d(f.v1[0], f.v1[1], f.v1[2]); f.n[0] = find_node(v1);
-        vec3d v2 = vec3d(f.v2[0], f.v2[1], f.v2[2]); f.n[1] = find_node(v2);
-        vec3d v3 = vec3d(f.v3[0], f.v3[1], f.v3[2]); f.n[2] = find_node(v3);
-		f.nid = nid++;
-	}
-	int NN = (int)m_Node.size();
+	// merge the vertices
+	std::vector<vec3d> nodes;
+	std::vector<int> tri;
+	weld_vertices(nodes, tri);
+	int NN = (int)nodes.size();
 
 	// create the mesh
 	FSSurfaceMesh* pm = new FSSurfaceMesh;
 	pm->Create(NN, 0, NF);
 
 	// create nodes
+#pragma omp parallel for
 	for (int i=0; i<NN; ++i)
 	{
-		vec3d& ri = m_Node[i].r;
 		FSNode& node = pm->Node(i);
-		node.pos(ri);
+		node.pos(nodes[i]);
 	}
 
 	// create elements
-	std::list<FACET>::iterator is = m_Face.begin();
-	for (int i=0; i<NF; ++i, ++is)
+#pragma omp parallel for
+	for (int i=0; i<NF; ++i)
 	{
-		FACET& f = *is;
-		int n = f.nid;
-		if (n >= 0)
-		{
-			FSFace& face = pm->Face(n);
-			face.SetType(FE_FACE_TRI3);
-			face.m_gid = 0;
-			face.n[0] = f.n[0];
-			face.n[1] = f.n[1];
-			face.n[2] = f.n[2];
-		}
+		FSFace& face = pm->Face(i);
+		face.SetType(FE_FACE_TRI3);
+		face.m_gid = 0;
+		face.n[0] = tri[3 * i    ];
+		face.n[1] = tri[3 * i + 1];
+		face.n[2] = tri[3 * i + 2];
 	}
 
 	// update the mesh
@@ -303,52 +629,22 @@ GObject* STLimport::build_mesh()
 }
 
 //-----------------------------------------------------------------------------
-int STLimport::FindBox(const vec3d& r)
-{
-	BoundingBox& b = m_box;
-	int i = (int)(m_NB*(r.x - b.x0)/(b.x1 - b.x0));
-	int j = (int)(m_NB*(r.y - b.y0)/(b.y1 - b.y0));
-	int k = (int)(m_NB*(r.z - b.z0)/(b.z1 - b.z0));
-	return k + j*(m_NB + i*m_NB);
-}
-
-//-----------------------------------------------------------------------------
-int STLimport::find_node(const vec3d& r, const double eps)
+BoundingBox STLimport::GetBoundingBox()
 {
-	// get the box in which this node lies
-	int nb = FindBox(r);
-	assert((nb >= 0)&&(nb<(int)m_BL.size()));
-	OBOX& b = m_BL[nb];
-
-	// see if this node is already in this box
-	int N = (int)b.NL.size();
-	for (int i=0; i<N; ++i)
-	{
-		NODE& ni = m_Node[b.NL[i]];
-		vec3d& ri = ni.r;
-		if ((ri - r)*(ri - r) < eps) return ni.n;
-	}
+	int NV = (int)m_vert.size() / 3;
+	if (NV == 0) return BoundingBox();
 
-	N = (int)m_Node.size();
-	NODE nd;
-	nd.r = r;
-	nd.n = N;
-	m_Node.push_back(nd);
-	b.NL.push_back(nd.n);
-	return nd.n;
-}
+	const float* v = m_vert.data();
+	float x0 = v[0], y0 = v[1], z0 = v[2];
+	float x1 = x0, y1 = y0, z1 = z0;
 
-//-----------------------------------------------------------------------------
-BoundingBox STLimport::GetBoundingBox()
-{
-	std::list<FACET>::iterator pf = m_Face.begin();
-	vec3d r = vec3d(pf->v1[0], pf->v1[1], pf->v1[2]);
-	BoundingBox b(r, r);
-	for (pf = m_Face.begin(); pf != m_Face.end(); ++pf)
+	// This pass is memory-bound and cheap compared to the weld, so it is not parallelized.
+	for (int i = 1; i < NV; ++i)
 	{
-		b += vec3d(pf->v1[0], pf->v1[1], pf->v1[2]);
-		b += vec3d(pf->v2[0], pf->v2[1], pf->v2[2]);
-		b += vec3d(pf->v3[0], pf->v3[1], pf->v3[2]);
+		const float* r = v + 3 * (size_t)i;
+		if (r[0] < x0) x0 = r[0]; if (r[0] > x1) x1 = r[0];
+		if (r[1] < y0) y0 = r[1]; if (r[1] > y1) y1 = r[1];
+		if (r[2] < z0) z0 = r[2]; if (r[2] > z1) z1 = r[2];
 	}
-	return b;
+	return BoundingBox(x0, y0, z0, x1, y1, z1);
 }
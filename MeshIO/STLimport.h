@@ -30,41 +30,9 @@ SOFTWARE.*/
 #include <FEMLib/FSProject.h>
 
 #include <vector>
-#include <list>
 
 class STLimport : public FSFileImport
 {
-	struct FACET
-	{
-		float	norm[3];
-		float	v1[3];
-		float	v2[3];
-		float	v3[3];
-		int		n[3];
-		int		nid;
-	};
-
-	struct NODE
-	{
-		vec3d	r;
-		int		n;
-	};
-
-	class OBOX
-	{
-	public:
-		vec3d		r0, r1;		// points defining box
-		std::vector<int>	NL;			// list of nodes inside this box
-
-	public:
-		OBOX(){}
-		OBOX(const OBOX& b) 
-		{
-			r0 = b.r0; r1 = b.r1;
-			NL = b.NL; 
-		}
-	};
-
 public:
 	STLimport(FSProject& prj);
 	virtual ~STLimport(void);
@@ -72,29 +40,21 @@ public:
 	bool Load(const char* szfile);
 
 protected:
-	bool read_line(char* szline, const char* sz);
-
 	GObject* build_mesh();
-	int find_node(const vec3d& r, const double eps = 1e-14);
-	int FindBox(const vec3d& r);
 
-	::BoundingBox GetBoundingBox();
+	// merge vertices that are closer than the weld tolerance
+	void weld_vertices(std::vector<vec3d>& nodes, std::vector<int>& tri);
 
-private:
-	bool read_ascii(const char* szfile);
-	bool read_binary(const char* szfile);
+	::BoundingBox GetBoundingBox();
 
 private:
-	bool read_facet(FACET& f);
+	bool read_ascii(const char* buf, size_t size);
+	bool read_binary(const char* buf, size_t size);
 
 protected:
 	FSModel*			m_pfem;
-	std::list<FACET>	m_Face;
-	std::vector<NODE>	m_Node;
-	int					m_nline;	// line counter
-
-	int					m_NB;
-	std::vector<OBOX>	m_BL;		// box lists
+	std::vector<float>	m_vert;		// vertex coordinates (nine floats per facet)
+	double				m_tol;		// vertex weld tolerance
 
-	BoundingBox				m_box;		// bounding box
+	BoundingBox			m_box;		// bounding box
 };
@@ -0,0 +1,127 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "FSBoxBVH.h"
+#include <algorithm>
+#include <assert.h>
+
+// max number of primitives in a leaf
+const int BVH_LEAF_SIZE = 4;
+
+FSBoxBVH::FSBoxBVH()
+{
+}
+
+void FSBoxBVH::Clear()
+{
+	m_node.clear();
+	m_prim.clear();
+	m_box.clear();
+}
+
+void FSBoxBVH::Build(const std::vector<BoundingBox>& boxes)
+{
+	m_node.clear();
+	m_prim.clear();
+	m_box = boxes;
+
+	int NP = (int)m_box.size();
+	if (NP == 0) return;
+
+	m_prim.resize(NP);
+	for (int i = 0; i < NP; ++i) m_prim[i] = i;
+
+	m_node.reserve(2 * (NP / BVH_LEAF_SIZE + 1));
+	m_node.push_back(NODE());
+	BuildNode(0, 0, NP);
+}
+
+void FSBoxBVH::BuildNode(int nid, int n0, int n1)
+{
+	BoundingBox box = m_box[m_prim[n0]];
+	vec3d c0 = box.Center();
+	BoundingBox cbox(c0, c0);
+	for (int i = n0 + 1; i < n1; ++i)
+	{
+		const BoundingBox& bi = m_box[m_prim[i]];
+		box += bi;
+		cbox += bi.Center();
+	}
+
+	NODE& node = m_node[nid];
+	node.box = box;
+	node.left = -1;
+	node.n0 = n0;
+	node.n1 = n1;
+	if (n1 - n0 <= BVH_LEAF_SIZE) return;
+
+	// split at the median along the longest axis of the box centers
+	int axis = 0;
+	if (cbox.Height() > cbox.Width()) axis = 1;
+	if (cbox.Depth() > (axis == 0 ? cbox.Width() : cbox.Height())) axis = 2;
+
+	int nm = (n0 + n1) / 2;
+	const std::vector<BoundingBox>& pb = m_box;
+	std::nth_element(m_prim.begin() + n0, m_prim.begin() + nm, m_prim.begin() + n1, [&pb, axis](int a, int b) {
+		vec3d ca = pb[a].Center();
+		vec3d cb = pb[b].Center();
+		return (axis == 0 ? ca.x < cb.x : (axis == 1 ? ca.y < cb.y : ca.z < cb.z));
+	});
+
+	// the two children are stored next to each other
+	// (note that this may reallocate m_node, so node can no longer be used)
+	int left = (int)m_node.size();
+	m_node[nid].left = left;
+	m_node.push_back(NODE());
+	m_node.push_back(NODE());
+
+	BuildNode(left    , n0, nm);
+	BuildNode(left + 1, nm, n1);
+}
+
+void FSBoxBVH::Refit(const std::vector<BoundingBox>& boxes)
+{
+	assert(boxes.size() == m_box.size());
+	m_box = boxes;
+	if (m_node.empty()) return;
+
+	// children are always stored after their parent, so we can update the boxes bottom-up
+	for (int i = (int)m_node.size() - 1; i >= 0; --i)
+	{
+		NODE& node = m_node[i];
+		if (node.left == -1)
+		{
+			BoundingBox box = m_box[m_prim[node.n0]];
+			for (int j = node.n0 + 1; j < node.n1; ++j) box += m_box[m_prim[j]];
+			node.box = box;
+		}
+		else
+		{
+			node.box = m_node[node.left].box;
+			node.box += m_node[node.left + 1].box;
+		}
+	}
+}
@@ -0,0 +1,111 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <FSCore/box.h>
+#include <vector>
+#include <utility>
+
+//-----------------------------------------------------------------------------
+// A bounding volume hierarchy of boxes. This is the common core of the
+// element, closest-point and ray hierarchies: it only knows about the
+// bounding boxes of the primitives, and the queries are implemented on top
+// of it with the Traverse function. When the primitives move, the hierarchy
+// can be refit, which only updates the bounding boxes, but keeps the tree
+// structure.
+class FSBoxBVH
+{
+	struct NODE
+	{
+		BoundingBox	box;
+		int		left;	// index of left child, or -1 for a leaf (right child is left + 1)
+		int		n0;		// first primitive in m_prim (leaves only)
+		int		n1;		// one past last primitive in m_prim (leaves only)
+	};
+
+public:
+	FSBoxBVH();
+
+	// Build the hierarchy from the primitives' bounding boxes
+	void Build(const std::vector<BoundingBox>& boxes);
+
+	// update the bounding boxes (the number of primitives must not change)
+	void Refit(const std::vector<BoundingBox>& boxes);
+
+	// remove all data
+	void Clear();
+
+	// number of primitives
+	int Primitives() const { return (int)m_box.size(); }
+
+	// bounding box of primitive i
+	const BoundingBox& PrimitiveBox(int i) const { return m_box[i]; }
+
+	// is the hierarchy built
+	bool IsValid() const { return (m_node.empty() == false); }
+
+	// Visit the hierarchy depth-first. The functors have the signatures:
+	//  bool skipNode(const BoundingBox& box) : returns true if the node (and its children) can be skipped
+	//  void visit(int i) : called for each primitive i in the leaves that are not skipped
+	//  bool rightFirst(const BoundingBox& left, const BoundingBox& right) : returns true if the right child should be visited first
+	// Since skipNode is called when a node is visited, it can depend on the results found so far.
+	template <class SkipNode, class Visit, class RightFirst> void Traverse(SkipNode skipNode, Visit visit, RightFirst rightFirst) const;
+
+private:
+	void BuildNode(int nid, int n0, int n1);
+
+private:
+	std::vector<NODE>			m_node;	// tree nodes (children always come after their parent)
+	std::vector<int>			m_prim;	// primitive indices, sorted by leaf
+	std::vector<BoundingBox>	m_box;	// primitive bounding boxes
+};
+
+template <class SkipNode, class Visit, class RightFirst> void FSBoxBVH::Traverse(SkipNode skipNode, Visit visit, RightFirst rightFirst) const
+{
+	if (m_node.empty()) return;
+
+	// The tree is split at the median, so its depth is about log2(N), and 64 is plenty.
+	int stack[64];
+	int ns = 0;
+	stack[ns++] = 0;
+	while (ns > 0)
+	{
+		const NODE& node = m_node[stack[--ns]];
+		if (skipNode(node.box)) continue;
+
+		if (node.left == -1)
+		{
+			for (int i = node.n0; i < node.n1; ++i) visit(m_prim[i]);
+		}
+		else
+		{
+			int l = node.left, r = node.left + 1;
+			if (rightFirst(m_node[l].box, m_node[r].box)) std::swap(l, r);
+			stack[ns++] = r;
+			stack[ns++] = l;
+		}
+	}
+}
@@ -0,0 +1,102 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "FSElementBVH.h"
+#include "FSCoreMesh.h"
+#include "MeshTools.h"
+
+FSElementBVH::FSElementBVH(FSCoreMesh& mesh) : m_mesh(mesh)
+{
+}
+
+void FSElementBVH::ElementBoxes(std::vector<BoundingBox>& box) const
+{
+	int NE = m_mesh.Elements();
+	box.resize(NE);
+	#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
+	{
+		FSElement_& e = m_mesh.ElementRef(i);
+		int ne = e.Nodes();
+
+		vec3d r0 = m_mesh.Node(e.m_node[0]).r;
+		BoundingBox bi(r0, r0);
+		for (int j = 1; j < ne; ++j) bi += m_mesh.Node(e.m_node[j]).r;
+
+		// same tolerance as FindElementRef
+		double R = bi.GetMaxExtent();
+		bi.Inflate(R * 0.001);
+
+		box[i] = bi;
+	}
+}
+
+void FSElementBVH::Build()
+{
+	std::vector<BoundingBox> box;
+	ElementBoxes(box);
+	m_bvh.Build(box);
+}
+
+void FSElementBVH::Refit()
+{
+	if (m_bvh.IsValid() == false) return;
+
+	std::vector<BoundingBox> box;
+	ElementBoxes(box);
+	m_bvh.Refit(box);
+}
+
+bool FSElementBVH::FindElement(const vec3f& p, int& nelem, double r[3]) const
+{
+	nelem = -1;
+
+	vec3d x = to_vec3d(p);
+	double q[3];
+	m_bvh.Traverse(
+		[&](const BoundingBox& box) {
+			return (box.IsInside(x) == false);
+		},
+		[&](int eid) {
+			// we already found an element with a lower index
+			if ((nelem != -1) && (eid > nelem)) return;
+
+			if (m_bvh.PrimitiveBox(eid).IsInside(x))
+			{
+				FSElement_& e = m_mesh.ElementRef(eid);
+				if (ProjectInsideElement(m_mesh, e, p, q))
+				{
+					nelem = eid;
+					r[0] = q[0]; r[1] = q[1]; r[2] = q[2];
+				}
+			}
+		},
+		[](const BoundingBox&, const BoundingBox&) {
+			return false;
+		});
+
+	return (nelem != -1);
+}
@@ -0,0 +1,62 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include "FSBoxBVH.h"
+
+class FSCoreMesh;
+
+//-----------------------------------------------------------------------------
+// A bounding volume hierarchy of the element bounding boxes of a mesh. It is
+// used to quickly find the element that contains a point. The hierarchy is
+// built once, and when the nodes move it can be refit, which only updates the
+// bounding boxes, but keeps the tree structure.
+class FSElementBVH
+{
+public:
+	FSElementBVH(FSCoreMesh& mesh);
+
+	// build the hierarchy using the current node positions of the mesh
+	void Build();
+
+	// update the bounding boxes with the current node positions of the mesh
+	void Refit();
+
+	// find the element that contains the point p. The iso-parametric coordinates
+	// are returned in r. If more than one element contains the point, the element
+	// with the lowest index is returned.
+	bool FindElement(const vec3f& p, int& nelem, double r[3]) const;
+
+	// number of elements in the hierarchy
+	int Elements() const { return m_bvh.Primitives(); }
+
+private:
+	void ElementBoxes(std::vector<BoundingBox>& box) const;
+
+private:
+	FSCoreMesh&	m_mesh;
+	FSBoxBVH	m_bvh;	// hierarchy of element bounding boxes
+};
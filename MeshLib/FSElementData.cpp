@@ -341,6 +341,28 @@ bool FSPartData::AddPart(int localPartID)
 
 int FSPartData::GetElementIndex(int nelem) { return m_lut[nelem]; }
 
+void FSPartData::RenumberElements(const std::vector<int>& newIndex)
+{
+	std::vector<int> oldLut = m_lut;
+	std::vector<double> oldData = m_data;
+	assert(oldLut.size() == newIndex.size());
+
+	// the lookup table is rebuilt from the new element order
+	AllocateData();
+
+	int blockSize = m_maxElemItems * ItemSize();
+	int NE = (int)newIndex.size();
+	for (int i = 0; i < NE; ++i)
+	{
+		int l0 = oldLut[i];
+		if (l0 >= 0)
+		{
+			int l1 = m_lut[newIndex[i]]; assert(l1 >= 0);
+			for (int k = 0; k < blockSize; ++k) m_data[l1 * blockSize + k] = oldData[l0 * blockSize + k];
+		}
+	}
+}
+
 FSPartSet* FSPartData::GetPartSet()
 {
 	return dynamic_cast<FSPartSet*>(GetItemList());
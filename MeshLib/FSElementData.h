@@ -100,6 +100,10 @@ public:
 
 	void SetItemList(FSItemListBuilder* item, int n = 0) override;
 
+	// reorder the data after the mesh elements were renumbered
+	// (newIndex[i] is the new index of the element that had index i)
+	void RenumberElements(const std::vector<int>& newIndex);
+
 public:
 	void Save(OArchive& ar);
 	void Load(IArchive& ar);
@@ -654,6 +654,8 @@ void FSMesh::UpdateElementNeighbors()
 	FSNodeElementList& NET = NodeElementList();
 
 	// loop over all elements
+	// Note that each element only sets its own neighbors, so that the result
+	// does not depend on the order in which the threads process the elements.
 #pragma omp parallel for shared(NET)
 	for (int i = 0; i < elems; i++)
 	{
@@ -704,14 +706,14 @@ void FSMesh::UpdateElementNeighbors()
 						{
 							int nbe = NET.ElementIndex(inode, k);
 							FSElement_* pne = ElementPtr(nbe);
-							if ((pne != pe) && pne->IsSolid())
+							// (checking a few face nodes first avoids most of the FindFace calls)
+							if ((pne != pe) && pne->IsSolid() && pne->HasNode(f1.n[1]) && pne->HasNode(f1.n[2]))
 							{
 								int l = pne->FindFace(f1);
 								if (l != -1)
 								{
 									bfound = true;
 									pe->m_nbr[j] = nbe;
-									pne->m_nbr[l] = i;
 									break;
 								}
 							}
@@ -748,7 +750,6 @@ void FSMesh::UpdateElementNeighbors()
 							{
 								bfound = true;
 								pe->m_nbr[j] = NET.ElementIndex(inode, k);
-								pne->m_nbr[l] = i;
 								break;
 							}
 						}
@@ -787,7 +788,9 @@ void FSMesh::UpdateElementNeighbors()
 //-----------------------------------------------------------------------------
 void FSMesh::MarkExteriorEdges()
 {
-	for (int i = 0; i < Edges(); ++i)
+	int NE = Edges();
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
 	{
 		FSEdge& edge = Edge(i);
 		edge.SetExterior(edge.m_gid >= 0);
@@ -979,19 +982,14 @@ void FSMesh::UpdateEdgeElementTable()
 	int NE = Elements();
 	if ((NC == 0) || (NE == 0)) return;
 
-	// clear all edge-element connectivity
-	for (int i = 0; i < NC; ++i)
-	{
-		FSEdge& e = Edge(i);
-		e.m_elem = -1;
-	}
-
 	// get the node element table
 	FSNodeElementList& NET = NodeElementList();
 
+#pragma omp parallel for shared(NET)
 	for (int i = 0; i < NC; ++i)
 	{
 		FSEdge& edge = Edge(i);
+		edge.m_elem = -1;
 
 		int n0 = edge.n[0];
 		int nval = NET.Valence(n0);
@@ -1077,10 +1075,12 @@ void FSMesh::UpdateFaceNeighbors()
 	FSNodeFaceList& NFT = NodeFaceList();
 
 	// find all face neighbours
-	int n[4];
+	// (Each face only sets its own neighbors, so this can be done in parallel.)
+#pragma omp parallel for shared(NFT)
 	for (int i = 0; i<NF; ++i)
 	{
 		FSFace* pf = FacePtr(i);
+		int n[4];
 
 		int ne = pf->Edges();
 		for (int j = 0; j<ne; ++j)
@@ -1117,6 +1117,7 @@ void FSMesh::UpdateFaceNeighbors()
 	}
 
 	// clean up face neighbors
+#pragma omp parallel for
 	for (int i = 0; i < NF; ++i)
 	{
 		FSFace* pf = FacePtr(i);
@@ -1134,16 +1135,13 @@ void FSMesh::UpdateEdgeNeighbors()
 	FSNodeEdgeList NET;
 	NET.Build(this, true);
 
-	for (int i = 0; i<Edges(); ++i)
+	int NE = Edges();
+#pragma omp parallel for shared(NET)
+	for (int i = 0; i<NE; ++i)
 	{
 		FSEdge& edge = Edge(i);
 		edge.m_nbr[0] = -1;
 		edge.m_nbr[1] = -1;
-	}
-
-	for (int i = 0; i<Edges(); ++i)
-	{
-		FSEdge& edge = Edge(i);
 		if (edge.m_gid >= 0)
 		{
 			for (int j = 0; j<2; ++j)
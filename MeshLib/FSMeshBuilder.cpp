@@ -28,6 +28,8 @@ SOFTWARE.*/
 #include "FSMesh.h"
 #include <GeomLib/GObject.h>
 #include <MeshLib/FSFaceEdgeList.h>
+#include <MeshLib/FSPointGrid.h>
+#include <MeshLib/FSElementData.h>
 #include <memory>
 using namespace std;
 
@@ -788,34 +790,39 @@ void FSMeshBuilder::AttachAndWeld(FSMesh& mesh, double tol)
 	vector<int> order(nodes);
 	for (int i = 0; i<nodes; ++i) order[i] = i;
 
-	// sqr distance treshold
-	double tol2 = tol*tol;
-
-	// loop over the selected nodes
+	// put the target nodes in a grid, so we only need to look at nearby nodes
 	int nsrc = (int)src.size();
 	int ntrg = (int)trg.size();
+	vector<vec3d> trgPos(ntrg);
+	for (int j = 0; j < ntrg; ++j) trgPos[j] = m_mesh.Node(trg[j]).r;
+	FSPointGrid grid(trgPos, tol);
+
+	// find the target candidates of all source nodes (in parallel)
+	vector< vector<int> > cand(nsrc);
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < nsrc; ++i)
+	{
+		grid.FindNeighbors(m_mesh.Node(src[i]).r, tol, cand[i]);
+	}
+
+	// loop over the candidate pairs. This is done in the same order as a
+	// full pair loop over the source and target nodes, so the result does
+	// not depend on the number of threads.
 	for (int i = 0; i<nsrc; ++i)
-		for (int j = 0; j<ntrg; ++j)
+	{
+		vector<int>& ci = cand[i];
+		for (int n = 0; n<(int)ci.size(); ++n)
 		{
+			int j = ci[n];
 			FSNode& ni = m_mesh.Node(src[i]);
-			FSNode& nj = m_mesh.Node(trg[j]);
-
-			// calculate (squared) distance between nodes
-			vec3d& ri = ni.r;
-			vec3d& rj = nj.r;
 
+			// nodes coincide (within tolerance), so weld.
+			// If one of the nodes has a gid, we don't want to loose it.
 			int gi = ni.m_gid;
-			int gj = nj.m_gid;
-
-			double d2 = (ri - rj).SqrLength();
-			if (d2 <= tol2)
-			{
-				// nodes coindice, so weld.
-				// If one of the nodes has a gid, we don't want to loose it.
-				if (gi >= 0) order[trg[j]] = src[i];
-				else order[src[i]] = trg[j];
-			}
+			if (gi >= 0) order[trg[j]] = src[i];
+			else order[src[i]] = trg[j];
 		}
+	}
 
 	// if nodes that are tagged for removal are required, the RemoveIsolatedNodes()
 	// will not remove them. So, we remove the required flag. 
@@ -1797,6 +1804,11 @@ void FSMeshBuilder::AutoPartitionSurface(double angleDegrees, bool creaseInterna
 		pf->m_gid = -1;
 	}
 
+	// evaluate the face normals up front, since they are needed several times
+	vector<vec3d> faceNormal(NF);
+#pragma omp parallel for
+	for (int i = 0; i < NF; ++i) faceNormal[i] = m_mesh.FaceNormal(m_mesh.Face(i));
+
 	// stack for tracking unprocessed faces
 	vector<FSFace*> stack(NF);
 	int ns = 0;
@@ -1817,7 +1829,7 @@ void FSMeshBuilder::AutoPartitionSurface(double angleDegrees, bool creaseInterna
 				// mark as processed
 				pf->m_gid = ngid;
 
-				vec3d Nf = m_mesh.FaceNormal(*pf);
+				vec3d Nf = faceNormal[pf - m_mesh.FacePtr()];
 
 				// get the element part ID's
 				assert(pf->m_elem[0].eid >= 0);
@@ -1838,10 +1850,10 @@ void FSMeshBuilder::AutoPartitionSurface(double angleDegrees, bool creaseInterna
 						bool badd = false;
 						if ((pf->IsExternal() == false) && (pf2->IsExternal() == false))
 						{
-							if ((creaseInternal == false) || (Nf * m_mesh.FaceNormal(*pf2) >= eps))
+							if ((creaseInternal == false) || (Nf * faceNormal[pf2 - m_mesh.FacePtr()] >= eps))
 								badd = true;
 						}
-						else if (Nf * m_mesh.FaceNormal(*pf2) >= eps)
+						else if (Nf * faceNormal[pf2 - m_mesh.FacePtr()] >= eps)
 						{
 							badd = true;
 						}
@@ -2076,9 +2088,13 @@ void FSMeshBuilder::AutoPartitionNodes()
 //-----------------------------------------------------------------------------
 void FSMeshBuilder::BuildFaces()
 {
-	// let's count them first
-	int faces = 0;
+	// Let's count them first. The solid faces are stored first, followed by the shell faces,
+	// so we count them separately. The counts are turned into offsets below, which allows
+	// us to create the faces in parallel and still get the same face order.
 	int elems = m_mesh.Elements();
+	vector<int> solidOffset(elems + 1, 0);
+	vector<int> shellOffset(elems + 1, 0);
+#pragma omp parallel for
 	for (int i = 0; i<elems; i++)
 	{
 		FSElement& el = m_mesh.Element(i);
@@ -2087,6 +2103,7 @@ void FSMeshBuilder::BuildFaces()
 		// we create a face if an element does not have a neighbor
 		// or if the neighbor has a different gid and is not a shell.
 		// Note that we need to make sure we don't double-count.
+		int faces = 0;
 		int n = el.Faces();
 		for (int j = 0; j<n; ++j)
 		{
@@ -2100,13 +2117,20 @@ void FSMeshBuilder::BuildFaces()
 				}
 			}
 		}
+		solidOffset[i + 1] = faces;
 
 		// shell elements always add a face
-		if (el.IsShell())
-		{
-			++faces;
-		}
+		shellOffset[i + 1] = (el.IsShell() ? 1 : 0);
+	}
+
+	// turn the counts into offsets
+	for (int i = 0; i<elems; ++i)
+	{
+		solidOffset[i + 1] += solidOffset[i];
+		shellOffset[i + 1] += shellOffset[i];
 	}
+	int solidFaces = solidOffset[elems];
+	int faces = solidFaces + shellOffset[elems];
 
 	// make sure we have faces
 	if (faces == 0)
@@ -2119,14 +2143,13 @@ void FSMeshBuilder::BuildFaces()
 	m_mesh.m_Face.resize(faces);
 
 	// create the faces
-	FSFace* pf = m_mesh.FacePtr();
-	int nf = 0;
-
-	// solid elements
+#pragma omp parallel for
 	for (int i = 0; i<elems; i++)
 	{
 		FSElement& el = m_mesh.Element(i);
 
+		// solid elements
+		int nf = solidOffset[i];
 		int n = el.Faces();
 		for (int j = 0; j<n; j++)
 		{
@@ -2135,34 +2158,31 @@ void FSMeshBuilder::BuildFaces()
 			FSElement_* pen = (nbid == -1 ? 0 : m_mesh.ElementPtr(nbid));
 			if (pen == 0)
 			{
-				el.GetFace(j, *pf);
-				pf->SetExterior(true);
-				pf->SetID(nf + 1);
-				++pf; ++nf;
+				FSFace& face = m_mesh.Face(nf);
+				el.GetFace(j, face);
+				face.SetExterior(true);
+				face.SetID(nf + 1);
+				++nf;
 			}
 			else if ((el.m_gid < pen->m_gid) && (pen->IsShell() == false))
 			{
-				*pf = el.GetFace(j);
-				pf->SetExterior(false);
-				pf->SetID(nf + 1);
-				++pf; ++nf;
+				FSFace& face = m_mesh.Face(nf);
+				face = el.GetFace(j);
+				face.SetExterior(false);
+				face.SetID(nf + 1);
+				++nf;
 			}
 		}
-	}
-
-	// shell elements
-	for (int i = 0; i<elems; i++)
-	{
-		FSElement& el = m_mesh.Element(i);
+		assert(nf == solidOffset[i + 1]);
 
 		// shell elements
-		int n = el.Edges();
-		if (n>0)
+		if (el.Edges() > 0)
 		{
-			el.GetShellFace(*pf);
-			pf->SetExterior(true);
-			pf->SetID(nf + 1);
-			++pf; ++nf;
+			nf = solidFaces + shellOffset[i];
+			FSFace& face = m_mesh.Face(nf);
+			el.GetShellFace(face);
+			face.SetExterior(true);
+			face.SetID(nf + 1);
 		}
 	}
 
@@ -2171,99 +2191,132 @@ void FSMeshBuilder::BuildFaces()
 }
 
 //-----------------------------------------------------------------------------
+// The edges are collected from the faces (and beams) in the same order as a simple serial
+// loop would find them. Each candidate edge is kept if no candidate that comes before it
+// is the same edge. Candidates are grouped by their lowest node number, so this check
+// only needs to look at a few candidates, and can be done in parallel.
 void FSMeshBuilder::BuildEdges()
 {
 	// delete edges
 	m_mesh.m_Edge.clear();
 
 	// tag all faces
-	for (int i = 0; i < m_mesh.Faces(); ++i) m_mesh.Face(i).m_ntag = i;
+	int NF = m_mesh.Faces();
+	for (int i = 0; i < NF; ++i) m_mesh.Face(i).m_ntag = i;
 
-	// keep node-edge table to prevent adding duplicate edges
-	int NN = m_mesh.Nodes();
-	vector<vector<int> > NET(NN);
+	// count the candidate edges of all faces and beams
+	int NE = m_mesh.Elements();
+	vector<int> offset(NF + NE + 1, 0);
+#pragma omp parallel for
+	for (int i = 0; i<NF; ++i)
+	{
+		FSFace& f = m_mesh.Face(i);
+		int ne = f.Edges();
+		int m = 0;
+		for (int j = 0; j<ne; ++j)
+		{
+			FSFace* pfn = m_mesh.FacePtr(f.m_nbr[j]);
+			if (((pfn == 0) && f.IsExternal()) || (pfn && (f.m_ntag < pfn->m_ntag))) m++;
+		}
+		offset[i + 1] = m;
+	}
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
+	{
+		offset[NF + i + 1] = (m_mesh.Element(i).IsBeam() ? 1 : 0);
+	}
+	for (int i = 0; i < NF + NE; ++i) offset[i + 1] += offset[i];
+	int NC = offset[NF + NE];
+	if (NC == 0)
+	{
+		m_mesh.RebuildEdgeData();
+		return;
+	}
 
-	// loop over all faces
-	int NF = m_mesh.Faces();
+	// create the candidate edges
+	vector<FSEdge> edge(NC);
+#pragma omp parallel for
 	for (int i = 0; i<NF; ++i)
 	{
 		FSFace& f = m_mesh.Face(i);
 		int ne = f.Edges();
+		int m = offset[i];
 		for (int j = 0; j<ne; ++j)
 		{
 			FSFace* pfn = m_mesh.FacePtr(f.m_nbr[j]);
 			if (((pfn == 0) && f.IsExternal()) || (pfn && (f.m_ntag < pfn->m_ntag)))
 			{
-				FSEdge e = f.GetEdge(j);
-
-				// see if this edge already exists
-				bool bfound = false;
-				vector<int>& net = NET[e.n[0]];
-				for (int l = 0; l < net.size(); ++l)
-				{
-					FSEdge& el = m_mesh.Edge(net[l]);
-					if (el == e)
-					{
-						// the edge already exists, so don't add it
-						bfound = true;
-						break;
-					}
-				}
-
-				// If not, then process and add
-				if (bfound == false)
-				{
-					e.m_gid = ((pfn == 0) || (f.m_gid != pfn->m_gid) ? 0 : -1);
-					e.SetID((int)m_mesh.m_Edge.size() + 1);
-					e.SetExterior(e.m_gid == 0);
-
-					int edgeIndex = m_mesh.Edges();
-					m_mesh.m_Edge.push_back(e);
-					NET[e.n[0]].push_back(edgeIndex);
-					NET[e.n[1]].push_back(edgeIndex);
-				}
+				FSEdge& e = edge[m++];
+				e = f.GetEdge(j);
+				e.m_gid = ((pfn == 0) || (f.m_gid != pfn->m_gid) ? 0 : -1);
 			}
 		}
 	}
-
-	// loop over beam elements
-	for (int i = 0; i < m_mesh.Elements(); ++i)
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
 	{
 		FSElement& el = m_mesh.Element(i);
 		if (el.IsBeam())
 		{
-			FSEdge e;
+			FSEdge& e = edge[offset[NF + i]];
 			e.SetType(FE_EDGE2);
 			e.n[0] = el.m_node[0];
 			e.n[1] = el.m_node[1];
+			e.m_gid = 0;
+			e.m_elem = i;
+		}
+	}
+
+	// group the candidates by their lowest node
+	int NN = m_mesh.Nodes();
+	vector<int> bucket(NN + 1, 0);
+	for (int i = 0; i < NC; ++i)
+	{
+		FSEdge& e = edge[i];
+		bucket[min(e.n[0], e.n[1]) + 1]++;
+	}
+	for (int i = 0; i < NN; ++i) bucket[i + 1] += bucket[i];
+	vector<int> pos(bucket.begin(), bucket.end() - 1);
+	vector<int> list(NC);
+	for (int i = 0; i < NC; ++i)
+	{
+		FSEdge& e = edge[i];
+		list[pos[min(e.n[0], e.n[1])]++] = i;
+	}
 
-			// see if this edge already exists
-			bool bfound = false;
-			vector<int>& net = NET[e.n[0]];
-			for (int l = 0; l < net.size(); ++l)
+	// only keep the first occurrence of each edge
+	vector<int> keep(NC, 1);
+#pragma omp parallel for schedule(dynamic, 1024)
+	for (int i = 0; i < NN; ++i)
+	{
+		for (int k = bucket[i]; k < bucket[i + 1]; ++k)
+		{
+			FSEdge& ek = edge[list[k]];
+			for (int l = bucket[i]; l < k; ++l)
 			{
-				FSEdge& el = m_mesh.Edge(net[l]);
-				if (el == e)
+				if (edge[list[l]] == ek)
 				{
-					// the edge already exists, so don't add it
-					bfound = true;
+					keep[list[k]] = 0;
 					break;
 				}
 			}
+		}
+	}
 
-			// If not, then process and add
-			if (bfound == false)
-			{
-				e.m_gid = 0;
-				e.m_elem = i;
-				e.SetID((int)m_mesh.m_Edge.size() + 1);
-				e.SetExterior(e.m_gid == 0);
-
-				int edgeIndex = m_mesh.Edges();
-				m_mesh.m_Edge.push_back(e);
-				NET[e.n[0]].push_back(edgeIndex);
-				NET[e.n[1]].push_back(edgeIndex);
-			}
+	// collect the edges
+	vector<int> edgeIndex(NC + 1, 0);
+	for (int i = 0; i < NC; ++i) edgeIndex[i + 1] = edgeIndex[i] + keep[i];
+	m_mesh.m_Edge.resize(edgeIndex[NC]);
+#pragma omp parallel for
+	for (int i = 0; i < NC; ++i)
+	{
+		if (keep[i])
+		{
+			int n = edgeIndex[i];
+			FSEdge& e = m_mesh.Edge(n);
+			e = edge[i];
+			e.SetID(n + 1);
+			e.SetExterior(e.m_gid == 0);
 		}
 	}
 
@@ -2277,3 +2330,108 @@ void FSMeshBuilder::RepairEdges()
 	AutoPartitionNodes();
 	m_mesh.RebuildNodeData();
 }
+
+void FSMeshBuilder::RenumberMesh(const std::vector<int>& nodeOrder, const std::vector<int>& elemOrder)
+{
+	int NN = m_mesh.Nodes();
+	int NE = m_mesh.Elements();
+	assert(nodeOrder.size() == NN);
+	assert(elemOrder.size() == NE);
+
+	// inverse maps
+	std::vector<int> newNode(NN), newElem(NE);
+	for (int i = 0; i < NN; ++i) newNode[nodeOrder[i]] = i;
+	for (int i = 0; i < NE; ++i) newElem[elemOrder[i]] = i;
+
+	// reorder the nodes
+	std::vector<FSNode> oldNodes = m_mesh.m_Node;
+	for (int i = 0; i < NN; ++i) m_mesh.m_Node[i] = oldNodes[nodeOrder[i]];
+	std::vector<FSNode>().swap(oldNodes);
+
+	// reorder the elements and update their connectivity
+	std::vector<FSElement> oldElems = m_mesh.m_Elem;
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
+	{
+		FSElement& el = m_mesh.m_Elem[i];
+		el = oldElems[elemOrder[i]];
+		int ne = el.Nodes();
+		for (int j = 0; j < ne; ++j) el.m_node[j] = newNode[el.m_node[j]];
+	}
+	std::vector<FSElement>().swap(oldElems);
+
+	// the element data is stored per element
+	if (m_mesh.m_data.IsValid())
+	{
+		Mesh_Data oldData = m_mesh.m_data;
+		for (int i = 0; i < NE; ++i) m_mesh.m_data[i] = oldData[elemOrder[i]];
+	}
+
+	// faces and edges keep their order, but refer to new node and element indices
+	int NF = m_mesh.Faces();
+#pragma omp parallel for
+	for (int i = 0; i < NF; ++i)
+	{
+		FSFace& face = m_mesh.Face(i);
+		int nf = face.Nodes();
+		for (int j = 0; j < nf; ++j) face.n[j] = newNode[face.n[j]];
+		for (int j = 0; j < 3; ++j)
+		{
+			int eid = face.m_elem[j].eid;
+			if (eid >= 0) face.m_elem[j].eid = newElem[eid];
+		}
+	}
+
+	int NL = m_mesh.Edges();
+	for (int i = 0; i < NL; ++i)
+	{
+		FSEdge& edge = m_mesh.Edge(i);
+		int ne = edge.Nodes();
+		for (int j = 0; j < ne; ++j) edge.n[j] = newNode[edge.n[j]];
+		if (edge.m_elem >= 0) edge.m_elem = newElem[edge.m_elem];
+	}
+
+	// Update the node and element sets. The order of the items is preserved,
+	// so the data fields defined on these sets remain valid.
+	for (int i = 0; i < m_mesh.FENodeSets(); ++i)
+	{
+		FSNodeSet* pg = m_mesh.GetFENodeSet(i);
+		std::vector<int> items = pg->CopyItems();
+		for (int& n : items) n = newNode[n];
+		pg->clear();
+		pg->add(items);
+	}
+
+	for (int i = 0; i < m_mesh.FEElemSets(); ++i)
+	{
+		FSElemSet* pg = m_mesh.GetFEElemSet(i);
+		std::vector<int> items = pg->CopyItems();
+		for (int& n : items) n = newElem[n];
+		pg->clear();
+		pg->add(items);
+	}
+
+	// part data is stored in element order, so it needs to be reordered
+	for (int i = 0; i < m_mesh.MeshDataFields(); ++i)
+	{
+		FSPartData* pd = dynamic_cast<FSPartData*>(m_mesh.GetMeshDataField(i));
+		if (pd) pd->RenumberElements(newElem);
+	}
+
+	// the geometry nodes store the index of their mesh node
+	GObject* po = m_mesh.GetGObject();
+	if (po)
+	{
+		for (int i = 0; i < NN; ++i)
+		{
+			FSNode& node = m_mesh.Node(i);
+			GNode* pn = (node.m_gid >= 0 ? po->Node(node.m_gid) : nullptr);
+			if (pn) pn->SetNodeIndex(i);
+		}
+	}
+
+	// rebuild the topology and lookup tables (this also updates the partitions)
+	m_mesh.ClearMeshTopo();
+	m_mesh.UpdateElementNeighbors();
+	m_mesh.UpdateMesh();
+}
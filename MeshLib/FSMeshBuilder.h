@@ -26,6 +26,7 @@ SOFTWARE.*/
 
 #pragma once
 #include <FSCore/math3d.h>
+#include <vector>
 
 class FSNode;
 class FSElement;
@@ -120,6 +121,11 @@ public:
 	// repair edges (and node data)
 	void RepairEdges();
 
+	// Renumber the nodes and elements. Node i of the renumbered mesh is node nodeOrder[i]
+	// of the current mesh, and similarly for the elements. All item lists, mesh data,
+	// and partitions are updated accordingly.
+	void RenumberMesh(const std::vector<int>& nodeOrder, const std::vector<int>& elemOrder);
+
 private:
 	void BuildFaces();
 	void BuildEdges();
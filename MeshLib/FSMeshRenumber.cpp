@@ -0,0 +1,237 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "FSMeshRenumber.h"
+#include "FSMesh.h"
+#include "FSNodeNodeList.h"
+#include <algorithm>
+#include <stdint.h>
+
+MeshTools::MeshLocality MeshTools::EvaluateLocality(FSMesh& mesh)
+{
+	MeshLocality L = { 0.0, 0, 0.0 };
+
+	int NE = mesh.Elements();
+	if (NE == 0) return L;
+
+	double span = 0.0, gap = 0.0;
+	long long npairs = 0;
+	int bandwidth = 0;
+
+	// (reduction(max) is not available in OpenMP 2.0, so each thread keeps its own max)
+#pragma omp parallel
+	{
+		int bw = 0;
+#pragma omp for reduction(+:span, gap, npairs)
+		for (int i = 0; i < NE; ++i)
+		{
+			FSElement& el = mesh.Element(i);
+			int ne = el.Nodes();
+			int n0 = el.m_node[0], n1 = el.m_node[0];
+			for (int j = 1; j < ne; ++j)
+			{
+				int nj = el.m_node[j];
+				if (nj < n0) n0 = nj;
+				if (nj > n1) n1 = nj;
+			}
+			span += (double)(n1 - n0);
+			if (n1 - n0 > bw) bw = n1 - n0;
+
+			int nf = el.Faces();
+			for (int j = 0; j < nf; ++j)
+			{
+				int nbr = el.m_nbr[j];
+				if (nbr >= 0)
+				{
+					gap += (double)(nbr > i ? nbr - i : i - nbr);
+					npairs++;
+				}
+			}
+		}
+
+#pragma omp critical
+		if (bw > bandwidth) bandwidth = bw;
+	}
+
+	L.nodeSpan = span / NE;
+	L.bandwidth = bandwidth;
+	L.neighborGap = (npairs > 0 ? gap / (double)npairs : 0.0);
+	return L;
+}
+
+// Spread the lower 21 bits of x so that there are two zero bits between each bit.
+static uint64_t spread_bits(uint64_t x)
+{
+	x &= 0x1fffff;
+	x = (x | (x << 32)) & 0x001f00000000ffffull;
+	x = (x | (x << 16)) & 0x001f0000ff0000ffull;
+	x = (x | (x <<  8)) & 0x100f00f00f00f00full;
+	x = (x | (x <<  4)) & 0x10c30c30c30c30c3ull;
+	x = (x | (x <<  2)) & 0x1249249249249249ull;
+	return x;
+}
+
+// Order the nodes along a Morton curve through the bounding box of the mesh
+static void MortonNodeOrder(FSMesh& mesh, std::vector<int>& order)
+{
+	int NN = mesh.Nodes();
+	BoundingBox box;
+	for (int i = 0; i < NN; ++i) box += mesh.Node(i).r;
+	vec3d r0 = box.r0();
+	double W = box.GetMaxExtent();
+	double s = (W > 0.0 ? 2097151.0 / W : 0.0);
+
+	std::vector<uint64_t> code(NN);
+#pragma omp parallel for
+	for (int i = 0; i < NN; ++i)
+	{
+		vec3d d = (mesh.Node(i).r - r0)*s;
+		uint64_t x = (uint64_t)d.x;
+		uint64_t y = (uint64_t)d.y;
+		uint64_t z = (uint64_t)d.z;
+		code[i] = spread_bits(x) | (spread_bits(y) << 1) | (spread_bits(z) << 2);
+	}
+
+	order.resize(NN);
+	for (int i = 0; i < NN; ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&code](int a, int b) { return code[a] < code[b]; });
+}
+
+// Reverse Cuthill-McKee ordering of the node graph. Each connected component
+// is started from a pseudo-peripheral node of lowest degree.
+static void RCMNodeOrder(FSMesh& mesh, std::vector<int>& order)
+{
+	int NN = mesh.Nodes();
+	FSNodeNodeList NNL(&mesh);
+
+	order.clear();
+	order.reserve(NN);
+
+	std::vector<int> level(NN, -1);
+	std::vector<int> tag(NN, 0);
+	std::vector<int> queue; queue.reserve(NN);
+	std::vector<int> nbr;
+
+	// breadth-first search from node n0, which fills queue and returns the last level
+	auto bfs = [&](int n0, std::vector<int>& q) {
+		q.clear();
+		q.push_back(n0);
+		level[n0] = 0;
+		for (size_t k = 0; k < q.size(); ++k)
+		{
+			int n = q[k];
+			int nval = NNL.Valence(n);
+			for (int j = 0; j < nval; ++j)
+			{
+				int m = NNL.Node(n, j);
+				if (level[m] == -1)
+				{
+					level[m] = level[n] + 1;
+					q.push_back(m);
+				}
+			}
+		}
+		return level[q.back()];
+	};
+
+	for (int i = 0; i < NN; ++i)
+	{
+		if (tag[i] != 0) continue;
+
+		// find the node of lowest degree in this component
+		int ns = i;
+		bfs(i, queue);
+		for (int n : queue) if (NNL.Valence(n) < NNL.Valence(ns)) ns = n;
+		for (int n : queue) level[n] = -1;
+
+		// find a pseudo-peripheral node by repeatedly moving to a node of
+		// lowest degree in the last level (a few iterations are usually enough)
+		int depth = bfs(ns, queue);
+		for (int iter = 0; iter < 5; ++iter)
+		{
+			int nc = -1;
+			for (int n : queue)
+			{
+				if ((level[n] == depth) && ((nc == -1) || (NNL.Valence(n) < NNL.Valence(nc)))) nc = n;
+			}
+			for (int n : queue) level[n] = -1;
+
+			int d = bfs(nc, queue);
+			if (d <= depth) break;
+			ns = nc;
+			depth = d;
+		}
+		for (int n : queue) level[n] = -1;
+
+		// Cuthill-McKee: visit neighbors in order of increasing degree
+		size_t k0 = order.size();
+		order.push_back(ns);
+		tag[ns] = 1;
+		for (size_t k = k0; k < order.size(); ++k)
+		{
+			int n = order[k];
+			int nval = NNL.Valence(n);
+			nbr.clear();
+			for (int j = 0; j < nval; ++j)
+			{
+				int m = NNL.Node(n, j);
+				if (tag[m] == 0) { tag[m] = 1; nbr.push_back(m); }
+			}
+			std::stable_sort(nbr.begin(), nbr.end(), [&NNL](int a, int b) { return NNL.Valence(a) < NNL.Valence(b); });
+			order.insert(order.end(), nbr.begin(), nbr.end());
+		}
+	}
+
+	std::reverse(order.begin(), order.end());
+}
+
+void MeshTools::CalculateRenumbering(FSMesh& mesh, int method, std::vector<int>& nodeOrder, std::vector<int>& elemOrder)
+{
+	int NN = mesh.Nodes();
+	int NE = mesh.Elements();
+
+	if (method == RENUMBER_MORTON) MortonNodeOrder(mesh, nodeOrder);
+	else RCMNodeOrder(mesh, nodeOrder);
+	assert(nodeOrder.size() == NN);
+
+	std::vector<int> newNode(NN);
+	for (int i = 0; i < NN; ++i) newNode[nodeOrder[i]] = i;
+
+	// sort the elements by their lowest (new) node index
+	std::vector<int> key(NE);
+#pragma omp parallel for
+	for (int i = 0; i < NE; ++i)
+	{
+		FSElement& el = mesh.Element(i);
+		int ne = el.Nodes();
+		int nmin = newNode[el.m_node[0]];
+		for (int j = 1; j < ne; ++j) nmin = std::min(nmin, newNode[el.m_node[j]]);
+		key[i] = nmin;
+	}
+
+	elemOrder.resize(NE);
+	for (int i = 0; i < NE; ++i) elemOrder[i] = i;
+	std::stable_sort(elemOrder.begin(), elemOrder.end(), [&key](int a, int b) { return key[a] < key[b]; });
+}
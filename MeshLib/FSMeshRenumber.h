@@ -0,0 +1,56 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include <vector>
+
+class FSMesh;
+
+namespace MeshTools {
+
+	//! Methods for renumbering the nodes and elements of a mesh
+	enum RenumberMethod
+	{
+		RENUMBER_RCM,		//!< reverse Cuthill-McKee ordering of the node graph
+		RENUMBER_MORTON		//!< ordering along a Morton (Z-order) curve through the node positions
+	};
+
+	//! Measures of how well the mesh numbering preserves locality.
+	//! Smaller values mean that connected items are closer together in memory.
+	struct MeshLocality
+	{
+		double	nodeSpan;		//!< average difference between the largest and smallest node index of an element
+		int		bandwidth;		//!< largest node index difference of any element
+		double	neighborGap;	//!< average index difference between neighboring elements
+	};
+
+	//! Evaluate the locality of the current mesh numbering. This uses the element neighbor data.
+	MeshLocality EvaluateLocality(FSMesh& mesh);
+
+	//! Calculate a new node and element ordering. On return, nodeOrder[i] is the
+	//! (current) index of the node that will become node i, and similarly for elemOrder.
+	//! Elements are ordered by the smallest new index of their nodes.
+	void CalculateRenumbering(FSMesh& mesh, int method, std::vector<int>& nodeOrder, std::vector<int>& elemOrder);
+}
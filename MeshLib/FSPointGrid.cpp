@@ -0,0 +1,140 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "FSPointGrid.h"
+#include <algorithm>
+
+// max number of cells per direction (so that a cell key fits in 64 bits)
+const int GRID_MAX_CELLS = (1 << 21) - 1;
+
+FSPointGrid::FSPointGrid(const std::vector<vec3d>& points, double h) : m_points(points)
+{
+	m_nx = m_ny = m_nz = 1;
+	m_h = 1.0;
+	int N = (int)points.size();
+	if (N == 0) return;
+
+	// get the bounding box of the points
+	vec3d r0 = points[0], r1 = points[0];
+	for (int i = 1; i < N; ++i)
+	{
+		const vec3d& r = points[i];
+		if (r.x < r0.x) r0.x = r.x; if (r.x > r1.x) r1.x = r.x;
+		if (r.y < r0.y) r0.y = r.y; if (r.y > r1.y) r1.y = r.y;
+		if (r.z < r0.z) r0.z = r.z; if (r.z > r1.z) r1.z = r.z;
+	}
+	m_r0 = r0;
+
+	// make sure the number of cells stays within bounds
+	double L = r1.x - r0.x;
+	if (r1.y - r0.y > L) L = r1.y - r0.y;
+	if (r1.z - r0.z > L) L = r1.z - r0.z;
+	m_h = h;
+	if (m_h * (GRID_MAX_CELLS - 1) < L) m_h = L / (GRID_MAX_CELLS - 1);
+	if (m_h <= 0.0) m_h = 1.0;
+
+	m_nx = (int)((r1.x - r0.x) / m_h) + 1;
+	m_ny = (int)((r1.y - r0.y) / m_h) + 1;
+	m_nz = (int)((r1.z - r0.z) / m_h) + 1;
+
+	// assign the points to their cells
+	m_item.resize(N);
+#pragma omp parallel for schedule(static)
+	for (int n = 0; n < N; ++n)
+	{
+		int i, j, k;
+		CellIndex(points[n], i, j, k);
+		m_item[n].key = CellKey(i, j, k);
+		m_item[n].index = n;
+	}
+
+	// sort by cell, and then by index
+	std::sort(m_item.begin(), m_item.end(), [](const ITEM& a, const ITEM& b) {
+		return (a.key < b.key) || ((a.key == b.key) && (a.index < b.index));
+	});
+}
+
+uint64_t FSPointGrid::CellKey(int i, int j, int k) const
+{
+	return ((uint64_t)i << 42) | ((uint64_t)j << 21) | (uint64_t)k;
+}
+
+void FSPointGrid::CellIndex(const vec3d& r, int& i, int& j, int& k) const
+{
+	i = (int)((r.x - m_r0.x) / m_h);
+	j = (int)((r.y - m_r0.y) / m_h);
+	k = (int)((r.z - m_r0.z) / m_h);
+	if (i < 0) i = 0; else if (i >= m_nx) i = m_nx - 1;
+	if (j < 0) j = 0; else if (j >= m_ny) j = m_ny - 1;
+	if (k < 0) k = 0; else if (k >= m_nz) k = m_nz - 1;
+}
+
+void FSPointGrid::FindNeighbors(const vec3d& x, double R, std::vector<int>& l) const
+{
+	l.clear();
+	if (m_item.empty() || (R < 0.0)) return;
+
+	int i0, j0, k0, i1, j1, k1;
+	CellIndex(x - vec3d(R, R, R), i0, j0, k0);
+	CellIndex(x + vec3d(R, R, R), i1, j1, k1);
+
+	double R2 = R * R;
+	for (int i = i0; i <= i1; ++i)
+		for (int j = j0; j <= j1; ++j)
+			for (int k = k0; k <= k1; ++k)
+			{
+				ITEM it = { CellKey(i, j, k), -1 };
+				auto p = std::lower_bound(m_item.begin(), m_item.end(), it, [](const ITEM& a, const ITEM& b) {
+					return (a.key < b.key) || ((a.key == b.key) && (a.index < b.index));
+				});
+				for (; (p != m_item.end()) && (p->key == it.key); ++p)
+				{
+					const vec3d& r = m_points[p->index];
+					if ((r - x).SqrLength() <= R2) l.push_back(p->index);
+				}
+			}
+
+	std::sort(l.begin(), l.end());
+}
+
+int FSPointGrid::FindClosest(const vec3d& x, double R) const
+{
+	std::vector<int> l;
+	FindNeighbors(x, R, l);
+
+	// the list is sorted, so the first point with the smallest distance wins
+	int imin = -1;
+	double dmin = R * R;
+	for (int n : l)
+	{
+		double d2 = (m_points[n] - x).SqrLength();
+		if (d2 < dmin)
+		{
+			dmin = d2;
+			imin = n;
+		}
+	}
+	return imin;
+}
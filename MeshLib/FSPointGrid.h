@@ -0,0 +1,73 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include <FSCore/math3d.h>
+#include <vector>
+#include <stdint.h>
+
+//-----------------------------------------------------------------------------
+// A uniform grid of points, used to find all points that lie within a given
+// distance of a query point. Only occupied cells are stored. The cells are
+// kept in a sorted list so that queries always return the same result,
+// regardless of the order in which the points were added. The cell size is
+// normally set to the search radius (e.g. a weld tolerance), so that a query
+// only has to visit the 27 cells around the query point.
+class FSPointGrid
+{
+public:
+	// Build the grid for the points. The cell size will be at least h, but can be
+	// larger when h is very small compared to the size of the point cloud.
+	FSPointGrid(const std::vector<vec3d>& points, double h);
+
+	// find all points that lie within a distance R of x. The indices (into the
+	// point array) are returned in ascending order.
+	void FindNeighbors(const vec3d& x, double R, std::vector<int>& l) const;
+
+	// find the closest point that lies within a distance R of x (strictly less).
+	// If more than one point has the same distance, the lowest index is returned.
+	// Returns -1 if there is no such point.
+	int FindClosest(const vec3d& x, double R) const;
+
+	// number of points in the grid
+	int Points() const { return (int)m_points.size(); }
+
+private:
+	uint64_t CellKey(int i, int j, int k) const;
+	void CellIndex(const vec3d& r, int& i, int& j, int& k) const;
+
+private:
+	struct ITEM
+	{
+		uint64_t	key;	// key of the cell this point is in
+		int			index;	// index of point
+	};
+
+	const std::vector<vec3d>&	m_points;
+	std::vector<ITEM>	m_item;	// points sorted by cell key (and then by index)
+	vec3d	m_r0;		// lower corner of the grid
+	double	m_h;		// cell size
+	int		m_nx, m_ny, m_nz;	// number of cells in each direction
+};
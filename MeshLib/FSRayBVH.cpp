@@ -0,0 +1,73 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "FSRayBVH.h"
+#include <algorithm>
+#include <limits>
+
+FSRayBVH::FSRayBVH()
+{
+}
+
+BoundingBox FSRayBVH::FaceBox(const vec3d* r, int n)
+{
+	BoundingBox box(r[0], r[0]);
+	for (int i = 1; i < n; ++i) box += r[i];
+
+	// The ray-face tests use a tolerance of 0.01 on the natural coordinates,
+	// which can place an intersection up to a few percent of the face size
+	// outside of the face. A margin of 5% keeps the hierarchy conservative.
+	double R = box.GetMaxExtent();
+	box.Inflate(0.05*R + 1e-12);
+	return box;
+}
+
+// clip the parameter range [tmin, tmax] of the line o + t*s to the slab [a, b]
+static bool clip_slab(double o, double t, double a, double b, double& tmin, double& tmax)
+{
+	if (t == 0.0) return ((o >= a) && (o <= b));
+
+	double s0 = (a - o) / t;
+	double s1 = (b - o) / t;
+	if (s0 > s1) std::swap(s0, s1);
+	if (s0 > tmin) tmin = s0;
+	if (s1 < tmax) tmax = s1;
+	return (tmin <= tmax);
+}
+
+double FSRayBVH::RayBoxDistance(const BoundingBox& b, const vec3d& o, const vec3d& t, bool bothSides)
+{
+	const double inf = std::numeric_limits<double>::max();
+	double tmin = (bothSides ? -inf : 0.0);
+	double tmax = inf;
+	if (!clip_slab(o.x, t.x, b.x0, b.x1, tmin, tmax)) return -1.0;
+	if (!clip_slab(o.y, t.y, b.y0, b.y1, tmin, tmax)) return -1.0;
+	if (!clip_slab(o.z, t.z, b.z0, b.z1, tmin, tmax)) return -1.0;
+
+	// the distance to the closest point of the clipped segment
+	if (tmin > 0.0) return tmin;
+	if (tmax < 0.0) return -tmax;
+	return 0.0;
+}
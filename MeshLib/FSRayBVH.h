@@ -0,0 +1,108 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include "FSBoxBVH.h"
+
+//-----------------------------------------------------------------------------
+// A bounding volume hierarchy of boxes that is used to accelerate ray queries
+// against a surface. The hierarchy only knows about the bounding boxes of the
+// primitives (e.g. faces). The exact ray-primitive test is done by the caller,
+// so that the results are identical to a brute-force loop over all primitives.
+// When the primitives move (e.g. in a new state), the hierarchy can be refit,
+// which only updates the bounding boxes, but keeps the tree structure.
+class FSRayBVH
+{
+public:
+	FSRayBVH();
+
+	// Build the hierarchy from the primitives' bounding boxes
+	void Build(const std::vector<BoundingBox>& boxes) { m_bvh.Build(boxes); }
+
+	// update the bounding boxes (the number of primitives must not change)
+	void Refit(const std::vector<BoundingBox>& boxes) { m_bvh.Refit(boxes); }
+
+	// number of primitives
+	int Primitives() const { return m_bvh.Primitives(); }
+
+	// is the hierarchy built
+	bool IsValid() const { return m_bvh.IsValid(); }
+
+	// Find the closest primitive that is hit by the ray (o, t). If bothSides is true,
+	// the entire line is searched, otherwise only the positive side. The hit test is a functor with the signature
+	// bool(int i, double& L), which returns true if primitive i is hit, in which
+	// case L is the distance from the ray origin to the intersection point.
+	// If more than one primitive has the same distance, the lowest index is returned.
+	// Returns -1 if no primitive is hit.
+	template <class HitTest> int CastRay(const vec3d& o, const vec3d& t, bool bothSides, HitTest hitTest) const;
+
+public:
+	// The bounding box of a face with nodes r[0..n-1]. The ray-face tests allow
+	// intersections slightly outside of the face, so the box is inflated accordingly.
+	static BoundingBox FaceBox(const vec3d* r, int n);
+
+private:
+	// distance along the ray to the box (in units of t), or -1 if the ray misses the box
+	static double RayBoxDistance(const BoundingBox& b, const vec3d& o, const vec3d& t, bool bothSides);
+
+private:
+	FSBoxBVH	m_bvh;
+};
+
+template <class HitTest> int FSRayBVH::CastRay(const vec3d& o, const vec3d& t, bool bothSides, HitTest hitTest) const
+{
+	int imin = -1;
+	double Lmin = 0.0;
+
+	// box distances are measured along t, so scale them to compare with the hit distance
+	double tl = t.Length();
+
+	m_bvh.Traverse(
+		// skip nodes that cannot contain a closer hit
+		// (equal distance is visited since it may have a primitive with a lower index)
+		[&](const BoundingBox& box) {
+			double d = RayBoxDistance(box, o, t, bothSides);
+			return ((d < 0) || ((imin >= 0) && (d*tl > Lmin)));
+		},
+		[&](int id) {
+			double L;
+			if (hitTest(id, L))
+			{
+				if ((imin == -1) || (L < Lmin) || ((L == Lmin) && (id < imin)))
+				{
+					imin = id;
+					Lmin = L;
+				}
+			}
+		},
+		// visit the closest child first
+		[&](const BoundingBox& l, const BoundingBox& r) {
+			double dl = RayBoxDistance(l, o, t, bothSides);
+			double dr = RayBoxDistance(r, o, t, bothSides);
+			return ((dl < 0) || ((dr >= 0) && (dr < dl)));
+		});
+
+	return imin;
+}
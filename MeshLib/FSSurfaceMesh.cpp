@@ -31,6 +31,7 @@ SOFTWARE.*/
 #include "FSFaceEdgeList.h"
 #include "FSNodeEdgeList.h"
 #include "FSNodeFaceList.h"
+#include "FSPointGrid.h"
 using namespace std;
 
 FSSurfaceMesh::FSSurfaceMesh()
@@ -1353,34 +1354,26 @@ void FSSurfaceMesh::AttachAndWeld(const FSSurfaceMesh& mesh, double weldToleranc
 		}
 	}
 
+	// put the boundary nodes in a grid, so we only need to look at nearby nodes
+	vector<vec3d> pos0(nodeList0.size());
+	for (size_t j = 0; j < nodeList0.size(); ++j) pos0[j] = nodeList0[j].second;
+	FSPointGrid grid(pos0, weldTolerance);
+
 	// if a node must be welded, we'll set their index in the tag list to the welded node index
 	int newNodes = NN0;
 	for (int i = 0; i<NN1; ++i)
 	{
 		if (tag[i] == 1)
 		{
-			double Dmin = 1e99;
-			int jmin = -1;
 			const FSNode& nodei = mesh.Node(i);
 			vec3d ri;
 			if (po2) ri = po1->GetTransform().GlobalToLocal(po2->GetTransform().LocalToGlobal(nodei.r));
 			else ri = nodei.r;
 
-			for (size_t j=0; j<nodeList0.size(); ++j)
-			{
-				vec3d& rj = nodeList0[j].second;
-
-				double D2 = (ri - rj).SqrLength();
-				if (D2 < Dmin)
-				{
-					Dmin = D2;
-					jmin = nodeList0[j].first;
-				}
-			}
-
-			if (Dmin < weldTolerance*weldTolerance)
+			int jmin = grid.FindClosest(ri, weldTolerance);
+			if (jmin >= 0)
 			{
-				tag[i] = jmin;
+				tag[i] = nodeList0[jmin].first;
 			}
 			else tag[i] = newNodes++;
 		}
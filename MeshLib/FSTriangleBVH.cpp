@@ -0,0 +1,167 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "FSTriangleBVH.h"
+
+// squared distance between a point and a box (zero if the point is inside the box)
+static double box_distance2(const BoundingBox& b, const vec3d& x)
+{
+	double dx = (x.x < b.x0 ? b.x0 - x.x : (x.x > b.x1 ? x.x - b.x1 : 0.0));
+	double dy = (x.y < b.y0 ? b.y0 - x.y : (x.y > b.y1 ? x.y - b.y1 : 0.0));
+	double dz = (x.z < b.z0 ? b.z0 - x.z : (x.z > b.z1 ? x.z - b.z1 : 0.0));
+	return dx*dx + dy*dy + dz*dz;
+}
+
+FSTriangleBVH::FSTriangleBVH()
+{
+}
+
+void FSTriangleBVH::TriangleBoxes(std::vector<BoundingBox>& box) const
+{
+	int NT = (int)m_index.size() / 3;
+	box.resize(NT);
+	#pragma omp parallel for
+	for (int i = 0; i < NT; ++i)
+	{
+		const int* n = &m_index[3 * i];
+		BoundingBox bi(m_point[n[0]], m_point[n[0]]);
+		bi += m_point[n[1]];
+		bi += m_point[n[2]];
+		box[i] = bi;
+	}
+}
+
+void FSTriangleBVH::Build(const std::vector<vec3d>& points, const std::vector<int>& tri)
+{
+	m_point = points;
+	m_index = tri;
+
+	std::vector<BoundingBox> box;
+	TriangleBoxes(box);
+	m_bvh.Build(box);
+}
+
+void FSTriangleBVH::Refit(const std::vector<vec3d>& points)
+{
+	assert(points.size() == m_point.size());
+	m_point = points;
+	if (m_bvh.IsValid() == false) return;
+
+	std::vector<BoundingBox> box;
+	TriangleBoxes(box);
+	m_bvh.Refit(box);
+}
+
+bool FSTriangleBVH::ClosestPoint(const vec3d& x, Projection& P) const
+{
+	P.tri = -1;
+	P.vert = -1;
+	P.d2 = 0.0;
+
+	m_bvh.Traverse(
+		// skip nodes that cannot contain a closer point
+		// (equal distance is visited since it may have a triangle with a lower index)
+		[&](const BoundingBox& box) {
+			return ((P.tri >= 0) && (box_distance2(box, x) > P.d2));
+		},
+		[&](int tid) {
+			if ((P.tri >= 0) && (box_distance2(m_bvh.PrimitiveBox(tid), x) > P.d2)) return;
+
+			const int* n = &m_index[3 * tid];
+			int vert;
+			vec3d q = ClosestPointOnTriangle(x, m_point[n[0]], m_point[n[1]], m_point[n[2]], vert);
+			double d2 = (q - x).SqrLength();
+			if ((P.tri == -1) || (d2 < P.d2) || ((d2 == P.d2) && (tid < P.tri)))
+			{
+				P.q = q;
+				P.d2 = d2;
+				P.tri = tid;
+				P.vert = vert;
+			}
+		},
+		// visit the closest child first
+		[&](const BoundingBox& l, const BoundingBox& r) {
+			return (box_distance2(l, x) > box_distance2(r, x));
+		});
+
+	return (P.tri != -1);
+}
+
+// See Ericson, Real-Time Collision Detection, section 5.1.5
+vec3d FSTriangleBVH::ClosestPointOnTriangle(const vec3d& p, const vec3d& a, const vec3d& b, const vec3d& c, int& vert)
+{
+	vert = -1;
+	vec3d ab = b - a;
+	vec3d ac = c - a;
+	vec3d ap = p - a;
+
+	// vertex region a
+	double d1 = ab*ap;
+	double d2 = ac*ap;
+	if ((d1 <= 0.0) && (d2 <= 0.0)) { vert = 0; return a; }
+
+	// vertex region b
+	vec3d bp = p - b;
+	double d3 = ab*bp;
+	double d4 = ac*bp;
+	if ((d3 >= 0.0) && (d4 <= d3)) { vert = 1; return b; }
+
+	// edge region ab
+	double vc = d1*d4 - d3*d2;
+	if ((vc <= 0.0) && (d1 >= 0.0) && (d3 <= 0.0))
+	{
+		double v = d1 / (d1 - d3);
+		return a + ab*v;
+	}
+
+	// vertex region c
+	vec3d cp = p - c;
+	double d5 = ab*cp;
+	double d6 = ac*cp;
+	if ((d6 >= 0.0) && (d5 <= d6)) { vert = 2; return c; }
+
+	// edge region ac
+	double vb = d5*d2 - d1*d6;
+	if ((vb <= 0.0) && (d2 >= 0.0) && (d6 <= 0.0))
+	{
+		double w = d2 / (d2 - d6);
+		return a + ac*w;
+	}
+
+	// edge region bc
+	double va = d3*d6 - d5*d4;
+	if ((va <= 0.0) && ((d4 - d3) >= 0.0) && ((d5 - d6) >= 0.0))
+	{
+		double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		return b + (c - b)*w;
+	}
+
+	// inside face region
+	double den = va + vb + vc;
+	if (den == 0.0) { vert = 0; return a; } // degenerate triangle
+	double v = vb / den;
+	double w = vc / den;
+	return a + ab*v + ac*w;
+}
@@ -0,0 +1,77 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include "FSBoxBVH.h"
+
+//-----------------------------------------------------------------------------
+// A bounding volume hierarchy of triangles, used to find the closest point on
+// a triangulated surface. The triangles are defined by indices into a point
+// array. When the points move (e.g. in a new state), the hierarchy can be
+// refit, which only updates the bounding boxes, but keeps the tree structure.
+class FSTriangleBVH
+{
+public:
+	// result of a closest point query
+	struct Projection
+	{
+		vec3d	q;		// closest point
+		double	d2;		// squared distance to closest point
+		int		tri;	// index of closest triangle
+		int		vert;	// local vertex index (0-2) if the closest point is a vertex of the triangle, or -1 otherwise
+	};
+
+public:
+	FSTriangleBVH();
+
+	// Build the hierarchy. The triangle list stores three point indices per triangle.
+	void Build(const std::vector<vec3d>& points, const std::vector<int>& tri);
+
+	// update the point positions and the bounding boxes
+	void Refit(const std::vector<vec3d>& points);
+
+	// find the closest point on the surface to x. If more than one triangle
+	// has the same distance, the triangle with the lowest index is returned.
+	bool ClosestPoint(const vec3d& x, Projection& P) const;
+
+	// number of triangles
+	int Triangles() const { return m_bvh.Primitives(); }
+
+	// is the hierarchy built
+	bool IsValid() const { return m_bvh.IsValid(); }
+
+public:
+	// Calculate the closest point on the triangle (a, b, c) to p. If the closest
+	// point is a vertex, its local index is returned in vert, otherwise vert is -1.
+	static vec3d ClosestPointOnTriangle(const vec3d& p, const vec3d& a, const vec3d& b, const vec3d& c, int& vert);
+
+private:
+	void TriangleBoxes(std::vector<BoundingBox>& box) const;
+
+private:
+	FSBoxBVH			m_bvh;		// hierarchy of triangle bounding boxes
+	std::vector<int>	m_index;	// point indices of triangles
+	std::vector<vec3d>	m_point;	// point coordinates
+};
@@ -28,8 +28,92 @@ SOFTWARE.*/
 #include "FEWeldModifier.h"
 #include <MeshLib/FSMeshBuilder.h>
 #include <MeshLib/FSSurfaceMesh.h>
+#include <MeshLib/FSPointGrid.h>
 using namespace std;
 
+//-----------------------------------------------------------------------------
+// Keeps track of the nodes that the selected nodes are welded to (their targets)
+// while the weld loops run. A selected node is always compared against the
+// current position of its target, just like the pairwise loop does. Targets move
+// when nodes are welded to them, so the grid of the original positions is searched
+// with the threshold extended by the largest distance that any target has moved.
+class FEWeldTargets
+{
+public:
+	FEWeldTargets(FSMeshBase& m, const vector<int>& sel, vector<int>& order, double threshold) : m_mesh(m), m_sel(sel), m_order(order), m_pos(Positions(m, sel)), m_grid(m_pos, threshold)
+	{
+		int n = (int)sel.size();
+		m_lid.assign(m.Nodes(), -1);
+		m_members.resize(n);
+		for (int i = 0; i < n; ++i)
+		{
+			m_lid[sel[i]] = i;
+			m_members[i].push_back(i);
+		}
+		m_R = threshold;
+		m_drift = 0.0;
+	}
+
+	// Find the targets (as indices into the selection) that lie within the threshold
+	// of r. The targets are returned in ascending order, with their squared distances.
+	void FindTargets(const vec3d& r, vector<pair<int, double> >& l)
+	{
+		l.clear();
+		m_grid.FindNeighbors(r, m_R + m_drift, m_cand);
+		double eps = m_R * m_R;
+		for (int k : m_cand)
+		{
+			if (m_members[k].empty()) continue;
+			const vec3d& rk = m_mesh.Node(m_sel[k]).r;
+			double d = (r.x - rk.x)*(r.x - rk.x) + (r.y - rk.y)*(r.y - rk.y) + (r.z - rk.z)*(r.z - rk.z);
+			if (d <= eps) l.push_back(make_pair(k, d));
+		}
+	}
+
+	// the selected nodes that are welded to target k
+	const vector<int>& Members(int k) const { return m_members[k]; }
+
+	// the target of selected node j
+	int Target(int j) const { return m_lid[m_order[m_sel[j]]]; }
+
+	// weld the selected node j to the target node ni
+	void Weld(int j, int ni)
+	{
+		vector<int>& l = m_members[Target(j)];
+		l.erase(find(l.begin(), l.end(), j));
+		m_order[m_sel[j]] = ni;
+		m_members[m_lid[ni]].push_back(j);
+	}
+
+	// update the drift after target node ni was moved
+	void Moved(int ni)
+	{
+		int k = m_lid[ni];
+		double d = (m_mesh.Node(ni).r - m_pos[k]).Length();
+		if (d > m_drift) m_drift = d;
+	}
+
+private:
+	static vector<vec3d> Positions(FSMeshBase& m, const vector<int>& sel)
+	{
+		vector<vec3d> pos(sel.size());
+		for (size_t i = 0; i < sel.size(); ++i) pos[i] = m.Node(sel[i]).r;
+		return pos;
+	}
+
+private:
+	FSMeshBase&			m_mesh;
+	const vector<int>&	m_sel;
+	vector<int>&		m_order;
+	vector<vec3d>		m_pos;		// original positions of the selected nodes
+	FSPointGrid			m_grid;
+	vector<int>			m_lid;		// selection index of each mesh node
+	vector< vector<int> >	m_members;	// selected nodes that are welded to each target
+	vector<int>			m_cand;
+	double				m_R;		// weld threshold
+	double				m_drift;	// max distance that a target has moved
+};
+
 //! constructor
 FEWeldNodes::FEWeldNodes() : FEModifier("Weld nodes")
 { 
@@ -91,31 +175,43 @@ void FEWeldNodes::UpdateNodes(FSMesh* pm)
 	double threshold = GetFloatValue(0);
 	double eps = threshold*threshold;
 
-	// loop over the selected nodes
+	// Loop over the selected nodes. For each node, we look for the next node (in 
+	// selection order) that lies within the threshold, weld it, and continue from
+	// there. This gives the same result as comparing all pairs in order.
 	int n = (int) sel.size();
+	FEWeldTargets targets(m, sel, m_order, threshold);
+	vector<pair<int, double> > cand;
 	for (int i=0; i<n-1; ++i)
-		for (int j=i+1; j<n; ++j)
+	{
+		int ni = m_order[sel[i]];
+		vec3d& ri = m.Node(ni).r;
+		int last = i;
+		while (true)
 		{
-			int ni = m_order[sel[i]];
-			int nj = m_order[sel[j]];
-
-			if (ni != nj)
+			// find the next node that is welded to a target within the threshold
+			targets.FindTargets(ri, cand);
+			int jmin = n;
+			for (auto& c : cand)
 			{
-				// calculate distance between nodes
-				vec3d& ri = m.Node(ni).r;
-				vec3d& rj = m.Node(nj).r;
+				if (sel[c.first] == ni) continue;
+				for (int j : targets.Members(c.first))
+					if ((j > last) && (j < jmin)) jmin = j;
+			}
+			if (jmin == n) break;
 
-				double d = (ri.x-rj.x)*(ri.x-rj.x)+(ri.y-rj.y)*(ri.y-rj.y)+(ri.z-rj.z)*(ri.z-rj.z);
-				if (d <= eps)
-				{
-					// weld nodes ni and nj
-					m_order[sel[j]] = ni;
+			int nj = m_order[sel[jmin]];
+			vec3d& rj = m.Node(nj).r;
 
-					// move nodes to the average of the two
-					ri = (ri+rj)*0.5;
-				}
-			}
+			// weld nodes ni and nj
+			targets.Weld(jmin, ni);
+
+			// move nodes to the average of the two
+			ri = (ri+rj)*0.5;
+			targets.Moved(ni);
+
+			last = jmin;
 		}
+	}
 
 	// reassign node numbers
 	for (int i=0; i<nodes; ++i)
@@ -346,25 +442,25 @@ void FEWeldSurfaceNodes::UpdateNodes(FSSurfaceMesh* pm)
 
 	// loop over the selected nodes
 	int n = (int)sel.size();
+	FEWeldTargets targets(m, sel, m_order, threshold);
+	vector<pair<int, double> > cand;
 	for (int i = 0; i < n - 1; ++i)
 	{
 		int ni = m_order[sel[i]];
 		vec3d& ri = m.Node(ni).r;
 
-		// find the closest node
+		// find the closest node (the first one in selection order if there is a tie)
 		int jmin = -1;
 		double dmin = 0.0;
-		for (int j = i + 1; j < n; ++j)
+		targets.FindTargets(ri, cand);
+		for (auto& c : cand)
 		{
-			int nj = m_order[sel[j]];
-
-			if (ni != nj)
+			if (sel[c.first] == ni) continue;
+			for (int j : targets.Members(c.first))
 			{
-				// calculate distance between nodes
-				vec3d& rj = m.Node(nj).r;
-
-				double d = (ri.x - rj.x)*(ri.x - rj.x) + (ri.y - rj.y)*(ri.y - rj.y) + (ri.z - rj.z)*(ri.z - rj.z);
-				if ((d <= eps) && ((d < dmin) || jmin == -1))
+				if (j <= i) continue;
+				double d = c.second;
+				if ((jmin == -1) || (d < dmin) || ((d == dmin) && (j < jmin)))
 				{
 					jmin = j;
 					dmin = d;
@@ -380,10 +476,11 @@ void FEWeldSurfaceNodes::UpdateNodes(FSSurfaceMesh* pm)
 			vec3d& rj = m.Node(nj).r;
 
 			// weld nodes ni and nj
-			m_order[sel[jmin]] = ni;
+			targets.Weld(jmin, ni);
 
 			// move nodes to the average of the two
 			ri = (ri + rj)*0.5;
+			targets.Moved(ni);
 		}
 	}
 
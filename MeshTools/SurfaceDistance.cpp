@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include "SurfaceDistance.h"
 #include <MeshLib/FSMesh.h>
 #include <GeomLib/GObject.h>
+#include <MeshLib/FSTriangleBVH.h>
 
 CSurfaceDistance::CSurfaceDistance()
 {
@@ -250,10 +251,37 @@ bool CSurfaceDistance::ClosestPoint(GObject* pso, GObject* pmo, std::vector<doub
 	FSMesh* ps = pso->GetFEMesh();
 	FSMesh* pm = pmo->GetFEMesh();
 
+	// triangulate the surface of the master mesh
+	std::vector<vec3d> pts(pm->Nodes());
+	for (int i = 0; i < pm->Nodes(); ++i) pts[i] = pm->Node(i).r;
+
+	std::vector<int> tri;
+	tri.reserve(6 * pm->Faces());
+	for (int i = 0; i < pm->Faces(); ++i)
+	{
+		// only the corner nodes are used, so higher-order faces are treated as linear
+		FSFace& f = pm->Face(i);
+		switch (f.Shape())
+		{
+		case FE_FACE_TRI:
+			tri.insert(tri.end(), { f.n[0], f.n[1], f.n[2] });
+			break;
+		case FE_FACE_QUAD:
+			tri.insert(tri.end(), { f.n[0], f.n[1], f.n[2] });
+			tri.insert(tri.end(), { f.n[0], f.n[2], f.n[3] });
+			break;
+		}
+	}
+	if (tri.empty()) return false;
+
+	FSTriangleBVH bvh;
+	bvh.Build(pts, tri);
+
 	// get the number of nodes
 	int nodes = ps->Nodes();
 
 	// repeat for all nodes
+#pragma omp parallel for schedule(dynamic, 256)
 	for (int i=0; i<nodes; ++i)
 	{
 		FSNode& nodei = ps->Node(i);
@@ -264,26 +292,11 @@ bool CSurfaceDistance::ClosestPoint(GObject* pso, GObject* pmo, std::vector<doub
 		// convert it to the local coordinate in the master object
 		ri = pmo->GetTransform().GlobalToLocal(ri);
 
-		// repeat over all master nodes
-		double Dmin = 0.0;
-		for (int j=0; j<pm->Nodes(); ++j)
-		{
-			// get the position of the master node
-			vec3d& rj = pm->Node(j).r;
-
-			// separation vector
-			vec3d r = rj - ri;
-
-			// square length
-			double d2 = r*r;
-
-			if ((d2 < Dmin)||(j==0))
-			{
-				Dmin = d2;
-			}			
-		}
+		// find the closest point on the master surface
+		FSTriangleBVH::Projection P;
+		bvh.ClosestPoint(ri, P);
 
-		dist[i] = sqrt(Dmin);
+		dist[i] = sqrt(P.d2);
 	}
 
 	return true;
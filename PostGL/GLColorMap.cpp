@@ -182,13 +182,11 @@ void CGLColorMap::UpdateRange(int n0, int n1, float dt, bool breset)
 				FSElement_& el = pm->ElementRef(i);
 				if (ignoreHiddenMesh && !el.IsVisible()) continue;
 
-				ELEMDATA& d0 = s0.m_ELEM[i];
-				ELEMDATA& d1 = s1.m_ELEM[i];
-				if ((d0.m_state & StatusFlags::ACTIVE) && (d1.m_state & StatusFlags::ACTIVE))
+				if ((s0.m_ELEM.m_state[i] & StatusFlags::ACTIVE) && (s1.m_ELEM.m_state[i] & StatusFlags::ACTIVE))
 				{
 					vec3d r = pm->ElementCenter(el);
-					float f0 = d0.m_val;
-					float f1 = d1.m_val;
+					float f0 = s0.m_ELEM.m_val[i];
+					float f1 = s1.m_ELEM.m_val[i];
 					float f = f0 + (f1 - f0) * w;
 					if (f > fmax) { fmax = f; m_rmax = r; }
 					if (f < fmin) { fmin = f; m_rmin = r; }
@@ -205,9 +203,7 @@ void CGLColorMap::UpdateRange(int n0, int n1, float dt, bool breset)
 				FSElement_& el = pm->ElementRef(i);
 				if (ignoreHiddenMesh && !el.IsVisible()) continue;
 
-				ELEMDATA& d0 = s0.m_ELEM[i];
-				ELEMDATA& d1 = s1.m_ELEM[i];
-				if ((d0.m_state & StatusFlags::ACTIVE) && (d1.m_state & StatusFlags::ACTIVE))
+				if ((s0.m_ELEM.m_state[i] & StatusFlags::ACTIVE) && (s1.m_ELEM.m_state[i] & StatusFlags::ACTIVE))
 				{
 					for (int j = 0; j < el.Nodes(); ++j)
 					{
@@ -333,9 +329,7 @@ void CGLColorMap::UpdateRange(int n0, int n1, float dt, bool breset)
 	for (int i = 0; i < pm->Elements(); ++i)
 	{
 		FSElement_& el = pm->ElementRef(i);
-		ELEMDATA& d0 = s0.m_ELEM[i];
-		ELEMDATA& d1 = s1.m_ELEM[i];
-		if ((d0.m_state & StatusFlags::ACTIVE) && (d1.m_state & StatusFlags::ACTIVE))
+		if ((s0.m_ELEM.m_state[i] & StatusFlags::ACTIVE) && (s1.m_ELEM.m_state[i] & StatusFlags::ACTIVE))
 		{
 			el.Activate();
 		}
@@ -378,39 +372,44 @@ void CGLColorMap::UpdateRenderMesh(int n0, int n1, float dt)
 
 	vector<double> buf(pm->Nodes());
 
+	// Only the texture coordinates of the render mesh are updated, so this
+	// can be done in parallel over the faces.
+	int NF = gmsh->Faces();
+	int NFO = obj->Faces();
 	if (m_bDispNodeVals == false)
 	{
 		ValArray& faceData0 = s0.m_FaceData;
 		ValArray& faceData1 = s1.m_FaceData;
 
-		vector<float> buf(pm->Nodes());
-
-		for (int i = 0; i < gmsh->Faces(); ++i)
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < NF; ++i)
 		{
 			GLMesh::FACE& glface = gmsh->Face(i);
-			if (glface.pid < obj->Faces())
+			if (glface.pid < NFO)
 			{
 				assert(glface.fid >= 0);
 				FSFace& face = pm->Face(glface.fid);
 
 				FACEDATA& fd0 = s0.m_FACE[glface.fid];
-				FACEDATA& fd1 = s1.m_FACE[glface.fid];
 				if (face.IsEnabled() && (fd0.m_ntag > 0))
 				{
-					face.m_ntag = 1;
-					for (int j = 0; j < face.Nodes(); ++j)
-					{
-						float f0 = faceData0.value(glface.fid, j);
-						float f1 = (n0 == n1 ? f0 : faceData1.value(glface.fid, j));
-						float f = f0 + (f1 - f0) * w;
-						buf[face.n[j]] = f;
-					}
-
 					for (int j = 0; j < 3; ++j)
 					{
 						int nj = glface.n[j];
 						int nid = gmsh->Node(nj).nid;
-						float f = ((nid >= 0) && (nid < buf.size()) ? buf[nid] - min : 0.f);
+
+						// find the face data of this node
+						float f = 0.f;
+						for (int k = 0; k < face.Nodes(); ++k)
+						{
+							if (face.n[k] == nid)
+							{
+								float f0 = faceData0.value(glface.fid, k);
+								float f1 = (n0 == n1 ? f0 : faceData1.value(glface.fid, k));
+								f = f0 + (f1 - f0) * w - min;
+								break;
+							}
+						}
 						glface.t[j] = vec3f(f * dti, 0.f, 0.f);
 					}
 				}
@@ -423,13 +422,24 @@ void CGLColorMap::UpdateRenderMesh(int n0, int n1, float dt)
 				}
 			}
 		}
+
+		for (int i = 0; i < NF; ++i)
+		{
+			GLMesh::FACE& glface = gmsh->Face(i);
+			if (glface.pid < NFO)
+			{
+				FSFace& face = pm->Face(glface.fid);
+				if (face.IsEnabled() && (s0.m_FACE[glface.fid].m_ntag > 0)) face.m_ntag = 1;
+			}
+		}
 	}
 	else
 	{
-		for (int i = 0; i < gmsh->Faces(); ++i)
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < NF; ++i)
 		{
 			GLMesh::FACE& glface = gmsh->Face(i);
-			if (glface.pid < obj->Faces())
+			if (glface.pid < NFO)
 			{
 				assert(glface.fid >= 0);
 				FSFace& face = pm->Face(glface.fid);
@@ -483,10 +493,7 @@ void CGLColorMap::UpdateRenderMesh(int n0, int n1, float dt)
 
 			int iel = face.m_elem[0].eid;
 
-			ELEMDATA& d0 = s0.m_ELEM[iel];
-			ELEMDATA& d1 = s1.m_ELEM[iel];
-
-			if (((d0.m_state & StatusFlags::ACTIVE) == 0) || ((d1.m_state & StatusFlags::ACTIVE) == 0))
+			if (((s0.m_ELEM.m_state[iel] & StatusFlags::ACTIVE) == 0) || ((s1.m_ELEM.m_state[iel] & StatusFlags::ACTIVE) == 0))
 			{
 				face.Deactivate();
 			}
@@ -518,12 +525,10 @@ void CGLColorMap::UpdateRenderMesh(int n0, int n1, float dt)
 			int ni = de.elem;
 			if (ni >= 0)
 			{
-				ELEMDATA& d0 = s0.m_ELEM[ni];
-				ELEMDATA& d1 = s1.m_ELEM[ni];
-				if ((d0.m_state & StatusFlags::ACTIVE) && (d1.m_state & StatusFlags::ACTIVE))
+				if ((s0.m_ELEM.m_state[ni] & StatusFlags::ACTIVE) && (s1.m_ELEM.m_state[ni] & StatusFlags::ACTIVE))
 				{
-					float f0 = d0.m_val;
-					float f1 = d1.m_val;
+					float f0 = s0.m_ELEM.m_val[ni];
+					float f1 = s1.m_ELEM.m_val[ni];
 					float f = f0 + (f1 - f0) * w;
 					de.tex[0] = de.tex[1] = (f - min) * dti;
 				}
@@ -553,7 +558,8 @@ void CGLColorMap::UpdateRenderMesh(int n0, int n1, float dt)
 		}
 	}
 
-	gmsh->setModified(true);
+	// only the texture coordinates have changed
+	gmsh->setScalarModified(true);
 }
 
 void CGLColorMap::UpdateState(int ntime, bool breset)
@@ -91,6 +91,7 @@ void CGLDisplacementMap::Activate(bool b)
 		Post::FERefState& ref = *state->m_ref;
 		FSMeshBase* pm = state->GetFEMesh();
 		for (int i = 0; i<pm->Nodes(); ++i) pm->Node(i).r = to_vec3d(ref.m_Node[i].m_rt);
+		po->GetFSModel()->UpdateElementBVH(pm);
 	}
 }
 
@@ -225,4 +226,7 @@ void CGLDisplacementMap::UpdateNodes()
 
 	// update the normals
     pm->UpdateBoundingBox();
+
+	// the element search structure needs to be refit
+	po->GetFSModel()->UpdateElementBVH(pm);
 }
@@ -30,6 +30,9 @@ SOFTWARE.*/
 #include "GLModel.h"
 #include <FSCore/ClassDescriptor.h>
 #include <GLLib/GLRenderEngine.h>
+#include <unordered_map>
+#include <stdint.h>
+#include <omp.h>
 using namespace Post;
 
 extern int LUT[256][15];
@@ -151,30 +154,44 @@ void CGLIsoSurfacePlot::UpdateMesh()
 	float vmax = m_crng.y;
 	float D = vmax - vmin;
 
-	// build a GLMesh
-	m_renderMesh.Clear();
-	GLMesh mesh;
+	// calculate the slice values and colors
+	vector<float> ref(m_nslices);
+	vector<GLColor> col(m_nslices);
 	for (int i = 0; i < m_nslices; ++i)
 	{
-		float ref = vmin + ((float)i + 0.5f)* D / (m_nslices);
+		ref[i] = vmin + ((float)i + 0.5f)* D / (m_nslices);
 
-		float w = (ref - vmin) / D;
+		float w = (ref[i] - vmin) / D;
 
 		CColorMap& map = m_Col.ColorMap();
-		GLColor col = map.map(w);
-		col.a = (unsigned char)(m_transparency * 255.0);
-		UpdateSlice(m_renderMesh, ref, col);
+		col[i] = map.map(w);
+		col[i].a = (unsigned char)(m_transparency * 255.0);
 	}
+
+	// build the GLMesh
+	m_renderMesh.Clear();
+	UpdateSlices(m_renderMesh, ref, col);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void CGLIsoSurfacePlot::UpdateSlice(GLMesh& mesh, float ref, GLColor col)
+// A triangle of an iso-surface. The vertices are identified by the (global)
+// mesh edge they lie on, so that they can be shared between triangles.
+struct ISO_TRIANGLE
 {
-	float ev[8];	// element nodal values
-	vec3f ex[8];	// element nodal positions
-	vec3f en[8];	// element nodal gradients
+	uint64_t	key[3];	// edge keys of vertices
+	vec3f		r[3];	// vertex positions
+	vec3f		n[3];	// vertex normals
+};
 
+static inline uint64_t iso_edge_key(int a, int b)
+{
+	if (a > b) { int t = a; a = b; b = t; }
+	return ((uint64_t)a << 32) | (uint64_t)b;
+}
+
+void CGLIsoSurfacePlot::UpdateSlices(GLMesh& mesh, const vector<float>& ref, const vector<GLColor>& col)
+{
 	const int HEX_NT[8] = {0, 1, 2, 3, 4, 5, 6, 7};
 	const int PEN_NT[8] = {0, 1, 2, 2, 3, 4, 5, 5};
 	const int TET_NT[8] = {0, 1, 2, 2, 3, 3, 3, 3};
@@ -186,17 +203,34 @@ void CGLIsoSurfacePlot::UpdateSlice(GLMesh& mesh, float ref, GLColor col)
 	// get the mesh
 	FSMesh* pm = mdl->GetActiveMesh();
 
-	const int* nt = nullptr;
+	const int NS = (int)ref.size();
+	const int NE = pm->Elements();
 
-	// loop over all elements
-	for (int i=0; i<pm->Elements(); ++i)
+	// Each thread collects the triangles of its elements, per slice. With a static
+	// schedule each thread processes a contiguous range of elements, so processing the
+	// buffers in thread order gives the same triangle order as a serial loop.
+	int nthreads = omp_get_max_threads();
+	vector< vector< vector<ISO_TRIANGLE> > > buf(nthreads, vector< vector<ISO_TRIANGLE> >(NS));
+
+#pragma omp parallel num_threads(nthreads)
 	{
-		// render only if the element is visible and
-		// its material is enabled
-		FSElement_& el = pm->ElementRef(i);
-		Material* pmat = ps->GetMaterial(el.m_MatID);
-		if (pmat->benable && (el.IsVisible() || m_bcut_hidden) && el.IsSolid())
+		vector< vector<ISO_TRIANGLE> >& tbuf = buf[omp_get_thread_num()];
+
+		float ev[8];	// element nodal values
+		vec3f ex[8];	// element nodal positions
+		vec3f en[8];	// element nodal gradients
+		int   eg[8];	// element global node numbers
+
+#pragma omp for schedule(static)
+		for (int i=0; i<NE; ++i)
 		{
+			// render only if the element is visible and
+			// its material is enabled
+			FSElement_& el = pm->ElementRef(i);
+			Material* pmat = ps->GetMaterial(el.m_MatID);
+			if ((pmat->benable && (el.IsVisible() || m_bcut_hidden) && el.IsSolid()) == false) continue;
+
+			const int* nt = nullptr;
 			switch (el.Type())
 			{
 			case FE_HEX8   : nt = HEX_NT; break;
@@ -213,69 +247,117 @@ void CGLIsoSurfacePlot::UpdateSlice(GLMesh& mesh, float ref, GLColor col)
 			default:
 				assert(false);
 			}
+			if (nt == nullptr) continue;
 
 			// get the nodal values
+			float emin, emax;
 			for (int k=0; k<8; ++k)
 			{
-				FSNode& node = pm->Node(el.m_node[nt[k]]);
+				eg[k] = el.m_node[nt[k]];
+				FSNode& node = pm->Node(eg[k]);
 
-				ev[k] = m_val[el.m_node[nt[k]]];
+				ev[k] = m_val[eg[k]];
 				ex[k] = to_vec3f(node.r);
-				en[k] = m_grd[el.m_node[nt[k]]];
-			}
+				if (m_bsmooth) en[k] = m_grd[eg[k]];
 
-			// calculate the case of the element
-			int ncase = 0;
-			for (int k=0; k<8; ++k) 
-				if (ev[k] <= ref) ncase |= (1 << k);
+				if ((k == 0) || (ev[k] < emin)) emin = ev[k];
+				if ((k == 0) || (ev[k] > emax)) emax = ev[k];
+			}
 
-			// loop over faces
-			int* pf = LUT[ncase];
-			for (int l=0; l<5; l++)
+			for (int s = 0; s < NS; ++s)
 			{
-				if (*pf == -1) break;
-
-				// calculate nodal positions
-				vec3f r[3], vn[3];
-				for (int k=0; k<3; k++)
+				// skip slices that do not cut this element
+				float refs = ref[s];
+				if ((refs < emin) || (refs >= emax)) continue;
+
+				// calculate the case of the element
+				int ncase = 0;
+				for (int k=0; k<8; ++k) 
+					if (ev[k] <= refs) ncase |= (1 << k);
+
+				// loop over faces
+				int* pf = LUT[ncase];
+				for (int l=0; l<5; l++)
 				{
-					int n1 = EL_HEX[pf[k]][0];
-					int n2 = EL_HEX[pf[k]][1];
-
-					float w = (ref - ev[n1]) / (ev[n2] - ev[n1]);
-
-					r[k] = ex[n1]*(1-w) + ex[n2]*w;
-				}
+					if (*pf == -1) break;
 
-				// calculate normals
-				if (m_bsmooth)
-				{
+					// calculate nodal positions
+					ISO_TRIANGLE tri;
+					float w[3];
 					for (int k=0; k<3; k++)
 					{
 						int n1 = EL_HEX[pf[k]][0];
 						int n2 = EL_HEX[pf[k]][1];
 
-						float w = (ref - ev[n1]) / (ev[n2] - ev[n1]);
+						w[k] = (refs - ev[n1]) / (ev[n2] - ev[n1]);
 
-						vn[k] = en[n1]*(1-w) + en[n2]*w;
-						vn[k].Normalize();
+						tri.r[k] = ex[n1]*(1-w[k]) + ex[n2]*w[k];
+						tri.key[k] = iso_edge_key(eg[n1], eg[n2]);
 					}
+
+					// calculate normals
+					if (m_bsmooth)
+					{
+						for (int k=0; k<3; k++)
+						{
+							int n1 = EL_HEX[pf[k]][0];
+							int n2 = EL_HEX[pf[k]][1];
+
+							tri.n[k] = en[n1]*(1-w[k]) + en[n2]*w[k];
+							tri.n[k].Normalize();
+						}
+					}
+					else
+					{
+						for (int k=0; k<3; k++)
+						{
+							int kp1 = (k+1)%3;
+							int km1 = (k+2)%3;
+							tri.n[k] = (tri.r[kp1] - tri.r[k])^(tri.r[km1] - tri.r[k]);
+							tri.n[k].Normalize();
+						}
+					}
+
+					tbuf[s].push_back(tri);
+					pf+=3;
 				}
-				else
+			}
+		}
+	}
+
+	// Add the triangles to the mesh, slice by slice. Vertices that lie
+	// on the same mesh edge (in the same slice) are shared.
+	std::unordered_map<uint64_t, int> vertexMap;
+	vec3f tex[3];
+	for (int s = 0; s < NS; ++s)
+	{
+		size_t ntri = 0;
+		for (int t = 0; t < nthreads; ++t) ntri += buf[t][s].size();
+		vertexMap.clear();
+		vertexMap.reserve(2 * ntri);
+
+		GLColor c[3] = { col[s], col[s], col[s] };
+		for (int t = 0; t < nthreads; ++t)
+		{
+			vector<ISO_TRIANGLE>& tris = buf[t][s];
+			for (ISO_TRIANGLE& tri : tris)
+			{
+				int nodes[3];
+				for (int k = 0; k < 3; ++k)
 				{
-					for (int k=0; k<3; k++)
+					auto it = vertexMap.find(tri.key[k]);
+					if (it == vertexMap.end())
 					{
-						int kp1 = (k+1)%3;
-						int km1 = (k+2)%3;
-						vn[k] = (r[kp1] - r[k])^(r[km1] - r[k]);
-						vn[k].Normalize();
+						nodes[k] = mesh.AddNode(tri.r[k]);
+						vertexMap[tri.key[k]] = nodes[k];
 					}
+					else nodes[k] = it->second;
 				}
-
-				// Add the face
-				mesh.AddFace(r, vn, col);
-				pf+=3;
+				mesh.AddFace(nodes, tri.n, tex, c);
 			}
+
+			// release memory as we go
+			vector<ISO_TRIANGLE>().swap(tris);
 		}
 	}
 }
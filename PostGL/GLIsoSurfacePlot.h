@@ -82,7 +82,7 @@ public:
 
 protected:
 	void UpdateMesh();
-	void UpdateSlice(GLMesh& mesh, float ref, GLColor col);
+	void UpdateSlices(GLMesh& mesh, const vector<float>& ref, const vector<GLColor>& col);
 
 protected:
 	int		m_nslices;		// nr. of iso surface slices
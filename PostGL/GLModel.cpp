@@ -374,6 +374,7 @@ void CGLModel::ResetMesh()
 		FSNode& node = mesh.Node(i);
 		node.r = to_vec3d(ref.m_Node[i].m_rt);
 	}
+	fem.UpdateElementBVH(&mesh);
 }
 
 //-----------------------------------------------------------------------------
@@ -658,7 +659,7 @@ void CGLModel::SelectElemsInRange(float fmin, float fmax, bool bsel)
 		FSElement_& el = pm->ElementRef(i);
 		if (el.IsEnabled() && el.IsVisible() && ((bsel == false) || (el.IsSelected())))
 		{
-			float v = state->m_ELEM[i].m_val;
+			float v = state->m_ELEM.m_val[i];
 			if ((v >= fmin) && (v <= fmax)) el.Select();
 			else el.Unselect();
 		}
@@ -497,147 +497,183 @@ bool Post::DataScaleVec3(FEPostModel& fem, int nfield, vec3d scale)
 }
 
 //-----------------------------------------------------------------------------
-// Apply a smoothing step operation on data
-bool DataSmoothStep(FEPostModel& fem, int nfield, double theta)
+// Calls f(n) for each state of the model. The data of each state is stored separately, so
+// the states are processed in parallel. If states are loaded on demand, they are processed
+// in order instead, so that only a few states need to be in memory at any time.
+template <class F> void forEachState(FEPostModel& fem, F f)
 {
-	// loop over all states
-	int ndata = FIELD_CODE(nfield);
-	for (int n = 0; n<fem.GetStates(); ++n)
+	int NS = fem.GetStates();
+	if (fem.GetStateLoader())
 	{
-		FEState& s = *fem.GetState(n);
-		FSMesh& mesh = *s.GetFEMesh();
-		if (IS_NODE_FIELD(nfield))
-		{
-			int NN = mesh.Nodes();
-			Post::FEMeshData& d = s.m_Data[ndata];
-			
-			switch (d.GetType())
-			{
-			case DATA_SCALAR:
-			{
-				vector<float> D; D.assign(NN, 0.f);
-				vector<int> tag; tag.assign(NN, 0);
-				Post::FENodeData<float>& data = dynamic_cast< Post::FENodeData<float>& >(d);
+		for (int n = 0; n < NS; ++n) f(n);
+	}
+	else
+	{
+#pragma omp parallel for schedule(dynamic, 1)
+		for (int n = 0; n < NS; ++n) f(n);
+	}
+}
 
-				// evaluate the average value of the neighbors
-				int NE = mesh.Elements();
-				for (int i=0; i<NE; ++i)
-				{
-					FSElement_& el = mesh.ElementRef(i);
-					int ne = el.Nodes();
-					for (int j=0; j<ne; ++j)
-					{
-						float f = data[el.m_node[j]];
-						for (int k = 0; k<ne; ++k)
-						if (k != j)
-						{
-							int nk = el.m_node[k];
-							D[nk] += f;
-							tag[nk]++;
-						}
-					}
-				}
+//-----------------------------------------------------------------------------
+// blend a value with the average of its neighbors
+inline float smoothBlend(float v, float D, double theta) { return (float)((1.0 - theta)*v + theta*D); }
+inline vec3f smoothBlend(const vec3f& v, const vec3f& D, double theta) { return v * (1.0 - theta) + D*theta; }
 
-				// normalize 
-				for (int i=0; i<NN; ++i) if (tag[i]>0) D[i] /= (float) tag[i];
+//-----------------------------------------------------------------------------
+// Apply a smoothing operation on the node data of one state
+template <typename T> void DataSmoothNodes(FSMesh& mesh, FENodeData<T>& data, double theta, int niters, const T& zero)
+{
+	int NN = mesh.Nodes();
+	int NE = mesh.Elements();
 
-				// assign to data field
-				for (int i = 0; i<NN; ++i) { data[i] = (float)((1.0 - theta)*data[i] + theta*D[i]); }
-			}
-			break;
-			case DATA_VEC3:
-			{
-				vector<vec3f> D; D.assign(NN, vec3f(0.f, 0.f, 0.f));
-				vector<int> tag; tag.assign(NN, 0);
-				Post::FENodeData<vec3f>& data = dynamic_cast< Post::FENodeData<vec3f>& >(d);
+	// count the neighbors of each node
+	vector<int> tag(NN, 0);
+	for (int i = 0; i<NE; ++i)
+	{
+		FSElement_& el = mesh.ElementRef(i);
+		int ne = el.Nodes();
+		for (int j = 0; j<ne; ++j)
+			for (int k = 0; k<ne; ++k)
+				if (k != j) tag[el.m_node[k]]++;
+	}
 
-				// evaluate the average value of the neighbors
-				int NE = mesh.Elements();
-				for (int i = 0; i<NE; ++i)
+	vector<T> D(NN);
+	for (int iter = 0; iter < niters; ++iter)
+	{
+		// evaluate the average value of the neighbors
+		D.assign(NN, zero);
+		for (int i = 0; i<NE; ++i)
+		{
+			FSElement_& el = mesh.ElementRef(i);
+			int ne = el.Nodes();
+			for (int j = 0; j<ne; ++j)
+			{
+				T v = data[el.m_node[j]];
+				for (int k = 0; k<ne; ++k)
+				if (k != j)
 				{
-					FSElement_& el = mesh.ElementRef(i);
-					int ne = el.Nodes();
-					for (int j = 0; j<ne; ++j)
-					{
-						vec3f v = data[el.m_node[j]];
-						for (int k = 0; k<ne; ++k)
-						if (k != j)
-						{
-							int nk = el.m_node[k];
-							D[nk] += v;
-							tag[nk]++;
-						}
-					}
+					int nk = el.m_node[k];
+					D[nk] += v;
 				}
-
-				// normalize 
-				for (int i = 0; i<NN; ++i) if (tag[i]>0) D[i] /= (float)tag[i];
-
-				// assign to data field
-				for (int i = 0; i<NN; ++i) { data[i] = data[i] * (1.0 - theta) + D[i]*theta; }
-			}
-			break;
-			default:
-				return false;
 			}
 		}
-		else if (IS_ELEM_FIELD(nfield))
-		{
-			Post::FEMeshData& d = s.m_Data[ndata];
-			if ((d.GetFormat() == DATA_ITEM)&&(d.GetType() == DATA_SCALAR))
-			{
-				int NE = mesh.Elements();
 
-				vector<float> D; D.assign(NE, 0.f);
-				vector<int> tag; tag.assign(NE, 0);
-				Post::FEElementData<float, DATA_ITEM>& data = dynamic_cast< Post::FEElementData<float, DATA_ITEM>& >(d);
+		// normalize 
+		for (int i = 0; i<NN; ++i) if (tag[i]>0) D[i] /= (float)tag[i];
 
-				for (int i=0; i<NE; ++i) mesh.ElementRef(i).m_ntag = i;
+		// assign to data field
+		for (int i = 0; i<NN; ++i) { data[i] = smoothBlend(data[i], D[i], theta); }
+	}
+}
 
-				// evaluate the average value of the neighbors
-				for (int i=0; i<NE; ++i)
-				{
-					FSElement_& el = mesh.ElementRef(i);
-					int nf = el.Faces();
-					for (int j=0; j<nf; ++j)
-					{
-						FSElement_* pj = mesh.ElementPtr(el.m_nbr[j]);
-						if (pj && (data.active(pj->m_ntag)))
-						{
-							float f;
-							data.eval(pj->m_ntag, &f);
-							D[i] += f;
-							tag[i]++;
-						}
-					}
-				}
+//-----------------------------------------------------------------------------
+// Apply a smoothing operation on the element data of one state
+void DataSmoothElems(FSMesh& mesh, Post::FEElementData<float, DATA_ITEM>& data, double theta, int niters)
+{
+	int NE = mesh.Elements();
 
-				// normalize 
-				for (int i=0; i<NE; ++i) if (tag[i]>0) D[i] /= (float) tag[i];
+	// get the element values, so we don't need to evaluate them for each neighbor
+	vector<float> val(NE, 0.f);
+	vector<bool> act(NE, false);
+	for (int i = 0; i<NE; ++i)
+	{
+		if (data.active(i))
+		{
+			act[i] = true;
+			data.eval(i, &val[i]);
+		}
+	}
 
-				// assign to data field
-				for (int i = 0; i<NE; ++i) 
-					if (data.active(i))
-					{
-						float f;
-						data.eval(i, &f);
-						D[i] =(float)((1.0 - theta)*f + theta*D[i]);
-						data.set(i, D[i]);
-					}
+	// count the (active) neighbors of each element
+	vector<int> tag(NE, 0);
+	for (int i = 0; i<NE; ++i)
+	{
+		FSElement_& el = mesh.ElementRef(i);
+		int nf = el.Faces();
+		for (int j = 0; j<nf; ++j)
+		{
+			int nj = el.m_nbr[j];
+			if ((nj >= 0) && act[nj]) tag[i]++;
+		}
+	}
+
+	vector<float> D(NE);
+	for (int iter = 0; iter < niters; ++iter)
+	{
+		// evaluate the average value of the neighbors
+		D.assign(NE, 0.f);
+		for (int i = 0; i<NE; ++i)
+		{
+			FSElement_& el = mesh.ElementRef(i);
+			int nf = el.Faces();
+			for (int j = 0; j<nf; ++j)
+			{
+				int nj = el.m_nbr[j];
+				if ((nj >= 0) && act[nj]) D[i] += val[nj];
 			}
 		}
+
+		// normalize 
+		for (int i = 0; i<NE; ++i) if (tag[i]>0) D[i] /= (float)tag[i];
+
+		// update the values
+		for (int i = 0; i<NE; ++i)
+			if (act[i]) val[i] = smoothBlend(val[i], D[i], theta);
 	}
 
-	return true;
+	// assign to data field
+	for (int i = 0; i<NE; ++i)
+		if (act[i]) data.set(i, val[i]);
 }
 
 //-----------------------------------------------------------------------------
 // Apply a smoothing operation on data
 bool Post::DataSmooth(FEPostModel& fem, int nfield, double theta, int niters)
 {
-	for (int n = 0; n<niters; ++n) 
+	if ((fem.GetStates() == 0) || (niters <= 0)) return true;
+
+	// the data type is the same for all states, so we only need to check the first state
+	int ndata = FIELD_CODE(nfield);
+	Post::FEMeshData& d = fem.GetState(0)->m_Data[ndata];
+	if (IS_NODE_FIELD(nfield))
 	{
-		if (DataSmoothStep(fem, nfield, theta) == false) return false;
+		switch (d.GetType())
+		{
+		case DATA_SCALAR:
+		{
+			if (dynamic_cast<Post::FENodeData<float>*>(&d) == nullptr) return false;
+			forEachState(fem, [=, &fem](int n) {
+				FEState& s = *fem.GetState(n);
+				Post::FENodeData<float>& data = static_cast<Post::FENodeData<float>&>(s.m_Data[ndata]);
+				DataSmoothNodes<float>(*s.GetFEMesh(), data, theta, niters, 0.f);
+			});
+		}
+		break;
+		case DATA_VEC3:
+		{
+			if (dynamic_cast<Post::FENodeData<vec3f>*>(&d) == nullptr) return false;
+			forEachState(fem, [=, &fem](int n) {
+				FEState& s = *fem.GetState(n);
+				Post::FENodeData<vec3f>& data = static_cast<Post::FENodeData<vec3f>&>(s.m_Data[ndata]);
+				DataSmoothNodes<vec3f>(*s.GetFEMesh(), data, theta, niters, vec3f(0.f, 0.f, 0.f));
+			});
+		}
+		break;
+		default:
+			return false;
+		}
+	}
+	else if (IS_ELEM_FIELD(nfield))
+	{
+		if ((d.GetFormat() == DATA_ITEM)&&(d.GetType() == DATA_SCALAR))
+		{
+			if (dynamic_cast<Post::FEElementData<float, DATA_ITEM>*>(&d) == nullptr) return false;
+			forEachState(fem, [=, &fem](int n) {
+				FEState& s = *fem.GetState(n);
+				Post::FEElementData<float, DATA_ITEM>& data = static_cast<Post::FEElementData<float, DATA_ITEM>&>(s.m_Data[ndata]);
+				DataSmoothElems(*s.GetFEMesh(), data, theta, niters);
+			});
+		}
 	}
 
 	return true;
@@ -1124,155 +1160,166 @@ bool Post::DataMath(FEPostModel& fem, int nfield, int nop)
 
 
 //-----------------------------------------------------------------------------
-bool Post::DataGradient(FEPostModel& fem, int vecField, int sclField, int config)
+// Calculate the gradient of a scalar field for one state
+void DataGradientState(FEPostModel& fem, int n, int nvec, int nscl, int sclField, int config)
 {
-	int nvec = FIELD_CODE(vecField);
-	int nscl = FIELD_CODE(sclField);
+	FEState& state = *fem.GetState(n);
+	FEMeshData& v = state.m_Data[nvec];
+	FEMeshData& s = state.m_Data[nscl];
 
-	// loop over all the states
-	for (int n=0; n<fem.GetStates(); ++n)
-	{
-		FEState& state = *fem.GetState(n);
-		FEMeshData& v = state.m_Data[nvec];
-		FEMeshData& s = state.m_Data[nscl];
-
-		// zero the vector field
-		if (IS_NODE_FIELD(vecField) && (v.GetType() == DATA_VEC3))
-		{
-			FENodeData<vec3f>* pv = dynamic_cast<FENodeData<vec3f>*>(&v);
-			int N = pv->size();
-			for (int i = 0; i<N; ++i) (*pv)[i] = vec3f(0,0,0);
-		}
-		else return false;
+	// zero the vector field
+	FENodeData<vec3f>* pv = static_cast<FENodeData<vec3f>*>(&v);
+	int N = pv->size();
+	for (int i = 0; i<N; ++i) (*pv)[i] = vec3f(0,0,0);
 
-		// get the mesh
-		FSMesh* mesh = state.GetFEMesh();
+	// get the mesh
+	FSMesh* mesh = state.GetFEMesh();
 
-		// evaluate the field over all the nodes
-		const int NN = mesh->Nodes();
-		vector<double> d(NN, 0.f);
+	// evaluate the field over all the nodes
+	const int NN = mesh->Nodes();
+	vector<double> d(NN, 0.f);
 
-		if (s.GetType() == DATA_SCALAR)
+	if (s.GetType() == DATA_SCALAR)
+	{
+		if (IS_NODE_FIELD(sclField))
 		{
-			if (IS_NODE_FIELD(sclField))
-			{
-				FENodeData_T<float>* ps = dynamic_cast<FENodeData_T<float>*>(&s); assert(ps);
-				for (int i=0; i<NN; ++i) 
-				{	
-					float f;	
-					ps->eval(i, &f);
-					d[i] = (double) f;
-				}
+			FENodeData_T<float>* ps = dynamic_cast<FENodeData_T<float>*>(&s); assert(ps);
+			for (int i=0; i<NN; ++i) 
+			{	
+				float f;	
+				ps->eval(i, &f);
+				d[i] = (double) f;
 			}
-			else if (IS_ELEM_FIELD(sclField))
+		}
+		else if (IS_ELEM_FIELD(sclField))
+		{
+			if (s.GetFormat() == DATA_NODE)
 			{
-				if (s.GetFormat() == DATA_NODE)
-				{
-					vector<int> tag(NN, 0);
-					FEElemData_T<float, DATA_NODE>* ps = dynamic_cast<FEElemData_T<float, DATA_NODE>*>(&s);
+				vector<int> tag(NN, 0);
+				FEElemData_T<float, DATA_NODE>* ps = dynamic_cast<FEElemData_T<float, DATA_NODE>*>(&s);
 
-					float ed[FSElement::MAX_NODES] = {0.f};
-					for (int i=0; i<mesh->Elements(); ++i)
+				float ed[FSElement::MAX_NODES] = {0.f};
+				for (int i=0; i<mesh->Elements(); ++i)
+				{
+					FSElement_& el = mesh->ElementRef(i);
+					if (ps->active(i))
 					{
-						FSElement_& el = mesh->ElementRef(i);
-						if (ps->active(i))
+						ps->eval(i, ed);
+						for (int j=0; j<el.Nodes(); ++j)
 						{
-							ps->eval(i, ed);
-							for (int j=0; j<el.Nodes(); ++j)
-							{
-								d[el.m_node[j]] += ed[j];
-								tag[el.m_node[j]]++;
-							}
+							d[el.m_node[j]] += ed[j];
+							tag[el.m_node[j]]++;
 						}
 					}
-					for (int i=0; i<NN; ++i)
-						if (tag[i] > 0) d[i] /= (double) tag[i];
 				}
-				else if (s.GetFormat() == DATA_ITEM)
-				{
-					vector<int> tag(NN, 0);
-					FEElemData_T<float, DATA_ITEM>* ps = dynamic_cast<FEElemData_T<float, DATA_ITEM>*>(&s);
+				for (int i=0; i<NN; ++i)
+					if (tag[i] > 0) d[i] /= (double) tag[i];
+			}
+			else if (s.GetFormat() == DATA_ITEM)
+			{
+				vector<int> tag(NN, 0);
+				FEElemData_T<float, DATA_ITEM>* ps = dynamic_cast<FEElemData_T<float, DATA_ITEM>*>(&s);
 
-					float ed =  0.f;
-					for (int i = 0; i<mesh->Elements(); ++i)
+				float ed =  0.f;
+				for (int i = 0; i<mesh->Elements(); ++i)
+				{
+					FSElement_& el = mesh->ElementRef(i);
+					if (ps->active(i))
 					{
-						FSElement_& el = mesh->ElementRef(i);
-						if (ps->active(i))
+						ps->eval(i, &ed);
+						for (int j = 0; j<el.Nodes(); ++j)
 						{
-							ps->eval(i, &ed);
-							for (int j = 0; j<el.Nodes(); ++j)
-							{
-								d[el.m_node[j]] += ed;
-								tag[el.m_node[j]]++;
-							}
+							d[el.m_node[j]] += ed;
+							tag[el.m_node[j]]++;
 						}
 					}
-					for (int i = 0; i<NN; ++i)
-						if (tag[i] > 0) d[i] /= (double)tag[i];
 				}
-				else if (s.GetFormat() == DATA_MULT)
-				{
-					vector<int> tag(NN, 0);
-					FEElemData_T<float, DATA_MULT>* ps = dynamic_cast<FEElemData_T<float, DATA_MULT>*>(&s);
+				for (int i = 0; i<NN; ++i)
+					if (tag[i] > 0) d[i] /= (double)tag[i];
+			}
+			else if (s.GetFormat() == DATA_MULT)
+			{
+				vector<int> tag(NN, 0);
+				FEElemData_T<float, DATA_MULT>* ps = dynamic_cast<FEElemData_T<float, DATA_MULT>*>(&s);
 
-					float ed[FSElement::MAX_NODES] = { 0.f };
-					for (int i = 0; i<mesh->Elements(); ++i)
+				float ed[FSElement::MAX_NODES] = { 0.f };
+				for (int i = 0; i<mesh->Elements(); ++i)
+				{
+					FSElement_& el = mesh->ElementRef(i);
+					if (ps->active(i))
 					{
-						FSElement_& el = mesh->ElementRef(i);
-						if (ps->active(i))
+						ps->eval(i, ed);
+						for (int j = 0; j<el.Nodes(); ++j)
 						{
-							ps->eval(i, ed);
-							for (int j = 0; j<el.Nodes(); ++j)
-							{
-								d[el.m_node[j]] += ed[j];
-								tag[el.m_node[j]]++;
-							}
+							d[el.m_node[j]] += ed[j];
+							tag[el.m_node[j]]++;
 						}
 					}
-					for (int i = 0; i<NN; ++i)
-						if (tag[i] > 0) d[i] /= (double)tag[i];
 				}
+				for (int i = 0; i<NN; ++i)
+					if (tag[i] > 0) d[i] /= (double)tag[i];
 			}
 		}
+	}
 
-		// now, calculate the gradient for each element
-		vector<vec3f> G(NN, vec3f(0.f, 0.f, 0.f));
-		vec3f eg[FSElement::MAX_NODES];
-		float ed[FSElement::MAX_NODES];
-		vector<int> tag(NN, 0);
-		for (int i=0; i<mesh->Elements(); ++i)
-		{
-			FSElement_& el = mesh->ElementRef(i);
+	// now, calculate the gradient for each element
+	vector<vec3f> G(NN, vec3f(0.f, 0.f, 0.f));
+	vec3f eg[FSElement::MAX_NODES];
+	float ed[FSElement::MAX_NODES];
+	vector<int> tag(NN, 0);
+	for (int i=0; i<mesh->Elements(); ++i)
+	{
+		FSElement_& el = mesh->ElementRef(i);
 
-			for (int j = 0; j<el.Nodes(); ++j) ed[j] = (float)d[el.m_node[j]];
+		for (int j = 0; j<el.Nodes(); ++j) ed[j] = (float)d[el.m_node[j]];
 
-			for (int j=0; j<el.Nodes(); ++j)
-			{
-				// get the iso-coords at the nodes
-				double q[3] = {0,0,0};
-				el.iso_coord(j, q);
+		for (int j=0; j<el.Nodes(); ++j)
+		{
+			// get the iso-coords at the nodes
+			double q[3] = {0,0,0};
+			el.iso_coord(j, q);
+
+			// evaluate the gradient at the node
+			if (config == 1)
+				shape_grad(fem, i, q, n, eg);
+			else 
+				shape_grad_ref(fem, i, q, n, eg);
+
+			vec3f grad(0.f, 0.f, 0.f);
+			for (int k=0; k<el.Nodes(); ++k) grad += eg[k] * ed[k];
+			
+			G[el.m_node[j]] += grad;
+			tag[el.m_node[j]]++;
+		}
+	}
 
-				// evaluate the gradient at the node
-				if (config == 1)
-					shape_grad(fem, i, q, n, eg);
-				else 
-					shape_grad_ref(fem, i, q, n, eg);
+	for (int i = 0; i<NN; ++i)
+	{
+		if (tag[i] > 0) G[i] /= (float) tag[i];
+		(*pv)[i] = G[i];
+	}
+}
 
-				vec3f grad(0.f, 0.f, 0.f);
-				for (int k=0; k<el.Nodes(); ++k) grad += eg[k] * ed[k];
-				
-				G[el.m_node[j]] += grad;
-				tag[el.m_node[j]]++;
-			}
-		}
+//-----------------------------------------------------------------------------
+bool Post::DataGradient(FEPostModel& fem, int vecField, int sclField, int config)
+{
+	int nvec = FIELD_CODE(vecField);
+	int nscl = FIELD_CODE(sclField);
+	if (fem.GetStates() == 0) return true;
 
-		FENodeData<vec3f>* pv = dynamic_cast<FENodeData<vec3f>*>(&v);
-		for (int i = 0; i<NN; ++i)
-		{
-			if (tag[i] > 0) G[i] /= (float) tag[i];
-			(*pv)[i] = G[i];
-		}
+	// the vector field must be a nodal vec3 field
+	// (this is the same for all states, so we only need to check the first state)
+	FEMeshData& v = fem.GetState(0)->m_Data[nvec];
+	if (IS_NODE_FIELD(vecField) && (v.GetType() == DATA_VEC3))
+	{
+		if (dynamic_cast<FENodeData<vec3f>*>(&v) == nullptr) return false;
 	}
+	else return false;
+
+	// process all the states
+	forEachState(fem, [=, &fem](int n) {
+		DataGradientState(fem, n, nvec, nscl, sclField, config);
+	});
 
 	return true;
 }
@@ -2342,6 +2389,54 @@ ModelDataField* Post::DataEigenTensor(FEPostModel& fem, ModelDataField* dataFiel
 	return newField;
 }
 
+//-----------------------------------------------------------------------------
+// Evaluate the time rate of node data for state n, using a backward difference.
+template <typename T> void nodeDataTimeRate(FEPostModel& fem, int n, int nold, int nnew, int NN, const T& zero)
+{
+	Post::FENodeData<T>& vt = static_cast<FENodeData<T>&>(fem.GetState(n)->m_Data[nnew]);
+	if (n == 0)
+	{
+		for (int i = 0; i < NN; ++i)
+		{
+			vt[i] = zero;
+		}
+		return;
+	}
+
+	FEState* state0 = fem.GetState(n - 1);
+	FEState* state1 = fem.GetState(n);
+
+	double dt = state1->m_time - state0->m_time;
+
+	Post::FENodeData_T<T>& d0 = static_cast<FENodeData_T<T>&>(state0->m_Data[nold]);
+	Post::FENodeData_T<T>& d1 = static_cast<FENodeData_T<T>&>(state1->m_Data[nold]);
+
+	// access the values directly, if we can
+	Post::FENodeData<T>* p0 = dynamic_cast<FENodeData<T>*>(&d0);
+	Post::FENodeData<T>* p1 = dynamic_cast<FENodeData<T>*>(&d1);
+	if (p0 && p1)
+	{
+		for (int i = 0; i < NN; ++i)
+		{
+			T dvdt = ((*p1)[i] - (*p0)[i]) / dt;
+			vt[i] = dvdt;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < NN; ++i)
+		{
+			T v0, v1;
+			d0.eval(i, &v0);
+			d1.eval(i, &v1);
+
+			T dvdt = (v1 - v0) / dt;
+
+			vt[i] = dvdt;
+		}
+	}
+}
+
 ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField, const std::string& name)
 {
 	if (dataField == nullptr) return nullptr;
@@ -2351,6 +2446,7 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 	int nfmt = dataField->Format();
 
 	FSMesh& mesh = *fem.GetFEMesh(0);
+	int NN = mesh.Nodes();
 
 	ModelDataField* newField = 0;
 	if (nclass == NODE_DATA)
@@ -2363,39 +2459,9 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 			int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 			int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-			for (int n = 0; n < fem.GetStates(); ++n)
-			{
-				Post::FENodeData<float>& vt = dynamic_cast<FENodeData<float>&>(fem.GetState(n)->m_Data[nnew]);
-				if (n == 0)
-				{
-					for (int i = 0; i < mesh.Nodes(); ++i)
-					{
-						vt[i] = 0.f;
-					}
-				}
-				else
-				{
-					FEState* state0 = fem.GetState(n - 1);
-					FEState* state1 = fem.GetState(n);
-
-					double dt = state1->m_time - state0->m_time;
-
-					Post::FENodeData_T<float>& d0 = dynamic_cast<FENodeData_T<float>&>(state0->m_Data[nold]);
-					Post::FENodeData_T<float>& d1 = dynamic_cast<FENodeData_T<float>&>(state1->m_Data[nold]);
-
-
-					for (int i = 0; i < mesh.Nodes(); ++i)
-					{
-						float v0, v1;
-						d0.eval(i, &v0);
-						d1.eval(i, &v1);
-
-						float dvdt = (v1 - v0) / dt;
-
-						vt[i] = dvdt;
-					}
-				}
-			}
+			forEachState(fem, [=, &fem](int n) {
+				nodeDataTimeRate<float>(fem, n, nold, nnew, NN, 0.f);
+			});
 		}
 		else if (ntype == DATA_VEC3)
 		{
@@ -2405,39 +2471,9 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 			int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 			int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-			for (int n = 0; n < fem.GetStates(); ++n)
-			{
-				Post::FENodeData<vec3f>& vt = dynamic_cast<FENodeData<vec3f>&>(fem.GetState(n)->m_Data[nnew]);
-				if (n == 0)
-				{
-					for (int i = 0; i < mesh.Nodes(); ++i)
-					{
-						vt[i] = vec3f(0.f, 0.f, 0.f);
-					}
-				}
-				else
-				{
-					FEState* state0 = fem.GetState(n - 1);
-					FEState* state1 = fem.GetState(n    );
-
-					double dt = state1->m_time - state0->m_time;
-
-					Post::FENodeData_T<vec3f>& d0 = dynamic_cast<FENodeData_T<vec3f>&>(state0->m_Data[nold]);
-					Post::FENodeData_T<vec3f>& d1 = dynamic_cast<FENodeData_T<vec3f>&>(state1->m_Data[nold]);
-
-
-					for (int i = 0; i < mesh.Nodes(); ++i)
-					{
-						vec3f v0, v1;
-						d0.eval(i, &v0);
-						d1.eval(i, &v1);
-
-						vec3f dvdt = (v1 - v0) / dt;
-
-						vt[i] = dvdt;
-					}
-				}
-			}
+			forEachState(fem, [=, &fem](int n) {
+				nodeDataTimeRate<vec3f>(fem, n, nold, nnew, NN, vec3f(0.f, 0.f, 0.f));
+			});
 		}
 	}
 	else if (nclass == ELEM_DATA)
@@ -2452,12 +2488,12 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 				int nold = dataField->GetFieldID(); nold = FIELD_CODE(nold);
 				int nnew = newField->GetFieldID(); nnew = FIELD_CODE(nnew);
 
-				for (int n = 0; n < fem.GetStates(); ++n)
-				{
-					Post::FEElementData<vec3f, DATA_REGION>& vt = dynamic_cast<FEElementData<vec3f, DATA_REGION>&>(fem.GetState(n)->m_Data[nnew]);
+				int NS = fem.GetStates();
+				forEachState(fem, [=, &fem](int n) {
+					Post::FEElementData<vec3f, DATA_REGION>& vt = static_cast<FEElementData<vec3f, DATA_REGION>&>(fem.GetState(n)->m_Data[nnew]);
 
 					int n0 = n, n1 = n;
-					if (fem.GetStates() > 1)
+					if (NS > 1)
 					{
 						if (n == 0) { n1 = n + 1; }
 						else n0 = n - 1;
@@ -2478,7 +2514,7 @@ ModelDataField* Post::DataTimeRate(FEPostModel& fem, ModelDataField* dataField,
 					{
 						vt[i] = (d1[i] - d0[i]) / dt;
 					}
-				}
+				});
 			}
 		}
 	}
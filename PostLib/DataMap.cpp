@@ -40,7 +40,7 @@ void VectorMap::Gradient(int ntime, std::vector<float> &v)
 {
 	assert(m_pmesh);
 	if (m_pmesh == 0) return;
-	std::vector<vec3f>& G = m_Data[ntime];
+	std::vector<vec3f>& G = State(ntime);
 	FSMesh& mesh = *m_pmesh;
 
 	int i, k;
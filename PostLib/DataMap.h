@@ -41,7 +41,15 @@ public:
 	~DataMap(void) {}
 
 	int States() { return (int)m_Data.size(); }
-	std::vector<T>& State(int n) { return m_Data[n]; }
+
+	// The data of a state is only allocated when it is first accessed, so
+	// only the states that are actually visited take up memory.
+	std::vector<T>& State(int n)
+	{
+		std::vector<T>& d = m_Data[n];
+		if (d.size() != m_items) d.assign(m_items, m_val);
+		return d;
+	}
 	int GetTag(int n) { return m_tag[n]; }
 	void SetTag(int n, int ntag) { m_tag[n] = ntag; }
 	void SetTags(int n)
@@ -52,17 +60,21 @@ public:
 	void Create(int nstates, int items, T val = T(0), int ntag = 0)
 	{
 		m_tag.assign(nstates, ntag);
+		m_Data.clear();
 		m_Data.resize(nstates);
-		for (int i=0; i<nstates; ++i) m_Data[i].assign(items, val);
+		m_items = items;
+		m_val = val;
 	}
 
-	void Clear() { m_Data.clear(); m_tag.clear(); }
+	void Clear() { m_Data.clear(); m_tag.clear(); m_items = 0; }
 
 	void SetFEMesh(FSMesh* pm) { m_pmesh = pm; }
 
 protected:
 	std::vector<int>	m_tag;
 	std::vector< std::vector<T> >	m_Data;
+	size_t	m_items = 0;	// items per state
+	T		m_val;			// initial value of items
 	FSMesh*	m_pmesh;
 };
 
@@ -85,6 +85,9 @@ void FEAreaCoverage::Surface::Create(FSMesh& mesh)
 			m_NLT[inode].push_back(i);
 		}
 	}
+
+	// the hierarchy is built when the positions are first updated
+	m_bvh = FSRayBVH();
 }
 
 //-----------------------------------------------------------------------------
@@ -255,6 +258,20 @@ void FEAreaCoverage::UpdateSurface(FEAreaCoverage::Surface& s, int nstate)
 		}
 	}
 	for (int i=0; i<(int)s.m_norm.size(); ++i) s.m_norm[i].Normalize();
+
+	// update the face boxes of the ray-query hierarchy
+	vector<BoundingBox> box(NF);
+#pragma omp parallel for
+	for (int i = 0; i < NF; ++i)
+	{
+		FSFace& f = mesh.Face(s.m_face[i]);
+		int nn = (f.Shape() == FE_FACE_QUAD ? 4 : 3);
+		vec3d rn[4];
+		for (int j = 0; j < nn; ++j) rn[j] = to_vec3d(s.m_pos[s.m_lnode[i*MN + j]]);
+		box[i] = FSRayBVH::FaceBox(rn, nn);
+	}
+	if (s.m_bvh.IsValid() && (s.m_bvh.Primitives() == NF)) s.m_bvh.Refit(box);
+	else s.m_bvh.Build(box);
 }
 
 //-----------------------------------------------------------------------------
@@ -298,24 +315,16 @@ bool FEAreaCoverage::intersect(const vec3f& r, const vec3f& N, FEAreaCoverage::S
 	vec3d rd = to_vec3d(r);
 	Ray ray = {rd, to_vec3d(N)};
 
-	// loop over all facets connected to this node
-	Intersection q;
-	int imin = -1;
-	double Lmin;
-	for (int i = 0; i<(int)surf.m_face.size(); ++i)
-	{
-		// see if the ray intersects this face
-		if (faceIntersect(surf, ray, i, q))
-		{
-			double L = (q.point - rd).Length();
-			if ((imin == -1) || (L < Lmin))
-			{
-				imin = i;
-				Lmin = L;
-				qmin = q;
-			}
-		}
-	}
+	// find the closest face that the ray intersects
+	bool bothSides = m_ballowBackIntersections;
+	int imin = surf.m_bvh.CastRay(rd, ray.direction, bothSides, [&](int i, double& L) {
+		Intersection q;
+		if (faceIntersect(surf, ray, i, q) == false) return false;
+		L = (q.point - rd).Length();
+		return true;
+	});
+
+	if (imin != -1) faceIntersect(surf, ray, imin, qmin);
 
 	return (imin != -1);
 }
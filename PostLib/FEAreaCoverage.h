@@ -27,6 +27,7 @@ SOFTWARE.*/
 #pragma once
 #include <MeshLib/FSMesh.h>
 #include <MeshLib/Intersect.h>
+#include <MeshLib/FSRayBVH.h>
 #include <vector>
 #include <string>
 #include "FEDataField.h"
@@ -55,6 +56,8 @@ class FEAreaCoverage : public ModelDataField
 		vector<vec3f>	m_fnorm;	// face normals
 
 		vector<vector<int> >	m_NLT;	// node-facet look-up table
+
+		FSRayBVH	m_bvh;	// ray-query hierarchy of the faces
 	};
 
 public:
@@ -311,7 +311,7 @@ bool FEASCIIExport::Save(FEPostModel* pfem, int n0, int n1, const char* szfile)
 					FSElement_& e = m.ElementRef(i);
 					if (e.m_ntag == 1)
 					{
-						float& d = ps->m_ELEM[i].m_val;
+						float& d = ps->m_ELEM.m_val[i];
 						int id = m.ElementRef(i).m_nid;
 						print_format(szfmt, id, d, fp);
 					}
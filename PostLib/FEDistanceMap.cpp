@@ -110,18 +110,38 @@ void Post::FEDistanceMap::Surface::BuildNodeList(FSMesh& mesh)
 		for (int j=0; j<nf; ++j) m_lnode[MN * i + j] = mesh.Node(f.n[j]).m_ntag;
 	}
 
-	// create the node-facet look-up table
-	m_NLT.resize(Nodes());
+	// triangulate the surface (only the corner nodes are used)
+	m_tri.clear();
+	m_triFace.clear();
 	for (int i=0; i<Faces(); ++i)
 	{
 		FSFace& f = mesh.Face(m_face[i]);
-		int nf = f.Nodes();
-		for (int j=0; j<nf; ++j)
+		const int* ln = &m_lnode[MN*i];
+		switch (f.Type())
 		{
-			int inode = m_lnode[MN*i+j];
-			m_NLT[inode].push_back(m_face[i]);
+		case FE_FACE_TRI3:
+		case FE_FACE_TRI6:
+		case FE_FACE_TRI7:
+		case FE_FACE_TRI10:
+			m_tri.insert(m_tri.end(), { ln[0], ln[1], ln[2] });
+			m_triFace.push_back(i);
+			break;
+		case FE_FACE_QUAD4:
+		case FE_FACE_QUAD8:
+		case FE_FACE_QUAD9:
+			m_tri.insert(m_tri.end(), { ln[0], ln[1], ln[2] });
+			m_tri.insert(m_tri.end(), { ln[0], ln[2], ln[3] });
+			m_triFace.push_back(i);
+			m_triFace.push_back(i);
+			break;
+		default:
+			assert(false);
 		}
 	}
+
+	// the hierarchy is built when the positions are known
+	m_pos.clear();
+	m_bvh = FSTriangleBVH();
 }
 
 //-----------------------------------------------------------------------------
@@ -186,6 +206,10 @@ void Post::FEDistanceMap::ApplyState(int n)
 	FEState* ps = fem.GetState(n);
 	Post::FEFaceData<float, DATA_NODE>* df = dynamic_cast<Post::FEFaceData<float, DATA_NODE>*>(&ps->m_Data[nfield]);
 
+	// update the surfaces to this state
+	UpdateSurface(m_surf1, n);
+	UpdateSurface(m_surf2, n);
+
 	// loop over all nodes of surface 1
 	vector<float> a(m_surf1.Nodes());
 	#pragma omp parallel for
@@ -194,7 +218,7 @@ void Post::FEDistanceMap::ApplyState(int n)
 		int inode = m_surf1.m_node[i];
 		FSNode& node = mesh.Node(inode);
 		vec3f r = fem.NodePosition(inode, n);
-		Projection P = project(m_surf2, r, n);
+		Projection P = project(m_surf2, r);
 		a[i] = (P.q - r).Length();
 		if (m_bsigned)
 		{
@@ -222,7 +246,7 @@ void Post::FEDistanceMap::ApplyState(int n)
 		int inode = m_surf2.m_node[i];
 		FSNode& node = mesh.Node(inode);
 		vec3f r = fem.NodePosition(inode, n);
-		Projection P = project(m_surf1, r, n);
+		Projection P = project(m_surf1, r);
 		b[i] = (P.q - r).Length();
 		if (m_bsigned)
 		{
@@ -261,131 +285,48 @@ void Post::FEDistanceMap::Init()
 }
 
 //-----------------------------------------------------------------------------
-Post::FEDistanceMap::Projection Post::FEDistanceMap::project(Post::FEDistanceMap::Surface& surf, vec3f& r, int ntime)
+void Post::FEDistanceMap::UpdateSurface(Post::FEDistanceMap::Surface& s, int ntime)
 {
 	Post::FEPostModel& fem = *GetModel();
-	FSMesh& mesh = *fem.GetFEMesh(0);
 
+	int NN = s.Nodes();
+	s.m_pos.resize(NN);
+	for (int i = 0; i < NN; ++i) s.m_pos[i] = to_vec3d(fem.NodePosition(s.m_node[i], ntime));
+
+	// the hierarchy is built for the first state, and refit for all others
+	if (s.m_bvh.IsValid()) s.m_bvh.Refit(s.m_pos);
+	else s.m_bvh.Build(s.m_pos, s.m_tri);
+}
+
+//-----------------------------------------------------------------------------
+Post::FEDistanceMap::Projection Post::FEDistanceMap::project(Post::FEDistanceMap::Surface& surf, vec3f& r)
+{
 	Post::FEDistanceMap::Projection P;
+	P.q = r;
+	P.n = vec3f(0, 0, 0);
 
-	// find the closest surface node
-	vec3f q = fem.NodePosition(surf.m_node[0], ntime);
-	float Dmin = (q - r)*(q - r);
-	int imin = 0;
-	for (int i=1; i<surf.Nodes(); ++i)
-	{
-		vec3f p = fem.NodePosition(surf.m_node[i], ntime);
-		float D = (p - r)*(p - r);
-		if (D < Dmin)
-		{
-			q = p;
-			Dmin = D;
-			imin = i;
-		}
-	}
-	P.q = q;
-	P.n = surf.m_norm[imin];
+	FSTriangleBVH::Projection Q;
+	if (surf.m_bvh.ClosestPoint(to_vec3d(r), Q) == false) return P;
 
-	// Look into the nearest node's star first. 
-	bool found = false;
-	vector<int>& FT = surf.m_NLT[imin];
-	for (int i = 0; i < (int)FT.size(); ++i)
+	P.q = to_vec3f(Q.q);
+	if (Q.vert >= 0)
 	{
-		// get the i-th facet
-		FSFace& face = mesh.Face(FT[i]);
-
-		// project r onto the the facet
-		Projection Pi;
-		if (ProjectToFacet(face, r, ntime, Pi))
-		{
-			// return the closest projection
-			float D = (Pi.q - r) * (Pi.q - r);
-			if (D < Dmin)
-			{
-				P = Pi;
-				Dmin = D;
-				found = true;
-			}
-		}
+		// the closest point is a node, so we use the node normal
+		int inode = surf.m_tri[3 * Q.tri + Q.vert];
+		P.n = surf.m_norm[inode];
 	}
-
-	if (!found)
+	else
 	{
-		// The previous search can fail since the nearest node's star may not contain
-		// the point r. This shouldn't happen a lot, but if it does happen, let's do an expensive search
-		// over all facets.
-		for (int i = 0; i < (int)surf.Faces(); ++i)
-		{
-			// get the i-th facet
-			FSFace& face = mesh.Face(surf.m_face[i]);
-
-			// project r onto the the facet
-			Projection Pi;
-			if (ProjectToFacet(face, r, ntime, Pi))
-			{
-				// return the closest projection
-				float D = (Pi.q - r) * (Pi.q - r);
-				if (D < Dmin)
-				{
-					P = Pi;
-					Dmin = D;
-				}
-			}
-		}
+		// use the facet normal
+		const int MN = FSFace::MAX_NODES;
+		int iface = surf.m_triFace[Q.tri];
+		const int* ln = &surf.m_lnode[MN * iface];
+		vec3f y0 = to_vec3f(surf.m_pos[ln[0]]);
+		vec3f y1 = to_vec3f(surf.m_pos[ln[1]]);
+		vec3f y2 = to_vec3f(surf.m_pos[ln[2]]);
+		P.n = (y1 - y0) ^ (y2 - y0);
+		P.n.Normalize();
 	}
 
 	return P;
 }
-
-//-----------------------------------------------------------------------------
-bool Post::FEDistanceMap::ProjectToFacet(FSFace& f, vec3f& x, int ntime, Projection& P)
-{
-	Post::FEPostModel& fem = *GetModel();
-
-	// get the mesh to which this surface belongs
-	FSMesh& mesh = *fem.GetFEMesh(0);
-	
-	// number of element nodes
-	int nf = f.Nodes();
-	
-	// get the elements nodal positions
-	const int MN = FSFace::MAX_NODES;
-	vec3f y[MN];
-	
-	// calculate normal projection of x onto element
-	switch (f.Type())
-	{
-	case FE_FACE_TRI3:
-	case FE_FACE_TRI6:
-	case FE_FACE_TRI7:
-	case FE_FACE_TRI10:
-		{
-			for (int i = 0; i<3; ++i) y[i] = fem.NodePosition(f.n[i], ntime);
-			bool b = ProjectToTriangle(y, x, P.q, m_tol);
-			if (b)
-			{
-				P.n = (y[1] - y[0]) ^ (y[2] - y[0]);
-				P.n.Normalize();
-			}
-			return b;
-		}
-		break;
-	case FE_FACE_QUAD4:
-	case FE_FACE_QUAD8:
-	case FE_FACE_QUAD9:
-		{
-			for (int i = 0; i<4; ++i) y[i] = fem.NodePosition(f.n[i], ntime);
-			bool b = ProjectToQuad(y, x, P.q, m_tol);
-			if (b)
-			{
-				P.n = (y[1] - y[0]) ^ (y[2] - y[0]);
-				P.n.Normalize();
-			}
-			return b;
-		}
-		break;
-	default:
-		assert(false);
-	}
-	return false;
-}
@@ -26,6 +26,7 @@ SOFTWARE.*/
 
 #pragma once
 #include "FEDataField.h"
+#include <MeshLib/FSTriangleBVH.h>
 
 namespace Post {
 
@@ -51,7 +52,10 @@ private:
 		std::vector<int>	m_lnode;	// local node list
 		std::vector<vec3f> m_norm;	// node normals
 
-		std::vector< std::vector<int> >	m_NLT;	// node-facet look-up table
+		std::vector<int>	m_tri;		// triangulation of the surface (local node indices)
+		std::vector<int>	m_triFace;	// local facet index of each triangle
+		std::vector<vec3d>	m_pos;		// node positions of current state
+		FSTriangleBVH		m_bvh;		// hierarchy of the triangles for closest point queries
 	};
 
 	struct Projection
@@ -99,11 +103,11 @@ protected:
 	// build node normal list
 	void BuildNormalList(FEDistanceMap::Surface& s, bool flip);
 
-	// project r onto the surface
-	Projection project(Surface& surf, vec3f& r, int ntime);
+	// update the node positions and the triangle hierarchy of a surface
+	void UpdateSurface(FEDistanceMap::Surface& s, int ntime);
 
-	// project r onto a facet
-	bool ProjectToFacet(FSFace& face, vec3f& r, int ntime, Projection& P);
+	// find the closest point to r on the surface
+	Projection project(Surface& surf, vec3f& r);
 
 protected:
 	Surface			m_surf1;
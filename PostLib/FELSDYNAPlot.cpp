@@ -526,7 +526,6 @@ bool FELSDYNAPlotImport::ReadStates(FEPostModel& fem)
 					}
 
 					// load shell stress data
-					ELEMDATA* pe = &pstate->m_ELEM[0] + (m_hdr.nel8 + m_hdr.nel2);
 					for (int i=0; i<m_hdr.nel4; i++, pf += m_hdr.nv2d)
 					{
 						int n = i + m_hdr.nel8 + m_hdr.nel2;
@@ -534,10 +533,8 @@ bool FELSDYNAPlotImport::ReadStates(FEPostModel& fem)
 						s.add(n, m);
 						ps.add(n, pf[6]);
 						p.add(n, -m.tr()/3.f);
-						pe[i].m_h[0] = pf[29];
-						pe[i].m_h[1] = pf[29];
-						pe[i].m_h[2] = pf[29];
-						pe[i].m_h[3] = pf[29];
+						float h[4] = { pf[29], pf[29], pf[29], pf[29] };
+						pstate->m_ELEM.SetShellThickness(n, h, 4);
 
 						if (m_hdr.nv2d == 44)
 						{
@@ -861,8 +858,8 @@ bool FELSDYNAPlotExport::Save(FEPostModel& fem, const char* szfile, bool bflag[6
 				s[19] = s[5];
 
 				// shell thicknesses
-				float* h = ps->m_ELEM[i].m_h;
-				s[29] += 0.25f*(h[0] + h[1] + h[2] + h[3]);
+				const ELEMDATA& ed = ps->m_ELEM;
+				s[29] += 0.25f*(ed.ShellThickness(i, 0) + ed.ShellThickness(i, 1) + ed.ShellThickness(i, 2) + ed.ShellThickness(i, 3));
 
 				fwrite(s, sizeof(float), 32, fp);
 			}
@@ -385,16 +385,13 @@ bool FELSDYNAimport::BuildMesh(FEPostModel& fem)
 	{
 		int nel8 = (int) m_solid.size();
 		int nel2 = 0;	// we don't read beams yet
-		ELEMDATA* pd = &ps->m_ELEM[0] + (nel8 + nel2);
 
 		list<ELEMENT_SHELL>::iterator pe = m_shell.begin();
 		for (int i=0; i<(int) m_shell.size(); ++i, ++pe)
 		{
 			double* h = pe->h;
-			pd[i].m_h[0] = (float) h[0];
-			pd[i].m_h[1] = (float) h[1];
-			pd[i].m_h[2] = (float) h[2];
-			pd[i].m_h[3] = (float) h[3];
+			float hf[4] = { (float)h[0], (float)h[1], (float)h[2], (float)h[3] };
+			ps->m_ELEM.SetShellThickness(nel8 + nel2 + i, hf, 4);
 		}
 
 		FEElementData<float,DATA_MULT>& d = dynamic_cast<FEElementData<float,DATA_MULT>&>(ps->m_Data[0]);
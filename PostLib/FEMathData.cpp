@@ -73,6 +73,9 @@ FEMeshData* FEMathNodeDataField::CreateData(FEState* pstate)
 
 bool FEMathNodeDataField::BuildMath(bool updateVars)
 {
+	// clear the program so that it is not evaluated when building fails
+	m_prog.Clear();
+
 	string expr = m_eq;
 	if (expr.empty()) expr = "0";
 
@@ -111,6 +114,8 @@ bool FEMathNodeDataField::BuildMath(bool updateVars)
 		bool b = m_math.Create(expr, false); assert(b);
 	}
 
+	m_prog.Compile(m_math);
+
 	return true;
 }
 
@@ -141,6 +146,67 @@ void FEMathNodeData::eval(int n, float* pv)
 	*pv = (float)v;
 }
 
+// Evaluates the compiled program of a math field for all n items. The function 
+// getVars(i, v) should return the variables of item i in v.
+template <class F> static void EvalProgram(const FEMathProgram& prog, int n, int nvars, F getVars, std::vector<float>& val)
+{
+	const int C = FEMathProgram::CHUNK;
+	val.resize(n);
+	int chunks = (n + C - 1) / C;
+#pragma omp parallel
+	{
+		std::vector<double> var(nvars * C, 0.0), scratch(prog.ScratchSize()), v(nvars);
+		double out[C];
+#pragma omp for schedule(static)
+		for (int k = 0; k < chunks; ++k)
+		{
+			int i0 = k * C;
+			int m = (i0 + C <= n ? C : n - i0);
+			for (int l = 0; l < m; ++l)
+			{
+				getVars(i0 + l, &v[0]);
+				for (int j = 0; j < nvars; ++j) var[j * C + l] = v[j];
+			}
+			prog.Evaluate(m, &var[0], &scratch[0], out);
+			for (int l = 0; l < m; ++l) val[i0 + l] = (float)out[l];
+		}
+	}
+}
+
+bool FEMathNodeData::EvalAll(std::vector<float>& val)
+{
+	if (m_pdf == nullptr) return false;
+	const FEMathProgram& prog = m_pdf->Program();
+	if (prog.IsValid() == false) return false;
+
+	int nvars = 4 + (int)m_vars.size();
+	if (prog.Variables() > nvars) return false;
+
+	double time = m_state->m_time;
+	FEPostModel& fem = *GetFSModel();
+	int ntime = m_state->GetID();
+	int NN = GetFEMesh()->Nodes();
+
+	// the node positions are read before the parallel region since they
+	// may require the state to be paged in
+	std::vector<vec3f> rt(NN);
+	for (int n = 0; n < NN; ++n) rt[n] = fem.NodePosition(n, ntime);
+
+	EvalProgram(prog, NN, nvars, [&](int n, double* v) {
+		const vec3f& r = rt[n];
+		v[0] = r.x; v[1] = r.y; v[2] = r.z; v[3] = time;
+		for (int i = 0; i < m_vars.size(); ++i)
+		{
+			Post::FENodeData_T<float>* vari = m_vars[i];
+			float vi = 0.f;
+			if (vari && vari->active(n)) vari->eval(n, &vi);
+			v[4 + i] = vi;
+		}
+	}, val);
+
+	return true;
+}
+
 FEMathElemDataField::FEMathElemDataField(Post::FEPostModel* fem, unsigned int flag) : FEScalarMathDataField(fem, ELEM_DATA, flag)
 {
 	m_eq = "";
@@ -149,6 +215,9 @@ FEMathElemDataField::FEMathElemDataField(Post::FEPostModel* fem, unsigned int fl
 
 bool FEMathElemDataField::BuildMath(bool updateVars)
 {
+	// clear the program so that it is not evaluated when building fails
+	m_prog.Clear();
+
 	string expr = m_eq;
 	if (expr.empty()) expr = "0";
 
@@ -186,6 +255,8 @@ bool FEMathElemDataField::BuildMath(bool updateVars)
 		bool b = m_math.Create(expr, false); assert(b);
 	}
 
+	m_prog.Compile(m_math);
+
 	return true;
 }
 
@@ -239,6 +310,45 @@ void FEMathElemData::eval(int n, float* pv)
 	*pv = (float)v;
 }
 
+bool FEMathElemData::EvalAll(std::vector<float>& val)
+{
+	if (m_pdf == nullptr) return false;
+	const FEMathProgram& prog = m_pdf->Program();
+	if (prog.IsValid() == false) return false;
+
+	int nvars = 4 + (int)m_vars.size();
+	if (prog.Variables() > nvars) return false;
+
+	double time = m_state->m_time;
+	FEPostModel& fem = *GetFSModel();
+	int ntime = m_state->m_id;
+	FSMesh* mesh = GetFEMesh();
+	int NE = mesh->Elements();
+
+	// get the state before the parallel region, since this may page it in
+	FEState* ps = fem.GetState(ntime);
+	if ((ps == nullptr) || (ps->m_NODE.empty() && (NE > 0))) return false;
+	const NODEDATA* pn = &ps->m_NODE[0];
+
+	EvalProgram(prog, NE, nvars, [&](int n, double* v) {
+		FSElement_& el = mesh->ElementRef(n);
+		int ne = el.Nodes();
+		vec3f c(0, 0, 0);
+		for (int i = 0; i < ne; ++i) c += pn[el.m_node[i]].m_rt;
+		if (ne > 0) c /= ne;
+		v[0] = c.x; v[1] = c.y; v[2] = c.z; v[3] = time;
+		for (int i = 0; i < m_vars.size(); ++i)
+		{
+			Post::FEElemData_T<float, DATA_ITEM>* vari = m_vars[i];
+			float vi = 0.f;
+			if (vari && vari->active(n)) vari->eval(n, &vi);
+			v[4 + i] = vi;
+		}
+	}, val);
+
+	return true;
+}
+
 FEMathVec3DataField::FEMathVec3DataField(Post::FEPostModel* fem, unsigned int flag) : ModelDataField(fem, DATA_VEC3, DATA_NODE, NODE_DATA, flag)
 {
 	for (int i = 0; i < 3; ++i)
@@ -27,6 +27,7 @@ SOFTWARE.*/
 #pragma once
 #include "FEMeshData_T.h"
 #include <FECore/MathObject.h>
+#include "FEMathProgram.h"
 
 namespace Post {
 
@@ -43,6 +44,9 @@ public:
 	// evaluate the nodal data for this state
 	void eval(int n, float* pv) override;
 
+	// evaluate all nodes at once. Returns false if the expression could not be compiled.
+	bool EvalAll(std::vector<float>& val);
+
 	void AddVariable(FENodeData_T<float>* var) { m_vars.push_back(var); }
 
 private:
@@ -58,6 +62,9 @@ public:
 	// evaluate the nodal data for this state
 	void eval(int n, float* pv) override;
 
+	// evaluate all elements at once. Returns false if the expression could not be compiled.
+	bool EvalAll(std::vector<float>& val);
+
 	void AddVariable(FEElemData_T<float, DATA_ITEM>* var) { m_vars.push_back(var); }
 
 private:
@@ -101,12 +108,16 @@ public:
 
 	double value(const std::vector<double>& vars);
 
+	// the compiled expression
+	const FEMathProgram& Program() const { return m_prog; }
+
 protected:
 	virtual bool BuildMath(bool updateVars) = 0;
 
 protected:
 	std::string	m_eq;		//!< equation string
 	MSimpleExpression	m_math;
+	FEMathProgram		m_prog;
 	std::vector<std::pair<std::string, ModelDataField*>> m_var;
 };
 
@@ -0,0 +1,157 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#include "stdafx.h"
+#include "FEMathProgram.h"
+#include <FECore/MathObject.h>
+#include <FECore/MItem.h>
+#include <math.h>
+using namespace Post;
+
+FEMathProgram::FEMathProgram()
+{
+	m_regs = 0;
+	m_vars = 0;
+}
+
+void FEMathProgram::Clear()
+{
+	m_code.clear();
+	m_regs = 0;
+	m_vars = 0;
+}
+
+bool FEMathProgram::Compile(MSimpleExpression& m)
+{
+	Clear();
+	const MItem* pi = m.GetExpression().ItemPtr();
+	if (pi == nullptr) return false;
+	if (compile(pi) < 0)
+	{
+		Clear();
+		return false;
+	}
+	m_regs = (int)m_code.size();
+	return true;
+}
+
+// compile an item and return the register that holds its value (or -1 on failure)
+int FEMathProgram::compile(const MItem* pi)
+{
+	Instr I = { OP_CONST, -1, -1, 0.0, nullptr, nullptr };
+	switch (pi->Type())
+	{
+	case MCONST: I.c = dynamic_cast<const MConstant*>(pi)->value(); break;
+	case MFRAC : { FRACTION f = dynamic_cast<const MFraction*>(pi)->fraction(); I.c = f.n / f.d; } break;
+	case MNAMED: I.c = dynamic_cast<const MNamedCt*>(pi)->value(); break;
+	case MVAR:
+	{
+		const MVariable* pv = dynamic_cast<const MVarRef*>(pi)->GetVariable();
+		I.op = OP_VAR;
+		I.a = pv->index();
+		if (I.a + 1 > m_vars) m_vars = I.a + 1;
+	}
+	break;
+	case MNEG:
+	{
+		I.op = OP_NEG;
+		I.a = compile(dynamic_cast<const MUnary*>(pi)->Item());
+		if (I.a < 0) return -1;
+	}
+	break;
+	case MADD:
+	case MSUB:
+	case MMUL:
+	case MDIV:
+	case MPOW:
+	{
+		const MBinary* pb = dynamic_cast<const MBinary*>(pi);
+		I.a = compile(pb->LeftItem()); if (I.a < 0) return -1;
+		I.b = compile(pb->RightItem()); if (I.b < 0) return -1;
+		switch (pi->Type())
+		{
+		case MADD: I.op = OP_ADD; break;
+		case MSUB: I.op = OP_SUB; break;
+		case MMUL: I.op = OP_MUL; break;
+		case MDIV: I.op = OP_DIV; break;
+		default:
+			I.op = OP_POW;
+		}
+	}
+	break;
+	case MF1D:
+	{
+		const MFunc1D* pf = dynamic_cast<const MFunc1D*>(pi);
+		I.op = OP_F1;
+		I.f1 = pf->funcptr();
+		I.a = compile(pf->Item()); if (I.a < 0) return -1;
+	}
+	break;
+	case MF2D:
+	{
+		const MFunc2D* pf = dynamic_cast<const MFunc2D*>(pi);
+		I.op = OP_F2;
+		I.f2 = pf->funcptr();
+		I.a = compile(pf->LeftItem()); if (I.a < 0) return -1;
+		I.b = compile(pf->RightItem()); if (I.b < 0) return -1;
+	}
+	break;
+	default:
+		// not supported
+		return -1;
+	}
+
+	m_code.push_back(I);
+	return (int)m_code.size() - 1;
+}
+
+void FEMathProgram::Evaluate(int n, const double* var, double* r, double* out) const
+{
+	const int C = CHUNK;
+	const int NC = (int)m_code.size();
+	for (int i = 0; i < NC; ++i)
+	{
+		const Instr& I = m_code[i];
+		double* d = r + i * C;
+		const double* a = r + I.a * C;
+		const double* b = r + I.b * C;
+		switch (I.op)
+		{
+		case OP_CONST: for (int l = 0; l < C; ++l) d[l] = I.c; break;
+		case OP_VAR  : a = var + I.a * C; for (int l = 0; l < C; ++l) d[l] = a[l]; break;
+		case OP_NEG  : for (int l = 0; l < C; ++l) d[l] = -a[l]; break;
+		case OP_ADD  : for (int l = 0; l < C; ++l) d[l] = a[l] + b[l]; break;
+		case OP_SUB  : for (int l = 0; l < C; ++l) d[l] = a[l] - b[l]; break;
+		case OP_MUL  : for (int l = 0; l < C; ++l) d[l] = a[l] * b[l]; break;
+		case OP_DIV  : for (int l = 0; l < C; ++l) d[l] = a[l] / b[l]; break;
+		case OP_POW  : for (int l = 0; l < n; ++l) d[l] = pow(a[l], b[l]); break;
+		case OP_F1   : for (int l = 0; l < n; ++l) d[l] = I.f1(a[l]); break;
+		case OP_F2   : for (int l = 0; l < n; ++l) d[l] = I.f2(a[l], b[l]); break;
+		}
+	}
+
+	const double* res = r + (NC - 1) * C;
+	for (int l = 0; l < n; ++l) out[l] = res[l];
+}
@@ -0,0 +1,86 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+#pragma once
+#include <vector>
+
+class MSimpleExpression;
+class MItem;
+
+namespace Post {
+
+//-----------------------------------------------------------------------------
+// A math expression compiled into a flat list of instructions. Each instruction
+// writes to its own register, and each register holds CHUNK values, so that a 
+// program evaluates CHUNK points at once in tight (vectorizable) loops. 
+// The instructions perform the same operations in the same order as the 
+// expression tree, so the results are identical to MSimpleExpression::value_s.
+class FEMathProgram
+{
+public:
+	enum { CHUNK = 16 };
+
+public:
+	FEMathProgram();
+
+	// Compile the expression. Returns false if the expression contains
+	// items that are not supported (in which case the program is invalid).
+	bool Compile(MSimpleExpression& m);
+
+	void Clear();
+
+	bool IsValid() const { return !m_code.empty(); }
+
+	// number of variables the program reads
+	int Variables() const { return m_vars; }
+
+	// size of the scratch buffer (in doubles) that Evaluate needs
+	int ScratchSize() const { return m_regs * CHUNK; }
+
+	// Evaluate the program for n <= CHUNK points. Variable k of point l is var[k*CHUNK + l].
+	// The scratch buffer must be of size ScratchSize().
+	void Evaluate(int n, const double* var, double* scratch, double* out) const;
+
+private:
+	int compile(const MItem* pi);
+
+private:
+	enum OpCode { OP_CONST, OP_VAR, OP_NEG, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_POW, OP_F1, OP_F2 };
+
+	struct Instr
+	{
+		int		op;
+		int		a, b;	// operand registers (or variable index for OP_VAR)
+		double	c;		// constant value
+		double	(*f1)(double);
+		double	(*f2)(double, double);
+	};
+
+	std::vector<Instr>	m_code;	// the result is in the last register
+	int		m_regs;
+	int		m_vars;
+};
+
+}
@@ -1873,7 +1873,7 @@ void SurfaceCongruency::set_facelist(vector<int>& L)
 //-----------------------------------------------------------------------------
 void SurfaceCongruency::eval(int n, float* f)
 {
-	FEPointCongruency map;
+	FEPointCongruency& map = m_map;
 	map.SetLevels(m_nlevels);
 	map.m_nmax = m_nmax;
 	map.m_bext = m_bext;
@@ -1882,6 +1882,9 @@ void SurfaceCongruency::eval(int n, float* f)
 	FEPostModel* pfem = GetFSModel();
 	FSMesh* pmesh = GetFEMesh();
 
+	// the mesh holds the positions of the active state
+	map.SetState(pfem->CurrentTimeIndex());
+
 	// get the face
 	FSFace& face = pmesh->Face(n);
 	int ntime = m_state->GetID();
@@ -30,6 +30,7 @@ SOFTWARE.*/
 #include "FEState.h"
 #include <MeshLib/FSMesh.h>
 #include "FEDataField.h"
+#include "FEPointCongruency.h"
 #include <set>
 
 namespace Post {
@@ -1049,6 +1050,7 @@ protected:
 	void eval(int n, float* f);
 
 	std::vector<int> m_face;
+	FEPointCongruency	m_map;	// reused for all faces, so the mesh search structures are only built once
 
 public:
 	static int m_nlevels;
@@ -37,6 +37,56 @@ FEPointCongruency::FEPointCongruency()
 	m_nlevels = 1;
 	m_nmax = 1;
 	m_bext = 0;
+	m_mesh = nullptr;
+	m_ntime = -1;
+	m_brefit = true;
+}
+
+//-----------------------------------------------------------------------------
+void FEPointCongruency::SetState(int ntime)
+{
+	if (ntime != m_ntime) m_brefit = true;
+	m_ntime = ntime;
+}
+
+//-----------------------------------------------------------------------------
+static bool SameBox(const BoundingBox& a, const BoundingBox& b)
+{
+	return (a.x0 == b.x0) && (a.y0 == b.y0) && (a.z0 == b.z0) &&
+		   (a.x1 == b.x1) && (a.y1 == b.y1) && (a.z1 == b.z1);
+}
+
+//-----------------------------------------------------------------------------
+// Build the node-face list and the ray-query hierarchy. These are kept when the
+// same mesh is used for multiple nodes, so that each projection only costs a
+// hierarchy traversal instead of a loop over all faces. When the node positions
+// change (i.e. a different state or displacement), the hierarchy is refit.
+void FEPointCongruency::UpdateMesh(FSMesh* mesh)
+{
+	bool sameTopo = (mesh == m_mesh) && m_bvh.IsValid() && (m_bvh.Primitives() == mesh->Faces());
+	if (sameTopo && !m_brefit && SameBox(m_box, mesh->GetBoundingBox())) return;
+
+	if (!sameTopo)
+	{
+		m_mesh = mesh;
+		m_NFL.Build(m_mesh);
+	}
+	m_box = mesh->GetBoundingBox();
+	m_brefit = false;
+
+	int NF = mesh->Faces();
+	vector<BoundingBox> box(NF);
+#pragma omp parallel for
+	for (int i = 0; i < NF; ++i)
+	{
+		FSFace& face = mesh->Face(i);
+		int nn = (face.Shape() == FE_FACE_QUAD ? 4 : 3);
+		vec3d rn[4];
+		for (int j = 0; j < nn; ++j) rn[j] = mesh->Node(face.n[j]).pos();
+		box[i] = FSRayBVH::FaceBox(rn, nn);
+	}
+	if (sameTopo) m_bvh.Refit(box);
+	else m_bvh.Build(box);
 }
 
 //-----------------------------------------------------------------------------
@@ -54,11 +104,9 @@ FEPointCongruency::CONGRUENCY_DATA FEPointCongruency::Congruency(FSMesh* mesh, i
 	d.Kemax = 0;
 	d.nface = -1;
 
-	// store a pointer to the mesh
-	m_mesh = mesh;
+	// update the mesh data structures
 	if (mesh == nullptr) return d;
-
-	m_NFL.Build(m_mesh);
+	UpdateMesh(mesh);
 
 	// find the projection of the node onto the opposing surface
 	vec3f q, sn;
@@ -135,15 +183,10 @@ bool FEPointCongruency::Project(int nid, int& nface, vec3f& q, double rs[2], vec
 
 	// find the normal at this node
 	sn = vec3f(0.f, 0.f, 0.f);
-	for (int i=0; i<pm->Faces(); ++i)
+	for (int i=0; i<m_NFL.Valence(nid); ++i)
 	{
-		FSFace& face = pm->Face(i);
-		vec3f Nf = to_vec3f(pm->FaceNormal(face));
-		int nf = face.Nodes();
-		for (int j=0; j<nf; ++j)
-		{
-			if (face.n[j] == nid) sn += Nf;
-		}
+		FSFace& face = *m_NFL.Face(nid, i);
+		sn += to_vec3f(pm->FaceNormal(face));
 	}
 	sn.Normalize();
 
@@ -157,36 +200,34 @@ bool FEPointCongruency::Project(int nid, int& nface, vec3f& q, double rs[2], vec
 bool FEPointCongruency::Intersect(const Ray& ray, int& nface, int nid, vec3f& q, double rs[2])
 {
 	FSMesh* pm = m_mesh;
-	nface = -1;
-	double Dmin = 0;
-	double rsi[2];
 	vec3f o = to_vec3f(ray.origin);
-	for (int i=0; i<pm->Faces(); ++i)
-	{
+
+	// find the closest face that the ray (or its extension backwards) intersects
+	nface = m_bvh.CastRay(ray.origin, ray.direction, true, [&](int i, double& D) {
 		FSFace& face = pm->Face(i);
+
 		// make sure this face does not contain nid
-		if (face.HasNode(nid) == false)
-		{
-			bool b = false;
-			switch (face.m_type)
-			{
-			case FE_FACE_TRI3 : b = IntersectTri3 (ray, face, q, rsi); break;
-			case FE_FACE_QUAD4: b = IntersectQuad4(ray, face, q, rsi); break;
-			}
+		if (face.HasNode(nid)) return false;
 
-			if (b)
-			{
-				double D = (q - o).Length();
-				if ((nface == -1) || (D < Dmin))
-				{
-					nface = i;
-					Dmin = D;
-					rs[0] = rsi[0];
-					rs[1] = rsi[1];
-				}
-			}
+		vec3f qi;
+		double rsi[2];
+		bool b = false;
+		switch (face.m_type)
+		{
+		case FE_FACE_TRI3 : b = IntersectTri3 (ray, face, qi, rsi); break;
+		case FE_FACE_QUAD4: b = IntersectQuad4(ray, face, qi, rsi); break;
 		}
+		if (b) D = (qi - o).Length();
+		return b;
+	});
+
+	if (nface != -1)
+	{
+		FSFace& face = pm->Face(nface);
+		if (face.m_type == FE_FACE_TRI3) IntersectTri3(ray, face, q, rs);
+		else IntersectQuad4(ray, face, q, rs);
 	}
+
 	return (nface != -1);
 }
 
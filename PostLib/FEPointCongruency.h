@@ -28,6 +28,7 @@ SOFTWARE.*/
 #include <FSCore/math3d.h>
 #include <MeshLib/Intersect.h>
 #include <MeshLib/FSNodeFaceList.h>
+#include <MeshLib/FSRayBVH.h>
 #include <set>
 
 class FSFace;
@@ -62,7 +63,12 @@ public:
 
 	void SetLevels(int niter) { m_nlevels = niter; }
 
+	// Set the state whose node positions the mesh currently holds. The search
+	// structures are refit to the new positions when this changes.
+	void SetState(int ntime);
+
 private:
+	void UpdateMesh(FSMesh* pm);
 	bool Project(int nid, int& nface, vec3f& q, double rs[2], vec3f& sn);
 	bool Intersect(const Ray& ray, int& nface, int nid, vec3f& q, double rs[2]);
 
@@ -81,5 +87,9 @@ public:
 private:
 	FSMesh*		m_mesh;
 	FSNodeFaceList	m_NFL;
+	FSRayBVH		m_bvh;	// ray-query hierarchy of the mesh faces
+	int			m_ntime;	// state the hierarchy was fitted to
+	BoundingBox	m_box;		// mesh box the hierarchy was fitted to
+	bool		m_brefit;	// the hierarchy needs to be refit
 };
 }
@@ -37,6 +37,9 @@ SOFTWARE.*/
 #include <string>
 #include <memory>
 #include <utility>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 using namespace std;
 using namespace Post;
 
@@ -83,6 +86,9 @@ FEPostModel::FEPostModel()
 	m_nTime = 0;
 	m_fTime = 0.f;
 
+	m_maxResidentStates = 16;
+	m_dataRevision = 0;
+
 	m_activeModel = this;
 }
 
@@ -99,6 +105,8 @@ FEPostModel::~FEPostModel()
 
 void FEPostModel::DeleteMeshes()
 {
+	m_bvh.clear();
+	m_bvhRefit.clear();
 	m_mesh.clear();
 	m_RefState.clear();
 }
@@ -116,7 +124,7 @@ FEPostModel* FEPostModel::GetActiveModel()
 FEState* FEPostModel::CurrentState()
 {
 	if (m_nTime >= 0 && m_nTime < GetStates())
-		return m_State[m_nTime].get();
+		return GetState(m_nTime);
 	return nullptr;
 }
 
@@ -137,15 +145,17 @@ int FEPostModel::GetClosestTime(double t)
 {
 	if (GetStates() == 0) return -1;
 
-	FEState& s0 = *GetState(0);
+	// NOTE: we only need the time values here, so we access the states directly
+	// to avoid loading state data if states are loaded on demand.
+	FEState& s0 = *m_State[0];
 	if (s0.m_time >= t) return 0;
 
-	FEState& s1 = *GetState(GetStates() - 1);
+	FEState& s1 = *m_State[GetStates() - 1];
 	if (s1.m_time <= t) return GetStates() - 1;
 
 	for (int i = 1; i<GetStates(); ++i)
 	{
-		FEState& s = *GetState(i);
+		FEState& s = *m_State[i];
 		if (s.m_time >= t) return i - 1;
 	}
 	return GetStates() - 1;
@@ -160,6 +170,8 @@ float FEPostModel::GetTimeValue(int ntime)
 void FEPostModel::AddMesh(FSMesh* mesh)
 {
 	m_mesh.emplace_back(mesh);
+	m_bvh.emplace_back(nullptr);
+	m_bvhRefit.push_back(false);
 
 	// create a reference state for this mesh
 	std::unique_ptr<FERefState> ref = std::make_unique<FERefState>(this);
@@ -256,12 +268,17 @@ void FEPostModel::EnableMaterial(int i, bool enable)
 // clear the FE-states
 void FEPostModel::ClearStates()
 {
+	m_residentStates.clear();
+	m_stateLoader.reset();
 	m_State.clear();
 	m_nTime = 0;
 }
 
 void FEPostModel::AddState(FEState* pFEState)
 {
+	// the state loader cannot reload states it did not index
+	if (pFEState->IsResident()) LoadAllStates();
+
 	pFEState->SetID((int) m_State.size());
 	pFEState->m_ref = m_RefState[m_RefState.size() - 1].get();
 	m_State.emplace_back(pFEState); 
@@ -270,6 +287,9 @@ void FEPostModel::AddState(FEState* pFEState)
 // add a state
 void FEPostModel::AddState(float ftime, int nstatus, bool interpolateData)
 {
+	// new states cannot be loaded from file
+	LoadAllStates();
+
 	FEState* psnew = nullptr;
 	for (auto& state : m_State)
 		if (state->m_time > ftime)
@@ -625,6 +645,10 @@ void FEPostModel::InterpolateStateData(FEState* ps)
 void FEPostModel::DeleteState(int n)
 {
 	if (n < 0 || n >= m_State.size()) return;
+
+	// the state loader refers to states by their index
+	LoadAllStates();
+
 	vector<unique_ptr<FEState>>::iterator it = m_State.begin();
 	for (size_t i=0; i<n; ++i) ++it;
 	m_State.erase(it);
@@ -636,12 +660,115 @@ void FEPostModel::DeleteState(int n)
 FEState* FEPostModel::GetState(int nstate)
 { 
 	if ((nstate < 0) || (nstate >= m_State.size())) return nullptr;
-	return m_State[nstate].get(); 
+	FEState* ps = m_State[nstate].get();
+	if (m_stateLoader)
+	{
+		std::lock_guard<std::mutex> lock(m_pageMutex);
+		PageInState(ps);
+	}
+	return ps;
+}
+
+void FEPostModel::SetStateLoader(FEStateLoader* loader)
+{
+	m_stateLoader.reset(loader);
+
+	// keep track of the states that are already in memory
+	m_residentStates.clear();
+	if (loader)
+	{
+		for (auto& state : m_State)
+		{
+			if (state->IsResident()) m_residentStates.push_back(state.get());
+		}
+	}
+}
+
+void FEPostModel::SetMaxResidentStates(int n)
+{
+	// Some code accesses a few states at the same time (e.g. to interpolate
+	// between states), so we need to keep at least a few states around.
+	if (n < 4) n = 4;
+	m_maxResidentStates = n;
+
+	std::lock_guard<std::mutex> lock(m_pageMutex);
+	PageOutStates(m_maxResidentStates);
+}
+
+void FEPostModel::PageOutStates(size_t nmax)
+{
+	// Code that runs in parallel may still be working on any of the resident states, 
+	// so we don't release anything until we're back in serial code.
+#ifdef _OPENMP
+	if (omp_in_parallel()) return;
+#endif
+
+	// The active state is never paged out, since it is referenced by the rendering code.
+	FEState* active = (((m_nTime >= 0) && (m_nTime < (int)m_State.size())) ? m_State[m_nTime].get() : nullptr);
+
+	auto it = m_residentStates.end();
+	while ((m_residentStates.size() > nmax) && (it != m_residentStates.begin()))
+	{
+		--it;
+		FEState* old = *it;
+		if (old != active)
+		{
+			old->ReleaseData();
+			it = m_residentStates.erase(it);
+		}
+	}
+}
+
+// Note that this must be called with the page mutex locked.
+void FEPostModel::PageInState(FEState* ps)
+{
+	if (ps->IsResident())
+	{
+		// move it to the front of the list of most recently used states
+		if (m_residentStates.empty() || (m_residentStates.front() != ps))
+		{
+			m_residentStates.remove(ps);
+			m_residentStates.push_front(ps);
+		}
+		return;
+	}
+
+	// page out the least recently used states
+	size_t nmax = (m_maxResidentStates > 0 ? (size_t)m_maxResidentStates - 1 : 0);
+	PageOutStates(nmax);
+
+	ps->AllocateData();
+	if (m_stateLoader->LoadState(ps) == false)
+	{
+		// we keep the allocated (but empty) state so the caller has something to work with
+		assert(false);
+	}
+	m_residentStates.push_front(ps);
+}
+
+void FEPostModel::LoadAllStates()
+{
+	if (m_stateLoader == nullptr) return;
+
+	for (auto& state : m_State)
+	{
+		if (state->IsResident() == false)
+		{
+			state->AllocateData();
+			m_stateLoader->LoadState(state.get());
+		}
+	}
+
+	m_residentStates.clear();
+	m_stateLoader.reset();
 }
 
 // insert a state a time f
 void FEPostModel::InsertState(FEState *ps, float f)
 {
+	// the state loader refers to states by their index
+	LoadAllStates();
+
 	vector<unique_ptr<FEState>>::iterator it = m_State.begin();
 	for (it=m_State.begin(); it != m_State.end(); ++it)
 		if ((*it)->m_time > f) 
@@ -1146,6 +1273,9 @@ void FEPostModel::DeleteDataField(ModelDataField* pd)
 	}
 	if (m == -1) { assert(false); return; }
 
+	// the state loader refers to data fields by their index
+	LoadAllStates();
+
 	// remove this field from all states
 	int NS = GetStates();
 	for (int i=0; i<NS; ++i)
@@ -1162,13 +1292,18 @@ void FEPostModel::DeleteDataField(ModelDataField* pd)
 // Add a data field to all states of the model
 void FEPostModel::AddDataField(ModelDataField* pd, const std::string& name)
 {
+	// Data of explicit fields is stored with the states and can't be recreated
+	// when a state is paged in again, so all states need to stay in memory.
+	if ((pd->Flags() & IMPLICIT_DATA) == 0) LoadAllStates();
+
 	// add the data field to the data manager
 	m_DM->AddDataField(pd, name);
 
 	// now add new data for each of the states
+	// (states that are not in memory will create their data when they are paged in)
 	for (auto& state : m_State)
 	{
-		state->m_Data.push_back(pd->CreateData(state.get()));
+		if (state->IsResident()) state->m_Data.push_back(pd->CreateData(state.get()));
 	}
 
 	// update all dependants
@@ -1180,6 +1315,9 @@ void FEPostModel::AddDataField(ModelDataField* pd, vector<int>& L)
 {
 	assert(pd->DataClass() == FACE_DATA);
 
+	// the face list is assigned to the data of each state, so all states need to stay in memory
+	LoadAllStates();
+
 	// add the data field to the data manager
 	m_DM->AddDataField(pd);
 
@@ -1231,13 +1369,41 @@ vec3f FEPostModel::NodePosition(int n, int ntime)
 	return r;
 }
 
+FSElementBVH* FEPostModel::GetElementBVH(FSMesh* mesh)
+{
+	for (size_t i = 0; i < m_mesh.size(); ++i)
+	{
+		if (m_mesh[i].get() == mesh)
+		{
+			if (m_bvh[i] == nullptr)
+			{
+				m_bvh[i].reset(new FSElementBVH(*mesh));
+				m_bvh[i]->Build();
+			}
+			else if (m_bvhRefit[i]) m_bvh[i]->Refit();
+			m_bvhRefit[i] = false;
+			return m_bvh[i].get();
+		}
+	}
+	return nullptr;
+}
+
+void FEPostModel::UpdateElementBVH(FSMeshBase* mesh)
+{
+	for (size_t i = 0; i < m_mesh.size(); ++i)
+	{
+		if (m_mesh[i].get() == mesh) m_bvhRefit[i] = true;
+	}
+}
+
 vec3f FEPostModel::NodePosition(const vec3f& r, int ntime)
 {
 	FSMesh* mesh = GetState(ntime)->GetFEMesh();
 
 	// find the element in which this node lies
 	int iel = -1; double iso[3] = {0};
-	if (mesh && FindElementInReferenceFrame(*mesh, r, iel, iso))
+	FSElementBVH* bvh = (mesh ? GetElementBVH(mesh) : nullptr);
+	if (bvh && bvh->FindElement(r, iel, iso))
 	{
 		vec3f x[FSElement::MAX_NODES];
 		GetElementCoords(iel, ntime, x);
@@ -1277,7 +1443,7 @@ int FEPostModel::GetElementCoords(int iel, int ntime, vec3f* r)
 	if ((iel < 0) || (iel >= mesh->Elements())) return 0;
 
 	FSElement_& elem = mesh->ElementRef(iel);
-	NODEDATA* pn = &m_State[ntime]->m_NODE[0];
+	NODEDATA* pn = &GetState(ntime)->m_NODE[0];
 
 	int ne = elem.Nodes();
 	for (int i=0; i<elem.Nodes(); i++)
@@ -1324,6 +1490,7 @@ void FEPostModel::AddDependant(FEModelDependant* pc)
 
 void FEPostModel::UpdateDependants()
 {
+	m_dataRevision++;
 	size_t N = m_Dependants.size();
 	for (size_t i=0; i<N; ++i) m_Dependants[i]->Update(this);
 }
@@ -1409,15 +1576,13 @@ void FEPostModel::UpdateMeshState(int ntime)
 	for (int i = 0; i < NE; ++i)
 	{
 		FSElement_& el = mesh->ElementRef(i);
-		ELEMDATA& data = state.m_ELEM[i];
-
 		if (el.IsShell())
 		{
 			int n = el.Nodes();
-			for (int j = 0; j < n; ++j) el.m_h[j] = data.m_h[j];
+			for (int j = 0; j < n; ++j) el.m_h[j] = state.m_ELEM.ShellThickness(i, j);
 		}
 
-		if ((data.m_state & StatusFlags::VISIBLE) == 0)
+		if ((state.m_ELEM.m_state[i] & StatusFlags::VISIBLE) == 0)
 		{
 			if (!el.IsEroded())
 			{
@@ -1465,6 +1630,7 @@ void FEPostModel::UpdateMeshState(int ntime)
 
 void FEPostModel::ResetAllStates()
 {
+	m_dataRevision++;
 	for (auto& state : m_State)
 	{
 		state->m_nField = -1;
@@ -1527,7 +1693,7 @@ void FEPostModel::AddPointObject(FEPostModel::PointObject* ob)
 
 	for (auto& state : m_State)
 	{
-		state->AddPointObjectData();
+		if (state->IsResident()) state->AddPointObjectData();
 	}
 }
 
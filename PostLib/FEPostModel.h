@@ -27,6 +27,7 @@ SOFTWARE.*/
 #pragma once
 
 #include <MeshLib/FSMesh.h>
+#include <MeshLib/FSElementBVH.h>
 #include "Material.h"
 #include "FEState.h"
 #include "FEDataManager.h"
@@ -34,6 +35,8 @@ SOFTWARE.*/
 #include <FSCore/box.h>
 #include <vector>
 #include <memory>
+#include <list>
+#include <mutex>
 #include "constants.h"
 
 namespace Post {
@@ -60,6 +63,20 @@ public:
 	virtual void Update(FEPostModel* pfem) = 0;
 };
 
+//! Interface for classes that can load the data of a state on demand. When a
+//! state loader is set on the model, states are created without data and are
+//! only paged in when they are requested. Only a limited number of states is
+//! kept in memory at any time.
+class FEStateLoader
+{
+public:
+	FEStateLoader() {}
+	virtual ~FEStateLoader() {}
+
+	//! Fill the (allocated) data of the state. 
+	virtual bool LoadState(FEState* ps) = 0;
+};
+
 //! Class that describes an FEPostModel. A model consists of a mesh (in the future
 //! there can be multiple meshes to support remeshing), a list of materials
 //! and a list of states. The states contain the data associated with the model
@@ -235,6 +252,21 @@ public:
 	//! Retrieve pointer to a state
 	FEState* GetState(int nstate);
 
+	//! Set the object that loads state data on demand. The model takes ownership of the loader.
+	void SetStateLoader(FEStateLoader* loader);
+
+	//! Get the state loader
+	FEStateLoader* GetStateLoader() { return m_stateLoader.get(); }
+
+	//! Set the max number of states that are kept in memory when states are loaded on demand
+	void SetMaxResidentStates(int n);
+
+	//! Get the max number of states that are kept in memory when states are loaded on demand
+	int GetMaxResidentStates() const { return m_maxResidentStates; }
+
+	//! Load all the states and stop loading states on demand
+	void LoadAllStates();
+
 	//! Add a new data field
 	void AddDataField(ModelDataField* pd, const std::string& name = "");
 
@@ -341,6 +373,11 @@ public:
 	//! Get a mesh by index
 	FSMesh* GetFEMesh(int i);
 
+	//! Get the search structure for finding the element that contains a point (built on first use)
+	FSElementBVH* GetElementBVH(FSMesh* mesh);
+	//! Call this when the node positions of a mesh were changed (the search structure is refit when it is used next)
+	void UpdateElementBVH(FSMeshBase* mesh);
+
     //! Enable or disable mesh items based on material's state
     void UpdateMeshState();
     //! Update mesh state at a specific time
@@ -349,6 +386,10 @@ public:
     //! Reset all the states so any update will force the state to be evaluated
 	void ResetAllStates();
 
+	//! Counter that is incremented whenever the data of the states may have changed
+	//! (Can be used by classes that cache evaluated data to check if it is still valid.)
+	unsigned int DataRevision() const { return m_dataRevision; }
+
 public:
 	//! Merge another FEPostModel into this one
 	bool Merge(FEPostModel* fem);
@@ -399,6 +440,12 @@ protected:
 	void EvalFaceField(int ntime, int nfield);
 	//! Helper function for evaluating element fields
 	void EvalElemField(int ntime, int nfield);
+
+	//! make sure the state's data is in memory
+	void PageInState(FEState* ps);
+
+	//! page out the least recently used states until at most nmax states are left in memory
+	void PageOutStates(size_t nmax);
 	
 protected:
 	//! Name (as displayed in model viewer)
@@ -420,6 +467,9 @@ protected:
 	std::vector< std::unique_ptr<FERefState>>	m_RefState;	// reference state for meshes
 	//! The list of meshes
 	std::vector<std::unique_ptr<FSMesh>>	m_mesh;		// the list of meshes
+	//! Element search structures for meshes
+	std::vector<std::unique_ptr<FSElementBVH>>	m_bvh;	// one for each mesh (created on first use)
+	std::vector<bool>						m_bvhRefit;	// flags that the search structure needs to be refit
 	//! Bounding box of mesh
 	BoundingBox						m_bbox;		// bounding box of mesh
 
@@ -437,6 +487,15 @@ protected:
 	//! Array of pointers to FE-state structures
 	std::vector<std::unique_ptr<FEState>>	m_State;	// array of pointers to FE-state structures
 
+	//! Loads state data on demand
+	std::unique_ptr<FEStateLoader>	m_stateLoader;
+	//! Max number of resident states when states are loaded on demand
+	int						m_maxResidentStates;
+	//! Resident states, in order of most recent use
+	std::list<FEState*>		m_residentStates;
+	//! Protects the list of resident states and the state loader (states can be requested from parallel code)
+	std::mutex				m_pageMutex;
+
 	//! The Data Manager
 	std::unique_ptr<FEDataManager>	m_DM;		// the Data Manager
 	//! Vector field defining the displacement
@@ -445,6 +504,9 @@ protected:
 	//! Vector of dependant objects
 	std::vector<FEModelDependant*>	m_Dependants;
 
+	//! data revision counter (see DataRevision)
+	unsigned int		m_dataRevision;
+
 	//! Only one model can be active at a time
 	static FEPostModel*	m_activeModel;
 };
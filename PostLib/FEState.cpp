@@ -90,6 +90,47 @@ void ObjectData::push_back(mat3f f)
 }
 
 
+void ELEMDATA::resize(int elems)
+{
+	m_val.assign(elems, 0.f);
+	m_state.assign(elems, StatusFlags::VISIBLE);
+	ClearShellThickness();
+}
+
+void ELEMDATA::release()
+{
+	vector<float>().swap(m_val);
+	vector<unsigned int>().swap(m_state);
+	ClearShellThickness();
+}
+
+void ELEMDATA::SetShellThickness(int elem, const float* h, int n)
+{
+	if ((elem < 0) || (elem >= (int)m_val.size()) || (n < 0) || (n > FSElement::MAX_NODES)) return;
+	if (m_hoff.empty())
+	{
+		m_hoff.assign(m_val.size(), -1);
+		m_hcount.assign(m_val.size(), 0);
+	}
+
+	// allocate a new block if the element doesn't have one that is large enough
+	int off = m_hoff[elem];
+	if ((off < 0) || (n > m_hcount[elem]))
+	{
+		off = m_hoff[elem] = (int)m_h.size();
+		m_h.resize(m_h.size() + n);
+	}
+	m_hcount[elem] = (unsigned char)n;
+	for (int j = 0; j < n; ++j) m_h[off + j] = h[j];
+}
+
+void ELEMDATA::ClearShellThickness()
+{
+	vector<int>().swap(m_hoff);
+	vector<unsigned char>().swap(m_hcount);
+	vector<float>().swap(m_h);
+}
+
 FERefState::FERefState(FEPostModel* fem)
 {
 
@@ -101,7 +142,29 @@ FEState::FEState(float time, FEPostModel* fem, FSMesh* pmesh) : m_fem(fem), m_me
 {
 	m_id = -1;
 	m_ref = nullptr; // will be set by model
+	m_time = time;
+	m_nField = -1;
+	m_status = 0;
+	m_bresident = false;
 
+	AllocateData();
+}
+
+//-----------------------------------------------------------------------------
+FEState::FEState(float time, int status, FEPostModel* fem, FSMesh* pmesh) : m_fem(fem), m_mesh(pmesh)
+{
+	m_id = -1;
+	m_ref = nullptr; // will be set by model
+	m_time = time;
+	m_nField = -1;
+	m_status = status;
+	m_bresident = false;
+}
+
+//-----------------------------------------------------------------------------
+void FEState::AllocateData()
+{
+	FEPostModel* fem = m_fem;
 	FSMesh& mesh = *m_mesh;
 
 	int nodes = mesh.Nodes();
@@ -141,14 +204,6 @@ FEState::FEState(float time, FEPostModel* fem, FSMesh* pmesh) : m_fem(fem), m_me
 
 	// initialize data
 	for (int i=0; i<nodes; ++i) m_NODE[i].m_rt = to_vec3f(mesh.Node(i).r);
-	for (int i=0; i<elems; ++i)
-	{
-		m_ELEM[i].m_state = StatusFlags::VISIBLE;
-		m_ELEM[i].m_h[0] = 0.f;
-		m_ELEM[i].m_h[1] = 0.f;
-		m_ELEM[i].m_h[2] = 0.f;
-		m_ELEM[i].m_h[3] = 0.f;
-	}
 
 	AddPointObjectData();
 
@@ -181,9 +236,7 @@ FEState::FEState(float time, FEPostModel* fem, FSMesh* pmesh) : m_fem(fem), m_me
 		}
 	}
 
-	m_time = time;
 	m_nField = -1;
-	m_status = 0;
 
 	FEDataManager* pdm = fem->GetDataManager();
 	int N = pdm->DataFields();
@@ -193,6 +246,32 @@ FEState::FEState(float time, FEPostModel* fem, FSMesh* pmesh) : m_fem(fem), m_me
 		ModelDataField& d = *(*it);
 		m_Data.push_back(d.CreateData(this));
 	}
+
+	m_bresident = true;
+}
+
+//-----------------------------------------------------------------------------
+void FEState::ReleaseData()
+{
+	m_Data.clear();
+
+	for (OBJ_POINT_DATA& d : m_objPt) delete d.data;
+	for (OBJ_LINE_DATA& d : m_objLn) delete d.data;
+
+	// swap with empty vectors so that the memory is actually returned
+	vector<NODEDATA>().swap(m_NODE);
+	vector<EDGEDATA>().swap(m_EDGE);
+	vector<FACEDATA>().swap(m_FACE);
+	m_ELEM.release();
+	vector<OBJ_POINT_DATA>().swap(m_objPt);
+	vector<OBJ_LINE_DATA>().swap(m_objLn);
+
+	m_ElemData.release();
+	m_FaceData.release();
+	m_EdgeData.release();
+
+	m_nField = -1;
+	m_bresident = false;
 }
 
 void FEState::AddPointObjectData()
@@ -281,6 +360,7 @@ FEState::FEState(float time, FEPostModel* pfem, FEState* pstate) : m_fem(pfem)
 	m_nField = -1;
 	m_status = 0;
 	m_mesh = pstate->m_mesh;
+	m_bresident = true;
 
 	RebuildData();
 
@@ -370,8 +450,6 @@ void FEState::RebuildData()
 		FSElement_& el = mesh.ElementRef(i);
 		int ne = el.Nodes();
 		m_ElemData.append(ne);
-
-		m_ELEM[i].m_state = StatusFlags::VISIBLE;
 	}
 
 	// allocate face data
@@ -394,13 +472,6 @@ void FEState::RebuildData()
 
 	// initialize data
 	for (int i = 0; i < nodes; ++i) m_NODE[i].m_rt = to_vec3f(mesh.Node(i).r);
-	for (int i = 0; i < elems; ++i)
-	{
-		m_ELEM[i].m_h[0] = 0.f;
-		m_ELEM[i].m_h[1] = 0.f;
-		m_ELEM[i].m_h[2] = 0.f;
-		m_ELEM[i].m_h[3] = 0.f;
-	}
 
 	int ptObjs = fem.PointObjects();
 	m_objPt.resize(ptObjs);
@@ -698,7 +769,7 @@ double Post::IntegrateReferenceElems(FSMesh& mesh, const std::vector<int>& elemL
 	for (int i = 0; i < NE; ++i)
 	{
 		FSElement_& e = mesh.ElementRef(elemList[i]);
-		if (e.IsSolid() && (ps->m_ELEM[i].m_state & Post::StatusFlags::ACTIVE))
+		if (e.IsSolid() && (ps->m_ELEM.m_state[i] & Post::StatusFlags::ACTIVE))
 		{
 			int nn = e.Nodes();
 
@@ -751,7 +822,7 @@ double Post::IntegrateElems(FSMesh& mesh, const std::vector<int>& elemList, Post
 	for (int i = 0; i < NE; ++i)
 	{
 		FSElement_& e = mesh.ElementRef(elemList[i]);
-		if (e.IsSolid() && (ps->m_ELEM[i].m_state & Post::StatusFlags::ACTIVE))
+		if (e.IsSolid() && (ps->m_ELEM.m_state[i] & Post::StatusFlags::ACTIVE))
 		{
 			int nn = e.Nodes();
 
@@ -790,7 +861,7 @@ double Post::IntegrateElems(FSMesh& mesh, const std::vector<int>& elemList, Post
 			// add to integral
 			res += IntegrateHex(r, v);
 		}
-		else if (e.IsShell() && (ps->m_ELEM[i].m_state & Post::StatusFlags::ACTIVE))
+		else if (e.IsShell() && (ps->m_ELEM.m_state[i] & Post::StatusFlags::ACTIVE))
 		{
 			int nn = e.Nodes();
 
@@ -811,7 +882,7 @@ double Post::IntegrateElems(FSMesh& mesh, const std::vector<int>& elemList, Post
 		// TODO: This was done so that discrete element variables can be added, but I don't think that makes sense
 		//       for other element types that are considered "beams", e.g. discrete elements. 
 		//       I think the solution is to distinguish between "beams" and "discrete" elements. 
-		if (e.IsBeam() && (ps->m_ELEM[i].m_state & Post::StatusFlags::ACTIVE))
+		if (e.IsBeam() && (ps->m_ELEM.m_state[i] & Post::StatusFlags::ACTIVE))
 		{
 			double v0 = ps->m_ElemData.value(i, 0);
 			double v1 = ps->m_ElemData.value(i, 1);
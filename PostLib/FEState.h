@@ -62,12 +62,52 @@ struct EDGEDATA
 	float	m_nv[FSEdge::MAX_NODES]; //!< nodal values
 };
 
-//! Data structure for storing element information
-struct ELEMDATA
+//! Class for storing element information. The values and state flags are stored 
+//! in separate arrays. Shell thicknesses are only stored for the elements that have 
+//! them, and are not allocated at all if no shell thickness is set.
+class ELEMDATA
 {
-	float			m_val;		//!< current element value
-	unsigned int	m_state;	//!< state flags
-	float			m_h[FSElement::MAX_NODES];		//!< shell thickness (TODO: Can we move this to the face data?)
+public:
+	//! Allocate data for the given number of elements
+	void resize(int elems);
+
+	//! Release all data
+	void release();
+
+	//! Number of elements
+	int size() const { return (int)m_val.size(); }
+
+	//! Was any shell thickness set?
+	bool HasShellThickness() const { return !m_hoff.empty(); }
+
+	//! Set the n nodal shell thicknesses of an element
+	void SetShellThickness(int elem, const float* h, int n);
+
+	//! Get the shell thickness of node j of an element (zero if not set)
+	float ShellThickness(int elem, int j) const
+	{
+		if (m_hoff.empty() || (m_hoff[elem] < 0) || (j < 0) || (j >= m_hcount[elem])) return 0.f;
+		return m_h[m_hoff[elem] + j];
+	}
+
+	//! Number of nodal shell thicknesses stored for an element (zero if not set)
+	int ShellThicknessNodes(int elem) const
+	{
+		if (m_hoff.empty()) return 0;
+		return m_hcount[elem];
+	}
+
+	//! Remove all shell thicknesses
+	void ClearShellThickness();
+
+public:
+	std::vector<float>			m_val;		//!< current element values
+	std::vector<unsigned int>	m_state;	//!< element state flags
+
+private:
+	std::vector<int>	m_hoff;	//!< offset into m_h for each element (-1 if not set)
+	std::vector<unsigned char>	m_hcount;	//!< number of shell thicknesses of each element
+	std::vector<float>	m_h;	//!< shell thicknesses
 };
 
 //! Data structure for storing face information
@@ -161,6 +201,9 @@ public:
 	FEState(float time, FEPostModel* fem, FSMesh* mesh);
 	//! Constructor with time, model, and existing state
 	FEState(float time, FEPostModel* fem, FEState* state);
+	//! Constructor for a state whose data is loaded on demand (see FEStateLoader).
+	//! No data is allocated until the state is paged in.
+	FEState(float time, int status, FEPostModel* fem, FSMesh* mesh);
 
 	//! Set the ID of this state
 	void SetID(int n);
@@ -185,6 +228,15 @@ public:
 	//! Add point object data
 	void AddPointObjectData();
 
+	//! Is the state's data resident in memory?
+	bool IsResident() const { return m_bresident; }
+
+	//! Allocate and initialize all the state's data
+	void AllocateData();
+
+	//! Release all the state's data (the state's time and status are kept)
+	void ReleaseData();
+
 	//! Get node position at given node index
 	vec3f NodePosition(int node);
 	//! Get node reference position at given node index
@@ -196,11 +248,12 @@ public:
 	int		m_id;		//!< index in state array of FEPostModel
 	bool	m_bsmooth;	//!< smoothing flag
 	int		m_status;	//!< status flag
+	bool	m_bresident;	//!< is the state data allocated?
 
 	std::vector<NODEDATA>	m_NODE;		//!< nodal data
 	std::vector<EDGEDATA>	m_EDGE;		//!< edge data
 	std::vector<FACEDATA>	m_FACE;		//!< face data
-	std::vector<ELEMDATA>	m_ELEM;		//!< element data
+	ELEMDATA				m_ELEM;		//!< element data
 
 	std::vector<OBJ_POINT_DATA>	m_objPt;		//!< object point data
 	std::vector<OBJ_LINE_DATA>	m_objLn;		//!< object line data
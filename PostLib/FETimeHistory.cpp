@@ -0,0 +1,202 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#include "stdafx.h"
+#include "FETimeHistory.h"
+#include "FEPostModel.h"
+using namespace Post;
+
+//-----------------------------------------------------------------------------
+// evaluate the value of a single item at a state
+static float EvaluateItem(FEPostModel& fem, int itemType, int item, int ntime, int nfield)
+{
+	switch (itemType)
+	{
+	case FETimeHistoryCache::NODE_ITEM:
+	{
+		NODEDATA nd;
+		fem.EvaluateNode(item, ntime, nfield, nd);
+		return nd.m_val;
+	}
+	case FETimeHistoryCache::EDGE_ITEM:
+	{
+		EDGEDATA ed;
+		fem.EvaluateEdge(item, ntime, nfield, ed);
+		return ed.m_val;
+	}
+	case FETimeHistoryCache::FACE_ITEM:
+	{
+		float data[FSFace::MAX_NODES], val = 0.f;
+		fem.EvaluateFace(item, ntime, nfield, data, val);
+		return val;
+	}
+	case FETimeHistoryCache::ELEM_ITEM:
+	{
+		float data[FSElement::MAX_NODES] = { 0.f }, val = 0.f;
+		fem.EvaluateElement(item, ntime, nfield, data, val);
+		return val;
+	}
+	}
+	assert(false);
+	return 0.f;
+}
+
+//-----------------------------------------------------------------------------
+// When states are loaded on demand, they have to be accessed in order and from one
+// thread. Otherwise, the states can be evaluated in parallel, but the node-element 
+// and node-face lists are built on first use, so we need to make sure they are 
+// built before we start.
+static bool PrepareParallelEvaluation(FEPostModel& fem, bool nodeLists)
+{
+	if (fem.GetStateLoader()) return false;
+
+	if (nodeLists)
+	{
+		for (int i = 0; i < fem.GetStates(); ++i)
+		{
+			FSMesh* mesh = fem.GetState(i)->GetFEMesh();
+			mesh->NodeElementList();
+			mesh->NodeFaceList();
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void Post::EvaluateTimeHistory(FEPostModel& fem, int itemType, int nfield, const std::vector<int>& items, float* val, size_t stateStride, size_t itemStride)
+{
+	int NS = fem.GetStates();
+	int NI = (int)items.size();
+	if ((NS == 0) || (NI == 0)) return;
+
+	bool bparallel = PrepareParallelEvaluation(fem, (itemType == FETimeHistoryCache::NODE_ITEM));
+
+	// All items are evaluated for a state before moving on to the next one, 
+	// so when states are paged in, each state is only loaded once.
+	long long N = (long long)NS * NI;
+#pragma omp parallel for schedule(dynamic, 64) if (bparallel)
+	for (long long k = 0; k < N; ++k)
+	{
+		int ntime = (int)(k / NI);
+		int i = (int)(k % NI);
+		val[ntime * stateStride + i * itemStride] = EvaluateItem(fem, itemType, items[i], ntime, nfield);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Post::EvaluateNodeVectorHistory(FEPostModel& fem, int nvec, const std::vector<int>& items, vec3f* val)
+{
+	int NS = fem.GetStates();
+	int NI = (int)items.size();
+	if ((NS == 0) || (NI == 0)) return;
+
+	bool bparallel = PrepareParallelEvaluation(fem, true);
+
+	long long N = (long long)NS * NI;
+#pragma omp parallel for schedule(dynamic, 64) if (bparallel)
+	for (long long k = 0; k < N; ++k)
+	{
+		int ntime = (int)(k / NI);
+		int i = (int)(k % NI);
+		val[(size_t)k] = fem.EvaluateNodeVector(items[i], ntime, nvec);
+	}
+}
+
+//-----------------------------------------------------------------------------
+FETimeHistoryCache::FETimeHistoryCache()
+{
+	m_fem = nullptr;
+	m_revision = 0;
+	m_states = 0;
+}
+
+//-----------------------------------------------------------------------------
+void FETimeHistoryCache::SetModel(FEPostModel* fem)
+{
+	if (fem != m_fem)
+	{
+		m_fem = fem;
+		Clear();
+	}
+	else Validate();
+}
+
+//-----------------------------------------------------------------------------
+void FETimeHistoryCache::Clear()
+{
+	m_data.clear();
+	m_revision = (m_fem ? m_fem->DataRevision() : 0);
+	m_states = (m_fem ? m_fem->GetStates() : 0);
+}
+
+//-----------------------------------------------------------------------------
+void FETimeHistoryCache::Validate()
+{
+	if (m_fem == nullptr) return;
+	if ((m_fem->DataRevision() != m_revision) || (m_fem->GetStates() != m_states)) Clear();
+}
+
+//-----------------------------------------------------------------------------
+void FETimeHistoryCache::Evaluate(int itemType, int nfield, const std::vector<int>& items)
+{
+	if ((m_fem == nullptr) || items.empty()) return;
+	Validate();
+
+	FEPostModel& fem = *m_fem;
+	int NS = m_states;
+	if (NS == 0) return;
+
+	// assign columns to the items that are not cached yet
+	Column& col = m_data[std::make_pair(itemType, nfield)];
+	std::vector<int> newItems;
+	for (int item : items)
+	{
+		if (col.m_index.find(item) == col.m_index.end())
+		{
+			col.m_index[item] = (int)(col.m_val.size() / NS) + (int)newItems.size();
+			newItems.push_back(item);
+		}
+	}
+	if (newItems.empty()) return;
+
+	size_t offset = col.m_val.size();
+	col.m_val.resize(offset + newItems.size() * NS, 0.f);
+	EvaluateTimeHistory(fem, itemType, nfield, newItems, col.m_val.data() + offset, 1, NS);
+}
+
+//-----------------------------------------------------------------------------
+const float* FETimeHistoryCache::GetHistory(int itemType, int nfield, int item)
+{
+	if (m_fem == nullptr) return nullptr;
+
+	// evaluate the item if it is not cached yet
+	Evaluate(itemType, nfield, std::vector<int>{ item });
+	if (m_states == 0) return nullptr;
+
+	Column& col = m_data[std::make_pair(itemType, nfield)];
+	int n = col.m_index[item];
+	return col.m_val.data() + (size_t)n * m_states;
+}
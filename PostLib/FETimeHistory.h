@@ -0,0 +1,100 @@
+/*This file is part of the FEBio Studio source code and is licensed under the MIT license
+listed below.
+
+See Copyright-FEBio-Studio.txt for details.
+
+Copyright (c) 2021 University of Utah, The Trustees of Columbia University in
+the City of New York, and others.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.*/
+
+#pragma once
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <FSCore/math3d.h>
+
+namespace Post {
+
+class FEPostModel;
+
+//-----------------------------------------------------------------------------
+// Evaluate a data field for a list of items over all states. The value of item i at 
+// state n is stored in val[n*stateStride + i*itemStride]. (The item type is one of 
+// the FETimeHistoryCache::ItemType values.)
+void EvaluateTimeHistory(FEPostModel& fem, int itemType, int nfield, const std::vector<int>& items, float* val, size_t stateStride, size_t itemStride);
+
+// Evaluate a vector field for a list of nodes over all states. The vectors are 
+// stored by state, i.e. the vector of node i at state n is val[n*items.size() + i].
+void EvaluateNodeVectorHistory(FEPostModel& fem, int nvec, const std::vector<int>& items, vec3f* val);
+
+//-----------------------------------------------------------------------------
+// Extracts the time history of a data field for mesh items (nodes, edges, faces, elements).
+// The histories of a batch of items are evaluated for all states in one (parallel) pass
+// and are cached per field and item. Items that were already evaluated are not evaluated
+// again, e.g. when more items are selected, or when switching between plot types.
+// The cache is cleared when the model's data changes (see FEPostModel::DataRevision).
+class FETimeHistoryCache
+{
+public:
+	enum ItemType {
+		NODE_ITEM,
+		EDGE_ITEM,
+		FACE_ITEM,
+		ELEM_ITEM
+	};
+
+public:
+	FETimeHistoryCache();
+
+	// Set the model. The cache is cleared if the model (or its data) changed.
+	void SetModel(FEPostModel* fem);
+
+	// clear all cached values
+	void Clear();
+
+	// Make sure the time histories of the items are available. The items that are not
+	// cached yet are evaluated in one pass over all states.
+	void Evaluate(int itemType, int nfield, const std::vector<int>& items);
+
+	// Get the time history of an item (i.e. one value per state). The item is evaluated if
+	// it is not cached yet. The returned pointer is valid until the next call to Evaluate.
+	const float* GetHistory(int itemType, int nfield, int item);
+
+private:
+	// make sure the cached data is still valid
+	void Validate();
+
+private:
+	// The cached histories of a field for one item type. The values of each item
+	// are stored in one contiguous column with a value for each state.
+	struct Column
+	{
+		std::unordered_map<int, int>	m_index;	// column index of each item
+		std::vector<float>				m_val;		// cached values
+	};
+
+	FEPostModel*	m_fem;
+	unsigned int	m_revision;	// data revision of the model when the values were cached
+	int				m_states;	// number of states when the values were cached
+
+	std::map<std::pair<int, int>, Column>	m_data;	// cached values, keyed by item type and field
+};
+
+} // namespace Post
@@ -26,8 +26,12 @@ SOFTWARE.*/
 
 #include "FEVTKExport.h"
 #include <stdio.h>
+#include <stdint.h>
 #include "FEPostModel.h"
 #include "FEMeshData_T.h"
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 using namespace Post;
 using namespace std;
@@ -70,11 +74,15 @@ FEVTKExport::FEVTKExport(void)
 	m_bselElemsOnly = false;
 	m_bwriteSeriesFile = false;
 	m_bwritePartIDs = false;
+	m_bwriteBinary = false;
+	m_bcompress = false;
 
 	AddBoolParam(m_bwriteAllStates , "write_all_states", "Write all states");
 	AddBoolParam(m_bselElemsOnly   , "sel_elems_only"  , "Selected elements only");
 	AddBoolParam(m_bwriteSeriesFile, "write_series"    , "Write VTK series");
 	AddBoolParam(m_bwritePartIDs   , "write_part_ids"  , "Write element part IDs as cell data");
+	AddBoolParam(m_bwriteBinary    , "write_binary"    , "Write binary VTU files");
+	AddBoolParam(m_bcompress       , "compress"        , "Compress binary data");
 
 	m_fp = nullptr;
 	m_nodes = m_elems = 0;
@@ -88,6 +96,8 @@ bool FEVTKExport::UpdateData(bool bsave)
 		m_bselElemsOnly    = GetBoolValue(1);
 		m_bwriteSeriesFile = GetBoolValue(2);
 		m_bwritePartIDs    = GetBoolValue(3);
+		m_bwriteBinary     = GetBoolValue(4);
+		m_bcompress        = GetBoolValue(5);
 	}
 	else
 	{
@@ -95,6 +105,8 @@ bool FEVTKExport::UpdateData(bool bsave)
 		SetBoolValue(1, m_bselElemsOnly);
 		SetBoolValue(2, m_bwriteSeriesFile);
 		SetBoolValue(3, m_bwritePartIDs);
+		SetBoolValue(4, m_bwriteBinary);
+		SetBoolValue(5, m_bcompress);
 	}
 
 	return false;
@@ -179,6 +191,7 @@ bool FEVTKExport::Save(FEPostModel& fem, const char* szfile)
 			szroot[l] = 0;
 			strcpy(szext, sz);
 		}
+		if (m_bwriteBinary) strcpy(szext, ".vtu");
 
 		// strip the path of the root
 		const char* szbase = strrchr(szroot, '/');
@@ -190,25 +203,54 @@ bool FEVTKExport::Save(FEPostModel& fem, const char* szfile)
 		else szbase++;
 
 		vector<pair<string, float> > series;
+		vector<string> files;
     
 		// save each state in a separate file
 		int l0 = (int) log10((double)ns) + 1;
 		for (int is=0; is<ns; ++is) 
 		{
 			if (sprintf(szname, "%st%0*d%s", szroot, l0,is,szext) < 0) return false;
-
-			FEState* ps = fem.GetState(is);
-
-			if (WriteState(szname, ps) == false) return false;
+			files.push_back(szname);
 
 			if (sprintf(szname, "%st%0*d%s", szbase, l0, is, szext) < 0) return false;
-			series.push_back(pair<string, float>(szname, ps->m_time));
+			series.push_back(pair<string, float>(szname, fem.GetTimeValue(is)));
+		}
+
+		if (m_bwriteBinary && (fem.GetStateLoader() == nullptr))
+		{
+			// The binary writer does not share any file state, so the states 
+			// can be written concurrently. (States that are paged in from disk
+			// are written in order instead.)
+			vector<int> ok(ns, 0);
+#pragma omp parallel for schedule(dynamic, 1)
+			for (int is = 0; is < ns; ++is)
+			{
+				ok[is] = (WriteVTUState(files[is].c_str(), fem.GetState(is)) ? 1 : 0);
+			}
+			for (int is = 0; is < ns; ++is) if (ok[is] == 0) return false;
+		}
+		else
+		{
+			for (int is = 0; is < ns; ++is)
+			{
+				FEState* ps = fem.GetState(is);
+				bool b = (m_bwriteBinary ? WriteVTUState(files[is].c_str(), ps) : WriteState(files[is].c_str(), ps));
+				if (b == false) return false;
+			}
 		}
 
 		if (m_bwriteSeriesFile)
 		{
-			sprintf(szname, "%svtk.series", szroot);
-			WriteVTKSeriesFile(szname, series);
+			if (m_bwriteBinary)
+			{
+				sprintf(szname, "%spvd", szroot);
+				WritePVDFile(szname, series);
+			}
+			else
+			{
+				sprintf(szname, "%svtk.series", szroot);
+				WriteVTKSeriesFile(szname, series);
+			}
 		}
 
 		return true;
@@ -216,6 +258,7 @@ bool FEVTKExport::Save(FEPostModel& fem, const char* szfile)
 	else
 	{
 		FEState* state = fem.CurrentState();
+		if (m_bwriteBinary) return WriteVTUState(szfile, state);
 		return WriteState(szfile, state);
 	}
 }        
@@ -595,6 +638,310 @@ void FEVTKExport::WriteCellData(FEState* ps)
     }
 }
 
+//-----------------------------------------------------------------------------
+// Helper functions for writing binary (base64 encoded) XML data arrays.
+static void base64_encode(const unsigned char* in, size_t n, std::string& out)
+{
+	static const char* sztable = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t m = out.size();
+	out.resize(m + 4 * ((n + 2) / 3));
+	char* c = &out[m];
+	size_t i = 0;
+	for (; i + 2 < n; i += 3, c += 4)
+	{
+		unsigned int v = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+		c[0] = sztable[(v >> 18) & 0x3F];
+		c[1] = sztable[(v >> 12) & 0x3F];
+		c[2] = sztable[(v >>  6) & 0x3F];
+		c[3] = sztable[ v        & 0x3F];
+	}
+	if (i < n)
+	{
+		unsigned int v = (in[i] << 16) | (i + 1 < n ? in[i + 1] << 8 : 0);
+		c[0] = sztable[(v >> 18) & 0x3F];
+		c[1] = sztable[(v >> 12) & 0x3F];
+		c[2] = (i + 1 < n ? sztable[(v >> 6) & 0x3F] : '=');
+		c[3] = '=';
+	}
+}
+
+// Writes a DataArray in the inline binary format. The data is preceded by a UInt32 
+// header with the byte count. Compressed data is written as a single zlib block, 
+// in which case the block header is encoded separately from the data.
+static bool write_data_array(FILE* fp, const char* sztype, const char* szname, int ncomp, const void* data, size_t bytes, bool compress)
+{
+	fprintf(fp, "<DataArray type=\"%s\" Name=\"%s\" NumberOfComponents=\"%d\" format=\"binary\">\n", sztype, szname, ncomp);
+
+	std::string s;
+#ifdef HAVE_ZLIB
+	if (compress)
+	{
+		uLongf csize = compressBound((uLong)bytes);
+		vector<unsigned char> buf(csize);
+		if (compress2(buf.data(), &csize, (const Bytef*)data, (uLong)bytes, Z_BEST_SPEED) != Z_OK) return false;
+
+		uint32_t hdr[4] = { 1, (uint32_t)bytes, 0, (uint32_t)csize };
+		base64_encode((const unsigned char*)hdr, sizeof(hdr), s);
+		base64_encode(buf.data(), csize, s);
+	}
+	else
+#endif
+	{
+		vector<unsigned char> buf(sizeof(uint32_t) + bytes);
+		uint32_t nsize = (uint32_t)bytes;
+		memcpy(buf.data(), &nsize, sizeof(uint32_t));
+		if (bytes > 0) memcpy(buf.data() + sizeof(uint32_t), data, bytes);
+		base64_encode(buf.data(), buf.size(), s);
+	}
+
+	fwrite(s.data(), 1, s.size(), fp);
+	fprintf(fp, "\n</DataArray>\n");
+
+	return true;
+}
+
+static bool write_data_array(FILE* fp, const char* szname, int ncomp, const vector<float>& v, bool compress)
+{
+	return write_data_array(fp, "Float32", szname, ncomp, v.data(), v.size() * sizeof(float), compress);
+}
+
+// Collects the values of the tagged items. Tensors are expanded to all 9 components.
+// Returns the number of components, or 0 if the data type is not supported.
+static int pack_values(vector<float>& out, const vector<float>& val, int ntype, const vector<int>& tag)
+{
+	int n = (int)tag.size();
+	out.clear();
+	switch (ntype)
+	{
+	case DATA_SCALAR:
+		out.reserve(n);
+		for (int i = 0; i < n; ++i) if (tag[i]) out.push_back(val[i]);
+		return 1;
+	case DATA_VEC3:
+		out.reserve(3 * n);
+		for (int i = 0; i < n; ++i)
+			if (tag[i]) out.insert(out.end(), &val[3 * i], &val[3 * i] + 3);
+		return 3;
+	case DATA_MAT3S:
+		out.reserve(9 * n);
+		for (int i = 0; i < n; ++i)
+			if (tag[i])
+			{
+				const float* v = &val[6 * i];
+				float m[9] = { v[0], v[3], v[5], v[3], v[1], v[4], v[5], v[4], v[2] };
+				out.insert(out.end(), m, m + 9);
+			}
+		return 9;
+	case DATA_MAT3SD:
+		out.reserve(9 * n);
+		for (int i = 0; i < n; ++i)
+			if (tag[i])
+			{
+				const float* v = &val[3 * i];
+				float m[9] = { v[0], 0.f, 0.f, 0.f, v[1], 0.f, 0.f, 0.f, v[2] };
+				out.insert(out.end(), m, m + 9);
+			}
+		return 9;
+	}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+// Writes a state as an XML unstructured grid (.vtu) file with binary data arrays. 
+// The same fields are exported as in the legacy format. This function does not 
+// use any of the member file data, so it can be called for several states at once.
+bool FEVTKExport::WriteVTUState(const char* szname, FEState* ps)
+{
+	FSMesh* pm = ps->GetFEMesh();
+	if (pm == 0) return false;
+	FSMesh& mesh = *pm;
+
+	bool compress = m_bcompress;
+#ifndef HAVE_ZLIB
+	compress = false;
+#endif
+
+	FILE* fp = fopen(szname, "wb");
+	if (fp == 0) return false;
+
+	int NN = mesh.Nodes();
+	int NE = mesh.Elements();
+	vector<int> ntag(NN, 0), etag(NE, 0);
+	for (int i = 0; i < NN; ++i) ntag[i] = (mesh.Node(i).m_ntag >= 0 ? 1 : 0);
+	for (int i = 0; i < NE; ++i) etag[i] = (mesh.Element(i).m_ntag >= 0 ? 1 : 0);
+
+	fprintf(fp, "<?xml version=\"1.0\"?>\n");
+	fprintf(fp, "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"LittleEndian\" header_type=\"UInt32\"%s>\n", (compress ? " compressor=\"vtkZLibDataCompressor\"" : ""));
+	fprintf(fp, "<UnstructuredGrid>\n");
+	fprintf(fp, "<Piece NumberOfPoints=\"%d\" NumberOfCells=\"%d\">\n", m_nodes, m_elems);
+
+	bool bok = true;
+
+	// --- N O D E S ---
+	vector<float> pts; pts.reserve(3 * m_nodes);
+	for (int i = 0; i < NN; ++i)
+	{
+		if (ntag[i])
+		{
+			vec3f r = ps->NodePosition(i);
+			pts.push_back(r.x); pts.push_back(r.y); pts.push_back(r.z);
+		}
+	}
+	fprintf(fp, "<Points>\n");
+	bok &= write_data_array(fp, "Points", 3, pts, compress);
+	fprintf(fp, "</Points>\n");
+
+	// --- E L E M E N T S ---
+	vector<int32_t> conn, offs; offs.reserve(m_elems);
+	vector<uint8_t> types; types.reserve(m_elems);
+	for (int i = 0; i < NE; ++i)
+	{
+		FSElement& el = mesh.Element(i);
+		if (etag[i] == 0) continue;
+
+		int ne = el.Nodes();
+		for (int k = 0; k < ne; ++k) conn.push_back(mesh.Node(el.m_node[k]).m_ntag);
+		offs.push_back((int32_t)conn.size());
+
+		int vtk_type = 0;
+		switch (el.Type()) {
+			case FE_HEX8   : vtk_type = VTK_HEXAHEDRON; break;
+			case FE_TET4   : vtk_type = VTK_TETRA; break;
+			case FE_PENTA6 : vtk_type = VTK_WEDGE; break;
+			case FE_PYRA5  : vtk_type = VTK_PYRAMID; break;
+			case FE_QUAD4  : vtk_type = VTK_QUAD; break;
+			case FE_TRI3   : vtk_type = VTK_TRIANGLE; break;
+			case FE_BEAM2  : vtk_type = VTK_LINE; break;
+			case FE_HEX20  : vtk_type = VTK_QUADRATIC_HEXAHEDRON; break;
+			case FE_QUAD8  : vtk_type = VTK_QUADRATIC_QUAD; break;
+			case FE_BEAM3  : vtk_type = VTK_QUADRATIC_EDGE; break;
+			case FE_TET10  : vtk_type = VTK_QUADRATIC_TETRA; break;
+			case FE_TET15  : vtk_type = VTK_QUADRATIC_TETRA; break;
+			case FE_PENTA15: vtk_type = VTK_QUADRATIC_WEDGE; break;
+			case FE_HEX27  : vtk_type = VTK_QUADRATIC_HEXAHEDRON; break;
+			case FE_PYRA13 : vtk_type = VTK_QUADRATIC_PYRAMID; break;
+			case FE_TRI6   : vtk_type = VTK_QUADRATIC_TRIANGLE; break;
+			case FE_QUAD9  : vtk_type = VTK_QUADRATIC_QUAD; break;
+		}
+		types.push_back((uint8_t)vtk_type);
+	}
+	fprintf(fp, "<Cells>\n");
+	bok &= write_data_array(fp, "Int32", "connectivity", 1, conn.data(), conn.size() * sizeof(int32_t), compress);
+	bok &= write_data_array(fp, "Int32", "offsets"     , 1, offs.data(), offs.size() * sizeof(int32_t), compress);
+	bok &= write_data_array(fp, "UInt8", "types"       , 1, types.data(), types.size(), compress);
+	fprintf(fp, "</Cells>\n");
+
+	FEPostModel& fem = *ps->GetFSModel();
+	FEDataManager& DM = *fem.GetDataManager();
+	int NDATA = ps->m_Data.size();
+	char szfield[256];
+	vector<float> val, out;
+
+	// --- N O D E   D A T A ---
+	fprintf(fp, "<PointData>\n");
+	FEDataFieldPtr pd = DM.FirstDataField();
+	for (int n = 0; n < NDATA; ++n, ++pd)
+	{
+		ModelDataField& data = *(*pd);
+		FEMeshData& meshData = ps->m_Data[n];
+		int ntype = meshData.GetType();
+		DATA_FORMAT dfmt = meshData.GetFormat();
+
+		strcpy(szfield, data.GetName().c_str());
+		Space2_(szfield);
+
+		if (data.DataClass() == NODE_DATA)
+		{
+			if (FillNodeDataArray(val, meshData) == false) continue;
+
+			if (ntype == DATA_ARRAY)
+			{
+				std::vector<string> arrayNames = data.GetArrayNames();
+				for (int j = 0; j < data.GetArraySize(); ++j)
+				{
+					strcpy(szfield, arrayNames[j].c_str());
+					Space2_(szfield);
+					out.clear();
+					for (int i = 0; i < NN; ++i) if (ntag[i]) out.push_back(val[j * NN + i]);
+					bok &= write_data_array(fp, szfield, 1, out, compress);
+				}
+			}
+			else
+			{
+				int ncomp = pack_values(out, val, ntype, ntag);
+				if (ncomp > 0) bok &= write_data_array(fp, szfield, ncomp, out, compress);
+			}
+		}
+		else if ((data.DataClass() == ELEM_DATA) && ((dfmt == DATA_NODE) || (dfmt == DATA_MULT)))
+		{
+			if (FillElementNodeDataArray(val, meshData) == false) continue;
+
+			int ncomp = pack_values(out, val, ntype, ntag);
+			if (ncomp > 0) bok &= write_data_array(fp, szfield, ncomp, out, compress);
+		}
+	}
+	fprintf(fp, "</PointData>\n");
+
+	// --- E L E M E N T   C E L L   D A T A ---
+	fprintf(fp, "<CellData>\n");
+	if (m_bwritePartIDs)
+	{
+		vector<int32_t> pid; pid.reserve(m_elems);
+		for (int i = 0; i < NE; ++i) if (etag[i]) pid.push_back(mesh.Element(i).m_gid);
+		bok &= write_data_array(fp, "Int32", "part_IDs", 1, pid.data(), pid.size() * sizeof(int32_t), compress);
+	}
+
+	pd = DM.FirstDataField();
+	for (int n = 0; n < NDATA; ++n, ++pd)
+	{
+		ModelDataField& data = *(*pd);
+		if (data.DataClass() != ELEM_DATA) continue;
+
+		FEMeshData& meshData = ps->m_Data[n];
+		if (meshData.GetFormat() != DATA_ITEM) continue;
+
+		if ((FillElemDataArray(val, meshData) == false) || val.empty()) continue;
+
+		strcpy(szfield, data.GetName().c_str());
+		Space2_(szfield);
+
+		int ntype = meshData.GetType();
+		if ((ntype == DATA_ARRAY) || (ntype == DATA_ARRAY_VEC3))
+		{
+			int nc = (ntype == DATA_ARRAY ? 1 : 3);
+			std::vector<string> arrayNames = data.GetArrayNames();
+			for (int j = 0; j < data.GetArraySize(); ++j)
+			{
+				strcpy(szfield, arrayNames[j].c_str());
+				Space2_(szfield);
+				out.clear();
+				for (int i = 0; i < NE; ++i)
+					if (etag[i])
+					{
+						const float* v = &val[j * (nc * NE) + nc * i];
+						out.insert(out.end(), v, v + nc);
+					}
+				bok &= write_data_array(fp, szfield, nc, out, compress);
+			}
+		}
+		else
+		{
+			int ncomp = pack_values(out, val, ntype, etag);
+			if (ncomp > 0) bok &= write_data_array(fp, szfield, ncomp, out, compress);
+		}
+	}
+	fprintf(fp, "</CellData>\n");
+
+	fprintf(fp, "</Piece>\n");
+	fprintf(fp, "</UnstructuredGrid>\n");
+	fprintf(fp, "</VTKFile>\n");
+
+	if (ferror(fp)) bok = false;
+	fclose(fp);
+
+	return bok;
+}
+
 //-----------------------------------------------------------------------------
 inline void write_data(vector<float>& val, int index, const vec3f& v)
 {
@@ -1119,3 +1466,24 @@ void FEVTKExport::WriteVTKSeriesFile(const char* szfile, std::vector<std::pair<s
 
 	fclose(fp);
 }
+
+void FEVTKExport::WritePVDFile(const char* szfile, std::vector<std::pair<std::string, float> >& series)
+{
+	FILE* fp = fopen(szfile, "wt");
+	if (fp == nullptr) return;
+
+	fprintf(fp, "<?xml version=\"1.0\"?>\n");
+	fprintf(fp, "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"LittleEndian\">\n");
+	fprintf(fp, "\t<Collection>\n");
+
+	for (size_t i = 0; i < series.size(); ++i)
+	{
+		auto& it = series[i];
+		fprintf(fp, "\t\t<DataSet timestep=\"%g\" part=\"0\" file=\"%s\"/>\n", it.second, it.first.c_str());
+	}
+
+	fprintf(fp, "\t</Collection>\n");
+	fprintf(fp, "</VTKFile>\n");
+
+	fclose(fp);
+}
@@ -44,6 +44,7 @@ public:
 
 private:
 	bool WriteState(const char* szname, FEState* ps);
+	bool WriteVTUState(const char* szname, FEState* ps);
 	bool FillNodeDataArray(std::vector<float>& val, FEMeshData& data);
 	bool FillElementNodeDataArray(std::vector<float>& val, FEMeshData& meshData);
 	bool FillElemDataArray(std::vector<float>& val, FEMeshData& data);
@@ -57,6 +58,7 @@ private:
 
 private:
 	void WriteVTKSeriesFile(const char* szfile, std::vector<std::pair<std::string, float> >& series);
+	void WritePVDFile(const char* szfile, std::vector<std::pair<std::string, float> >& series);
 
 private:
 	bool UpdateData(bool bsave) override;
@@ -64,8 +66,10 @@ private:
 public:
 	bool	m_bwriteAllStates;	// write all states
 	bool	m_bselElemsOnly;	// only output selected elements
-	bool	m_bwriteSeriesFile;	// write the vtk.series file (only for writeAllStates)
+	bool	m_bwriteSeriesFile;	// write the vtk.series (or .pvd) file (only for writeAllStates)
 	bool	m_bwritePartIDs;	// write the element part IDs as cell data
+	bool	m_bwriteBinary;		// write binary XML (.vtu) files instead of legacy ASCII files
+	bool	m_bcompress;		// compress the binary data arrays (requires zlib)
 
 private:
 	FILE*	m_fp;
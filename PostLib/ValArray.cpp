@@ -37,6 +37,12 @@ void ValArray::clear()
 	m_data.clear(); 
 }
 
+void ValArray::release()
+{
+	std::vector<int>().swap(m_index);
+	std::vector<float>().swap(m_data);
+}
+
 void ValArray::append(int items)
 {
 	if (m_index.empty()) m_index.push_back(0);
@@ -35,6 +35,9 @@ public:
 
 	void clear();
 
+	// clear the array and free its memory
+	void release();
+
 	int itemSize(int n) const { return m_index[n + 1] - m_index[n]; }
 
 	// append an item with n values
@@ -27,8 +27,10 @@ SOFTWARE.*/
 #include "FEPostModel.h"
 #include "constants.h"
 #include "FEMeshData_T.h"
+#include "FEMathData.h"
 #include <MeshLib/MeshMetrics.h>
 #include <MeshLib/MeshTools.h>
+#include <typeinfo>
 using namespace Post;
 using namespace std;
 
@@ -188,7 +190,7 @@ bool FEPostModel::IsValidFieldCode(int nfield, int nstate)
 	if ((nstate < 0) || (nstate >= GetStates())) return false;
 
 	// get the state info
-	FEState& state = *m_State[nstate];
+	FEState& state = *GetState(nstate);
 
 	// get the data field
 	int ndata = FIELD_CODE(nfield);
@@ -230,7 +232,7 @@ bool FEPostModel::EvaluateNodalPosition(int nfield, int ntime)
 bool FEPostModel::Evaluate(int nfield, int ntime, bool breset)
 {
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FSMesh* mesh = state.GetFEMesh();
 	if (mesh->Nodes() == 0) return false;
 
@@ -256,11 +258,21 @@ void FEPostModel::EvalNodeField(int ntime, int nfield)
 	assert(IS_NODE_FIELD(nfield));
 
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FSMesh* mesh = state.GetFEMesh();
 	ValArray& faceData = state.m_FaceData;
 	ValArray& elemData = state.m_ElemData;
 
+	// math fields are evaluated for all nodes at once
+	std::vector<float> mathVal;
+	bool bmath = false;
+	int ndata = FIELD_CODE(nfield);
+	if ((ndata >= 0) && (ndata < state.m_Data.size()))
+	{
+		FEMathNodeData* pmd = dynamic_cast<FEMathNodeData*>(&state.m_Data[ndata]);
+		if (pmd) bmath = pmd->EvalAll(mathVal);
+	}
+
 	// first, we evaluate all the nodes
 #pragma omp parallel
 	{
@@ -272,7 +284,11 @@ void FEPostModel::EvalNodeField(int ntime, int nfield)
 			NODEDATA& d = state.m_NODE[i];
 			d.m_val = 0;
 			d.m_ntag = 0;
-			if (node.IsEnabled()) EvaluateNode(i, ntime, nfield, d);
+			if (node.IsEnabled())
+			{
+				if (bmath) { d.m_val = mathVal[i]; d.m_ntag = 1; }
+				else EvaluateNode(i, ntime, nfield, d);
+			}
 		}
 
 		// Next, we project the nodal data onto the faces
@@ -300,21 +316,196 @@ void FEPostModel::EvalNodeField(int ntime, int nfield)
 		for (int i = 0; i < NE; ++i)
 		{
 			FSElement_& e = mesh->ElementRef(i);
-			ELEMDATA& d = state.m_ELEM[i];
-			d.m_val = 0.f;
-			d.m_state &= ~StatusFlags::ACTIVE;
+			float& dval = state.m_ELEM.m_val[i];
+			unsigned int& dstate = state.m_ELEM.m_state[i];
+			dval = 0.f;
+			dstate &= ~StatusFlags::ACTIVE;
 			e.Deactivate();
 			if (e.IsEnabled())
 			{
-				d.m_state |= StatusFlags::ACTIVE;
+				dstate |= StatusFlags::ACTIVE;
 				e.Activate();
-				for (int j = 0; j < e.Nodes(); ++j) { float val = state.m_NODE[e.m_node[j]].m_val; elemData.value(i, j) = val; d.m_val += val; }
-				d.m_val /= (float)e.Nodes();
+				for (int j = 0; j < e.Nodes(); ++j) { float val = state.m_NODE[e.m_node[j]].m_val; elemData.value(i, j) = val; dval += val; }
+				dval /= (float)e.Nodes();
 			}
 		}
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Batched evaluation of face and element fields.
+// The per-item EvaluateFace/EvaluateElement functions resolve the data type with a
+// dynamic_cast and call the virtual eval/active for every item. For the common
+// vector-backed storage classes we resolve the concrete type once per field and
+// evaluate all items in a single (parallel) loop with non-virtual calls.
+static inline float batch_component(float v, int) { return v; }
+template <typename T> static inline float batch_component(const T& v, int n) { return component(v, n); }
+
+// Evaluate item i of the (concrete) data field df. Returns false if the item has no data.
+template <class D, typename T, DATA_FORMAT fmt>
+static inline bool batch_eval_item(D& df, int i, int nn, int ncomp, float* data, float& val)
+{
+	if (df.D::active(i) == false) return false;
+	if ((fmt == DATA_NODE) || (fmt == DATA_MULT))
+	{
+		T v[FSElement::MAX_NODES];
+		df.D::eval(i, v);
+		val = 0.f;
+		for (int j = 0; j < nn; ++j)
+		{
+			data[j] = batch_component(v[j], ncomp);
+			val += data[j];
+		}
+		val /= (float)nn;
+	}
+	else
+	{
+		T v;
+		df.D::eval(i, &v);
+		val = batch_component(v, ncomp);
+		for (int j = 0; j < nn; ++j) data[j] = val;
+	}
+	return true;
+}
+
+template <typename T, DATA_FORMAT fmt>
+static bool EvalFaceDataBatch(FEState& state, FEMeshData& rd, int ncomp)
+{
+	typedef FEFaceData<T, fmt> D;
+	if (typeid(rd) != typeid(D)) return false;
+	D& df = static_cast<D&>(rd);
+
+	FSMesh* mesh = state.GetFEMesh();
+	ValArray& faceData = state.m_FaceData;
+	const int NF = mesh->Faces();
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < NF; ++i)
+	{
+		FSFace& f = mesh->Face(i);
+		FACEDATA& d = state.m_FACE[i];
+		d.m_val = 0.f;
+		d.m_ntag = 0;
+		f.Deactivate();
+		if (f.IsEnabled())
+		{
+			float data[FSElement::MAX_NODES], val;
+			int nf = f.Nodes();
+			if (batch_eval_item<D, T, fmt>(df, i, nf, ncomp, data, val))
+			{
+				f.Activate();
+				d.m_ntag = 1;
+				d.m_val = val;
+				for (int j = 0; j < nf; ++j) faceData.value(i, j) = data[j];
+			}
+		}
+	}
+	return true;
+}
+
+template <typename T, DATA_FORMAT fmt>
+static bool EvalElemDataBatch(FEState& state, FEMeshData& rd, int ncomp)
+{
+	typedef FEElementData<T, fmt> D;
+	if (typeid(rd) != typeid(D)) return false;
+	D& df = static_cast<D&>(rd);
+
+	FSMesh* mesh = state.GetFEMesh();
+	ValArray& elemData = state.m_ElemData;
+	const int NE = mesh->Elements();
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < NE; ++i)
+	{
+		FSElement_& el = mesh->ElementRef(i);
+		float& dval = state.m_ELEM.m_val[i];
+		unsigned int& dstate = state.m_ELEM.m_state[i];
+		dval = 0.f;
+		dstate &= ~StatusFlags::ACTIVE;
+		el.Deactivate();
+		if (el.IsEnabled() && !el.IsEroded() && !el.IsDisabled())
+		{
+			float data[FSElement::MAX_NODES], val;
+			int ne = el.Nodes();
+			if (batch_eval_item<D, T, fmt>(df, i, ne, ncomp, data, val))
+			{
+				dstate |= StatusFlags::ACTIVE;
+				dval = val;
+				el.Activate();
+				for (int j = 0; j < ne; ++j) elemData.value(i, j) = data[j];
+			}
+		}
+	}
+	return true;
+}
+
+// dispatch on the data format
+template <template <typename, DATA_FORMAT> class F> struct BatchFormat
+{
+	template <typename T> static bool eval(FEState& state, FEMeshData& rd, int ncomp)
+	{
+		switch (rd.GetFormat())
+		{
+		case DATA_ITEM  : return F<T, DATA_ITEM  >::eval(state, rd, ncomp);
+		case DATA_REGION: return F<T, DATA_REGION>::eval(state, rd, ncomp);
+		case DATA_MULT  : return F<T, DATA_MULT  >::eval(state, rd, ncomp);
+		case DATA_NODE  : return F<T, DATA_NODE  >::eval(state, rd, ncomp);
+		default:
+			return false;
+		}
+	}
+};
+
+// dispatch on the data type
+template <template <typename, DATA_FORMAT> class F>
+static bool EvalFieldBatch(FEState& state, FEMeshData& rd, int ncomp)
+{
+	typedef BatchFormat<F> B;
+	switch (rd.GetType())
+	{
+	case DATA_SCALAR: return B::template eval<float  >(state, rd, ncomp);
+	case DATA_VEC3  : return B::template eval<vec3f  >(state, rd, ncomp);
+	case DATA_MAT3  : return B::template eval<mat3f  >(state, rd, ncomp);
+	case DATA_MAT3S : return B::template eval<mat3fs >(state, rd, ncomp);
+	case DATA_MAT3SD: return B::template eval<mat3fd >(state, rd, ncomp);
+	case DATA_TENS4S: return B::template eval<tens4fs>(state, rd, ncomp);
+	default:
+		return false;
+	}
+}
+
+// math element fields are evaluated for all elements at once
+static bool EvalMathElemBatch(FEState& state, FEMeshData& rd)
+{
+	FEMathElemData* pmd = dynamic_cast<FEMathElemData*>(&rd);
+	if (pmd == nullptr) return false;
+
+	std::vector<float> val;
+	if (pmd->EvalAll(val) == false) return false;
+
+	FSMesh* mesh = state.GetFEMesh();
+	ValArray& elemData = state.m_ElemData;
+	const int NE = mesh->Elements();
+#pragma omp parallel for schedule(static)
+	for (int i = 0; i < NE; ++i)
+	{
+		FSElement_& el = mesh->ElementRef(i);
+		state.m_ELEM.m_val[i] = 0.f;
+		state.m_ELEM.m_state[i] &= ~StatusFlags::ACTIVE;
+		el.Deactivate();
+		if (el.IsEnabled() && !el.IsEroded() && !el.IsDisabled())
+		{
+			state.m_ELEM.m_state[i] |= StatusFlags::ACTIVE;
+			state.m_ELEM.m_val[i] = val[i];
+			el.Activate();
+			int ne = el.Nodes();
+			for (int j = 0; j < ne; ++j) elemData.value(i, j) = val[i];
+		}
+	}
+	return true;
+}
+
+template <typename T, DATA_FORMAT fmt> struct FaceBatch { static bool eval(FEState& s, FEMeshData& rd, int n) { return EvalFaceDataBatch<T, fmt>(s, rd, n); } };
+template <typename T, DATA_FORMAT fmt> struct ElemBatch { static bool eval(FEState& s, FEMeshData& rd, int n) { return EvalElemDataBatch<T, fmt>(s, rd, n); } };
+
 //-----------------------------------------------------------------------------
 // Evaluate a face field variable
 void FEPostModel::EvalFaceField(int ntime, int nfield)
@@ -322,7 +513,7 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 	assert(IS_FACE_FIELD(nfield));
 
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FSMesh* mesh = state.GetFEMesh();
 
 	// get the data ID
@@ -381,28 +572,33 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 	{
 		// first evaluate all faces
 		ValArray& faceData = state.m_FaceData;
-		float data[FSFace::MAX_NODES], val;
-		for (int i = 0; i < mesh->Faces(); ++i)
+		if (EvalFieldBatch<FaceBatch>(state, rd, ncomp) == false)
 		{
-			FSFace& f = mesh->Face(i);
-			state.m_FACE[i].m_val = 0.f;
-			state.m_FACE[i].m_ntag = 0;
-			f.Deactivate();
-			if (f.IsEnabled())
+			float data[FSFace::MAX_NODES], val;
+			for (int i = 0; i < mesh->Faces(); ++i)
 			{
-				if (EvaluateFace(i, ntime, nfield, data, val))
+				FSFace& f = mesh->Face(i);
+				state.m_FACE[i].m_val = 0.f;
+				state.m_FACE[i].m_ntag = 0;
+				f.Deactivate();
+				if (f.IsEnabled())
 				{
-					f.Activate();
-					state.m_FACE[i].m_ntag = 1;
-					state.m_FACE[i].m_val = val;
-					for (int j=0; j<f.Nodes(); ++j)
-						faceData.value(i, j) = data[j];
+					if (EvaluateFace(i, ntime, nfield, data, val))
+					{
+						f.Activate();
+						state.m_FACE[i].m_ntag = 1;
+						state.m_FACE[i].m_val = val;
+						for (int j=0; j<f.Nodes(); ++j)
+							faceData.value(i, j) = data[j];
+					}
 				}
 			}
 		}
 
 		// now evaluate the nodes
-		for (int i = 0; i < mesh->Nodes(); ++i)
+		const int NN = mesh->Nodes();
+#pragma omp parallel for schedule(static)
+		for (int i = 0; i < NN; ++i)
 		{
 			NODEDATA& node = state.m_NODE[i];
 			node.m_val = 0.f;
@@ -430,12 +626,14 @@ void FEPostModel::EvalFaceField(int ntime, int nfield)
 
 	// evaluate the elements (to zero)
 	// Face data is not projected onto the elements
-	for (int i=0; i<mesh->Elements(); ++i)
+	const int NE = mesh->Elements();
+#pragma omp parallel for schedule(static)
+	for (int i=0; i<NE; ++i)
 	{
 		FSElement_& el = mesh->ElementRef(i);
 		el.Deactivate();
-		state.m_ELEM[i].m_val = 0.f;
-		state.m_ELEM[i].m_state &= ~StatusFlags::ACTIVE;
+		state.m_ELEM.m_val[i] = 0.f;
+		state.m_ELEM.m_state[i] &= ~StatusFlags::ACTIVE;
 	}
 }
 
@@ -444,7 +642,7 @@ void FEPostModel::EvalEdgeField(int ntime, int nfield)
 	assert(IS_EDGE_FIELD(nfield));
 
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FSMesh* mesh = state.GetFEMesh();
 
 	// get the data ID
@@ -541,8 +739,8 @@ void FEPostModel::EvalEdgeField(int ntime, int nfield)
 	{
 		FSElement_& el = mesh->ElementRef(i);
 		el.Deactivate();
-		state.m_ELEM[i].m_val = 0.f;
-		state.m_ELEM[i].m_state &= ~StatusFlags::ACTIVE;
+		state.m_ELEM.m_val[i] = 0.f;
+		state.m_ELEM.m_state[i] &= ~StatusFlags::ACTIVE;
 	}
 }
 
@@ -553,27 +751,36 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 	assert(IS_ELEM_FIELD(nfield));
 
 	// get the state data 
-	FEState& state = *m_State[ntime];
+	FEState& state = *GetState(ntime);
 	FSMesh* mesh = state.GetFEMesh();
 
 	// first evaluate all elements
-	float data[FSElement::MAX_NODES] = {0.f};
-	float val;
-	for (int i=0; i<mesh->Elements(); ++i)
+	// Plain element data is evaluated in one batch. Other fields (e.g. arrays)
+	// are evaluated element by element.
+	int ndata = FIELD_CODE(nfield);
+	int ncomp = FIELD_COMP(nfield);
+	assert((ndata >= 0) && (ndata < state.m_Data.size()));
+	if ((EvalMathElemBatch(state, state.m_Data[ndata]) == false) &&
+		(EvalFieldBatch<ElemBatch>(state, state.m_Data[ndata], ncomp) == false))
 	{
-		FSElement_& el = mesh->ElementRef(i);
-		state.m_ELEM[i].m_val = 0.f;
-		state.m_ELEM[i].m_state &= ~StatusFlags::ACTIVE;
-		el.Deactivate();
-		if (el.IsEnabled())
+		float data[FSElement::MAX_NODES] = {0.f};
+		float val;
+		for (int i=0; i<mesh->Elements(); ++i)
 		{
-			if (EvaluateElement(i, ntime, nfield, data, val))
+			FSElement_& el = mesh->ElementRef(i);
+			state.m_ELEM.m_val[i] = 0.f;
+			state.m_ELEM.m_state[i] &= ~StatusFlags::ACTIVE;
+			el.Deactivate();
+			if (el.IsEnabled())
 			{
-				state.m_ELEM[i].m_state |= StatusFlags::ACTIVE;
-				state.m_ELEM[i].m_val = val;
-				el.Activate();
-				int ne = el.Nodes();
-				for (int j=0; j<ne; ++j) state.m_ElemData.value(i, j) = data[j];
+				if (EvaluateElement(i, ntime, nfield, data, val))
+				{
+					state.m_ELEM.m_state[i] |= StatusFlags::ACTIVE;
+					state.m_ELEM.m_val[i] = val;
+					el.Activate();
+					int ne = el.Nodes();
+					for (int j=0; j<ne; ++j) state.m_ElemData.value(i, j) = data[j];
+				}
 			}
 		}
 	}
@@ -581,7 +788,9 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 	// now evaluate the nodes
 	ValArray& elemData = state.m_ElemData;
 	FSNodeElementList& NEL = mesh->NodeElementList();
-	for (int i=0; i<mesh->Nodes(); ++i)
+	const int NN = mesh->Nodes();
+#pragma omp parallel for schedule(static)
+	for (int i=0; i<NN; ++i)
 	{
 		FSNode& node = mesh->Node(i);
 		state.m_NODE[i].m_val = 0.f;
@@ -594,8 +803,7 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 			{
 				int eid = NEL.ElementIndex(i, j);
 				int nid = NEL.ElementNodeIndex(i, j);
-				ELEMDATA& e = state.m_ELEM[eid];
-				if (e.m_state & StatusFlags::ACTIVE)
+				if (state.m_ELEM.m_state[eid] & StatusFlags::ACTIVE)
 				{
 					val += elemData.value(eid, nid);
 					++n;
@@ -610,7 +818,9 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 	}
 
 	// evaluate faces
-	for (int i=0; i<mesh->Faces(); ++i)
+	const int NF = mesh->Faces();
+#pragma omp parallel for schedule(static)
+	for (int i=0; i<NF; ++i)
 	{
 		FSFace& f = mesh->Face(i);
 		FACEDATA& d = state.m_FACE[i];
@@ -618,7 +828,7 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 
 		int eid = f.m_elem[0].eid;
 		int lid = f.m_elem[0].lid;
-		if ((state.m_ELEM[eid].m_state & StatusFlags::ACTIVE) == 0)
+		if ((state.m_ELEM.m_state[eid] & StatusFlags::ACTIVE) == 0)
 		{
 			if (f.m_elem[1].eid >= 0)
 			{
@@ -629,8 +839,7 @@ void FEPostModel::EvalElemField(int ntime, int nfield)
 
 		f.Deactivate();
 
-		ELEMDATA& e = state.m_ELEM[eid];
-		if (e.m_state & StatusFlags::ACTIVE)
+		if (state.m_ELEM.m_state[eid] & StatusFlags::ACTIVE)
 		{
 			d.m_ntag = 1;
 
@@ -817,7 +1026,8 @@ void FEPostModel::EvaluateNode(const vec3f& p, int ntime, int nfield, NODEDATA&
 	FSMesh& mesh = *GetState(ntime)->GetFEMesh();
 	int elid = -1;
 	double r[3];
-	if (FindElementRef(mesh, p, elid, r) == false)
+	FSElementBVH* bvh = GetElementBVH(&mesh);
+	if ((bvh == nullptr) || (bvh->FindElement(p, elid, r) == false))
 	{
 		d.m_ntag = 0;
 		return;
@@ -848,7 +1058,7 @@ bool FEPostModel::EvaluateEdge(int n, int ntime, int nfield, EDGEDATA& d)
 	int ne = e.Nodes();
 
 	// get the state
-	FEState& s = *m_State[ntime];
+	FEState& s = *GetState(ntime);
 
 	if (IS_EDGE_FIELD(nfield))
 	{
@@ -1266,7 +1476,7 @@ bool FEPostModel::EvaluateFace(int n, int ntime, int nfield, float* data, float&
 	int ntag = 0;
 
 	// get the state
-	FEState& s = *m_State[ntime];
+	FEState& s = *GetState(ntime);
 
 
 	if (IS_FACE_FIELD(nfield))
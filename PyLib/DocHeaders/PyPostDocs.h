@@ -33,13 +33,13 @@ static const char *__doc_Post_EDGEDATA_m_nv = R"doc(nodal values)doc";
 
 static const char *__doc_Post_EDGEDATA_m_val = R"doc(current value)doc";
 
-static const char *__doc_Post_ELEMDATA = R"doc(Data structure for storing element information)doc";
+static const char *__doc_Post_ELEMDATA = R"doc(Class for storing element information)doc";
 
-static const char *__doc_Post_ELEMDATA_m_h = R"doc(shell thickness (TODO: Can we move this to the face data?))doc";
+static const char *__doc_Post_ELEMDATA_ShellThickness = R"doc(Get the shell thickness of node j of an element (zero if not set))doc";
 
-static const char *__doc_Post_ELEMDATA_m_state = R"doc(state flags)doc";
+static const char *__doc_Post_ELEMDATA_m_state = R"doc(element state flags)doc";
 
-static const char *__doc_Post_ELEMDATA_m_val = R"doc(current element value)doc";
+static const char *__doc_Post_ELEMDATA_m_val = R"doc(current element values)doc";
 
 static const char *__doc_Post_FACEDATA = R"doc(Data structure for storing face information)doc";
 
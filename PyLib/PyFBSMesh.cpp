@@ -41,6 +41,7 @@ SOFTWARE.*/
 #include <pybind11/pybind11.h>
 #include <pybind11/operators.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include "DocHeaders/PyMeshDocs.h"
 #include "PyUtil.h"
 
@@ -322,6 +323,44 @@ public:
 	}
 };
 
+// Returns the element connectivity as an array of shape (elements, max nodes per element),
+// padded with -1 for elements that have fewer nodes.
+py::array ElementConnectivity(FSMesh& self)
+{
+	int NE = self.Elements();
+	int nmax = 0;
+	for (int i = 0; i < NE; ++i) nmax = std::max(nmax, self.Element(i).Nodes());
+
+	py::array_t<int> a({ (py::ssize_t)NE, (py::ssize_t)nmax });
+	int* pd = a.mutable_data();
+	for (int i = 0; i < NE; ++i)
+	{
+		const FSElement& el = self.Element(i);
+		int ne = el.Nodes();
+		for (int j = 0; j < nmax; ++j) pd[(size_t)i * nmax + j] = (j < ne ? el.m_node[j] : -1);
+	}
+	return a;
+}
+
+// Returns the face connectivity as an array of shape (faces, max nodes per face),
+// padded with -1 for faces that have fewer nodes.
+py::array FaceConnectivity(FSMeshBase& self)
+{
+	int NF = self.Faces();
+	int nmax = 0;
+	for (int i = 0; i < NF; ++i) nmax = std::max(nmax, self.Face(i).Nodes());
+
+	py::array_t<int> a({ (py::ssize_t)NF, (py::ssize_t)nmax });
+	int* pd = a.mutable_data();
+	for (int i = 0; i < NF; ++i)
+	{
+		const FSFace& f = self.Face(i);
+		int nf = f.Nodes();
+		for (int j = 0; j < nmax; ++j) pd[(size_t)i * nmax + j] = (j < nf ? f.n[j] : -1);
+	}
+	return a;
+}
+
 py::object GetMeshDataValue(FSMeshData& self, int i)
 {
 	int n = self.DataItems();
@@ -455,10 +494,18 @@ void init_FSMesh(py::module_& m)
 	py::class_<FSLineMesh, std::unique_ptr<FSLineMesh, py::nodelete>>(mesh, "LineMesh", DOC(FSLineMesh))
 		.def_property_readonly( "nodes", [](FSLineMesh& self) { return PyMeshNodeList(&self); }, py::return_value_policy::reference_internal)
 		.def_property_readonly( "edges", [](FSLineMesh& self) { return PyMeshEdgeList(&self); }, py::return_value_policy::reference_internal)
+		// The mesh is not owned by Python, so setting it as the base of the array does not keep
+		// it alive. The array can only be used while the mesh is not modified or deleted.
+		.def_property_readonly("node_positions", [](py::object self) {
+			FSLineMesh& m = self.cast<FSLineMesh&>();
+			const double* pd = (m.Nodes() > 0 ? &m.Node(0).r.x : nullptr);
+			return py::array_t<double>({ (py::ssize_t)m.Nodes(), (py::ssize_t)3 }, { (py::ssize_t)sizeof(FSNode), (py::ssize_t)sizeof(double) }, pd, self);
+			}, "NumPy array of the node positions. Shares memory with the mesh, so it is only valid while the mesh is not modified or deleted.")
 		;
 
 	py::class_<FSMeshBase, FSLineMesh, std::unique_ptr<FSMeshBase, py::nodelete>>(mesh, "MeshBase", DOC(FSMeshBase))
 		.def_property_readonly("faces", [](FSMeshBase& self) { return PyMeshFaceList(&self); }, py::return_value_policy::reference_internal)
+		.def_property_readonly("face_connectivity", &FaceConnectivity, "NumPy array of the face nodes, padded with -1.")
 		.def("find_all_intersections", FindAllIntersections);
 		;
 
@@ -475,6 +522,7 @@ void init_FSMesh(py::module_& m)
 		.def("rebuild_mesh", &FSMesh::RebuildMesh, DOC(FSMesh, RebuildMesh))
 
 		.def_property_readonly("elements", [](FSMesh& self) { return PyMeshElementList(&self); }, py::return_value_policy::reference_internal)
+		.def_property_readonly("element_connectivity", &ElementConnectivity, "NumPy array of the element nodes, padded with -1.")
 
 		.def_property_readonly("node_sets", [](FSMesh& self) { return PyMeshNodeSetList(&self); }, py::return_value_policy::reference_internal)
 		.def_property_readonly("surfaces", [](FSMesh& self) { return PyMeshSurfaceList(&self); }, py::return_value_policy::reference_internal)
@@ -28,6 +28,7 @@ SOFTWARE.*/
 #ifdef HAS_PYTHON
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 #include <PostLib/FEPostModel.h>
 #include <PostLib/FEState.h>
 #include <PostLib/FEDataManager.h>
@@ -37,6 +38,7 @@ SOFTWARE.*/
 #include <PostLib/FEDistanceMap.h>
 #include <PostLib/DataFilter.h>
 #include <PostLib/FEVTKExport.h>
+#include <PostLib/FETimeHistory.h>
 #include <PostGL/GLModel.h>
 #include "DocHeaders/PyPostDocs.h"
 #include "PyFBSMesh.h"
@@ -327,6 +329,84 @@ double PostIntegrateFaces(FEPostModel& model, const std::string& surfName, int f
 	return Post::IntegrateFaces(*mesh, faceList, ps);
 }
 
+// Returns the state of a Python state object, making sure that its data is loaded
+// when the model loads its states on demand.
+static FEState& ResidentState(py::object state)
+{
+	FEState& s = state.cast<FEState&>();
+	FEPostModel* fem = s.GetFSModel();
+	if (fem->GetStateLoader()) fem->GetState(s.GetID());
+	return s;
+}
+
+// Returns a NumPy array that shares its memory with the data of a state. The state object is
+// set as the base of the array, but the state itself is owned by the model, so the array is 
+// only valid while the model is unchanged (i.e. not reloaded or closed, and its states are not
+// deleted). When the model loads its states on demand, the data of a state is released when
+// other states are paged in, so in that case a copy is returned instead.
+template <typename T>
+py::array StateDataArray(py::object state, const T* pd, std::vector<py::ssize_t> shape, std::vector<py::ssize_t> strides)
+{
+	FEState& s = state.cast<FEState&>();
+	if (s.GetFSModel()->GetStateLoader()) return py::array_t<T>(shape, strides, pd);
+	return py::array_t<T>(shape, strides, pd, state);
+}
+
+// Evaluates a field for all items of the given type over all states.
+// Returns an array of shape (states, items).
+py::array PostFieldHistory(CGLModel& model, py::handle fieldRef, int itemType)
+{
+	FEPostModel& fem = *model.GetFSModel();
+	int fieldCode = PyHandleToDataFieldCode(fem, fieldRef);
+
+	FSMesh* mesh = fem.GetFEMesh(0);
+	int items = 0;
+	if (mesh)
+	{
+		switch (itemType)
+		{
+		case FETimeHistoryCache::NODE_ITEM: items = mesh->Nodes(); break;
+		case FETimeHistoryCache::EDGE_ITEM: items = mesh->Edges(); break;
+		case FETimeHistoryCache::FACE_ITEM: items = mesh->Faces(); break;
+		case FETimeHistoryCache::ELEM_ITEM: items = mesh->Elements(); break;
+		}
+	}
+
+	std::vector<int> itemList(items);
+	for (int i = 0; i < items; ++i) itemList[i] = i;
+
+	int states = fem.GetStates();
+	py::array_t<float> a({ (py::ssize_t)states, (py::ssize_t)items });
+	float* pv = a.mutable_data();
+	{
+		py::gil_scoped_release release;
+		EvaluateTimeHistory(fem, itemType, fieldCode, itemList, pv, items, 1);
+	}
+	return a;
+}
+
+// Evaluates a vector field for all nodes over all states.
+// Returns an array of shape (states, nodes, 3).
+py::array PostNodeVectorHistory(CGLModel& model, py::handle fieldRef)
+{
+	FEPostModel& fem = *model.GetFSModel();
+	int fieldCode = PyHandleToDataFieldCode(fem, fieldRef);
+
+	FSMesh* mesh = fem.GetFEMesh(0);
+	int nodes = (mesh ? mesh->Nodes() : 0);
+	std::vector<int> nodeList(nodes);
+	for (int i = 0; i < nodes; ++i) nodeList[i] = i;
+
+	int states = fem.GetStates();
+	py::array_t<float> a({ (py::ssize_t)states, (py::ssize_t)nodes, (py::ssize_t)3 });
+	vec3f* pv = (vec3f*)a.mutable_data();
+	{
+		py::gil_scoped_release release;
+		EvaluateNodeVectorHistory(fem, fieldCode, nodeList, pv);
+	}
+	return a;
+}
+
 void init_FBSPost(py::module& m)
 {
 	InitStandardDataFields();
@@ -396,6 +476,18 @@ void init_FBSPost(py::module& m)
 		.def_property_readonly("plots"      , [](CGLModel& self) { return PyPostPlotList     (&self); }, py::return_value_policy::reference_internal)
 		.def_property_readonly("fe_meshes"  , [](CGLModel& self) { return PyPostFEMeshList   (&self); }, py::return_value_policy::reference_internal)
 
+		// bulk data extraction
+		.def("node_history", [](CGLModel& self, py::handle field) { return PostFieldHistory(self, field, FETimeHistoryCache::NODE_ITEM); }, py::arg("field"),
+			"Evaluates a data field for all nodes and states. Returns a NumPy array of shape (states, nodes).")
+		.def("edge_history", [](CGLModel& self, py::handle field) { return PostFieldHistory(self, field, FETimeHistoryCache::EDGE_ITEM); }, py::arg("field"),
+			"Evaluates a data field for all edges and states. Returns a NumPy array of shape (states, edges).")
+		.def("face_history", [](CGLModel& self, py::handle field) { return PostFieldHistory(self, field, FETimeHistoryCache::FACE_ITEM); }, py::arg("field"),
+			"Evaluates a data field for all faces and states. Returns a NumPy array of shape (states, faces).")
+		.def("elem_history", [](CGLModel& self, py::handle field) { return PostFieldHistory(self, field, FETimeHistoryCache::ELEM_ITEM); }, py::arg("field"),
+			"Evaluates a data field for all elements and states. Returns a NumPy array of shape (states, elements).")
+		.def("node_vector_history", &PostNodeVectorHistory, py::arg("field"),
+			"Evaluates a vector field (e.g. displacement) for all nodes and states. Returns a NumPy array of shape (states, nodes, 3).")
+
 		.def_property_readonly("colormap", [](CGLModel& self) { return self.GetColorMap(); }, py::return_value_policy::reference)
 		;
 
@@ -457,6 +549,33 @@ void init_FBSPost(py::module& m)
 		.def_readonly("face_data", &FEState::m_FACE, DOC(Post, FEState, m_FACE), py::return_value_policy::reference)
 		.def_readonly("elem_data", &FEState::m_ELEM, DOC(Post, FEState, m_ELEM), py::return_value_policy::reference)
 
+		// NumPy views of the state data (these share memory with the state and are only
+		// valid while the model is unchanged)
+		.def_property_readonly("node_positions", [](py::object self) {
+			FEState& s = ResidentState(self);
+			const float* pd = (s.m_NODE.empty() ? nullptr : &s.m_NODE[0].m_rt.x);
+			return StateDataArray(self, pd, { (py::ssize_t)s.m_NODE.size(), 3 }, { sizeof(NODEDATA), sizeof(float) });
+			}, "NumPy array of the nodal positions, as determined by the displacement map. Shares memory with the state, so it is only valid while the model is unchanged.")
+		.def_property_readonly("node_values", [](py::object self) {
+			FEState& s = ResidentState(self);
+			const float* pd = (s.m_NODE.empty() ? nullptr : &s.m_NODE[0].m_val);
+			return StateDataArray(self, pd, { (py::ssize_t)s.m_NODE.size() }, { sizeof(NODEDATA) });
+			}, "NumPy array of the nodal values of the last evaluated field. Shares memory with the state, so it is only valid while the model is unchanged.")
+		.def_property_readonly("edge_values", [](py::object self) {
+			FEState& s = ResidentState(self);
+			const float* pd = (s.m_EDGE.empty() ? nullptr : &s.m_EDGE[0].m_val);
+			return StateDataArray(self, pd, { (py::ssize_t)s.m_EDGE.size() }, { sizeof(EDGEDATA) });
+			}, "NumPy array of the edge values of the last evaluated field. Shares memory with the state, so it is only valid while the model is unchanged.")
+		.def_property_readonly("face_values", [](py::object self) {
+			FEState& s = ResidentState(self);
+			const float* pd = (s.m_FACE.empty() ? nullptr : &s.m_FACE[0].m_val);
+			return StateDataArray(self, pd, { (py::ssize_t)s.m_FACE.size() }, { sizeof(FACEDATA) });
+			}, "NumPy array of the face values of the last evaluated field. Shares memory with the state, so it is only valid while the model is unchanged.")
+		.def_property_readonly("elem_values", [](py::object self) {
+			FEState& s = ResidentState(self);
+			return StateDataArray(self, s.m_ELEM.m_val.data(), { (py::ssize_t)s.m_ELEM.size() }, { sizeof(float) });
+			}, "NumPy array of the element values of the last evaluated field. Shares memory with the state, so it is only valid while the model is unchanged.")
+
 		.def("integrate_elements", [](FEState& self, const std::string& elsetName, py::handle fieldRef) {
 			FEPostModel* fem = self.GetFSModel();
 			int fieldCode = PyHandleToDataFieldCode(*fem, fieldRef);
@@ -485,7 +604,13 @@ void init_FBSPost(py::module& m)
 	py::class_<ELEMDATA>(post, "ElementData", DOC(Post, ELEMDATA))
         .def_readonly("val", &ELEMDATA::m_val, DOC(Post, ELEMDATA, m_val))
         .def_readonly("state", &ELEMDATA::m_state, DOC(Post, ELEMDATA, m_state))
-        .def_readonly("shell_thickness", &ELEMDATA::m_h, DOC(Post, ELEMDATA, m_h));
+        .def("__len__", &ELEMDATA::size)
+        .def("shell_thickness", [](const ELEMDATA& self, int elem, int node) {
+				if ((elem < 0) || (elem >= self.size())) throw py::index_error("element index out of range");
+				int nodes = self.ShellThicknessNodes(elem);
+				if ((node < 0) || (node >= (nodes > 0 ? nodes : FSElement::MAX_NODES))) throw py::index_error("node index out of range");
+				return self.ShellThickness(elem, node);
+			}, py::arg("elem"), py::arg("node"), DOC(Post, ELEMDATA, ShellThickness));
 
 	py::class_<FACEDATA>(post, "FaceData", DOC(Post, FACEDATA))
         .def_readonly("val", &FACEDATA::m_val, DOC(Post, FACEDATA, m_val))
@@ -512,6 +637,8 @@ void init_FBSPost(py::module& m)
 		.def_readwrite("export_selected_elements_only", &FEVTKExport::m_bselElemsOnly)
 		.def_readwrite("write_series_file", &FEVTKExport::m_bwriteSeriesFile)
 		.def_readwrite("write_part_ids", &FEVTKExport::m_bwritePartIDs)
+		.def_readwrite("write_binary", &FEVTKExport::m_bwriteBinary)
+		.def_readwrite("compress", &FEVTKExport::m_bcompress)
 		.def("save", [](FEVTKExport& self, CGLModel& model, const char* szfile) { 
 			bool b = self.Save(*model.GetFSModel(), szfile); 
 			if (!b) throw std::runtime_error("Failed to save VTK file.");
@@ -40,6 +40,11 @@ rhi::Mesh::~Mesh()
 		delete[] vertexData;
 		vertexData = nullptr;
 	}
+	if (scalarData)
+	{
+		delete[] scalarData;
+		scalarData = nullptr;
+	}
 }
 
 void rhi::Mesh::create(unsigned int vertices, unsigned int sizeOfVertex, const void* data)
@@ -51,6 +56,20 @@ void rhi::Mesh::create(unsigned int vertices, unsigned int sizeOfVertex, const v
 	vbuf->create();
 }
 
+void rhi::Mesh::createScalarBuffer(unsigned int vertices, const float* data)
+{
+	sbufSize = vertices * sizeof(float);
+	sbuf.reset(m_rhi->newBuffer(QRhiBuffer::Static, QRhiBuffer::VertexBuffer, sbufSize));
+	sbuf->create();
+	setScalarData(data);
+}
+
+void rhi::Mesh::setScalarData(const float* data)
+{
+	if (scalarData == nullptr) scalarData = new float[sbufSize / sizeof(float)];
+	memcpy(scalarData, data, sbufSize);
+}
+
 void rhi::Mesh::Update(QRhiResourceUpdateBatch* u)
 {
 	if (vertexData)
@@ -60,10 +79,26 @@ void rhi::Mesh::Update(QRhiResourceUpdateBatch* u)
 		vertexData = nullptr;
 		uploadedBytes += vbufSize;
 	}
+
+	if (scalarData)
+	{
+		u->uploadStaticBuffer(sbuf.get(), scalarData);
+		delete[] scalarData;
+		scalarData = nullptr;
+		uploadedBytes += sbufSize;
+	}
 }
 
 void rhi::Mesh::BindVertexBuffer(QRhiCommandBuffer* cb)
 {
-	const QRhiCommandBuffer::VertexInput vbufBinding(vbuf.get(), 0);
-	cb->setVertexInput(0, 1, &vbufBinding);
+	if (sbuf)
+	{
+		const QRhiCommandBuffer::VertexInput vbufBinding[2] = { {vbuf.get(), 0}, {sbuf.get(), 0} };
+		cb->setVertexInput(0, 2, vbufBinding);
+	}
+	else
+	{
+		const QRhiCommandBuffer::VertexInput vbufBinding(vbuf.get(), 0);
+		cb->setVertexInput(0, 1, &vbufBinding);
+	}
 }
@@ -99,6 +99,10 @@ namespace rhi {
 
 		virtual bool CreateFromGLMesh(const GLMesh* gmsh) { return false; }
 
+		// Update only the scalar buffer. Returns false if the mesh doesn't have one,
+		// in which case the mesh needs to be recreated.
+		virtual bool UpdateScalarsFromGLMesh(const GLMesh* gmsh) { return false; }
+
 		size_t subMeshCount() const { return submeshes.size(); }
 
 		SubMesh* getSubMesh(int i)
@@ -114,6 +118,14 @@ namespace rhi {
 	protected:
 		void create(unsigned int vertices, unsigned int sizeOfVertex, const void* data);
 
+		// create a second vertex buffer that stores one scalar per vertex
+		void createScalarBuffer(unsigned int vertices, const float* data);
+
+		// set the new scalar values (uploaded on next update)
+		void setScalarData(const float* data);
+
+		size_t scalarCount() const { return sbufSize / sizeof(float); }
+
 	protected:
 		QRhi* m_rhi = nullptr;
 		bool active = false;
@@ -125,6 +137,11 @@ namespace rhi {
 		size_t vbufSize = 0;
 		unsigned char* vertexData = nullptr;
 
+		std::unique_ptr<QRhiBuffer> sbuf; // scalar buffer (optional)
+
+		size_t sbufSize = 0;
+		float* scalarData = nullptr;
+
 	public:
 		static size_t uploadedBytes;
 	};
@@ -75,6 +75,22 @@ void rhi::MeshRenderPass::removeCachedMesh(const GLMesh* mesh)
 	}
 }
 
+void rhi::MeshRenderPass::updateCachedMeshScalars(const GLMesh* mesh)
+{
+	if (mesh == nullptr) return;
+	unsigned int uid = mesh->GetUID();
+	for (auto it = m_meshList.begin(); it != m_meshList.end(); )
+	{
+		if ((it->gluid == uid) && !it->mesh->UpdateScalarsFromGLMesh(mesh))
+		{
+			delete it->mesh;
+			it = m_meshList.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
 rhi::Mesh* rhi::MeshRenderPass::addGLMesh(const GLMesh& mesh, bool cacheMesh)
 {
 	if (mesh.Nodes() == 0) return nullptr;
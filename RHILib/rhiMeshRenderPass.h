@@ -84,6 +84,10 @@ namespace rhi {
 
 		void removeCachedMesh(const GLMesh* mesh);
 
+		// Update the scalars of a cached mesh. Meshes that do not have a 
+		// separate scalar buffer are removed from the cache instead.
+		void updateCachedMeshScalars(const GLMesh* mesh);
+
 		size_t cachedMeshes() const { return m_meshList.size(); }
 
 	public:
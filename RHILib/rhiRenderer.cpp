@@ -261,6 +261,12 @@ void rhiRenderer::deleteCachedMesh(GLMesh* gm)
 	for (auto& it : m_volumeRenderPass) it.second->removeCachedMesh(gm);
 }
 
+void rhiRenderer::updateCachedMeshScalars(GLMesh* gm)
+{
+	// only the solid pass uses the face texture coordinates
+	m_solidPass->updateCachedMeshScalars(gm);
+}
+
 void rhiRenderer::setClearColor(const GLColor& c)
 {
 	m_clearColor = QColor(c.r, c.g, c.b, c.a);
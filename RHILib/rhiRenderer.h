@@ -100,6 +100,8 @@ public:
 
 	void deleteCachedMesh(GLMesh* gm) override;
 
+	void updateCachedMeshScalars(GLMesh* gm) override;
+
 	QSize pixelSize() const;
 
 	GLRenderStats GetRenderStats() const override;
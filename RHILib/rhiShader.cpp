@@ -248,13 +248,14 @@ QRhiVertexInputLayout SolidShader::meshLayout()
 {
 	QRhiVertexInputLayout meshLayout;
 	meshLayout.setBindings({
-		{ 13 * sizeof(float) }
+		{ 10 * sizeof(float) },
+		{ sizeof(float) } // scalar buffer
 		});
 	meshLayout.setAttributes({
 		{ 0, 0, QRhiVertexInputAttribute::Float3, 0 }, // position
 		{ 0, 1, QRhiVertexInputAttribute::Float3, 3 * sizeof(float) }, // normal 
-		{ 0, 2, QRhiVertexInputAttribute::Float3, 6 * sizeof(float) }, // texcoord
-		{ 0, 3, QRhiVertexInputAttribute::Float4, 9 * sizeof(float) }, // color
+		{ 1, 2, QRhiVertexInputAttribute::Float , 0 }, // texcoord
+		{ 0, 3, QRhiVertexInputAttribute::Float4, 6 * sizeof(float) }, // color
 		});
 	return meshLayout;
 }
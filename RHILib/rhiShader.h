@@ -111,17 +111,16 @@ public:
 class SolidShader : public rhi::Shader
 {
 public:
+	// The texture coordinate is stored in a separate scalar buffer (see rhi::ScalarTriMesh)
 	struct Vertex {
 		vec3f r; // coordinate
 		vec3f n; // normal
-		vec3f t; // texture coordinate
 		float c[4] = { 0.f }; // color
 
 		void operator = (const GLMesh::NODE& nd)
 		{
 			r = nd.r;
 			n = nd.n;
-			t = nd.t;
 			nd.c.toFloat(c);
 		}
 	};
@@ -101,7 +101,7 @@ void TwoPassSolidRenderPass::draw(QRhiCommandBuffer* cb)
 rhi::Mesh* TwoPassSolidRenderPass::newMesh(const GLMesh* mesh)
 {
 	if (mesh == nullptr) return nullptr;
-	rhi::Mesh* rm = new rhi::TriMesh<SolidShader::Vertex>(m_rhi);
+	rhi::Mesh* rm = new rhi::ScalarTriMesh<SolidShader::Vertex>(m_rhi);
 	if (!rm->CreateFromGLMesh(mesh))
 	{
 		delete rm;
@@ -89,4 +89,55 @@ namespace rhi {
 		TriMesh(const TriMesh&) = delete;
 		void operator = (const TriMesh&) = delete;
 	};
+
+	// Triangle mesh that stores the first texture coordinate in a separate
+	// vertex buffer, so that it can be updated without re-uploading the rest
+	// of the vertex data (e.g. when animating a color map).
+	template <typename Vertex>
+	class ScalarTriMesh : public TriMesh<Vertex>
+	{
+	public:
+		ScalarTriMesh(QRhi* rhi) : TriMesh<Vertex>(rhi) {}
+
+		bool CreateFromGLMesh(const GLMesh* gmsh) override
+		{
+			if (!TriMesh<Vertex>::CreateFromGLMesh(gmsh)) return false;
+
+			std::vector<float> scalars;
+			collectScalars(gmsh, scalars);
+			this->createScalarBuffer((unsigned int)scalars.size(), scalars.data());
+
+			return true;
+		}
+
+		bool UpdateScalarsFromGLMesh(const GLMesh* gmsh) override
+		{
+			if ((gmsh == nullptr) || (3 * (size_t)gmsh->Faces() != this->scalarCount())) return false;
+
+			std::vector<float> scalars;
+			collectScalars(gmsh, scalars);
+			this->setScalarData(scalars.data());
+
+			return true;
+		}
+
+	private:
+		// collect the scalars in the same order as the vertices
+		static void collectScalars(const GLMesh* gmsh, std::vector<float>& scalars)
+		{
+			scalars.resize(3 * (size_t)gmsh->Faces());
+			float* s = scalars.data();
+			for (size_t partition = 0; partition < gmsh->SurfacePartitions(); ++partition)
+			{
+				const GLMesh::SURFACE_PARTITION& part = gmsh->SurfacePartition(partition);
+#pragma omp parallel for
+				for (int i = 0; i < part.nf; ++i)
+				{
+					const GLMesh::FACE& f = gmsh->Face(i + part.n0);
+					for (int j = 0; j < 3; ++j) s[3 * i + j] = f.t[j].x;
+				}
+				s += 3 * part.nf;
+			}
+		}
+	};
 }
@@ -3,7 +3,7 @@
 // input
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 tex;
+layout(location = 2) in float tex;
 layout(location = 3) in vec4 color;
 
 // output
@@ -60,6 +60,6 @@ void main()
 
     v_normal = normalize((mesh.mv*vec4(normal, 0)).xyz);
     v_pos = (mesh.mv*vec4(position,1)).xyz;
-    v_tex = tex;
+    v_tex = vec3(tex, 0, 0);
     gl_Position = glob.projectionMatrix*(mesh.mv * vec4(position, 1));
 }
@@ -25,212 +25,470 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 #include "RTBTree.h"
 #include <FSCore/FSLogger.h>
-#include <stack>
+#include <algorithm>
+#include <limits>
+#include <cmath>
 #include <omp.h>
 
 using namespace gl;
 
-size_t rt::Btree::Block::size() const
-{
-	size_t n = tris.size();
-	if (child[0]) n += child[0]->size();
-	if (child[1]) n += child[1]->size();
-	return n;
-}
+static_assert(sizeof(rt::Btree::Node) == 32, "BVH nodes should be 32 bytes");
 
-void rt::Btree::Block::split(int level)
-{
-	if (level <= 0) return;
-	for (int i = 0; i < 2; ++i)
+namespace {
+
+	const int MAX_DEPTH = 60;		// max tree depth (must be smaller than traversal stack)
+	const int STACK_SIZE = 64;		// traversal stack size
+	const int MAX_LEAF_SIZE = 8;	// leaves larger than this are always split
+	const int SAH_BINS = 16;		// nr of bins for evaluating the SAH
+	const int PARALLEL_BINNING = 65536;	// min nr of triangles for binning in parallel
+
+	struct AABB
 	{
-		if (child[i] == nullptr)
+		double mn[3] = { 1e300, 1e300, 1e300 };
+		double mx[3] = { -1e300, -1e300, -1e300 };
+
+		void grow(const AABB& b)
 		{
-			Box box_i = box.split(i);
-			child[i] = new Block;
-			child[i]->box = box_i;
-			child[i]->split(level - 1);
+			for (int k = 0; k < 3; ++k)
+			{
+				if (b.mn[k] < mn[k]) mn[k] = b.mn[k];
+				if (b.mx[k] > mx[k]) mx[k] = b.mx[k];
+			}
 		}
-	}
-}
 
-void rt::Btree::Block::add(rt::Tri* tri, int level)
-{
-	if (level == 0)
+		void grow(const double* r)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				if (r[k] < mn[k]) mn[k] = r[k];
+				if (r[k] > mx[k]) mx[k] = r[k];
+			}
+		}
+
+		double area() const
+		{
+			double dx = mx[0] - mn[0], dy = mx[1] - mn[1], dz = mx[2] - mn[2];
+			if ((dx < 0) || (dy < 0) || (dz < 0)) return 0.0;
+			return 2.0 * (dx * dy + dy * dz + dz * dx);
+		}
+	};
+
+	struct Bin
 	{
-		tris.push_back(tri);
-	}
-	else
+		AABB	box;
+		int		count = 0;
+	};
+
+	struct BinSet
+	{
+		Bin bin[3][SAH_BINS];
+		AABB box;	// bounds of triangles
+		AABB cbox;	// bounds of centroids
+
+		void merge(const BinSet& b)
+		{
+			for (int k = 0; k < 3; ++k)
+				for (int i = 0; i < SAH_BINS; ++i)
+				{
+					bin[k][i].box.grow(b.bin[k][i].box);
+					bin[k][i].count += b.bin[k][i].count;
+				}
+			box.grow(b.box);
+			cbox.grow(b.cbox);
+		}
+	};
+
+	// a subtree that will be built by a separate thread
+	struct Subtree
 	{
-		for (int i = 0; i < 2; ++i)
+		int node, b, e, depth;
+	};
+
+	class BVHBuilder
+	{
+	public:
+		BVHBuilder(std::vector<AABB>& box, std::vector<Vec3>& cent, std::vector<int>& idx, int maxDepth) : m_box(box), m_cent(cent), m_idx(idx), m_maxDepth(maxDepth) {}
+
+		// build the tree for the triangles idx[b..e) and store it in node n. 
+		// if pending is not null, ranges smaller than minSize are not built, but added to pending
+		void build(std::vector<rt::Btree::Node>& nodes, int n, int b, int e, int depth, std::vector<Subtree>* pending, int minSize)
+		{
+			int count = e - b;
+			if (pending && (count < minSize))
+			{
+				pending->push_back({ n, b, e, depth });
+				return;
+			}
+
+			// bin the triangles
+			BinSet bins;
+			fillBins(bins, b, e, pending != nullptr);
+			setBounds(nodes[n], bins.box);
+
+			// find the best split
+			int axis = -1, split = -1;
+			double bestCost = count;
+			if ((count > 2) && (depth < m_maxDepth)) findSplit(bins, count, axis, split, bestCost);
+
+			int mid = -1;
+			if (axis >= 0)
+			{
+				double c0 = bins.cbox.mn[axis];
+				double s = SAH_BINS / (bins.cbox.mx[axis] - c0);
+				int* it = std::partition(&m_idx[0] + b, &m_idx[0] + e, [=](int i) {
+					return (binIndex(m_cent[i][axis], c0, s) <= split);
+				});
+				mid = (int)(it - &m_idx[0]);
+			}
+			else if ((count > MAX_LEAF_SIZE) && (depth < m_maxDepth))
+			{
+				// no good split found, but the leaf would be too large, so split at the median
+				int k = 0;
+				double w = 0;
+				for (int j = 0; j < 3; ++j) if (bins.box.mx[j] - bins.box.mn[j] > w) { w = bins.box.mx[j] - bins.box.mn[j]; k = j; }
+				mid = b + count / 2;
+				std::nth_element(&m_idx[0] + b, &m_idx[0] + mid, &m_idx[0] + e, [&](int i, int j) {
+					return (m_cent[i][k] < m_cent[j][k]) || ((m_cent[i][k] == m_cent[j][k]) && (i < j));
+				});
+			}
+
+			if ((mid <= b) || (mid >= e))
+			{
+				// make a leaf
+				nodes[n].first = b;
+				nodes[n].count = count;
+				return;
+			}
+
+			// create the children
+			int l = (int)nodes.size();
+			nodes.resize(l + 2);
+			nodes[n].first = l;
+			nodes[n].count = 0;
+			build(nodes, l    , b  , mid, depth + 1, pending, minSize);
+			build(nodes, l + 1, mid, e  , depth + 1, pending, minSize);
+		}
+
+	private:
+		static int binIndex(double c, double c0, double s)
 		{
-			if (child[i] == nullptr)
+			int i = (int)((c - c0) * s);
+			if (i < 0) i = 0;
+			if (i >= SAH_BINS) i = SAH_BINS - 1;
+			return i;
+		}
+
+		void fillBins(BinSet& bins, int b, int e, bool parallel)
+		{
+			// first, we need the bounds of the centroids
+			AABB box, cbox;
+			for (int i = b; i < e; ++i)
+			{
+				int n = m_idx[i];
+				box.grow(m_box[n]);
+				cbox.grow(m_cent[n].d);
+			}
+			bins.box = box;
+			bins.cbox = cbox;
+
+			double s[3];
+			for (int k = 0; k < 3; ++k)
 			{
-				Box box_n = box.split(i);
+				double w = cbox.mx[k] - cbox.mn[k];
+				s[k] = (w > 0 ? SAH_BINS / w : 0.0);
+			}
 
-				if (intersectBox(box_n, *tri))
+			if (parallel && (e - b >= PARALLEL_BINNING))
+			{
+				int nt = omp_get_max_threads();
+				std::vector<BinSet> tb(nt);
+#pragma omp parallel for schedule(static)
+				for (int i = b; i < e; ++i)
 				{
-					child[i] = new Block;
-					child[i]->box = box_n;
-					child[i]->add(tri, level - 1);
+					addToBins(tb[omp_get_thread_num()], m_idx[i], cbox, s);
 				}
+				for (int i = 0; i < nt; ++i) bins.merge(tb[i]);
+				bins.box = box;
+				bins.cbox = cbox;
 			}
-			else if (intersectBox(child[i]->box, *tri))
+			else
 			{
-				child[i]->add(tri, level - 1);
+				for (int i = b; i < e; ++i) addToBins(bins, m_idx[i], cbox, s);
 			}
 		}
-	}
-}
 
-std::vector<rt::Btree::Block*> rt::Btree::leaves()
-{
-	std::vector<rt::Btree::Block*> l;
-	std::stack<rt::Btree::Block*> S;
-	S.push(root);
-	while (!S.empty())
-	{
-		rt::Btree::Block* b = S.top(); S.pop();
-		if ((b->child[0] == nullptr) || (b->child[1] == nullptr))
+		void addToBins(BinSet& bins, int n, const AABB& cbox, const double* s)
 		{
-			l.push_back(b);
+			const Vec3& c = m_cent[n];
+			for (int k = 0; k < 3; ++k)
+			{
+				int j = binIndex(c[k], cbox.mn[k], s[k]);
+				Bin& bin = bins.bin[k][j];
+				bin.box.grow(m_box[n]);
+				bin.count++;
+			}
 		}
-		else
+
+		void findSplit(const BinSet& bins, int count, int& axis, int& split, double& bestCost)
 		{
-			if (b->child[0]) S.push(b->child[0]);
-			if (b->child[1]) S.push(b->child[1]);
+			double A = bins.box.area();
+			if (A <= 0) return;
+			for (int k = 0; k < 3; ++k)
+			{
+				if (bins.cbox.mx[k] <= bins.cbox.mn[k]) continue;
+
+				// sweep from the right to get the areas and counts of the right sides
+				double AR[SAH_BINS];
+				int NR[SAH_BINS];
+				AABB br;
+				int nr = 0;
+				for (int i = SAH_BINS - 1; i > 0; --i)
+				{
+					br.grow(bins.bin[k][i].box);
+					nr += bins.bin[k][i].count;
+					AR[i] = br.area();
+					NR[i] = nr;
+				}
+
+				// sweep from the left and evaluate the cost
+				AABB bl;
+				int nl = 0;
+				for (int i = 0; i < SAH_BINS - 1; ++i)
+				{
+					bl.grow(bins.bin[k][i].box);
+					nl += bins.bin[k][i].count;
+					if ((nl == 0) || (NR[i + 1] == 0)) continue;
+					double cost = 1.0 + (bl.area() * nl + AR[i + 1] * NR[i + 1]) / A;
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						axis = k;
+						split = i;
+					}
+				}
+			}
 		}
+
+		static void setBounds(rt::Btree::Node& node, const AABB& box)
+		{
+			// round outwards so that the float box contains the double box
+			const float inf = std::numeric_limits<float>::infinity();
+			for (int k = 0; k < 3; ++k)
+			{
+				node.bmin[k] = nextafterf((float)box.mn[k], -inf);
+				node.bmax[k] = nextafterf((float)box.mx[k],  inf);
+			}
+		}
+
+	private:
+		std::vector<AABB>& m_box;
+		std::vector<Vec3>& m_cent;
+		std::vector<int>& m_idx;
+		int m_maxDepth;
+	};
+
+	// find the ray parameter where the ray enters the box. Returns false if the ray misses the box,
+	// or if it enters beyond tmax.
+	inline bool slabTest(const rt::Btree::Node& node, const double* o, const double* invd, double tmax, double& tnear)
+	{
+		double t0 = 0.0, t1 = tmax;
+		for (int k = 0; k < 3; ++k)
+		{
+			double a = (node.bmin[k] - o[k]) * invd[k];
+			double b = (node.bmax[k] - o[k]) * invd[k];
+			if (a > b) std::swap(a, b);
+			if (a > t0) t0 = a;
+			if (b < t1) t1 = b;
+			if (t0 > t1) return false;
+		}
+		tnear = t0;
+		return true;
 	}
-	return l;
 }
 
-size_t rt::Btree::blocks() const
+void rt::Btree::clear()
 {
-	size_t n = 0;
-	std::stack<rt::Btree::Block*> S;
-	S.push(root);
-	while (!S.empty())
-	{
-		rt::Btree::Block* b = S.top(); S.pop();
-		n++;
-		if (b->child[0]) S.push(b->child[0]);
-		if (b->child[1]) S.push(b->child[1]);
-	}
-	return n;
+	m_mesh = nullptr;
+	m_nodes.clear(); m_nodes.shrink_to_fit();
+	m_tri.clear(); m_tri.shrink_to_fit();
+	m_vert.clear(); m_vert.shrink_to_fit();
 }
 
-void rt::Btree::Build(Mesh& mesh, int levels)
+void rt::Btree::Build(Mesh& mesh, int maxDepth)
 {
-	delete root;
-	root = new Block;
+	clear();
+	m_mesh = &mesh;
 
-	if (output) FSLogger::Write("Building binary tree ...\n");
+	if (output) FSLogger::Write("Building BVH ...\n");
 	int ntriangles = (int)mesh.triangles();
 	if (output) FSLogger::Write("  Nr of triangles : %d\n", ntriangles);
-	Box box;
-	for (size_t i = 0; i < mesh.triangles(); ++i)
+	if (ntriangles == 0) return;
+
+	if ((maxDepth < 0) || (maxDepth > MAX_DEPTH)) maxDepth = MAX_DEPTH;
+
+	// get the triangle bounds and centroids
+	std::vector<AABB> box(ntriangles);
+	std::vector<Vec3> cent(ntriangles);
+	m_tri.resize(ntriangles);
+#pragma omp parallel for
+	for (int i = 0; i < ntriangles; ++i)
 	{
 		rt::Tri& tri = mesh.triangle(i);
-		box += tri.r[0];
-		box += tri.r[1];
-		box += tri.r[2];
+		AABB b;
+		for (int j = 0; j < 3; ++j) b.grow(tri.r[j].d);
+		box[i] = b;
+		cent[i] = (tri.r[0] + tri.r[1] + tri.r[2]) / 3.0;
+		m_tri[i] = i;
 	}
-	root->box = box;
 
-	if (levels < 0) levels = 0;
-	if (output) FSLogger::Write("  Splitting levels : %d\n", levels);
-	int m = 0;
-	std::vector<rt::Btree::Block*> leaves;
-	if (ntriangles > 0)
+	BVHBuilder builder(box, cent, m_tri, maxDepth);
+
+	m_nodes.reserve(2 * (ntriangles / 2) + 1);
+	m_nodes.resize(1);
+
+	int nt = omp_get_max_threads();
+	if (nt < 2)
 	{
-#pragma omp parallel shared(leaves)
-		{
-			// the the number of threads in this parallel region
-			int numThreads = omp_get_num_threads();
+		builder.build(m_nodes, 0, 0, ntriangles, 0, nullptr, 0);
+	}
+	else
+	{
+		// build the top of the tree in serial (but with parallel binning), until
+		// the subtrees are small enough to distribute over the threads.
+		if (output) FSLogger::Write("  Using %d threads.\n", nt);
+		int minSize = ntriangles / (8 * nt);
+		if (minSize < 1024) minSize = 1024;
+		std::vector<Subtree> pending;
+		builder.build(m_nodes, 0, 0, ntriangles, 0, &pending, minSize);
 
-			// only execute in parallel if it's worth it
-			if ((levels < 2) || (numThreads < 2))
-			{
-				// let's do it in serial
-#pragma omp master
-				for (int i = 0; i < ntriangles; ++i)
-				{
-					rt::Tri& tri = mesh.triangle(i);
-					root->add(&tri, levels);
-				}
-			}
-			else
-			{
-				// create initial split
-#pragma omp single
-				{
-					m = (int)log2(numThreads);
-					if (m > levels - 1) m = levels - 1;
-					int actualThreads = (int)pow(2, m);
-					if (output) FSLogger::Write("  Using %d threads.\n", actualThreads);
-					root->split(m);
-					leaves = rt::Btree::leaves();
-				}
+		// build the subtrees in parallel
+		int ns = (int)pending.size();
+		std::vector< std::vector<Node> > sub(ns);
+#pragma omp parallel for schedule(dynamic)
+		for (int i = 0; i < ns; ++i)
+		{
+			Subtree& st = pending[i];
+			sub[i].resize(1);
+			builder.build(sub[i], 0, st.b, st.e, st.depth, nullptr, 0);
+		}
 
-				// loop over all the triangles and sort them in the blocks
-				int threadId = omp_get_thread_num();
-				if ((threadId >= 0) && (threadId < (int)leaves.size()))
-				{
-					for (int i = 0; i < ntriangles; ++i)
-					{
-						rt::Tri& tri = mesh.triangle(i);
-						if (intersectBox(leaves[threadId]->box, tri))
-							leaves[threadId]->add(&tri, levels - m);
-					}
-				}
-			}
+		// copy the subtrees into the tree. The subtree's root goes into the pending node, 
+		// and the other nodes are appended (in order, so the result does not depend on the threads).
+		for (int i = 0; i < ns; ++i)
+		{
+			std::vector<Node>& s = sub[i];
+			int offset = (int)m_nodes.size() - 1;
+			for (Node& node : s) if (node.count == 0) node.first += offset;
+			m_nodes[pending[i].node] = s[0];
+			m_nodes.insert(m_nodes.end(), s.begin() + 1, s.end());
+			std::vector<Node>().swap(s);
 		}
 	}
-	int nrblocks = (int)blocks();
-	if (output) FSLogger::Write("  Nr. of blocks : %d\n", nrblocks);
-	if (output) FSLogger::Write("  Nr. of triangles in BTree : %d\n", (int)root->size());
+	m_nodes.shrink_to_fit();
+
+	// store the triangles in tree order
+	m_vert.resize(3 * (size_t)ntriangles);
+#pragma omp parallel for
+	for (int i = 0; i < ntriangles; ++i)
+	{
+		rt::Tri& tri = mesh.triangle(m_tri[i]);
+		m_vert[3 * i    ] = tri.r[0];
+		m_vert[3 * i + 1] = tri.r[1] - tri.r[0];
+		m_vert[3 * i + 2] = tri.r[2] - tri.r[0];
+	}
+
+	if (output)
+	{
+		int leaves = 0;
+		for (const Node& node : m_nodes) if (node.count > 0) leaves++;
+		FSLogger::Write("  Nr. of nodes : %d\n", (int)m_nodes.size());
+		FSLogger::Write("  Nr. of leaves : %d\n", leaves);
+	}
 }
 
 bool rt::Btree::intersect(const Ray& ray, Point& p)
 {
-	Vec3 c;
-	if (root->box.intersect(ray, c) == false) return false;
+	if (m_nodes.empty()) return false;
+
+	const Vec3& o = ray.origin;
+	const Vec3& d = ray.direction;
+	double dd = d * d;
+
+	// inverse direction (we use a large number instead of inf to avoid 0*inf)
+	double invd[3];
+	for (int k = 0; k < 3; ++k) invd[k] = (d[k] != 0.0 ? 1.0 / d[k] : (std::signbit(d[k]) ? -1e300 : 1e300));
 
-	bool found = false;
-	double Dmin = 0;
+	double tbest = std::numeric_limits<double>::max();
+	int ibest = -1;
+	double ubest = 0, vbest = 0;
 
-	std::stack<rt::Btree::Block*> S;
-	S.push(root);
-	while (!S.empty())
+	double tnear;
+	if (slabTest(m_nodes[0], o.d, invd, tbest, tnear) == false) return false;
+
+	int stack[STACK_SIZE];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0)
 	{
-		rt::Btree::Block* block = S.top(); S.pop();
-		if (block->tris.empty() == false)
+		const Node& node = m_nodes[stack[--top]];
+		if (node.count > 0)
 		{
-			rt::Point tmp;
-			if (intersectTriangles(block->tris, ray, tmp))
+			// test all triangles in this leaf
+			for (int i = node.first; i < node.first + node.count; ++i)
 			{
-				double D2 = (tmp.r - ray.origin).sqrLength();
-				if ((found == false) || (D2 < Dmin))
+				const Vec3& v0 = m_vert[3 * i];
+				const Vec3& e1 = m_vert[3 * i + 1];
+				const Vec3& e2 = m_vert[3 * i + 2];
+
+				Vec3 h = Vec3::cross(d, e2);
+				double det = e1 * h;
+				if (det == 0.0) continue;
+				double f = 1.0 / det;
+				Vec3 s = o - v0;
+				double u = f * (s * h);
+				if ((u < 0.0) || (u > 1.0)) continue;
+				Vec3 q = Vec3::cross(s, e1);
+				double v = f * (d * q);
+				if ((v < 0.0) || (u + v > 1.0)) continue;
+				double t = f * (e2 * q);
+
+				// ignore hits at the ray origin
+				if ((t < 0.0) || (t * t * dd <= 1e-12)) continue;
+				if (t < tbest)
 				{
-					found = true;
-					Dmin = D2;
-					p = tmp;
+					tbest = t;
+					ibest = i;
+					ubest = u;
+					vbest = v;
 				}
 			}
 		}
-
-		Vec3 c1, c2;
-		bool b1 = (block->child[0] ? block->child[0]->box.intersect(ray, c1) : false);
-		bool b2 = (block->child[1] ? block->child[1]->box.intersect(ray, c2) : false);
-
-		if (b1)
-		{
-			if (!found || ((c1 - ray.origin).sqrLength() < Dmin)) S.push(block->child[0]);
-		}
-		if (b2)
+		else
 		{
-			if (!found || ((c2 - ray.origin).sqrLength() < Dmin)) S.push(block->child[1]);
+			// visit the nearest child first
+			int l = node.first;
+			double tl, tr;
+			bool bl = slabTest(m_nodes[l    ], o.d, invd, tbest, tl);
+			bool br = slabTest(m_nodes[l + 1], o.d, invd, tbest, tr);
+			if (bl && br)
+			{
+				if (tl <= tr) { stack[top++] = l + 1; stack[top++] = l; }
+				else { stack[top++] = l; stack[top++] = l + 1; }
+			}
+			else if (bl) stack[top++] = l;
+			else if (br) stack[top++] = l + 1;
 		}
 	}
 
-	return found;
+	if (ibest == -1) return false;
+
+	rt::Tri& tri = m_mesh->triangle(m_tri[ibest]);
+	double h0 = 1.0 - ubest - vbest, h1 = ubest, h2 = vbest;
+	p.r = o + d * tbest;
+	p.n = tri.n[0] * h0 + tri.n[1] * h1 + tri.n[2] * h2; p.n.normalize();
+	p.t = tri.t[0] * h0 + tri.t[1] * h1 + tri.t[2] * h2;
+	p.c = tri.c[0] * h0 + tri.c[1] * h1 + tri.c[2] * h2; p.c.clamp();
+	p.matid = tri.matid;
+
+	return true;
 }
@@ -29,44 +29,41 @@ SOFTWARE.*/
 
 namespace rt
 {
+	// Bounding volume hierarchy of the mesh triangles. The tree is built with the 
+	// surface area heuristic (SAH) and stored as a flat array of nodes. 
 	class Btree
 	{
 	public:
-		struct Block
+		// A node of the tree. For leaves (count > 0), first is the index of the first 
+		// triangle in the leaf. For internal nodes (count == 0), first is the index of 
+		// the left child. The right child is always stored right after the left child.
+		struct Node
 		{
-			Block() {}
-			~Block() { delete child[0]; delete child[1]; };
-
-			void split(int level);
-
-			void add(rt::Tri* tri, int level);
-
-			size_t size() const;
-
-			gl::Box box;
-			Block* child[2] = { nullptr };
-			std::vector<rt::Tri*> tris;
+			float	bmin[3];
+			int		first;
+			float	bmax[3];
+			int		count;
 		};
 
 		Btree() {}
-		~Btree() { delete root; }
 
-		void clear() {
-			delete root;
-			root = nullptr;
-		}
+		void clear();
 
-		Block* root = nullptr;
-
-		void Build(rt::Mesh& mesh, int levels);
+		// build the tree. maxDepth < 0 will use the default depth.
+		void Build(rt::Mesh& mesh, int maxDepth = -1);
 
 		bool intersect(const gl::Ray& ray, rt::Point& p);
 
-		std::vector<rt::Btree::Block*> leaves();
-
-		size_t blocks() const;
+		// number of nodes in the tree
+		size_t blocks() const { return m_nodes.size(); }
 
 	public:
 		bool output = true;
+
+	private:
+		rt::Mesh*	m_mesh = nullptr;
+		std::vector<Node>		m_nodes;	// tree nodes (root is m_nodes[0])
+		std::vector<int>		m_tri;		// mesh triangle index, in tree order
+		std::vector<gl::Vec3>	m_vert;		// v0, e1, e2 of each triangle, in tree order
 	};
 }
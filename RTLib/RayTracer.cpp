@@ -46,16 +46,8 @@ void rt::meshGeometry::finish()
 	size_t triangles = mesh.triangles();
 	for (size_t i = 0; i < triangles; ++i) mesh.triangle(i).id = (int)i;
 
-	int levels = bhv_levels;
-	if (levels < 0)
-	{
-		levels = (int)log2((double)triangles);
-	}
-	if (levels < 0) levels = 0;
-	if (levels > 20) levels = 20;
-
 	bhv.output = output;
-	bhv.Build(mesh, levels);
+	bhv.Build(mesh, bhv_levels);
 }
 
 bool rt::meshGeometry::intersect(const Ray& ray, rt::Point& q)
@@ -156,7 +148,7 @@ RayTracer::RayTracer()
 	AddColorParam(GLColor::White(), "Background color");
 #ifndef NDEBUG
 	Param* p = AddIntParam(-1, "BHV Levels");
-	p->SetIntRange(-1, 20);
+	p->SetIntRange(-1, 60);
 	p->SetVisible(false);
 #endif
 }
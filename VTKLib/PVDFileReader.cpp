@@ -25,6 +25,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.*/
 #include "PVDFileReader.h"
 #include "PVTUFileReader.h"
+#include "VTUFileReader.h"
 #include <FECore/XMLReader.h>
 using namespace VTK;
 
@@ -123,10 +124,16 @@ bool PVDFileReader::ParseCollection(XMLTag& tag, vtkModel& vtk)
 
 	if (datasets.empty()) return true;
 
-	std::vector<PVTUFileReader*> vtu(datasets.size(), nullptr);
+	// The data sets can be parallel (.pvtu) or serial (.vtu) files
+	std::vector<VTKFileReader*> vtu(datasets.size(), nullptr);
 	for (int i = 0; i < datasets.size(); ++i)
 	{
-		vtu[i] = new PVTUFileReader;
+		const std::string& file = datasets[i].filename;
+		size_t n = file.size();
+		if ((n > 4) && (file.compare(n - 4, 4, ".vtu") == 0))
+			vtu[i] = new VTUFileReader;
+		else
+			vtu[i] = new PVTUFileReader;
 	}
 
 	int numRead = 0;
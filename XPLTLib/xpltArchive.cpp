@@ -33,15 +33,11 @@ SOFTWARE.*/
 #endif
 
 #ifdef WIN32
-typedef __int64 off_type;
-#endif
-
-#ifdef LINUX // same for Linux and Mac OS X
-typedef off_t off_type;
-#endif
-
-#ifdef __APPLE__ // same for Linux and Mac OS X
-typedef off_t off_type;
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 #ifdef WIN32
@@ -67,6 +63,7 @@ class xpltArchive::Imp
 {
 public:
 	FileStream* m_fp;		// the file pointer
+	bool	m_bownfp;		// the file stream was created by the archive
 	bool	m_bswap;		// swap data when reading
 	bool	m_bend;			// chunk end flag
 	int		m_ncompress;	// compression flag
@@ -83,6 +80,15 @@ public:
 	char* m_buf;		// data buffer
 	void* m_pdata;	// data pointer
 	unsigned int	m_bufsize;	// size of data buffer
+	unsigned int	m_nskip;	// bytes of the top-level chunk that were not read
+	bool	m_bownbuf;		// buffer was allocated (otherwise it points into the file mapping)
+
+	// memory-mapped file (read mode only)
+	const char*	m_map;		// start of the mapped file
+	off_type	m_mapsize;	// size of the mapped file
+#ifdef WIN32
+	HANDLE		m_hmap;		// file mapping handle
+#endif
 
 	// write data
 	OBranch* m_pRoot;	// chunk tree root
@@ -91,19 +97,99 @@ public:
 	Imp()
 	{
 		m_fp = 0;
+		m_bownfp = false;
 		m_bend = true;
 		m_bswap = false;
 		m_nversion = 0;
 		m_buf = 0;
 		m_pdata = 0;
 		m_bufsize = 0;
+		m_nskip = 0;
+		m_bownbuf = true;
 		m_ncompress = 0;
 		m_pRoot = 0;
 		m_pChunk = 0;
 		m_bSaving = true;
+		m_map = 0;
+		m_mapsize = 0;
+#ifdef WIN32
+		m_hmap = NULL;
+#endif
+	}
+
+	// free the data buffer of the top-level chunk
+	void FreeBuffer()
+	{
+		if (m_buf && m_bownbuf) delete[] m_buf;
+		m_buf = 0;
+		m_pdata = 0;
+		m_bufsize = 0;
+		m_bownbuf = true;
 	}
+
+	// Map the entire file into memory. This allows uncompressed chunks to be
+	// accessed directly, without copying them to a buffer first.
+	bool MapFile();
+	void UnmapFile();
 };
 
+bool xpltArchive::Imp::MapFile()
+{
+	UnmapFile();
+
+	FILE* fp = m_fp->FilePtr();
+	if (fp == 0) return false;
+
+#ifdef WIN32
+	HANDLE hfile = (HANDLE)_get_osfhandle(_fileno(fp));
+	if (hfile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if ((GetFileSizeEx(hfile, &size) == FALSE) || (size.QuadPart == 0)) return false;
+
+	m_hmap = CreateFileMapping(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_hmap == NULL) return false;
+
+	void* p = MapViewOfFile(m_hmap, FILE_MAP_READ, 0, 0, 0);
+	if (p == NULL)
+	{
+		CloseHandle(m_hmap);
+		m_hmap = NULL;
+		return false;
+	}
+	m_map = (const char*)p;
+	m_mapsize = size.QuadPart;
+#else
+	int fd = fileno(fp);
+	struct stat st;
+	if ((fstat(fd, &st) != 0) || (st.st_size == 0)) return false;
+
+	void* p = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p == MAP_FAILED) return false;
+
+	// we mostly read the file front to back
+	madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	m_map = (const char*)p;
+	m_mapsize = st.st_size;
+#endif
+	return true;
+}
+
+void xpltArchive::Imp::UnmapFile()
+{
+	if (m_map == 0) return;
+#ifdef WIN32
+	UnmapViewOfFile(m_map);
+	CloseHandle(m_hmap);
+	m_hmap = NULL;
+#else
+	munmap((void*)m_map, (size_t)m_mapsize);
+#endif
+	m_map = 0;
+	m_mapsize = 0;
+}
+
 xpltArchive::xpltArchive() : im(*new xpltArchive::Imp)
 {
 }
@@ -141,14 +227,14 @@ void xpltArchive::Close()
 		}
 	}
 
+	// delete the buffer
+	im.FreeBuffer();
+
 	// close the file pointer
+	im.UnmapFile();
+	if (im.m_bownfp) delete im.m_fp;
 	im.m_fp = 0;
-
-	// delete the buffer
-	if (im.m_buf) delete[] im.m_buf;
-	im.m_buf = 0;
-	im.m_pdata = 0;
-	im.m_bufsize = 0;
+	im.m_bownfp = false;
 
 	// reset flags
 	im.m_bend = true;
@@ -170,11 +256,23 @@ void xpltArchive::Flush()
 }
 
 
+void xpltArchive::WriteBuffer(const std::vector<char>& buf)
+{
+	assert(im.m_pRoot == 0);
+	if (im.m_fp && (buf.empty() == false))
+	{
+		im.m_fp->BeginStreaming();
+		im.m_fp->Write(buf.data(), sizeof(char), buf.size());
+		im.m_fp->EndStreaming();
+	}
+}
+
 bool xpltArchive::Create(const char* szfile)
 {
 	// attempt to create the file
 	assert(im.m_fp == 0);
 	im.m_fp = new FileStream();
+	im.m_bownfp = true;
 	if (im.m_fp->Create(szfile) == false) return false;
 
 	// write the master tag 
@@ -246,6 +344,9 @@ bool xpltArchive::Open(FileStream* fp)
 	// set the end flag to false
 	im.m_bend = false;
 
+	// try to map the file into memory (if this fails, we'll just read the file)
+	im.MapFile();
+
 	// initialize decompression stream
 #ifdef HAVE_ZLIB
 	im.strm.zalloc = Z_NULL;
@@ -340,6 +441,7 @@ bool xpltArchive::Append(const char* szfile)
 	// reopen the plot file for appending
 	assert(im.m_fp == 0);
 	im.m_fp = new FileStream();
+	im.m_bownfp = true;
 	if (im.m_fp->Append(szfile) == false) return false;
 	im.m_bSaving = true;
 	return true;
@@ -359,7 +461,16 @@ int xpltArchive::OpenChunk()
 	if (im.m_buf == 0)
 	{
 		unsigned int id, nsize;
-		if (im.m_ncompress == 0)
+		if ((im.m_ncompress == 0) && im.m_map)
+		{
+			if (OpenMappedChunk(id, nsize) == false) return IO_ERROR;
+			if (nsize == 0)
+			{
+				im.m_bend = true;
+				return IO_END;
+			}
+		}
+		else if (im.m_ncompress == 0)
 		{
 			// see if we have reached the end of the file
 			if (feof(im.m_fp->FilePtr()) || ferror(im.m_fp->FilePtr())) return IO_ERROR;
@@ -425,6 +536,116 @@ int xpltArchive::OpenChunk()
 	return IO_OK;
 }
 
+bool xpltArchive::OpenMappedChunk(unsigned int& id, unsigned int& nsize)
+{
+	FILE* fp = im.m_fp->FilePtr();
+	off_type pos = ftell64(fp);
+	if ((pos < 0) || (pos + 2*sizeof(unsigned int) > im.m_mapsize)) return false;
+
+	// get the master chunk id and size
+	const char* pc = im.m_map + pos;
+	memcpy(&id, pc, sizeof(unsigned int)); if (im.m_bswap) bswap(id);
+	memcpy(&nsize, pc + sizeof(unsigned int), sizeof(unsigned int)); if (im.m_bswap) bswap(nsize);
+	pos += 2*sizeof(unsigned int);
+	if (pos + nsize > im.m_mapsize) return false;
+
+	// the buffer points directly into the mapped file
+	if (nsize > 0)
+	{
+		im.m_buf = (char*)(im.m_map + pos);
+		im.m_bownbuf = false;
+		im.m_bufsize = nsize;
+		im.m_pdata = im.m_buf;
+	}
+
+	// keep the file pointer in sync, since compressed chunks are read from the file
+	return (fseek64(fp, pos + nsize, SEEK_SET) == 0);
+}
+
+int xpltArchive::OpenChunkHead(unsigned int nmax)
+{
+	assert(im.m_ncompress == 0);
+	assert(im.m_buf == 0);
+
+	// when the file is mapped, there is no point in reading only part of the chunk
+	if (im.m_map) return OpenChunk();
+
+	// see if the end flag was set
+	if (im.m_bend)
+	{
+		im.m_bend = false;
+		return IO_END;
+	}
+
+	// see if we have reached the end of the file
+	if (feof(im.m_fp->FilePtr()) || ferror(im.m_fp->FilePtr())) return IO_ERROR;
+
+	// get the master chunk id and size
+	unsigned int id, nsize;
+	size_t nret = im.m_fp->read(&id, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
+	if (im.m_bswap) bswap(id);
+	nret = im.m_fp->read(&nsize, sizeof(unsigned int), 1); if (nret != 1) return IO_ERROR;
+	if (im.m_bswap) bswap(nsize);
+
+	if (nsize == 0)
+	{
+		im.m_bend = true;
+		return IO_END;
+	}
+
+	// only read the head of the chunk
+	unsigned int nread = (nsize < nmax ? nsize : nmax);
+	im.m_bufsize = nread;
+	im.m_buf = new char[im.m_bufsize];
+	if (im.m_fp->read(im.m_buf, sizeof(char), nread) != nread) return IO_ERROR;
+	im.m_pdata = im.m_buf;
+	im.m_nskip = nsize - nread;
+
+	// create a new chunk
+	CHUNK* pc = new CHUNK;
+	pc->id = id;
+	pc->nsize = nsize;
+	pc->pdata = im.m_pdata;
+	im.m_Chunk.push(pc);
+
+	return IO_OK;
+}
+
+off_type xpltArchive::Tell()
+{
+	off_type pos = ftell64(im.m_fp->FilePtr());
+
+	// the decompression stream may have read ahead
+#ifdef HAVE_ZLIB
+	if (im.m_ncompress) pos -= im.strm.avail_in;
+#endif
+
+	return pos;
+}
+
+bool xpltArchive::Seek(off_type pos)
+{
+	// clear the stack
+	while (im.m_Chunk.empty() == false)
+	{
+		CHUNK* pc = im.m_Chunk.top(); im.m_Chunk.pop();
+		delete pc;
+	}
+
+	// delete the buffer
+	im.FreeBuffer();
+	im.m_nskip = 0;
+	im.m_bend = false;
+
+	// discard any data that was read ahead by the decompression stream
+#ifdef HAVE_ZLIB
+	im.strm.avail_in = 0;
+	im.strm.next_in = Z_NULL;
+#endif
+
+	return (fseek64(im.m_fp->FilePtr(), pos, SEEK_SET) == 0);
+}
+
 void xpltArchive::CloseChunk()
 {
 	// pop the last chunk
@@ -447,10 +668,14 @@ void xpltArchive::CloseChunk()
 		im.m_bend = true;
 
 		// delete the buffer
-		delete[] im.m_buf;
-		im.m_buf = 0;
-		im.m_pdata = 0;
-		im.m_bufsize = 0;
+		im.FreeBuffer();
+
+		// skip the part of the chunk that was not read
+		if (im.m_nskip)
+		{
+			fseek64(im.m_fp->FilePtr(), im.m_nskip, SEEK_CUR);
+			im.m_nskip = 0;
+		}
 	}
 	else
 	{
@@ -460,6 +685,54 @@ void xpltArchive::CloseChunk()
 	}
 }
 
+bool xpltArchive::ReleaseChunk(ChunkBuffer& cb)
+{
+	// this only works for a complete top-level chunk
+	if ((im.m_Chunk.size() != 1) || (im.m_nskip != 0)) return false;
+
+	CHUNK* pc = im.m_Chunk.top(); im.m_Chunk.pop();
+	cb.id = pc->id;
+	cb.nsize = im.m_bufsize;
+	cb.pdata = im.m_buf;
+	cb.owner = im.m_bownbuf;
+	cb.bswap = im.m_bswap;
+	delete pc;
+
+	// the buffer now belongs to the caller
+	im.m_buf = 0;
+	im.m_pdata = 0;
+	im.m_bufsize = 0;
+	im.m_bownbuf = true;
+
+	// same as closing the chunk
+	im.m_bend = true;
+
+	return true;
+}
+
+void xpltArchive::Attach(ChunkBuffer& cb)
+{
+	im.FreeBuffer();
+	im.m_bswap = cb.bswap;
+	im.m_ncompress = 0;
+	im.m_bSaving = false;
+	im.m_bend = false;
+
+	im.m_buf = cb.pdata;
+	im.m_bownbuf = cb.owner;
+	im.m_bufsize = cb.nsize;
+	im.m_pdata = im.m_buf;
+
+	CHUNK* pc = new CHUNK;
+	pc->id = cb.id;
+	pc->nsize = cb.nsize;
+	pc->pdata = im.m_pdata;
+	im.m_Chunk.push(pc);
+
+	cb.pdata = 0;
+	cb.owner = false;
+}
+
 unsigned int xpltArchive::GetChunkID()
 {
 	CHUNK* pc = im.m_Chunk.top();
@@ -467,6 +740,16 @@ unsigned int xpltArchive::GetChunkID()
 	return pc->id;
 }
 
+const void* xpltArchive::next_block(size_t nbytes, size_t align)
+{
+	if (im.m_bswap || (im.m_pdata == 0)) return nullptr;
+	if (((size_t)im.m_pdata % align) != 0) return nullptr;
+
+	const void* p = im.m_pdata;
+	im.m_pdata = (char*)im.m_pdata + nbytes;
+	return p;
+}
+
 unsigned int xpltArchive::GetChunkSize()
 {
 	CHUNK* pc = im.m_Chunk.top();
@@ -520,4 +803,52 @@ xpltArchive::IOResult xpltArchive::sread(char* sz, int max_len)
 	}
 
 	return IO_OK;
-}
\ No newline at end of file
+}
+
+//=============================================================================
+// xpltOutputBuffer
+//=============================================================================
+
+void xpltOutputBuffer::BeginChunk(unsigned int id)
+{
+	// the size is filled in when the chunk is closed
+	unsigned int hdr[2] = { id, 0 };
+	m_open.push_back(m_buf.size());
+	m_buf.insert(m_buf.end(), (char*)hdr, (char*)hdr + sizeof(hdr));
+}
+
+void xpltOutputBuffer::EndChunk()
+{
+	assert(m_open.empty() == false);
+	size_t off = m_open.back(); m_open.pop_back();
+	unsigned int nsize = (unsigned int)(m_buf.size() - off - 2 * sizeof(unsigned int));
+	memcpy(&m_buf[off + sizeof(unsigned int)], &nsize, sizeof(unsigned int));
+}
+
+void xpltOutputBuffer::AddLeaf(unsigned int nid, const void* pd, size_t nsize)
+{
+	unsigned int hdr[2] = { nid, (unsigned int)nsize };
+	m_buf.insert(m_buf.end(), (char*)hdr, (char*)hdr + sizeof(hdr));
+	if (nsize > 0) m_buf.insert(m_buf.end(), (const char*)pd, (const char*)pd + nsize);
+}
+
+bool xpltOutputBuffer::Compress()
+{
+	assert(m_open.empty());
+#ifdef HAVE_ZLIB
+	uLongf nsize = compressBound((uLong)m_buf.size());
+	std::vector<char> out(nsize);
+	if (compress2((Bytef*)out.data(), &nsize, (const Bytef*)m_buf.data(), (uLong)m_buf.size(), Z_DEFAULT_COMPRESSION) != Z_OK) return false;
+	out.resize(nsize);
+	m_buf.swap(out);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void xpltOutputBuffer::Clear()
+{
+	m_buf.clear();
+	m_open.clear();
+}
@@ -31,6 +31,18 @@ SOFTWARE.*/
 #include <FSCore/math3d.h>
 #include <FSCore/Archive.h>
 
+#ifdef WIN32
+typedef __int64 off_type;
+#endif
+
+#ifdef LINUX // same for Linux and Mac OS X
+typedef off_t off_type;
+#endif
+
+#ifdef __APPLE__ // same for Linux and Mac OS X
+typedef off_t off_type;
+#endif
+
 //-----------------------------------------------------------------------------
 // Input archive
 class xpltArchive  
@@ -47,6 +59,16 @@ class xpltArchive
 public:
 	enum IOResult { IO_ERROR, IO_OK, IO_END };
 
+	// The data of a top-level chunk, which can be handed over to another archive.
+	struct ChunkBuffer
+	{
+		unsigned int	id;		// chunk ID
+		unsigned int	nsize;	// size of data
+		char*			pdata;	// chunk data
+		bool			owner;	// the buffer was allocated (otherwise it points into the mapped file)
+		bool			bswap;	// data needs to be byte-swapped
+	};
+
 public:
 	//! class constructor
 	xpltArchive();
@@ -92,6 +114,9 @@ public:
 		WriteChunk(nid, data);
 	}
 
+	// Write a top-level chunk that was assembled in memory (see xpltOutputBuffer)
+	void WriteBuffer(const std::vector<char>& buf);
+
 protected:
 	void AddChild(OChunk* c);
 
@@ -111,6 +136,17 @@ public: // reading
 	// Open a chunk
 	int OpenChunk();
 
+	// Open a top-level chunk, but only read the first nmax bytes of its data.
+	// The rest of the chunk is skipped when the chunk is closed.
+	// (Only works for uncompressed chunks)
+	int OpenChunkHead(unsigned int nmax);
+
+	// Get the file position of the next top-level chunk
+	off_type Tell();
+
+	// Move to a top-level chunk at the position returned by Tell
+	bool Seek(off_type pos);
+
 	// Get the current chunk ID
 	unsigned int GetChunkID();
 
@@ -120,6 +156,14 @@ public: // reading
 	// Close a chunk
 	void CloseChunk();
 
+	// Close the top-level chunk that was just opened and hand its data over to the caller.
+	// The data can then be read with another archive (see Attach).
+	bool ReleaseChunk(ChunkBuffer& cb);
+
+	// Read from a chunk buffer that was released by another archive. The top-level chunk
+	// is opened and the archive takes ownership of the buffer.
+	void Attach(ChunkBuffer& cb);
+
 	// input functions
 	IOResult read(char&   c);
 	IOResult read(int&    n);
@@ -155,6 +199,19 @@ public: // reading
 	IOResult read(std::vector<mat3f  >& a) { return read(&(a[0].d[0][0]), 9*(int) a.size()); }
 	IOResult read(std::vector<unsigned int>& a) { return read((int*)&a[0], (int)a.size()); }
 
+	// Get a pointer to the next n values of the current chunk. When possible, this points
+	// directly into the chunk buffer (or the mapped file) so that no copy is made. If the data
+	// needs to be byte-swapped (or is not aligned), it is read into tmp instead.
+	// The pointer is valid until the top-level chunk is closed.
+	template <typename T> const T* read_span(std::vector<T>& tmp, int n)
+	{
+		const T* p = (const T*)next_block(n * sizeof(T), alignof(T));
+		if (p) return p;
+		tmp.resize(n);
+		if (n > 0) read(tmp);
+		return tmp.data();
+	}
+
 	void SetVersion(unsigned int n);
 	unsigned int Version();
 
@@ -164,6 +221,60 @@ public: // reading
 
 	bool DecompressChunk(unsigned int& nid, unsigned int& nsize);
 
+protected:
+	// open a top-level chunk in the mapped file
+	bool OpenMappedChunk(unsigned int& nid, unsigned int& nsize);
+
+	// returns a pointer to the next nbytes of the current chunk and skips them,
+	// or null if the data cannot be used in-place.
+	const void* next_block(size_t nbytes, size_t align);
+
 protected:
 	Imp& im;
 };
+
+//-----------------------------------------------------------------------------
+// Assembles a top-level chunk in memory, using the same layout as xpltArchive.
+// Chunks can be assembled (and compressed) on separate threads this way and then 
+// written to the archive in order with xpltArchive::WriteBuffer.
+class xpltOutputBuffer
+{
+public:
+	xpltOutputBuffer() {}
+
+	// begin a chunk
+	void BeginChunk(unsigned int id);
+
+	// end a chunk
+	void EndChunk();
+
+	template <typename T> void WriteChunk(unsigned int nid, const T& o)
+	{
+		AddLeaf(nid, &o, sizeof(T));
+	}
+
+	template <typename T> void WriteChunk(unsigned int nid, const std::vector<T>& a)
+	{
+		AddLeaf(nid, a.data(), a.size() * sizeof(T));
+	}
+
+	void WriteData(int nid, std::vector<float>& data)
+	{
+		WriteChunk(nid, data);
+	}
+
+	// Compress the buffer into a single zlib stream (as expected by xpltArchive::DecompressChunk)
+	bool Compress();
+
+	// clear the buffer
+	void Clear();
+
+	const std::vector<char>& GetBuffer() const { return m_buf; }
+
+private:
+	void AddLeaf(unsigned int nid, const void* pd, size_t nsize);
+
+private:
+	std::vector<char>	m_buf;		// chunk data
+	std::vector<size_t>	m_open;		// offsets of the open chunks
+};
@@ -29,6 +29,7 @@ SOFTWARE.*/
 #include <PostLib/FEPostModel.h>
 #include <PostLib/FEMeshData_T.h>
 #include <memory>
+#include <omp.h>
 using namespace Post;
 using namespace std;
 
@@ -73,6 +74,11 @@ bool xpltFileExport::Save(FEPostModel& fem, const char* szfile)
 {
 	m_szerr[0] = 0;
 
+#ifndef HAVE_ZLIB
+	// we can't compress without zlib
+	m_ncompress = 0;
+#endif
+
 	if (m_ar.Create(szfile) == false) return error("Failed creating archive");
 
 	// write the root section (don't compress root)
@@ -86,14 +92,33 @@ bool xpltFileExport::Save(FEPostModel& fem, const char* szfile)
 	// set compression option
 	m_ar.SetCompression(m_ncompress);
 
-	// write the state data
+	// Write the state data. The states are assembled and compressed in parallel, 
+	// a batch at a time, and then written in order. (States that are paged in 
+	// from disk are processed one at a time.)
 	int NS = fem.GetStates();
-	for (int i=0; i<NS; ++i)
+	bool bparallel = (fem.GetStateLoader() == nullptr);
+	int nbatch = (bparallel ? 2 * omp_get_max_threads() : 1);
+	vector<xpltOutputBuffer> buf(nbatch);
+	vector<int> ok(nbatch, 0);
+	for (int n0 = 0; n0 < NS; n0 += nbatch)
 	{
-		if (WriteState(fem, *fem.GetState(i)) == false)
+		int nb = min(nbatch, NS - n0);
+#pragma omp parallel for schedule(dynamic, 1) if (bparallel)
+		for (int i = 0; i < nb; ++i)
 		{
-			m_ar.Close();
-			return false;
+			buf[i].Clear();
+			ok[i] = (WriteState(buf[i], fem, *fem.GetState(n0 + i)) ? 1 : 0);
+			if (ok[i] && m_ncompress) ok[i] = (buf[i].Compress() ? 1 : 0);
+		}
+
+		for (int i = 0; i < nb; ++i)
+		{
+			if (ok[i] == 0)
+			{
+				m_ar.Close();
+				return false;
+			}
+			m_ar.WriteBuffer(buf[i].GetBuffer());
 		}
 	}
 
@@ -506,59 +531,59 @@ bool xpltFileExport::WriteSurfaceSection(FSMesh& mesh)
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteState(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteState(xpltOutputBuffer& ar, FEPostModel& fem, FEState& state)
 {
-	m_ar.BeginChunk(PLT_STATE);
+	ar.BeginChunk(PLT_STATE);
 	{
 		// state header
-		m_ar.BeginChunk(PLT_STATE_HEADER);
+		ar.BeginChunk(PLT_STATE_HEADER);
 		{
 			float f = (float) state.m_time;
-			m_ar.WriteChunk(PLT_STATE_HDR_TIME, f);
+			ar.WriteChunk(PLT_STATE_HDR_TIME, f);
 		}
-		m_ar.EndChunk();
+		ar.EndChunk();
 
-		m_ar.BeginChunk(PLT_STATE_DATA);
+		ar.BeginChunk(PLT_STATE_DATA);
 		{
 			// Node Data
 			if (m_nodeData)
 			{
-				m_ar.BeginChunk(PLT_NODE_DATA);
+				ar.BeginChunk(PLT_NODE_DATA);
 				{
-					if (WriteNodeData(fem, state) == false) return false;
+					if (WriteNodeData(ar, fem, state) == false) return false;
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
 
 			// Element Data
 			if (m_elemData)
 			{
-				m_ar.BeginChunk(PLT_ELEMENT_DATA);
+				ar.BeginChunk(PLT_ELEMENT_DATA);
 				{
-					if (WriteElemData(fem, state) == false) return false;
+					if (WriteElemData(ar, fem, state) == false) return false;
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
 
 			// surface data
 			if (m_faceData)
 			{
-				m_ar.BeginChunk(PLT_FACE_DATA);
+				ar.BeginChunk(PLT_FACE_DATA);
 				{
-					if (WriteFaceData(fem, state) == false) return false;
+					if (WriteFaceData(ar, fem, state) == false) return false;
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
 		}
-		m_ar.EndChunk();
+		ar.EndChunk();
 	}
-	m_ar.EndChunk();
+	ar.EndChunk();
 
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteNodeData(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteNodeData(xpltOutputBuffer& ar, FEPostModel& fem, FEState& state)
 {
 	FEDataManager& DM = *fem.GetDataManager();
 	FEDataFieldPtr pd = DM.FirstDataField();
@@ -573,22 +598,22 @@ bool xpltFileExport::WriteNodeData(FEPostModel& fem, FEState& state)
 		if ((data.DataClass() == NODE_DATA) && (data.Flags() != IMPLICIT_DATA))
 		{
 			FEMeshData& meshData = state.m_Data[n];
-			m_ar.BeginChunk(PLT_STATE_VARIABLE);
+			ar.BeginChunk(PLT_STATE_VARIABLE);
 			{
-				m_ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
+				ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
 
-				m_ar.BeginChunk(PLT_STATE_VAR_DATA);
+				ar.BeginChunk(PLT_STATE_VAR_DATA);
 				{
 					// value array
 					vector<float> val;
 					if (FillNodeDataArray(val, meshData) == false) return false;
 
 					// write the value array
-					if (val.empty() == false) m_ar.WriteChunk(0, val);
+					if (val.empty() == false) ar.WriteChunk(0, val);
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
-			m_ar.EndChunk();
+			ar.EndChunk();
 		}
 	}
 
@@ -596,7 +621,7 @@ bool xpltFileExport::WriteNodeData(FEPostModel& fem, FEState& state)
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteElemData(xpltOutputBuffer& ar, FEPostModel& fem, FEState& state)
 {
 	FEDataManager& DM = *fem.GetDataManager();
 	FEDataFieldPtr pd = DM.FirstDataField();
@@ -610,12 +635,12 @@ bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
 		if ((data.DataClass() == ELEM_DATA) && (data.Flags() != IMPLICIT_DATA))
 		{
 			FEMeshData& data = state.m_Data[n];
-			m_ar.BeginChunk(PLT_STATE_VARIABLE);
+			ar.BeginChunk(PLT_STATE_VARIABLE);
 			{
-				m_ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
+				ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
 
 				vector<float> val;
-				m_ar.BeginChunk(PLT_STATE_VAR_DATA);
+				ar.BeginChunk(PLT_STATE_VAR_DATA);
 				{
 					int ND = mesh.MeshPartitions();
 					for (int i=0; i<ND; ++i)
@@ -624,12 +649,12 @@ bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
 
 						if (FillElemDataArray(val, data, part) == false) return false;
 
-						if (val.empty() == false) m_ar.WriteData(i+1, val);
+						if (val.empty() == false) ar.WriteData(i+1, val);
 					}
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
-			m_ar.EndChunk();
+			ar.EndChunk();
 		}
 	}
 
@@ -637,7 +662,7 @@ bool xpltFileExport::WriteElemData(FEPostModel& fem, FEState& state)
 }
 
 //-----------------------------------------------------------------------------
-bool xpltFileExport::WriteFaceData(FEPostModel& fem, FEState& state)
+bool xpltFileExport::WriteFaceData(xpltOutputBuffer& ar, FEPostModel& fem, FEState& state)
 {
 	FEDataManager& DM = *fem.GetDataManager();
 	FEDataFieldPtr pd = DM.FirstDataField();
@@ -651,12 +676,12 @@ bool xpltFileExport::WriteFaceData(FEPostModel& fem, FEState& state)
 		if ((data.DataClass() == FACE_DATA) && (data.Flags() != IMPLICIT_DATA))
 		{
 			FEMeshData& data = state.m_Data[n];
-			m_ar.BeginChunk(PLT_STATE_VARIABLE);
+			ar.BeginChunk(PLT_STATE_VARIABLE);
 			{
-				m_ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
+				ar.WriteChunk(PLT_STATE_VAR_ID, nid); nid++;
 
 				vector<float> val;
-				m_ar.BeginChunk(PLT_STATE_VAR_DATA);
+				ar.BeginChunk(PLT_STATE_VAR_DATA);
 				{
 					int NS = mesh.FESurfaces();
 					for (int i=0; i<NS; ++i)
@@ -665,12 +690,12 @@ bool xpltFileExport::WriteFaceData(FEPostModel& fem, FEState& state)
 
 						if (FillFaceDataArray(val, data, surf) == false) return false;
 
-						if (val.empty() == false) m_ar.WriteData(i+1, val);
+						if (val.empty() == false) ar.WriteData(i+1, val);
 					}
 				}
-				m_ar.EndChunk();
+				ar.EndChunk();
 			}
-			m_ar.EndChunk();
+			ar.EndChunk();
 		}
 	}
 
@@ -171,10 +171,10 @@ protected:
 
 	bool WritePart(FSMesh& m, FSMeshPartition& part);
 
-	bool WriteState(FEPostModel& fem, FEState& state);
-	bool WriteNodeData(FEPostModel& fem, FEState& state);
-	bool WriteElemData(FEPostModel& fem, FEState& state);
-	bool WriteFaceData(FEPostModel& fem, FEState& state);
+	bool WriteState   (xpltOutputBuffer& ar, FEPostModel& fem, FEState& state);
+	bool WriteNodeData(xpltOutputBuffer& ar, FEPostModel& fem, FEState& state);
+	bool WriteElemData(xpltOutputBuffer& ar, FEPostModel& fem, FEState& state);
+	bool WriteFaceData(xpltOutputBuffer& ar, FEPostModel& fem, FEState& state);
 
 	bool FillNodeDataArray(std::vector<float>& val, FEMeshData& data);
 	bool FillElemDataArray(std::vector<float>& val, FEMeshData& data, FSMeshPartition& part);
@@ -35,13 +35,21 @@ xpltParser::xpltParser(xpltFileReader* xplt) : m_xplt(xplt), m_ar(xplt->GetArchi
 {
 }
 
+xpltParser::xpltParser(xpltFileReader* xplt, xpltArchive& ar) : m_xplt(xplt), m_ar(ar)
+{
+}
+
 xpltParser::~xpltParser()
 {
 }
 
 bool xpltParser::errf(const char* szerr)
 {
-	return m_xplt->errf(szerr);
+	// states may be decoded in parallel
+	bool bret = false;
+	#pragma omp critical (xplt_errf)
+	bret = m_xplt->errf(szerr);
+	return bret;
 }
 
 void xpltParser::addWarning(int n)
@@ -59,21 +67,48 @@ int xpltParser::FileVersion() const
 xpltFileReader::xpltFileReader(Post::FEPostModel* fem) : FEFileReader(fem)
 {
 	m_xplt = 0;
+	m_fs = nullptr;
+	m_bpager = false;
 	m_read_state_flag = XPLT_READ_ALL_STATES;
 }
 
 xpltFileReader::~xpltFileReader()
 {
+	if (m_xplt) { delete m_xplt; m_xplt = 0; }
+	if (m_fs)
+	{
+		m_ar.Close();
+		Close();
+		delete m_fs;
+		m_fs = nullptr;
+	}
 }
 
 bool xpltFileReader::Load(const char* szfile)
 {
+	// When states are read on demand, the file needs to stay open after loading.
+	// We hand this off to a separate reader that will be owned by the model.
+	if ((m_read_state_flag == XPLT_READ_STATES_ON_DEMAND) && (m_bpager == false))
+	{
+		xpltFileReader* pager = new xpltFileReader(m_fem);
+		pager->m_bpager = true;
+		pager->SetReadStateFlag(XPLT_READ_STATES_ON_DEMAND);
+		bool bret = pager->Load(szfile);
+		if (pager->Errors() > 0) error(pager->GetErrorString());
+		m_hdr = pager->GetHeader();
+
+		// if the model did not take ownership of the pager, we can delete it
+		if (m_fem->GetStateLoader() != pager) delete pager;
+		return bret;
+	}
+
 	// open the file
 	if (Open(szfile, "rb") == false) return errf("Failed opening file.");
 
 	// attach the file to the archive
-	FileStream fs(m_fp, false);
-	if (m_ar.Open(&fs) == false) return errf("This is not a valid XPLT file.");
+	if (m_fs) delete m_fs;
+	m_fs = new FileStream(m_fp, false);
+	if (m_ar.Open(m_fs) == false) return errf("This is not a valid XPLT file.");
 
 	// open the root chunk (no compression for this sectio)
 	m_ar.SetCompression(0);
@@ -109,12 +144,29 @@ bool xpltFileReader::Load(const char* szfile)
 		return errf("This plot file requires a newer version of FEBio Studio.");
 	}
 
+	// only the newer parser supports reading states on demand
+	if ((m_read_state_flag == XPLT_READ_STATES_ON_DEMAND) && (dynamic_cast<XpltReader3*>(m_xplt) == nullptr))
+	{
+		m_read_state_flag = XPLT_READ_ALL_STATES;
+	}
+
 	// load the rest of the file
 	bool bret = m_xplt->Load(*m_fem);
 
-	// clean up
-	m_ar.Close();
-	Close();
+	// when reading states on demand, we keep the file open and let the model
+	// call us when it needs the state data.
+	if (bret && (m_read_state_flag == XPLT_READ_STATES_ON_DEMAND))
+	{
+		m_fem->SetStateLoader(this);
+	}
+	else
+	{
+		// clean up
+		m_ar.Close();
+		Close();
+		delete m_fs;
+		m_fs = nullptr;
+	}
 
 	if (m_xplt->warnings() > 0)
 	{
@@ -135,6 +187,13 @@ bool xpltFileReader::Load(const char* szfile)
 }
 
 
+//-----------------------------------------------------------------------------
+bool xpltFileReader::LoadState(Post::FEState* ps)
+{
+	if ((m_xplt == nullptr) || (m_fs == nullptr)) return false;
+	return m_xplt->LoadState(*m_fem, ps);
+}
+
 //-----------------------------------------------------------------------------
 bool xpltFileReader::ReadHeader()
 {
@@ -26,6 +26,7 @@ SOFTWARE.*/
 
 #pragma once
 #include "PostLib/FEFileReader.h"
+#include <PostLib/FEPostModel.h>
 #include "xpltArchive.h"
 
 enum XPLT_READ_STATE_FLAG { 
@@ -33,7 +34,8 @@ enum XPLT_READ_STATE_FLAG {
 	XPLT_READ_ALL_CONVERGED_STATES, 
 	XPLT_READ_LAST_STATE_ONLY, 
 	XPLT_READ_STATES_FROM_LIST,
-	XPLT_READ_FIRST_AND_LAST 
+	XPLT_READ_FIRST_AND_LAST,
+	XPLT_READ_STATES_ON_DEMAND		// only index the states and load them when needed (version 3.x only)
 };
 
 enum XPLT_READ_WARNING {
@@ -49,10 +51,14 @@ class xpltParser
 {
 public:
 	xpltParser(xpltFileReader* xplt);
+	xpltParser(xpltFileReader* xplt, xpltArchive& ar);
 	virtual ~xpltParser();
 
 	virtual bool Load(Post::FEPostModel& fem) = 0;
 
+	// load a state that was indexed when the file was loaded with XPLT_READ_STATES_ON_DEMAND
+	virtual bool LoadState(Post::FEPostModel& fem, Post::FEState* ps) { return false; }
+
 	bool errf(const char* sz);
 
 	void addWarning(int n);
@@ -67,7 +73,7 @@ protected:
 	std::vector<int>	m_wrng;	// warning list
 };
 
-class xpltFileReader : public Post::FEFileReader
+class xpltFileReader : public Post::FEFileReader, public Post::FEStateLoader
 {
 protected:
 	// file tags
@@ -105,6 +111,9 @@ public:
 	using FEFileReader::Load;
 	bool Load(const char* szfile) override;
 
+	// load the data of a state (when states are read on demand)
+	bool LoadState(Post::FEState* ps) override;
+
 	void SetReadStateFlag(int n) { m_read_state_flag = n; }
 	void SetReadStatesList(const std::vector<int>& l) { m_state_list = l; }
 
@@ -124,7 +133,9 @@ protected:
 private:
 	xpltParser*		m_xplt;
 	xpltArchive		m_ar;
+	FileStream*		m_fs;
 	HEADER			m_hdr;
+	bool			m_bpager;	//!< this reader is owned by the model and loads states on demand
 
 	// Options
 	int			m_read_state_flag;	//!< flag setting option for reading states
@@ -1225,12 +1225,11 @@ bool XpltReader::ReadStateSection(FEPostModel& fem)
 		float h[FSElement::MAX_NODES] = {0.f};
 		for (int i=0; i<NE; ++i)
 		{
-			ELEMDATA& d = ps->m_ELEM[i];
 			if (df.active(i))
 			{
 				df.eval(i, h);
 				int n = mesh.ElementRef(i).Nodes();
-				for (int j=0; j<n; ++j) d.m_h[j] = h[j];
+				ps->m_ELEM.SetShellThickness(i, h, n);
 			}
 		}
 	}
@@ -1244,9 +1244,9 @@ bool XpltReader2::ReadStateSection(FEPostModel& fem)
 					for (int i = 0; i < NE; ++i)
 					{
 						if (flags[i] == 1)
-							ps->m_ELEM[i].m_state = StatusFlags::VISIBLE;
+							ps->m_ELEM.m_state[i] = StatusFlags::VISIBLE;
 						else
-							ps->m_ELEM[i].m_state = 0;
+							ps->m_ELEM.m_state[i] = 0;
 					}
 				}
 				m_ar.CloseChunk();
@@ -1267,12 +1267,11 @@ bool XpltReader2::ReadStateSection(FEPostModel& fem)
 		float h[FSElement::MAX_NODES] = {0.f};
 		for (int i=0; i<NE; ++i)
 		{
-			ELEMDATA& d = ps->m_ELEM[i];
 			if (df.active(i))
 			{
 				df.eval(i, h);
 				int n = mesh.ElementRef(i).Nodes();
-				for (int j=0; j<n; ++j) d.m_h[j] = h[j];
+				ps->m_ELEM.SetShellThickness(i, h, n);
 			}
 		}
 	}
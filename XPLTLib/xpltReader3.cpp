@@ -32,6 +32,8 @@ SOFTWARE.*/
 #include <PostLib/FEState.h>
 #include <PostLib/FEPostModel.h>
 #include <MeshLib/FSMesh.h>
+#include <algorithm>
+#include <omp.h>
 
 using namespace Post;
 using namespace std;
@@ -151,6 +153,29 @@ XpltReader3::XpltReader3(xpltFileReader* xplt) : xpltParser(xplt)
 {
 	m_pstate = 0;
 	m_mesh = 0;
+	m_nxmesh = -1;
+	m_parent = nullptr;
+}
+
+XpltReader3::XpltReader3(XpltReader3& parent, xpltArchive& ar) : xpltParser(parent.m_xplt, ar)
+{
+	m_dic = parent.m_dic;
+	m_bHasDispl = parent.m_bHasDispl;
+	m_bHasStress = parent.m_bHasStress;
+	m_bHasNodalStress = parent.m_bHasNodalStress;
+	m_bHasShellThickness = parent.m_bHasShellThickness;
+	m_bHasFluidPressure = parent.m_bHasFluidPressure;
+	m_bHasElasticity = parent.m_bHasElasticity;
+	m_ngvsize = parent.m_ngvsize;
+	m_nnvsize = parent.m_nnvsize;
+	m_n3dsize = parent.m_n3dsize;
+	m_n2dsize = parent.m_n2dsize;
+	m_n1dsize = parent.m_n1dsize;
+	m_nel = parent.m_nel;
+	m_pstate = 0;
+	m_mesh = parent.m_mesh;
+	m_nxmesh = -1;
+	m_parent = &parent;
 }
 
 XpltReader3::~XpltReader3()
@@ -170,6 +195,9 @@ void XpltReader3::Clear()
 	m_bHasElasticity = false;
 	m_nel = 0;
 	m_pstate = 0;
+	m_index.clear();
+	m_xmeshList.clear();
+	m_nxmesh = -1;
 }
 
 //-----------------------------------------------------------------------------
@@ -208,6 +236,22 @@ bool XpltReader3::Load(FEPostModel& fem)
 	const xpltFileReader::HEADER& hdr = m_xplt->GetHeader();
 	m_ar.SetCompression(hdr.ncompression);
 	int read_state_flag = m_xplt->GetReadStateFlag();
+
+	// When reading states on demand, we only build an index of the states here.
+	// Note that we don't clear the dictionary and mesh since we need it to read the states later.
+	if (read_state_flag == XPLT_READ_STATES_ON_DEMAND) return IndexStates(fem);
+
+	// decode the states in parallel when most states need to be read
+	if ((omp_get_max_threads() > 1) &&
+		((read_state_flag == XPLT_READ_ALL_STATES) ||
+		 (read_state_flag == XPLT_READ_ALL_CONVERGED_STATES) ||
+		 (read_state_flag == XPLT_READ_STATES_FROM_LIST)))
+	{
+		bool bret = ReadStatesParallel(fem);
+		Clear();
+		return bret;
+	}
+
 	int nstate = 0;
 	try{
 		while (true)
@@ -284,6 +328,267 @@ bool XpltReader3::Load(FEPostModel& fem)
 	return true;
 }
 
+//-----------------------------------------------------------------------------
+// Reads the state sections in batches. The calling thread reads (and decompresses) a batch
+// of state sections, which are then decoded in parallel. The states are added to the model
+// in the order in which they appear in the file. (Only OpenMP 2.0 constructs are used here,
+// since that is all that MSVC supports.)
+bool XpltReader3::ReadStatesParallel(FEPostModel& fem)
+{
+	int read_state_flag = m_xplt->GetReadStateFlag();
+	vector<int> state_list = m_xplt->GetReadStates();
+
+	// a state section that is being decoded
+	struct STATE_CHUNK
+	{
+		xpltArchive::ChunkBuffer	data;
+		FSMesh*			mesh;
+		FEState*		state;
+		bool			bdata;	// was the section read?
+		bool			bok;
+		vector<int>		warnings;
+	};
+
+	// limit the number of state sections that are kept in memory
+	const int maxPending = 2 * omp_get_max_threads();
+	vector<STATE_CHUNK> pending(maxPending);
+	int npending = 0;
+
+	// decode a state section
+	// (this runs in a parallel region, so no exception may escape)
+	auto decode = [&](STATE_CHUNK& sc) {
+		if (sc.bdata == false) return;
+		try {
+			xpltArchive ar;
+			ar.Attach(sc.data);
+
+			XpltReader3 reader(*this, ar);
+			reader.m_mesh = sc.mesh;
+			sc.state = new FEState(0.f, &fem, sc.mesh);
+			sc.bok = reader.ReadStateData(fem, sc.state);
+			sc.warnings = reader.m_wrng;
+		}
+		catch (...)
+		{
+			sc.bok = false;
+		}
+	};
+
+	// decode the pending states and add them to the model (in order)
+	bool bret = true;
+	auto flush = [&]() {
+		if (npending == 0) return;
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int i = 0; i < npending; ++i) decode(pending[i]);
+
+		for (int i = 0; i < npending; ++i)
+		{
+			STATE_CHUNK& sc = pending[i];
+			for (int w : sc.warnings) addWarning(w);
+
+			if (sc.bok && bret)
+			{
+				if ((read_state_flag == XPLT_READ_ALL_CONVERGED_STATES) && (sc.state->m_status != 0))
+					delete sc.state;
+				else
+					fem.AddState(sc.state);
+			}
+			else
+			{
+				// we stop at the first state that could not be read
+				delete sc.state;
+				bret = false;
+			}
+			sc.state = nullptr;
+		}
+		npending = 0;
+	};
+
+	bool berr = false;
+	bool bexcept = false;
+	int nstate = 0;
+	try {
+		while (bret)
+		{
+			if (m_ar.OpenChunk() != xpltArchive::IO_OK) break;
+
+			if (m_ar.GetChunkID() == PLT_STATE)
+			{
+				bool bread = true;
+				if (read_state_flag == XPLT_READ_STATES_FROM_LIST)
+				{
+					bread = (std::find(state_list.begin(), state_list.end(), nstate) != state_list.end());
+				}
+
+				if (bread)
+				{
+					STATE_CHUNK& sc = pending[npending++];
+					sc.mesh = GetCurrentMesh();
+					sc.state = nullptr;
+					sc.bok = false;
+					sc.warnings.clear();
+					sc.bdata = m_ar.ReleaseChunk(sc.data);
+					if (sc.bdata == false) m_ar.CloseChunk();
+
+					if (npending == maxPending) flush();
+				}
+				else m_ar.CloseChunk();
+			}
+			else if (m_ar.GetChunkID() == PLT_MESH)
+			{
+				// the pending states still need the current mesh
+				flush();
+
+				if (ReadMesh(fem) == false) { berr = true; break; }
+				m_ar.CloseChunk();
+			}
+			else
+			{
+				errf("Error while reading state data.");
+				m_ar.CloseChunk();
+			}
+
+			// clear end-flag
+			if (m_ar.OpenChunk() != xpltArchive::IO_END) break;
+
+			++nstate;
+		}
+	}
+	catch (...)
+	{
+		bexcept = true;
+	}
+
+	// decode the remaining states
+	flush();
+
+	if (berr) return errf("Error while reading mesh section.");
+	if (bexcept) errf("An unknown exception has occurred.\nNot all data was read in.");
+	else if (bret == false) errf("An error occurred while reading the state data.\nNot all data was read in.");
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Read through the state sections and record their file positions, but don't read the state data.
+bool XpltReader3::IndexStates(FEPostModel& fem)
+{
+	m_index.clear();
+	m_xmeshList.clear();
+
+	bool bcompressed = (m_xplt->GetHeader().ncompression != 0);
+	try {
+		while (true)
+		{
+			off_type pos = m_ar.Tell();
+
+			// For uncompressed files we only need to read the header of the state sections.
+			// Compressed sections have to be decompressed completely.
+			int nret = (bcompressed ? m_ar.OpenChunk() : m_ar.OpenChunkHead(256));
+			if (nret != xpltArchive::IO_OK) break;
+
+			if (m_ar.GetChunkID() == PLT_STATE)
+			{
+				float time = 0.f;
+				int status = 0;
+				if (ReadStateHeader(time, status) == false) break;
+
+				STATE_INDEX si = { pos, GetCurrentMesh(), (int)m_xmeshList.size() };
+				m_index.push_back(si);
+
+				fem.AddState(new FEState(time, status, &fem, GetCurrentMesh()));
+			}
+			else if (m_ar.GetChunkID() == PLT_MESH)
+			{
+				// we need the entire mesh section
+				if (bcompressed == false)
+				{
+					if ((m_ar.Seek(pos) == false) || (m_ar.OpenChunk() != xpltArchive::IO_OK))
+						return errf("Error while reading mesh section.");
+				}
+
+				// the states that were indexed so far refer to the previous mesh
+				m_xmeshList.push_back(std::move(m_xmesh));
+				if (ReadMesh(fem) == false) return errf("Error while reading mesh section.");
+			}
+			else errf("Error while reading state data.");
+			m_ar.CloseChunk();
+
+			// clear end-flag
+			if (m_ar.OpenChunk() != xpltArchive::IO_END) break;
+		}
+	}
+	catch (...)
+	{
+		errf("An unknown exception has occurred.\nNot all data was read in.");
+	}
+
+	m_xmeshList.push_back(std::move(m_xmesh));
+	m_nxmesh = -1;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool XpltReader3::LoadState(FEPostModel& fem, FEState* ps)
+{
+	int n = ps->GetID();
+	if ((n < 0) || (n >= (int)m_index.size())) return false;
+	STATE_INDEX& si = m_index[n];
+
+	// make sure we use the mesh this state refers to
+	if (si.nxmesh != m_nxmesh)
+	{
+		if (m_nxmesh >= 0) std::swap(m_xmesh, m_xmeshList[m_nxmesh]);
+		std::swap(m_xmesh, m_xmeshList[si.nxmesh]);
+		m_nxmesh = si.nxmesh;
+	}
+	m_mesh = si.mesh;
+
+	if (m_ar.Seek(si.pos) == false) return errf("Error while reading state data.");
+	if ((m_ar.OpenChunk() != xpltArchive::IO_OK) || (m_ar.GetChunkID() != PLT_STATE))
+		return errf("Error while reading state data.");
+
+	bool bret = false;
+	try {
+		bret = ReadStateData(fem, ps);
+	}
+	catch (...)
+	{
+		bret = false;
+	}
+
+	// on error, the chunk stack is cleared when seeking to the next state
+	if (bret) m_ar.CloseChunk();
+
+	return bret;
+}
+
+//-----------------------------------------------------------------------------
+// reads the header of a state section (assumes the state section has been opened)
+bool XpltReader3::ReadStateHeader(float& time, int& status)
+{
+	while (m_ar.OpenChunk() == xpltArchive::IO_OK)
+	{
+		int nid = m_ar.GetChunkID();
+		if (nid == PLT_STATE_HEADER)
+		{
+			while (m_ar.OpenChunk() == xpltArchive::IO_OK)
+			{
+				int nid = m_ar.GetChunkID();
+				if (nid == PLT_STATE_HDR_TIME) m_ar.read(time);
+				if (nid == PLT_STATE_STATUS  ) m_ar.read(status);
+				m_ar.CloseChunk();
+			}
+			m_ar.CloseChunk();
+			return true;
+		}
+		m_ar.CloseChunk();
+	}
+	return errf("Error while reading state header.");
+}
+
 //-----------------------------------------------------------------------------
 bool XpltReader3::ReadRootSection(FEPostModel& fem)
 {
@@ -1876,6 +2181,16 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 		return errf("Error allocating memory for state data");
 	}
 
+	return ReadStateData(fem, ps);
+}
+
+//-----------------------------------------------------------------------------
+// read the data of a state section (assumes the state section has been opened)
+bool XpltReader3::ReadStateData(FEPostModel& fem, FEState* ps)
+{
+	// get the mesh
+	FSMesh& mesh = *GetCurrentMesh();
+
 	while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 	{
 		int nid = m_ar.GetChunkID();
@@ -1914,15 +2229,13 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 				int nid = m_ar.GetChunkID();
 				if (nid == PLT_NODE_COORDS)
 				{
-					const int dim = 3;
+					// each node is stored as its ID followed by its coordinates
 					int nodes = mesh.Nodes();
-					NODE node = { -1, 0.f, 0.f, 0.f };
-					for (int i = 0; i < nodes; ++i)
+					vector<float> tmp;
+					const float* a = m_ar.read_span(tmp, 4 * nodes);
+					for (int i = 0; i < nodes; ++i, a += 4)
 					{
-						m_ar.read(node.id);
-						m_ar.read(node.x, dim);
-
-						ps->m_NODE[i].m_rt = vec3f(node.x[0], node.x[1], node.x[2]);
+						ps->m_NODE[i].m_rt = vec3f(a[1], a[2], a[3]);
 					}
 				}
 				else if (m_ar.GetChunkID() == PLT_ELEMENT_STATE)
@@ -1934,9 +2247,9 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 					for (int i = 0; i < NE; ++i)
 					{
 						if (flags[i] == 1)
-							ps->m_ELEM[i].m_state = StatusFlags::VISIBLE;
+							ps->m_ELEM.m_state[i] = StatusFlags::VISIBLE;
 						else
-							ps->m_ELEM[i].m_state = 0;
+							ps->m_ELEM.m_state[i] = 0;
 					}
 				}
 				m_ar.CloseChunk();
@@ -1997,7 +2310,7 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 								{
 									assert((nv >= 0) && (nv < po->DataCount()));
 
-									ObjectData* pd = m_pstate->m_objPt[objId].data;
+									ObjectData* pd = ps->m_objPt[objId].data;
 
 									PlotObjectData* pod = po->GetData(nv);
 									switch (pod->Type())
@@ -2058,7 +2371,7 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 
 								assert((nv >= 0) && (nv < po->DataCount()));
 
-								ObjectData* pd = m_pstate->m_objLn[objId].data;
+								ObjectData* pd = ps->m_objLn[objId].data;
 								PlotObjectData* pod = po->GetData(nv);
 								switch (pod->Type())
 								{
@@ -2090,12 +2403,11 @@ bool XpltReader3::ReadStateSection(FEPostModel& fem)
 		float h[FSElement::MAX_NODES] = {0.f};
 		for (int i=0; i<NE; ++i)
 		{
-			ELEMDATA& d = ps->m_ELEM[i];
 			if (df.active(i))
 			{
 				df.eval(i, h);
 				int n = mesh.ElementRef(i).Nodes();
-				for (int j=0; j<n; ++j) d.m_h[j] = h[j];
+				ps->m_ELEM.SetShellThickness(i, h, n);
 			}
 		}
 	}
@@ -2239,38 +2551,38 @@ bool XpltReader3::ReadNodeData(FEPostModel& fem, FEState* pstate)
 
 						if (it.ntype == FLOAT)
 						{
-							vector<float> a(NN);
-							m_ar.read(a);
+							vector<float> tmp;
+							const float* a = m_ar.read_span(tmp, NN);
 
 							Post::FENodeData<float>& df = dynamic_cast<Post::FENodeData<float>&>(pstate->m_Data[nfield]);
 							for (int j=0; j<NN; ++j) df[j] = a[j];
 						}
 						else if (it.ntype == VEC3F)
 						{
-							vector<vec3f> a(NN);
-							m_ar.read(a);
+							vector<vec3f> tmp;
+							const vec3f* a = m_ar.read_span(tmp, NN);
 
 							Post::FENodeData<vec3f>& dv = dynamic_cast<Post::FENodeData<vec3f>&>(pstate->m_Data[nfield]);
 							for (int j=0; j<NN; ++j) dv[j] = a[j];
 						}
 						else if (it.ntype == MAT3FS)
 						{
-							vector<mat3fs> a(NN);
-							m_ar.read(a);
+							vector<mat3fs> tmp;
+							const mat3fs* a = m_ar.read_span(tmp, NN);
 							Post::FENodeData<mat3fs>& dv = dynamic_cast<Post::FENodeData<mat3fs>&>(pstate->m_Data[nfield]);
 							for (int j=0; j<NN; ++j) dv[j] = a[j];
 						}
 						else if (it.ntype == TENS4FS)
 						{
-							vector<tens4fs> a(NN);
-							m_ar.read(a);
+							vector<tens4fs> tmp;
+							const tens4fs* a = m_ar.read_span(tmp, NN);
 							Post::FENodeData<tens4fs>& dv = dynamic_cast<Post::FENodeData<tens4fs>&>(pstate->m_Data[nfield]);
 							for (int j=0; j<NN; ++j) dv[j] = a[j];
 						}
 						else if (it.ntype == MAT3F)
 						{
-							vector<mat3f> a(NN);
-							m_ar.read(a);
+							vector<mat3f> tmp;
+							const mat3f* a = m_ar.read_span(tmp, NN);
 							Post::FENodeData<mat3f>& dv = dynamic_cast<Post::FENodeData<mat3f>&>(pstate->m_Data[nfield]);
 							for (int j=0; j<NN; ++j) dv[j] = a[j];
 						}
@@ -2331,12 +2643,12 @@ bool XpltReader3::ReadElemData(FEPostModel &fem, FEState* pstate)
 					while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 					{
 						int nd = m_ar.GetChunkID() - 1;
-						assert((nd >= 0)&&(nd < m_xmesh.domains()));
-						if ((nd < 0) || (nd >= (int)m_xmesh.domains())) return errf("Failed reading all state data");
+						assert((nd >= 0)&&(nd < GetXMesh().domains()));
+						if ((nd < 0) || (nd >= (int)GetXMesh().domains())) return errf("Failed reading all state data");
 
 						int nfield = dm.FindDataField(it.szname);
 
-						Domain& dom = m_xmesh.domain(nd);
+						Domain& dom = GetXMesh().domain(nd);
 						FEElemItemData& ed = dynamic_cast<FEElemItemData&>(pstate->m_Data[nfield]);
 						switch (it.nfmt)
 						{
@@ -2513,48 +2825,48 @@ bool XpltReader3::ReadElemData_ITEM(XpltReader3::Domain& dom, Post::FEMeshData&
 	{
 	case FLOAT:
 		{
-			vector<float> a(NE);
-			m_ar.read(a);
+			vector<float> tmp;
+			const float* a = m_ar.read_span(tmp, NE);
 			Post::FEElementData<float,DATA_ITEM>& df = dynamic_cast<Post::FEElementData<float,DATA_ITEM>&>(s);
 			for (int i=0; i<NE; ++i) df.add(dom.elem[i].index, a[i]);
 		}
 		break;
 	case VEC3F:
 		{
-			vector<vec3f> a(NE);
-			m_ar.read(a);
+			vector<vec3f> tmp;
+			const vec3f* a = m_ar.read_span(tmp, NE);
 			Post::FEElementData<vec3f,DATA_ITEM>& dv = dynamic_cast<Post::FEElementData<vec3f,DATA_ITEM>&>(s);
 			for (int i=0; i<NE; ++i) dv.add(dom.elem[i].index, a[i]);
 		}
 		break;
 	case MAT3FS:
 		{
-			vector<mat3fs> a(NE);
-			m_ar.read(a);
+			vector<mat3fs> tmp;
+			const mat3fs* a = m_ar.read_span(tmp, NE);
 			Post::FEElementData<mat3fs,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<mat3fs,DATA_ITEM>&>(s);
 			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
 		}
 		break;
 	case MAT3FD:
 		{
-			vector<mat3fd> a(NE);
-			m_ar.read(a);
+			vector<mat3fd> tmp;
+			const mat3fd* a = m_ar.read_span(tmp, NE);
 			Post::FEElementData<mat3fd,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<mat3fd,DATA_ITEM>&>(s);
 			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
 		}
 		break;
     case TENS4FS:
 		{
-			vector<tens4fs> a(NE);
-			m_ar.read(a);
+			vector<tens4fs> tmp;
+			const tens4fs* a = m_ar.read_span(tmp, NE);
 			Post::FEElementData<tens4fs,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<tens4fs,DATA_ITEM>&>(s);
 			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
 		}
         break;
 	case MAT3F:
 		{
-			vector<mat3f> a(NE);
-			m_ar.read(a);
+			vector<mat3f> tmp;
+			const mat3f* a = m_ar.read_span(tmp, NE);
 			Post::FEElementData<mat3f,DATA_ITEM>& dm = dynamic_cast<Post::FEElementData<mat3f,DATA_ITEM>&>(s);
 			for (int i=0; i<NE; ++i) dm.add(dom.elem[i].index, a[i]);
 		}
@@ -2712,13 +3024,13 @@ bool XpltReader3::ReadFaceData(FEPostModel& fem, FEState* pstate)
 					while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 					{
 						int ns = m_ar.GetChunkID() - 1;
-						assert((ns >= 0)&&(ns < m_xmesh.surfaces()));
-						if ((ns < 0) || (ns >= m_xmesh.surfaces())) return errf("Failed reading all state data");
+						assert((ns >= 0)&&(ns < GetXMesh().surfaces()));
+						if ((ns < 0) || (ns >= GetXMesh().surfaces())) return errf("Failed reading all state data");
 
 //						int nfield = dm.FindDataField(it.szname);
 						int nfield = it.index;
 
-						Surface& s = m_xmesh.surface(ns);
+						Surface& s = GetXMesh().surface(ns);
 						switch (it.nfmt)
 						{
 						case FMT_NODE  : if (ReadFaceData_NODE  (mesh, s, pstate->m_Data[nfield], it.ntype) == false) return errf("Failed reading face data"); break;
@@ -2781,13 +3093,13 @@ bool XpltReader3::ReadEdgeData(FEPostModel& fem, FEState* pstate)
 					while (m_ar.OpenChunk() == xpltArchive::IO_OK)
 					{
 						int ns = m_ar.GetChunkID() - 1;
-						assert((ns >= 0)&&(ns < m_xmesh.edges()));
-						if ((ns < 0) || (ns >= m_xmesh.edges())) return errf("Failed reading all state data");
+						assert((ns >= 0)&&(ns < GetXMesh().edges()));
+						if ((ns < 0) || (ns >= GetXMesh().edges())) return errf("Failed reading all state data");
 
 //						int nfield = dm.FindDataField(it.szname);
 						int nfield = it.index;
 
-						Edge& e = m_xmesh.edge(ns);
+						Edge& e = GetXMesh().edge(ns);
 						switch (it.nfmt)
 						{
 						case FMT_NODE  : if (ReadEdgeData_NODE  (mesh, e, pstate->m_Data[nfield], it.ntype) == false) return errf("Failed reading edge data"); break;
@@ -2961,47 +3273,47 @@ bool XpltReader3::ReadFaceData_ITEM(XpltReader3::Surface &s, Post::FEMeshData& d
 	case FLOAT:
 		{
 			FEFaceData<float,DATA_ITEM>& df = dynamic_cast<FEFaceData<float,DATA_ITEM>&>(data);
-			vector<float> a(NF);
-			m_ar.read(a);
+			vector<float> tmp;
+			const float* a = m_ar.read_span(tmp, NF);
 			for (int i=0; i<NF; ++i) df.add(s.face[i].nid, a[i]);
 		}
 		break;
 	case VEC3F:
 		{
-			vector<vec3f> a(NF);
-			m_ar.read(a);
+			vector<vec3f> tmp;
+			const vec3f* a = m_ar.read_span(tmp, NF);
 			FEFaceData<vec3f,DATA_ITEM>& dv = dynamic_cast<FEFaceData<vec3f,DATA_ITEM>&>(data);
 			for (int i=0; i<NF; ++i) dv.add(s.face[i].nid, a[i]);
 		}
 		break;
 	case MAT3FS:
 		{
-			vector<mat3fs> a(NF);
-			m_ar.read(a);
+			vector<mat3fs> tmp;
+			const mat3fs* a = m_ar.read_span(tmp, NF);
 			FEFaceData<mat3fs,DATA_ITEM>& dm = dynamic_cast<FEFaceData<mat3fs,DATA_ITEM>&>(data);
 			for (int i=0; i<NF; ++i) dm.add(s.face[i].nid, a[i]);
 		}
 		break;
 	case MAT3F:
 		{
-			vector<mat3f> a(NF);
-			m_ar.read(a);
+			vector<mat3f> tmp;
+			const mat3f* a = m_ar.read_span(tmp, NF);
 			FEFaceData<mat3f,DATA_ITEM>& dm = dynamic_cast<FEFaceData<mat3f,DATA_ITEM>&>(data);
 			for (int i=0; i<NF; ++i) dm.add(s.face[i].nid, a[i]);
 		}
 		break;
 	case MAT3FD:
 		{
-			vector<mat3fd> a(NF);
-			m_ar.read(a);
+			vector<mat3fd> tmp;
+			const mat3fd* a = m_ar.read_span(tmp, NF);
 			FEFaceData<mat3fd,DATA_ITEM>& dm = dynamic_cast<FEFaceData<mat3fd,DATA_ITEM>&>(data);
 			for (int i=0; i<NF; ++i) dm.add(s.face[i].nid, a[i]);
 		}
 		break;
     case TENS4FS:
 		{
-			vector<tens4fs> a(NF);
-			m_ar.read(a);
+			vector<tens4fs> tmp;
+			const tens4fs* a = m_ar.read_span(tmp, NF);
 			FEFaceData<tens4fs,DATA_ITEM>& dm = dynamic_cast<FEFaceData<tens4fs,DATA_ITEM>&>(data);
 			for (int i=0; i<NF; ++i) dm.add(s.face[i].nid, a[i]);
 		}
@@ -3254,47 +3566,47 @@ bool XpltReader3::ReadEdgeData_ITEM(XpltReader3::Edge& e, Post::FEMeshData& data
 	case FLOAT:
 	{
 		FEEdgeData<float, DATA_ITEM>& df = dynamic_cast<FEEdgeData<float, DATA_ITEM>&>(data);
-		vector<float> a(NL);
-		m_ar.read(a);
+		vector<float> tmp;
+		const float* a = m_ar.read_span(tmp, NL);
 		for (int i = 0; i < NL; ++i) df.add(e.line[i].id, a[i]);
 	}
 	break;
 	case VEC3F:
 	{
-		vector<vec3f> a(NL);
-		m_ar.read(a);
+		vector<vec3f> tmp;
+		const vec3f* a = m_ar.read_span(tmp, NL);
 		FEEdgeData<vec3f, DATA_ITEM>& dv = dynamic_cast<FEEdgeData<vec3f, DATA_ITEM>&>(data);
 		for (int i = 0; i < NL; ++i) dv.add(e.line[i].id, a[i]);
 	}
 	break;
 	case MAT3FS:
 	{
-		vector<mat3fs> a(NL);
-		m_ar.read(a);
+		vector<mat3fs> tmp;
+		const mat3fs* a = m_ar.read_span(tmp, NL);
 		FEEdgeData<mat3fs, DATA_ITEM>& dm = dynamic_cast<FEEdgeData<mat3fs, DATA_ITEM>&>(data);
 		for (int i = 0; i < NL; ++i) dm.add(e.line[i].id, a[i]);
 	}
 	break;
 	case MAT3F:
 	{
-		vector<mat3f> a(NL);
-		m_ar.read(a);
+		vector<mat3f> tmp;
+		const mat3f* a = m_ar.read_span(tmp, NL);
 		FEEdgeData<mat3f, DATA_ITEM>& dm = dynamic_cast<FEEdgeData<mat3f, DATA_ITEM>&>(data);
 		for (int i = 0; i < NL; ++i) dm.add(e.line[i].id, a[i]);
 	}
 	break;
 	case MAT3FD:
 	{
-		vector<mat3fd> a(NL);
-		m_ar.read(a);
+		vector<mat3fd> tmp;
+		const mat3fd* a = m_ar.read_span(tmp, NL);
 		FEEdgeData<mat3fd, DATA_ITEM>& dm = dynamic_cast<FEEdgeData<mat3fd, DATA_ITEM>&>(data);
 		for (int i = 0; i < NL; ++i) dm.add(e.line[i].id, a[i]);
 	}
 	break;
 	case TENS4FS:
 	{
-		vector<tens4fs> a(NL);
-		m_ar.read(a);
+		vector<tens4fs> tmp;
+		const tens4fs* a = m_ar.read_span(tmp, NL);
 		FEEdgeData<tens4fs, DATA_ITEM>& dm = dynamic_cast<FEEdgeData<tens4fs, DATA_ITEM>&>(data);
 		for (int i = 0; i < NL; ++i) dm.add(e.line[i].id, a[i]);
 	}
@@ -414,11 +414,24 @@ public:
 	XpltReader3(xpltFileReader* xplt);
 	~XpltReader3();
 
+	// Creates a reader that decodes state sections from the archive ar, using the dictionary
+	// and mesh of the parent reader (used to decode states in parallel).
+	XpltReader3(XpltReader3& parent, xpltArchive& ar);
+
 	bool Load(Post::FEPostModel& fem);
 
+	// load a state that was indexed with IndexStates
+	bool LoadState(Post::FEPostModel& fem, Post::FEState* ps) override;
+
 protected:
 	bool ReadRootSection(Post::FEPostModel& fem);
 	bool ReadStateSection(Post::FEPostModel& fem);
+	bool ReadStateData(Post::FEPostModel& fem, Post::FEState* ps);
+	bool ReadStateHeader(float& time, int& status);
+
+	bool IndexStates(Post::FEPostModel& fem);
+
+	bool ReadStatesParallel(Post::FEPostModel& fem);
 
 	bool ReadDictionary(Post::FEPostModel& fem);
 	bool ReadMesh(Post::FEPostModel& fem);
@@ -471,6 +484,8 @@ protected:
 protected:
 	FSMesh* GetCurrentMesh() { return m_mesh; }
 
+	XMesh& GetXMesh() { return (m_parent ? m_parent->m_xmesh : m_xmesh); }
+
 protected:
 	Dictionary			m_dic;
 	XMesh				m_xmesh;
@@ -492,4 +507,17 @@ protected:
 
 	Post::FEState*	m_pstate;	//!< last read state section
 	FSMesh*	m_mesh;		//!< current mesh
+
+	XpltReader3*	m_parent;	//!< parent reader (for readers that only decode states)
+
+	// state index (only used when states are read on demand)
+	struct STATE_INDEX
+	{
+		off_type	pos;		//!< file position of state section
+		FSMesh*		mesh;		//!< mesh of this state
+		int			nxmesh;		//!< index into m_xmeshList
+	};
+	std::vector<STATE_INDEX>	m_index;
+	std::vector<XMesh>			m_xmeshList;	//!< meshes referenced by the state index
+	int							m_nxmesh;		//!< index of the mesh that is currently stored in m_xmesh
 };
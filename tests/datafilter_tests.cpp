@@ -0,0 +1,303 @@
+#include <gtest/gtest.h>
+#include <GeomLib/GPrimitive.h>
+#include <MeshLib/FSMesh.h>
+#include <MeshTools/FEBox.h>
+#include <PostLib/FEPostModel.h>
+#include <PostLib/FEDataManager.h>
+#include <PostLib/FEDataField.h>
+#include <PostLib/FEMeshData_T.h>
+#include <PostLib/DataFilter.h>
+#include <PostLib/constants.h>
+#include <vector>
+using namespace Post;
+
+// field IDs of the test model
+struct TestFields
+{
+	int scl;	// node scalar
+	int vec;	// node vector
+	int elm;	// element scalar
+	int grad;	// node vector that receives the gradient
+};
+
+// Build a small post model with a few states. The data values depend on position and time.
+static TestFields BuildTestModel(FEPostModel& fem)
+{
+	GBox o;
+	FEBoxMesher* mesher = dynamic_cast<FEBoxMesher*>(o.GetFEMesher());
+	mesher->SetResolution(4, 3, 5);
+	FSMesh* mesh = new FSMesh(*o.BuildMesh());
+	fem.AddMesh(mesh);
+
+	FEDataManager& dm = *fem.GetDataManager();
+	dm.AddDataField(new FEDataField_T<FENodeData<float> >(&fem), "scalar");
+	dm.AddDataField(new FEDataField_T<FENodeData<vec3f> >(&fem), "vector");
+	dm.AddDataField(new FEDataField_T<FEElementData<float, DATA_ITEM> >(&fem), "element");
+	dm.AddDataField(new FEDataField_T<FENodeData<vec3f> >(&fem), "gradient");
+
+	TestFields f;
+	f.scl = (*dm.DataField(0))->GetFieldID();
+	f.vec = (*dm.DataField(1))->GetFieldID();
+	f.elm = (*dm.DataField(2))->GetFieldID();
+	f.grad = (*dm.DataField(3))->GetFieldID();
+
+	int NN = mesh->Nodes();
+	int NE = mesh->Elements();
+	for (int n = 0; n < 6; ++n)
+	{
+		float t = 0.1f * n * n;
+		FEState* ps = new FEState(t, &fem, mesh);
+		fem.AddState(ps);
+
+		FENodeData<float>& s = dynamic_cast<FENodeData<float>&>(ps->m_Data[0]);
+		FENodeData<vec3f>& v = dynamic_cast<FENodeData<vec3f>&>(ps->m_Data[1]);
+		FEElementData<float, DATA_ITEM>& e = dynamic_cast<FEElementData<float, DATA_ITEM>&>(ps->m_Data[2]);
+		for (int i = 0; i < NN; ++i)
+		{
+			vec3d r = mesh->Node(i).r;
+			s[i] = (float)(r.x * r.x + 2.0 * r.y * r.z + t * r.x);
+			v[i] = vec3f((float)(r.y + t), (float)(r.x * r.z), (float)(t * t - r.z));
+		}
+		for (int i = 0; i < NE; i += 2) e.add(i, (float)(i % 7) + t);
+	}
+
+	return f;
+}
+
+// The filters below are the straightforward implementations that process one state at a time.
+// They serve as a reference for the filters in DataFilter.cpp.
+template <typename T> static void RefSmoothNodes(FEPostModel& fem, int nfield, double theta, int niters)
+{
+	for (int iter = 0; iter < niters; ++iter)
+	{
+		for (int n = 0; n < fem.GetStates(); ++n)
+		{
+			FEState& s = *fem.GetState(n);
+			FSMesh& mesh = *s.GetFEMesh();
+			FENodeData<T>& data = dynamic_cast<FENodeData<T>&>(s.m_Data[FIELD_CODE(nfield)]);
+			int NN = mesh.Nodes();
+			std::vector<T> D(NN, T(0.f, 0.f, 0.f));
+			std::vector<int> tag(NN, 0);
+			for (int i = 0; i < mesh.Elements(); ++i)
+			{
+				FSElement_& el = mesh.ElementRef(i);
+				int ne = el.Nodes();
+				for (int j = 0; j < ne; ++j)
+				{
+					T v = data[el.m_node[j]];
+					for (int k = 0; k < ne; ++k)
+						if (k != j) { D[el.m_node[k]] += v; tag[el.m_node[k]]++; }
+				}
+			}
+			for (int i = 0; i < NN; ++i) if (tag[i] > 0) D[i] /= (float)tag[i];
+			for (int i = 0; i < NN; ++i) data[i] = data[i] * (1.0 - theta) + D[i] * theta;
+		}
+	}
+}
+
+template <> void RefSmoothNodes<float>(FEPostModel& fem, int nfield, double theta, int niters)
+{
+	for (int iter = 0; iter < niters; ++iter)
+	{
+		for (int n = 0; n < fem.GetStates(); ++n)
+		{
+			FEState& s = *fem.GetState(n);
+			FSMesh& mesh = *s.GetFEMesh();
+			FENodeData<float>& data = dynamic_cast<FENodeData<float>&>(s.m_Data[FIELD_CODE(nfield)]);
+			int NN = mesh.Nodes();
+			std::vector<float> D(NN, 0.f);
+			std::vector<int> tag(NN, 0);
+			for (int i = 0; i < mesh.Elements(); ++i)
+			{
+				FSElement_& el = mesh.ElementRef(i);
+				int ne = el.Nodes();
+				for (int j = 0; j < ne; ++j)
+				{
+					float f = data[el.m_node[j]];
+					for (int k = 0; k < ne; ++k)
+						if (k != j) { D[el.m_node[k]] += f; tag[el.m_node[k]]++; }
+				}
+			}
+			for (int i = 0; i < NN; ++i) if (tag[i] > 0) D[i] /= (float)tag[i];
+			for (int i = 0; i < NN; ++i) data[i] = (float)((1.0 - theta) * data[i] + theta * D[i]);
+		}
+	}
+}
+
+static void RefSmoothElems(FEPostModel& fem, int nfield, double theta, int niters)
+{
+	for (int iter = 0; iter < niters; ++iter)
+	{
+		for (int n = 0; n < fem.GetStates(); ++n)
+		{
+			FEState& s = *fem.GetState(n);
+			FSMesh& mesh = *s.GetFEMesh();
+			FEElementData<float, DATA_ITEM>& data = dynamic_cast<FEElementData<float, DATA_ITEM>&>(s.m_Data[FIELD_CODE(nfield)]);
+			int NE = mesh.Elements();
+			std::vector<float> D(NE, 0.f);
+			std::vector<int> tag(NE, 0);
+			for (int i = 0; i < NE; ++i)
+			{
+				FSElement_& el = mesh.ElementRef(i);
+				for (int j = 0; j < el.Faces(); ++j)
+				{
+					int nj = el.m_nbr[j];
+					if ((nj >= 0) && data.active(nj))
+					{
+						float f; data.eval(nj, &f);
+						D[i] += f; tag[i]++;
+					}
+				}
+			}
+			for (int i = 0; i < NE; ++i) if (tag[i] > 0) D[i] /= (float)tag[i];
+			for (int i = 0; i < NE; ++i)
+				if (data.active(i))
+				{
+					float f; data.eval(i, &f);
+					data.set(i, (float)((1.0 - theta) * f + theta * D[i]));
+				}
+		}
+	}
+}
+
+static void RefGradient(FEPostModel& fem, int nscl, int config, std::vector<std::vector<vec3f> >& grad)
+{
+	grad.resize(fem.GetStates());
+	for (int n = 0; n < fem.GetStates(); ++n)
+	{
+		FEState& state = *fem.GetState(n);
+		FSMesh& mesh = *state.GetFEMesh();
+		FENodeData<float>& s = dynamic_cast<FENodeData<float>&>(state.m_Data[FIELD_CODE(nscl)]);
+		int NN = mesh.Nodes();
+		std::vector<vec3f> G(NN, vec3f(0.f, 0.f, 0.f));
+		std::vector<int> tag(NN, 0);
+		vec3f eg[FSElement::MAX_NODES];
+		for (int i = 0; i < mesh.Elements(); ++i)
+		{
+			FSElement_& el = mesh.ElementRef(i);
+			for (int j = 0; j < el.Nodes(); ++j)
+			{
+				double q[3] = { 0,0,0 };
+				el.iso_coord(j, q);
+				if (config == 1) shape_grad(fem, i, q, n, eg);
+				else shape_grad_ref(fem, i, q, n, eg);
+
+				vec3f g(0.f, 0.f, 0.f);
+				for (int k = 0; k < el.Nodes(); ++k) g += eg[k] * (float)((double)s[el.m_node[k]]);
+				G[el.m_node[j]] += g;
+				tag[el.m_node[j]]++;
+			}
+		}
+		for (int i = 0; i < NN; ++i) if (tag[i] > 0) G[i] /= (float)tag[i];
+		grad[n] = G;
+	}
+}
+
+// the filters should give the exact same results as the reference filters
+static bool isEqual(float a, float b) { return (a == b); }
+static bool isEqual(const vec3f& a, const vec3f& b) { return (a.x == b.x) && (a.y == b.y) && (a.z == b.z); }
+
+template <typename T> static void EXPECT_NODE_DATA_EQ(FEPostModel& a, FEPostModel& b, int nfield)
+{
+	ASSERT_EQ(a.GetStates(), b.GetStates());
+	for (int n = 0; n < a.GetStates(); ++n)
+	{
+		FENodeData<T>& da = dynamic_cast<FENodeData<T>&>(a.GetState(n)->m_Data[FIELD_CODE(nfield)]);
+		FENodeData<T>& db = dynamic_cast<FENodeData<T>&>(b.GetState(n)->m_Data[FIELD_CODE(nfield)]);
+		ASSERT_EQ(da.size(), db.size());
+		for (int i = 0; i < da.size(); ++i) EXPECT_TRUE(isEqual(da[i], db[i])) << "state " << n << ", node " << i;
+	}
+}
+
+TEST(DataFilterTests, SmoothNodeScalar)
+{
+	FEPostModel a, b;
+	TestFields fa = BuildTestModel(a);
+	TestFields fb = BuildTestModel(b);
+	EXPECT_TRUE(DataSmooth(a, fa.scl, 0.4, 3));
+	RefSmoothNodes<float>(b, fb.scl, 0.4, 3);
+	EXPECT_NODE_DATA_EQ<float>(a, b, fa.scl);
+}
+
+TEST(DataFilterTests, SmoothNodeVector)
+{
+	FEPostModel a, b;
+	TestFields fa = BuildTestModel(a);
+	TestFields fb = BuildTestModel(b);
+	EXPECT_TRUE(DataSmooth(a, fa.vec, 0.7, 2));
+	RefSmoothNodes<vec3f>(b, fb.vec, 0.7, 2);
+	EXPECT_NODE_DATA_EQ<vec3f>(a, b, fa.vec);
+}
+
+TEST(DataFilterTests, SmoothElemScalar)
+{
+	FEPostModel a, b;
+	TestFields fa = BuildTestModel(a);
+	TestFields fb = BuildTestModel(b);
+	EXPECT_TRUE(DataSmooth(a, fa.elm, 0.5, 4));
+	RefSmoothElems(b, fb.elm, 0.5, 4);
+	for (int n = 0; n < a.GetStates(); ++n)
+	{
+		FEElementData<float, DATA_ITEM>& da = dynamic_cast<FEElementData<float, DATA_ITEM>&>(a.GetState(n)->m_Data[FIELD_CODE(fa.elm)]);
+		FEElementData<float, DATA_ITEM>& db = dynamic_cast<FEElementData<float, DATA_ITEM>&>(b.GetState(n)->m_Data[FIELD_CODE(fb.elm)]);
+		ASSERT_EQ(da.size(), db.size());
+		for (int i = 0; i < da.size(); ++i) EXPECT_EQ(da[i], db[i]);
+	}
+}
+
+TEST(DataFilterTests, TimeRate)
+{
+	FEPostModel fem;
+	TestFields f = BuildTestModel(fem);
+	FEDataManager& dm = *fem.GetDataManager();
+	ModelDataField* sr = DataTimeRate(fem, *dm.DataField(0), "scalar rate");
+	ModelDataField* vr = DataTimeRate(fem, *dm.DataField(1), "vector rate");
+	ASSERT_NE(sr, nullptr);
+	ASSERT_NE(vr, nullptr);
+
+	for (int n = 0; n < fem.GetStates(); ++n)
+	{
+		FEState& s1 = *fem.GetState(n);
+		FENodeData<float>& ds = dynamic_cast<FENodeData<float>&>(s1.m_Data[FIELD_CODE(sr->GetFieldID())]);
+		FENodeData<vec3f>& dv = dynamic_cast<FENodeData<vec3f>&>(s1.m_Data[FIELD_CODE(vr->GetFieldID())]);
+		for (int i = 0; i < ds.size(); ++i)
+		{
+			if (n == 0)
+			{
+				EXPECT_EQ(ds[i], 0.f);
+				EXPECT_TRUE(isEqual(dv[i], vec3f(0.f, 0.f, 0.f)));
+			}
+			else
+			{
+				FEState& s0 = *fem.GetState(n - 1);
+				double dt = s1.m_time - s0.m_time;
+				FENodeData<float>& a0 = dynamic_cast<FENodeData<float>&>(s0.m_Data[FIELD_CODE(f.scl)]);
+				FENodeData<float>& a1 = dynamic_cast<FENodeData<float>&>(s1.m_Data[FIELD_CODE(f.scl)]);
+				FENodeData<vec3f>& b0 = dynamic_cast<FENodeData<vec3f>&>(s0.m_Data[FIELD_CODE(f.vec)]);
+				FENodeData<vec3f>& b1 = dynamic_cast<FENodeData<vec3f>&>(s1.m_Data[FIELD_CODE(f.vec)]);
+				float rs = (a1[i] - a0[i]) / dt;
+				vec3f rv = (b1[i] - b0[i]) / dt;
+				EXPECT_EQ(ds[i], rs);
+				EXPECT_TRUE(isEqual(dv[i], rv));
+			}
+		}
+	}
+}
+
+TEST(DataFilterTests, Gradient)
+{
+	for (int config = 0; config < 2; ++config)
+	{
+		FEPostModel fem;
+		TestFields f = BuildTestModel(fem);
+		EXPECT_TRUE(DataGradient(fem, f.grad, f.scl, config));
+
+		std::vector<std::vector<vec3f> > G;
+		RefGradient(fem, f.scl, config, G);
+		for (int n = 0; n < fem.GetStates(); ++n)
+		{
+			FENodeData<vec3f>& d = dynamic_cast<FENodeData<vec3f>&>(fem.GetState(n)->m_Data[FIELD_CODE(f.grad)]);
+			for (int i = 0; i < d.size(); ++i) EXPECT_TRUE(isEqual(d[i], G[n][i])) << "state " << n << ", node " << i;
+		}
+	}
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 #include <GeomLib/GPrimitive.h>
+#include <MeshLib/FSSurfaceMesh.h>
+#include <MeshTools/FEWeldModifier.h>
+#include <algorithm>
+#include <random>
 #include "tools.h"
 
 TEST(ModifierTests, WeldObjects)
@@ -17,3 +21,185 @@ TEST(ModifierTests, WeldObjects)
 	// Check the properties of the welded object
 	EXPECT_TOPO(mb1, 12, 20, 11, 2);
 }
+
+// The pairwise loops that the weld modifiers used before they searched a grid.
+// All nodes are selected.
+static void WeldNodesReference(std::vector<vec3d>& r, double threshold, std::vector<int>& order)
+{
+	int n = (int)r.size();
+	order.resize(n);
+	for (int i = 0; i < n; ++i) order[i] = i;
+	double eps = threshold * threshold;
+	for (int i = 0; i < n - 1; ++i)
+		for (int j = i + 1; j < n; ++j)
+		{
+			int ni = order[i];
+			int nj = order[j];
+			if (ni != nj)
+			{
+				vec3d& ri = r[ni];
+				vec3d& rj = r[nj];
+				double d = (ri.x - rj.x)*(ri.x - rj.x) + (ri.y - rj.y)*(ri.y - rj.y) + (ri.z - rj.z)*(ri.z - rj.z);
+				if (d <= eps)
+				{
+					order[j] = ni;
+					ri = (ri + rj)*0.5;
+				}
+			}
+		}
+	for (int i = 0; i < n; ++i) if (order[i] != i) order[i] = order[order[i]];
+}
+
+static void WeldSurfaceNodesReference(std::vector<vec3d>& r, double threshold, std::vector<int>& order)
+{
+	int n = (int)r.size();
+	order.resize(n);
+	for (int i = 0; i < n; ++i) order[i] = i;
+	double eps = threshold * threshold;
+	for (int i = 0; i < n - 1; ++i)
+	{
+		int ni = order[i];
+		vec3d& ri = r[ni];
+		int jmin = -1;
+		double dmin = 0.0;
+		for (int j = i + 1; j < n; ++j)
+		{
+			int nj = order[j];
+			if (ni != nj)
+			{
+				vec3d& rj = r[nj];
+				double d = (ri.x - rj.x)*(ri.x - rj.x) + (ri.y - rj.y)*(ri.y - rj.y) + (ri.z - rj.z)*(ri.z - rj.z);
+				if ((d <= eps) && ((d < dmin) || jmin == -1)) { jmin = j; dmin = d; }
+			}
+		}
+		if (jmin != -1)
+		{
+			vec3d& rj = r[order[jmin]];
+			order[jmin] = ni;
+			ri = (ri + rj)*0.5;
+		}
+	}
+	for (int i = 0; i < n; ++i) if (order[i] != i) order[i] = order[order[i]];
+}
+
+// Clusters of nodes with a spread of about the weld threshold (0.15), so that 
+// chains of welds occur, and a row of nodes along which the welded node moves
+// further than twice the threshold. Each triangle connects nodes that are far 
+// apart, so the triangles never collapse.
+static void WeldTestData(std::vector<vec3d>& r, std::vector<int>& tri)
+{
+	std::mt19937 gen(17);
+	std::uniform_real_distribution<double> U(-0.1, 0.1);
+	const int M = 4, K = 5;
+	for (int c = 0; c < M*M*M; ++c)
+		for (int k = 0; k < K; ++k)
+			r.push_back(vec3d(c % M + U(gen), (c / M) % M + U(gen), c / (M*M) + U(gen)));
+	std::shuffle(r.begin(), r.end(), gen);
+	double x[] = { 0.007, 0.144, 0.227, 0.490, 0.253, 0.367, 0.460, 0.241, 0.523, 0.556, 0.088, 0.421 };
+	for (double xi : x) r.push_back(vec3d(M + 1 + xi, 0, 0));
+
+	int n = (int)r.size();
+	for (int i = 0; i < n; ++i)
+	{
+		int j = (i + n / 3) % n, k = (i + 2 * n / 3) % n;
+		if (((r[i] - r[j]).Length() > 0.5) && ((r[i] - r[k]).Length() > 0.5) && ((r[j] - r[k]).Length() > 0.5))
+			tri.insert(tri.end(), { i, j, k });
+		else
+			tri.insert(tri.end(), { i, i, i });
+	}
+}
+
+// compare the welded mesh against the nodes of the reference weld
+template <class Mesh> static void EXPECT_WELD(const Mesh& m, const std::vector<vec3d>& r, const std::vector<int>& used)
+{
+	// nodes that are still used are numbered in their original order
+	int n = (int)r.size();
+	std::vector<int> newID(n, -1);
+	int nn = 0;
+	for (int i = 0; i < n; ++i) if (used[i]) newID[i] = nn++;
+	ASSERT_EQ(m.Nodes(), nn);
+	for (int i = 0; i < n; ++i)
+	{
+		if (used[i] == 0) continue;
+		vec3d d = m.Node(newID[i]).r - r[i];
+		EXPECT_LT(d.Length(), 1e-12);
+	}
+}
+
+TEST(ModifierTests, WeldSurfaceNodesMatchesPairwise)
+{
+	std::vector<vec3d> r;
+	std::vector<int> tri;
+	WeldTestData(r, tri);
+	int n = (int)r.size();
+
+	// the faces that do not connect three clusters are dropped
+	std::vector<int> faces;
+	for (int i = 0; i < (int)tri.size(); i += 3) if (tri[i] != tri[i + 1]) faces.push_back(i);
+
+	FSSurfaceMesh mesh;
+	mesh.Create(n, 0, (int)faces.size());
+	for (int i = 0; i < n; ++i) mesh.Node(i).r = r[i];
+	for (int i = 0; i < (int)faces.size(); ++i)
+	{
+		FSFace& f = mesh.Face(i);
+		f.SetType(FE_FACE_TRI3);
+		f.m_gid = 0;
+		for (int j = 0; j < 3; ++j) f.n[j] = tri[faces[i] + j];
+	}
+
+	std::vector<int> order;
+	double threshold = 0.15;
+	WeldSurfaceNodesReference(r, threshold, order);
+
+	std::vector<int> used(n, 0);
+	for (int i : faces) for (int j = 0; j < 3; ++j) used[order[tri[i + j]]] = 1;
+
+	FEWeldSurfaceNodes weld;
+	weld.SetThreshold(threshold);
+	FSSurfaceMesh* newMesh = weld.Apply(&mesh);
+	ASSERT_NE(newMesh, nullptr);
+	EXPECT_WELD(*newMesh, r, used);
+	delete newMesh;
+}
+
+TEST(ModifierTests, WeldNodesMatchesPairwise)
+{
+	std::vector<vec3d> r;
+	std::vector<int> tri;
+	WeldTestData(r, tri);
+	int n = (int)r.size();
+
+	std::vector<int> elems;
+	for (int i = 0; i < (int)tri.size(); i += 3) if (tri[i] != tri[i + 1]) elems.push_back(i);
+
+	FSMesh mesh;
+	mesh.Create(n, (int)elems.size());
+	for (int i = 0; i < n; ++i)
+	{
+		mesh.Node(i).r = r[i];
+		mesh.Node(i).Select();
+	}
+	for (int i = 0; i < (int)elems.size(); ++i)
+	{
+		FSElement& el = mesh.Element(i);
+		el.SetType(FE_TRI3);
+		el.m_gid = 0;
+		for (int j = 0; j < 3; ++j) el.m_node[j] = tri[elems[i] + j];
+	}
+	mesh.RebuildMesh();
+
+	std::vector<int> order;
+	double threshold = 0.15;
+	WeldNodesReference(r, threshold, order);
+
+	std::vector<int> used(n, 0);
+	for (int i : elems) for (int j = 0; j < 3; ++j) used[order[tri[i + j]]] = 1;
+
+	FEWeldNodes weld;
+	weld.SetThreshold(threshold);
+	FSMesh* newMesh = weld.Apply(&mesh);
+	ASSERT_NE(newMesh, nullptr);
+	EXPECT_WELD(*newMesh, r, used);
+	delete newMesh;
+}